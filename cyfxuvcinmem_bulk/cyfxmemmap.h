@@ -0,0 +1,103 @@
+/*
+ ## FX3 application memory map (cyfxmemmap.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXMEMMAP_H_
+#define _INCLUDED_CYFXMEMMAP_H_
+
+/* Single description of the System RAM layout. It is included by cyfxtx.cpp for the
+ * heap constants and preprocessed into the linker script (fx3cpp.ld.in -> $(TGT_DIR)/
+ * fx3cpp.ld) for the memory regions, so it must stay plain preprocessor: integer
+ * literals without suffixes, no C++.
+ *
+ * Only the sizes are set here; each base is the end of the region below it, and the
+ * buffer heap takes everything up to the top of System RAM.
+ *
+ *   Descriptor area          CY_FX_MEM_DSCR_*         (boot loader, SDK descriptors)
+ *   Code area                CY_FX_MEM_CODE_*         (.text, .rodata)
+ *   Data area                CY_FX_MEM_DATA_*         (.data, .bss)
+ *   C++ exception tables     CY_FX_MEM_EXC_*          (unused, the tables are discarded)
+ *   Runtime compiler heap    CY_FX_MEM_CHEAP_*        (newlib sbrk heap, unused)
+ *   Driver heap              CY_FX_MEM_DRV_HEAP_*     (CyU3PMemAlloc: thread stacks, OS objects)
+ *   Buffer heap              CY_FX_MEM_BUF_HEAP_*     (CyU3PDmaBufferAlloc: DMA buffers)
+ */
+
+#define CY_FX_MEM_SYSMEM_BASE           0x40000000      /* Start of the 512 KB System RAM. */
+#define CY_FX_MEM_SYSMEM_TOP            0x40080000      /* End of the System RAM. */
+
+#define CY_FX_MEM_ITCM_BASE             0x00000200      /* I-TCM after the exception vectors. */
+#define CY_FX_MEM_ITCM_SIZE             0x00003E00      /* Rest of the 16 KB I-TCM. */
+
+#define CY_FX_MEM_DTCM_HOT_BASE         0x10000A00      /* FIQ stack area of the 8 KB D-TCM. */
+#define CY_FX_MEM_DTCM_HOT_SIZE         0x00000200      /* 512 B */
+
+#define CY_FX_MEM_DSCR_SIZE             0x00003000      /* 12 KB */
+#define CY_FX_MEM_CODE_SIZE             0x00040000      /* 256 KB */
+#define CY_FX_MEM_DATA_SIZE             0x00005000      /* 20 KB */
+
+/* Compact map (make CY_FX_MEM_COMPACT=1 or 2). The exception table area is always
+ * empty, as the build uses -fno-exceptions and the linker script discards the tables,
+ * and this application does not use the compiler heap (no malloc, no new). Both are
+ * dropped: mode 1 gives the 64 KB to the buffer heap, mode 2 to the driver heap. The
+ * linker script fails the link if anything pulls in the compiler heap, and
+ * CyU3PMemInit checks the layout of the loaded image. */
+#if defined (CY_FX_MEM_COMPACT) && (CY_FX_MEM_COMPACT != 0)
+#define CY_FX_MEM_EXC_SIZE              0x00000000
+#define CY_FX_MEM_CHEAP_SIZE            0x00000000
+#else
+#define CY_FX_MEM_EXC_SIZE              0x00008000      /* 32 KB */
+#define CY_FX_MEM_CHEAP_SIZE            0x00008000      /* 32 KB */
+#endif
+
+#if defined (CY_FX_MEM_COMPACT) && (CY_FX_MEM_COMPACT == 2)
+#define CY_FX_MEM_DRV_HEAP_SIZE         0x00018000      /* 96 KB */
+#else
+#define CY_FX_MEM_DRV_HEAP_SIZE         0x00008000      /* 32 KB, at least 20 KB for the SDK */
+#endif
+
+#define CY_FX_MEM_DSCR_BASE             CY_FX_MEM_SYSMEM_BASE
+#define CY_FX_MEM_CODE_BASE             (CY_FX_MEM_DSCR_BASE + CY_FX_MEM_DSCR_SIZE)
+#define CY_FX_MEM_DATA_BASE             (CY_FX_MEM_CODE_BASE + CY_FX_MEM_CODE_SIZE)
+#define CY_FX_MEM_EXC_BASE              (CY_FX_MEM_DATA_BASE + CY_FX_MEM_DATA_SIZE)
+#define CY_FX_MEM_CHEAP_BASE            (CY_FX_MEM_EXC_BASE + CY_FX_MEM_EXC_SIZE)
+#define CY_FX_MEM_DRV_HEAP_BASE         (CY_FX_MEM_CHEAP_BASE + CY_FX_MEM_CHEAP_SIZE)
+#define CY_FX_MEM_BUF_HEAP_BASE         (CY_FX_MEM_DRV_HEAP_BASE + CY_FX_MEM_DRV_HEAP_SIZE)
+#define CY_FX_MEM_BUF_HEAP_SIZE         (CY_FX_MEM_SYSMEM_TOP - CY_FX_MEM_BUF_HEAP_BASE)
+
+/* Hot code placement. Functions marked CY_FX_HOT_CODE go to the CYFX_HOT_CODE section,
+ * which the linker script places in I-TCM next to the ThreadX interrupt code: they run
+ * with zero wait states and never miss in the I-cache. Keep it to the per-buffer path;
+ * the linker prints the I-TCM usage at the end of every link. Calls between I-TCM and
+ * System RAM go through linker veneers, so mark the callees of a hot function as well
+ * where they are small. The attribute is a no-op in the host build. */
+#if defined (CYFX_HOST_BUILD)
+#define CY_FX_HOT_CODE
+#else
+#define CY_FX_HOT_CODE                  __attribute__ ((section ("CYFX_HOT_CODE"), noinline))
+#endif
+
+/* Hot data placement. Variables marked CY_FX_HOT_DATA go to the CYFX_HOT_DATA section,
+ * which the linker script places in D-TCM, in the 512 bytes the SDK reserves for the
+ * FIQ stack: the SDK never registers an FIQ, and the rest of the D-TCM holds the kernel
+ * stacks. The section is not part of the image; the startup code zero fills it, so the
+ * variables must not have initializers other than zero. Keep it to the small state the
+ * streaming loop touches on every buffer. Building with CY_FX_HOT_DATA=0 leaves them in
+ * the data area, for comparison. The attribute is a no-op in the host build. */
+#if defined (CYFX_HOST_BUILD) || defined (CY_FX_HOT_DATA_OFF)
+#define CY_FX_HOT_DATA
+#else
+#define CY_FX_HOT_DATA                  __attribute__ ((section ("CYFX_HOT_DATA")))
+#endif
+
+/* Buffer heap space used by the SDK itself: EP0 and debug UART DMA buffers and the
+ * driver channels. Allowance checked against the application's DMA ring. */
+#define CY_FX_MEM_SDK_BUF_RESERVE       0x00002000      /* 8 KB */
+
+#if (CY_FX_MEM_BUF_HEAP_BASE >= CY_FX_MEM_SYSMEM_TOP)
+#error "cyfxmemmap.h: the regions below the buffer heap do not fit in System RAM"
+#endif
+
+#endif /* _INCLUDED_CYFXMEMMAP_H_ */
+
+/*[]*/
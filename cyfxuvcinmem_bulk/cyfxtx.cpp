@@ -36,7 +36,13 @@
 #include <cyu3os.h>
 #include <cyu3utils.h>
 #include <cyu3error.h>
+#include <cyu3vic.h>
 #include <cyfxversion.h>
+#include "cyfxmemmap.h"
+#include "cyfxuvcprofile.h"
+#include "cyfxuvcstack.h"
+#include "cyfxuvcarena.h"
+#include "cyfxuvcheap.h"
 
 /* Memory error detection is supported in SDK 1.3.3 and later. */
 #if ((CYFX_VERSION_MINOR > 3) || ((CYFX_VERSION_MINOR == 3) && (CYFX_VERSION_PATCH >= 3)))
@@ -54,7 +60,8 @@
 #endif
 
 /*
-   The default application memory map for FX3 firmware is as follows:
+   The application memory map is described once in cyfxmemmap.h, which also generates the
+   MEMORY regions of the linker script. The default map for FX3 firmware is as follows:
 
    Descriptor area          Base: 0x40000000 Size: 12  KB
    Code area                Base: 0x40003000 Size: 256 KB
@@ -70,11 +77,11 @@
    area which is used by the application code as well as the drivers to allocate thread
    stacks and other internal data structures.
  */
-constexpr uint32_t CY_U3P_MEM_HEAP_BASE = 0x40058000;
-constexpr uint32_t CY_U3P_MEM_HEAP_SIZE = 0x8000;
+constexpr uint32_t CY_U3P_MEM_HEAP_BASE = CY_FX_MEM_DRV_HEAP_BASE;
+constexpr uint32_t CY_U3P_MEM_HEAP_SIZE = CY_FX_MEM_DRV_HEAP_SIZE;
 
 /* Limit for the buffer heap area is the top of the SYSMEM RAM area. */
-constexpr uint32_t CY_U3P_SYS_MEM_TOP = 0x40080000;
+constexpr uint32_t CY_U3P_SYS_MEM_TOP = CY_FX_MEM_SYSMEM_TOP;
 
 /*
    The buffer heap is used to obtain data buffers for DMA transfers in or out of
@@ -82,8 +89,13 @@ constexpr uint32_t CY_U3P_SYS_MEM_TOP = 0x40080000;
    of a reserved area in the SYSTEM RAM and ensures that all allocated DMA buffers
    are aligned to cache lines.
  */
-constexpr uint32_t CY_U3P_BUFFER_HEAP_BASE = CY_U3P_MEM_HEAP_BASE + CY_U3P_MEM_HEAP_SIZE;
-constexpr uint32_t CY_U3P_BUFFER_HEAP_SIZE = CY_U3P_SYS_MEM_TOP - CY_U3P_BUFFER_HEAP_BASE;
+constexpr uint32_t CY_U3P_BUFFER_HEAP_BASE = CY_FX_MEM_BUF_HEAP_BASE;
+constexpr uint32_t CY_U3P_BUFFER_HEAP_SIZE = CY_FX_MEM_BUF_HEAP_SIZE;
+
+static_assert (CY_U3P_MEM_HEAP_SIZE >= 0x5000, "the driver heap must be at least 20 KB");
+static_assert ((CY_U3P_BUFFER_HEAP_BASE % 32) == 0, "the buffer heap must be cache line aligned");
+static_assert (CY_U3P_BUFFER_HEAP_BASE + CY_U3P_BUFFER_HEAP_SIZE == CY_U3P_SYS_MEM_TOP,
+        "the buffer heap must end at the top of System RAM");
 
 constexpr uint32_t CY_U3P_BUFFER_ALLOC_TIMEOUT = 10;
 constexpr uint32_t CY_U3P_MEM_ALLOC_TIMEOUT = 10;
@@ -98,10 +110,28 @@ constexpr uint32_t BYTE_TO_DWORD(uint32_t s) { return (s >> 2); }
 /* Cache line size for FX3. */
 constexpr uint32_t FX3_CACHE_LINE_SZ = 32;
 
+#if !defined (CYFX_HOST_BUILD)
+/* Linker script symbols: end of the data area and the compiler heap bounds. */
+extern "C" uint8_t _bss_end[], __heap_start[], __heap_end[];
+#endif
+
 static CyBool_t         glMemPoolInit   = CyFalse;              /* Whether the memory allocator has been initialized. */
 static CyU3PBytePool    glMemBytePool;                          /* ThreadX Byte pool used in the CyU3PMem* functions. */
 static CyU3PDmaBufMgr_t glBufferManager = {};                   /* Buffer manager used in the buffer alloc functions. */
 
+/*
+   Streaming session arena (cyfxuvcarena.h): a block of the buffer heap and the thread whose
+   buffer allocations are carved from it. Protected by the buffer manager lock.
+ */
+static uint32_t         glBufArenaStart     = 0;                /* Start of the block, 0 if none is reserved. */
+static uint32_t         glBufArenaTop       = 0;                /* Next free byte of the block. */
+static uint32_t         glBufArenaEnd       = 0;                /* End of the block. */
+static CyU3PThread     *glBufArenaOwner     = NULL;             /* Thread served from the block. */
+static CyBool_t         glBufArenaOpen      = CyFalse;          /* Whether allocations are served from the block. */
+static uint32_t         glBufArenaLive      = 0;                /* Buffers carved from the block and not yet freed. */
+static uint32_t         glBufArenaSessions  = 0;                /* Blocks released so far. */
+static uint32_t         glBufArenaFallbacks = 0;                /* Allocations that did not fit the block. */
+
 #ifdef CYFXTX_ERRORDETECTION
 
 /*
@@ -124,8 +154,34 @@ static uint32_t         glBufFreeCnt         = 0;               /* Number of fre
 static MemBlockInfo    *glBufInUseList       = 0;               /* List of all memory blocks in use. */
 static CyU3PMemCorruptCallback glBufBadCb    = 0;               /* Callback for notification of corrupted memory. */
 
+/*
+   Incremental checks (cyfxuvcheap.h). Every checked block carries canaries made of the
+   signatures mixed with its address; only 1 in glMemSamplePeriod blocks is linked into the
+   in-use list, and the list is walked a few blocks at a time from a cursor. The list and
+   the cursor are only changed with the interrupts masked.
+ */
+struct CyFxMemTrack_t
+{
+    MemBlockInfo          **list_pp;    /* In-use list of the heap: newest block, linked through prev_blk. */
+    MemBlockInfo           *cursor_p;   /* Next block to check, NULL to restart from the newest. */
+    uint32_t                lowAddr;    /* Bounds of the heap, for the list pointers. */
+    uint32_t                highAddr;
+    CyU3PMemCorruptCallback *badCb_p;   /* Callback for notification of corrupted memory. */
+    uint32_t                sinceTracked; /* Blocks allocated since the last linked one. */
+};
+
+constexpr uint32_t CY_FX_MEM_BLOCK_TRACKED = 1;                 /* MemBlockInfo pad[0]: block is in the in-use list. */
+
+static uint32_t         glMemSamplePeriod = 1;                  /* Link 1 in this many blocks into the in-use lists. */
+static CyFxMemTrack_t   glMemTrack = { &glMemInUseList, 0, CY_U3P_MEM_HEAP_BASE, CY_U3P_BUFFER_HEAP_BASE, &glMemBadCb, 0 };
+static CyFxMemTrack_t   glBufTrack = { &glBufInUseList, 0, CY_U3P_BUFFER_HEAP_BASE, CY_U3P_SYS_MEM_TOP, &glBufBadCb, 0 };
+
 #endif
 
+/* The host build (host/fx3host.cpp) has no exception vectors and starts the application
+   itself; it uses the allocators and memory primitives below as they are. */
+#if !defined (CYFX_HOST_BUILD)
+
 /**********************************************************************
  *                       ARM Exception Handlers                       *
  **********************************************************************/
@@ -200,8 +256,208 @@ tx_application_define (
     CyU3PApplicationDefine ();
 }
 
+#endif
+
 #ifdef CYFXTX_ERRORDETECTION
 
+/* Canary of a block: a signature mixed with the block address, so that a header copied
+   over from another block does not pass. */
+static inline uint32_t
+CyFxMemCanary (
+        const MemBlockInfo *block_p,
+        uint32_t            sig)
+{
+    return sig ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(block_p));
+}
+
+/* Whether the canaries and list pointers of a block are intact. */
+static CyBool_t
+CyFxMemBlockValid (
+        const CyFxMemTrack_t *track_p,
+        const MemBlockInfo   *block_p)
+{
+    uint32_t addr = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(block_p));
+
+    if ((addr < track_p->lowAddr) || (addr >= track_p->highAddr) ||
+            (block_p->alloc_size > track_p->highAddr - addr))
+        return CyFalse;
+
+    const uint32_t *endsig_p = reinterpret_cast<const uint32_t *>(
+            reinterpret_cast<const uint8_t *>(block_p) + block_p->alloc_size - sizeof (uint32_t));
+    return ((block_p->start_sig == CyFxMemCanary (block_p, CY_U3P_MEM_START_SIG)) &&
+            (*endsig_p == CyFxMemCanary (block_p, CY_U3P_MEM_END_SIG))) ? CyTrue : CyFalse;
+}
+
+/* Write the header and canaries of a newly allocated block, and link 1 in
+   glMemSamplePeriod blocks into the in-use list. */
+static void
+CyFxMemTrackAdd (
+        CyFxMemTrack_t *track_p,
+        MemBlockInfo   *block_p,
+        uint32_t        size,
+        uint32_t        id)
+{
+    block_p->alloc_id   = id;
+    block_p->alloc_size = size;
+    block_p->prev_blk   = 0;
+    block_p->next_blk   = 0;
+    block_p->start_sig  = CyFxMemCanary (block_p, CY_U3P_MEM_START_SIG);
+    block_p->pad[0]     = 0;
+    ((uint32_t *)block_p)[BYTE_TO_DWORD (size) - 1] = CyFxMemCanary (block_p, CY_U3P_MEM_END_SIG);
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    if (++track_p->sinceTracked >= glMemSamplePeriod)
+    {
+        track_p->sinceTracked = 0;
+        block_p->pad[0]       = CY_FX_MEM_BLOCK_TRACKED;
+        block_p->prev_blk     = *track_p->list_pp;
+        if (*track_p->list_pp != 0)
+            (*track_p->list_pp)->next_blk = block_p;
+        *track_p->list_pp     = block_p;
+    }
+    CyU3PVicEnableInterrupts (mask);
+}
+
+/* Whether a list pointer read from a block header is null or lies in the heap. */
+static inline CyBool_t
+CyFxMemLinkValid (
+        const CyFxMemTrack_t *track_p,
+        const MemBlockInfo   *link_p)
+{
+    uint32_t addr = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(link_p));
+    return ((link_p == 0) || ((addr >= track_p->lowAddr) && (addr < track_p->highAddr))) ? CyTrue : CyFalse;
+}
+
+/* Check the canaries of a block being freed and unlink it if it is tracked. A block
+   that fails the check is still unlinked when its header can be trusted that far: it
+   is freed by the caller anyway, and must not stay in the list walked by the checks. */
+static void
+CyFxMemTrackRemove (
+        CyFxMemTrack_t *track_p,
+        MemBlockInfo   *block_p,
+        void           *mem_p)
+{
+    if (!CyFxMemBlockValid (track_p, block_p))
+    {
+        /* Notify the user that memory has been corrupted. */
+        if (*track_p->badCb_p != 0)
+            (*track_p->badCb_p) (mem_p);
+    }
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    if ((block_p->pad[0] == CY_FX_MEM_BLOCK_TRACKED) && CyFxMemLinkValid (track_p, block_p->prev_blk) &&
+            CyFxMemLinkValid (track_p, block_p->next_blk))
+    {
+        if (block_p->next_blk != 0)
+            block_p->next_blk->prev_blk = block_p->prev_blk;
+        if (block_p->prev_blk != 0)
+            block_p->prev_blk->next_blk = block_p->next_blk;
+        if (*track_p->list_pp == block_p)
+            *track_p->list_pp = block_p->prev_blk;
+        if (track_p->cursor_p == block_p)
+            track_p->cursor_p = block_p->prev_blk;
+    }
+    else if (track_p->cursor_p == block_p)
+    {
+        /* Not unlinked: restart the walk from the newest block. */
+        track_p->cursor_p = 0;
+    }
+    CyU3PVicEnableInterrupts (mask);
+}
+
+/* Check up to maxBlocks tracked blocks from the cursor. */
+static CyU3PReturnStatus_t
+CyFxMemTrackStep (
+        CyFxMemTrack_t *track_p,
+        uint32_t        maxBlocks)
+{
+    MemBlockInfo *bad_p = 0;
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    for (uint32_t i = 0; i < maxBlocks; i++)
+    {
+        if (track_p->cursor_p == 0)
+        {
+            track_p->cursor_p = *track_p->list_pp;
+            if (track_p->cursor_p == 0)
+                break;
+        }
+
+        if (!CyFxMemBlockValid (track_p, track_p->cursor_p))
+        {
+            /* The list cannot be followed past a corrupted block: restart from the newest. */
+            bad_p = track_p->cursor_p;
+            track_p->cursor_p = 0;
+            break;
+        }
+
+        /* Stop at the end of a pass, so that a call never checks a block twice. */
+        track_p->cursor_p = track_p->cursor_p->prev_blk;
+        if (track_p->cursor_p == 0)
+            break;
+    }
+    CyU3PVicEnableInterrupts (mask);
+
+    if (bad_p != 0)
+    {
+        if (*track_p->badCb_p != 0)
+            (*track_p->badCb_p) ((void *)((uint8_t *)bad_p + sizeof (MemBlockInfo)));
+        return CY_U3P_ERROR_FAILURE;
+    }
+    return CY_U3P_SUCCESS;
+}
+
+/* Function     : CyFxMemCheckSampling
+ * Description  : Sets how many of the checked blocks are linked into the in-use lists
+ *                walked by the corruption checks. All blocks keep their canaries, which
+ *                are verified when they are freed.
+ * Parameters   :
+ *                period : Link 1 in period blocks; 1 links all of them.
+ * Return Value :
+ *                CY_U3P_SUCCESS if the period has been set.
+ *                CY_U3P_ERROR_BAD_ARGUMENT for a period of 0.
+ */
+CyU3PReturnStatus_t
+CyFxMemCheckSampling (
+        uint32_t period)
+{
+    if (period == 0)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    glMemSamplePeriod = period;
+    return CY_U3P_SUCCESS;
+}
+
+/* Function     : CyFxMemCorruptionCheckStep
+ * Description  : Checks the next maxBlocks tracked blocks of the driver heap, resuming
+ *                where the previous call stopped. The interrupts are masked for the
+ *                duration, so keep maxBlocks small.
+ * Parameters   :
+ *                maxBlocks : Number of blocks to check.
+ * Return Value : CY_U3P_SUCCESS or CY_U3P_ERROR_FAILURE depending on whether
+ *                corruption is found or not.
+ */
+CyU3PReturnStatus_t
+CyFxMemCorruptionCheckStep (
+        uint32_t maxBlocks)
+{
+    return CyFxMemTrackStep (&glMemTrack, maxBlocks);
+}
+
+/* Function     : CyFxBufCorruptionCheckStep
+ * Description  : Same as CyFxMemCorruptionCheckStep, for the buffer heap.
+ * Parameters   :
+ *                maxBlocks : Number of blocks to check.
+ * Return Value : CY_U3P_SUCCESS or CY_U3P_ERROR_FAILURE depending on whether
+ *                corruption is found or not.
+ */
+CyU3PReturnStatus_t
+CyFxBufCorruptionCheckStep (
+        uint32_t maxBlocks)
+{
+    return CyFxMemTrackStep (&glBufTrack, maxBlocks);
+}
+
 /* Function     : CyU3PMemEnableChecks
  * Description  : Enable memory leak and corruption checks in the driver heap allocator.
  *                Enabling the checks will cause the memory required for each allocated
@@ -252,10 +508,53 @@ CyU3PMemInit (
     if (!glMemPoolInit)
     {
 	glMemPoolInit = CyTrue;
+
+	/* The heaps start where the linker script stops placing data. In the compact map the
+	   exception and compiler heap areas belong to the heaps: check that the loaded image
+	   agrees with cyfxmemmap.h before handing the memory out. Nothing can be reported
+	   this early, so a mismatch stops here like the exception handlers. */
+#if !defined (CYFX_HOST_BUILD)
+	if ((reinterpret_cast<uintptr_t>(_bss_end) > CY_FX_MEM_DATA_BASE + CY_FX_MEM_DATA_SIZE) ||
+		(reinterpret_cast<uintptr_t>(__heap_end) - reinterpret_cast<uintptr_t>(__heap_start) != CY_FX_MEM_CHEAP_SIZE) ||
+		((CY_FX_MEM_CHEAP_SIZE == 0) && (reinterpret_cast<uintptr_t>(__heap_start) != CY_U3P_MEM_HEAP_BASE)))
+	{
+	    for (;;);
+	}
+#endif
+
+	/* The SDK thread stacks come from this heap: paint it so that their usage can be measured. */
+	CyFxUVCStackPaint ((void *)CY_U3P_MEM_HEAP_BASE, CY_U3P_MEM_HEAP_SIZE);
 	CyU3PBytePoolCreate (&glMemBytePool, (void *)CY_U3P_MEM_HEAP_BASE, CY_U3P_MEM_HEAP_SIZE);
     }
 }
 
+/* Function     : CyFxMemHeapInfoGet
+ * Description  : Reports the size of the driver heap and how much of it is free, so that
+ *                the heap can be sized from measurements.
+ * Parameters   :
+ *                size_p      : Filled with the heap size in bytes.
+ *                available_p : Filled with the number of free bytes.
+ *                fragments_p : Filled with the number of free fragments.
+ * Return Value : None
+ */
+void
+CyFxMemHeapInfoGet (
+        uint32_t *size_p,
+        uint32_t *available_p,
+        uint32_t *fragments_p)
+{
+    ULONG available = 0, fragments = 0;
+
+    if (glMemPoolInit)
+    {
+        tx_byte_pool_info_get (&glMemBytePool, NULL, &available, &fragments, NULL, NULL, NULL);
+    }
+
+    *size_p      = CY_U3P_MEM_HEAP_SIZE;
+    *available_p = available;
+    *fragments_p = fragments;
+}
+
 /* Function     : CyU3PMemAlloc
  * Description  : This function allocates memory required for various OS objects in the
  *                firmware application. This function is used by the SDK internal drivers
@@ -304,17 +603,7 @@ CyU3PMemAlloc (
         {
             /* Store the header information used for leak and corruption checks. */
             block_p = (MemBlockInfo *)ret_p;
-            block_p->alloc_id        = glMemAllocCnt++;
-            block_p->alloc_size      = size;
-            block_p->prev_blk        = glMemInUseList;
-            block_p->next_blk        = 0;
-            block_p->start_sig       = CY_U3P_MEM_START_SIG;
-            if (glMemInUseList != 0)
-                glMemInUseList->next_blk = block_p;
-            glMemInUseList           = block_p;
-
-            /* Add the end block signature as a footer. */
-            ((uint32_t *)block_p)[BYTE_TO_DWORD (size) - 1] = CY_U3P_MEM_END_SIG;
+            CyFxMemTrackAdd (&glMemTrack, block_p, size, glMemAllocCnt++);
 
             /* Update the return pointer to skip the header created. */
             ret_p = (void *)((uint8_t *)block_p + sizeof (MemBlockInfo));
@@ -338,7 +627,6 @@ CyU3PMemFree (
 {
 #ifdef CYFXTX_ERRORDETECTION
     MemBlockInfo *block_p;
-    uint32_t     *endsig_p;
 #endif
 
     /* Validity check for the pointer. */
@@ -350,28 +638,12 @@ CyU3PMemFree (
        the required book-keeping as well. */
     if (glMemEnableChecks)
     {
-        block_p  = reinterpret_cast<MemBlockInfo *>(static_cast<uint8_t *>(mem_p) - sizeof (MemBlockInfo));
-        endsig_p = reinterpret_cast<uint32_t *>(reinterpret_cast<uint8_t *>(block_p) + block_p->alloc_size - sizeof (uint32_t));
-
-        if ((block_p->start_sig != CY_U3P_MEM_START_SIG) || (*endsig_p != CY_U3P_MEM_END_SIG))
-        {
-            /* Notify the user that memory has been corrupted. */
-            if (glMemBadCb != 0)
-                glMemBadCb (mem_p);
-        }
+        block_p = reinterpret_cast<MemBlockInfo *>(static_cast<uint8_t *>(mem_p) - sizeof (MemBlockInfo));
 
+        /* Check the canaries and drop the block from the in-use list. */
+        CyFxMemTrackRemove (&glMemTrack, block_p, mem_p);
         glMemFreeCnt++;
 
-        /* Update the in-use linked list to drop the freed-up block. */
-        if (block_p->next_blk != 0)
-            block_p->next_blk->prev_blk = block_p->prev_blk;
-        if (block_p->prev_blk != 0)
-            block_p->prev_blk->next_blk = block_p->next_blk;
-        if (glMemInUseList == block_p)
-        {
-            glMemInUseList = block_p->prev_blk;
-        }
-
         mem_p = block_p;
     }
 #endif
@@ -432,7 +704,6 @@ CyU3PMemCorruptionCheck (
         void)
 {
     MemBlockInfo *block_p;
-    uint32_t     *mem_p;
 
     /* Run through all in-use memory blocks and send a callback for any blocks that do
        not match the start and end signatures.
@@ -440,11 +711,11 @@ CyU3PMemCorruptionCheck (
     block_p = glMemInUseList;
     while (block_p != 0)
     {
-        if (((uint32_t)block_p < CY_U3P_MEM_HEAP_BASE) || ((uint32_t)block_p >= CY_U3P_BUFFER_HEAP_BASE))
+        if ((static_cast<uint32_t>(reinterpret_cast<uintptr_t>(block_p)) < CY_U3P_MEM_HEAP_BASE) ||
+            (static_cast<uint32_t>(reinterpret_cast<uintptr_t>(block_p)) >= CY_U3P_BUFFER_HEAP_BASE))
             return CY_U3P_ERROR_FAILURE;
 
-        mem_p = (uint32_t *)((uint8_t *)block_p + block_p->alloc_size - sizeof (uint32_t));
-        if ((block_p->start_sig != CY_U3P_MEM_START_SIG) || (*mem_p != CY_U3P_MEM_END_SIG))
+        if (!CyFxMemBlockValid (&glMemTrack, block_p))
         {
             if (glMemBadCb != 0)
                 glMemBadCb ((void *)((uint8_t *)block_p + sizeof (MemBlockInfo)));
@@ -514,8 +785,9 @@ CyU3PMemSet (
  *                src   : Pointer to source memory block.
  *                count : Size of memory block.
  * Return Value : None
+ *                Placed in I-TCM, as the streaming loop copies every buffer with it.
  */
-void
+void CY_FX_HOT_CODE
 CyU3PMemCopy (
         uint8_t  *dest, 
         uint8_t  *src,
@@ -750,6 +1022,7 @@ CyU3PDmaBufferDeInit (
     glBufAllocCnt  = 0;
     glBufFreeCnt   = 0;
     glBufInUseList = 0;
+    glBufTrack.cursor_p = 0;
 #endif
 
     /* Free up and destroy the mutex variable. */
@@ -757,6 +1030,19 @@ CyU3PDmaBufferDeInit (
     CyU3PMutexDestroy (&glBufferManager.lock);
 }
 
+/* Function    : CyFxDmaBufferLockGet
+ * Description : Returns the mutex serializing the DMA buffer allocations, so that its
+ *               contention can be reported in profiling builds. NULL before the buffer
+ *               manager is initialized.
+ * Parameters  : None
+ */
+CyU3PMutex *
+CyFxDmaBufferLockGet (
+        void)
+{
+    return (glBufferManager.usedStatus != 0) ? &glBufferManager.lock : NULL;
+}
+
 /* Function    : CyU3PDmaBufMgrSetStatus
  * Description : Helper function for the DMA buffer manager. Used to set/clear
  *               a set of status bits from the alloc/free functions.
@@ -852,6 +1138,21 @@ CyU3PDmaBufferAlloc (
         return ptr;
     }
 
+    /* Carve the buffers of the arena owner from the arena, cache line aligned. */
+    if ((glBufArenaOpen) && (CyU3PThreadIdentify () == glBufArenaOwner))
+    {
+        tmp = ROUND_UP (blk_size, FX3_CACHE_LINE_SZ);
+        if (tmp <= glBufArenaEnd - glBufArenaTop)
+        {
+            ptr = reinterpret_cast<void *>(static_cast<uintptr_t>(glBufArenaTop));
+            glBufArenaTop += tmp;
+            glBufArenaLive++;
+            CyU3PMutexPut (&glBufferManager.lock);
+            return ptr;
+        }
+        glBufArenaFallbacks++;
+    }
+
 #ifdef CYFXTX_ERRORDETECTION
     if (glBufMgrEnableChecks)
     {
@@ -914,24 +1215,14 @@ CyU3PDmaBufferAlloc (
     {
         /* Mark the memory region identified as occupied and return the pointer. */
         CyU3PDmaBufMgrSetStatus (start, size - 1, CyTrue);
-        ptr = (void *)(glBufferManager.startAddr + (start << 5));
+        ptr = reinterpret_cast<void *>(static_cast<uintptr_t>(glBufferManager.startAddr + (start << 5)));
 
 #ifdef CYFXTX_ERRORDETECTION
         if (glBufMgrEnableChecks)
         {
             /* Store the header information used for leak and corruption checks. */
             block_p = (MemBlockInfo *)ptr;
-            block_p->alloc_id        = glBufAllocCnt++;
-            block_p->alloc_size      = blk_size;
-            block_p->prev_blk        = glBufInUseList;
-            block_p->next_blk        = 0;
-            block_p->start_sig       = CY_U3P_MEM_START_SIG;
-            if (glBufInUseList != 0)
-                glBufInUseList->next_blk = block_p;
-            glBufInUseList           = block_p;
-
-            /* Add the end block signature as a footer. */
-            ((uint32_t *)block_p)[BYTE_TO_DWORD (blk_size) - 1] = CY_U3P_MEM_END_SIG;
+            CyFxMemTrackAdd (&glBufTrack, block_p, blk_size, glBufAllocCnt++);
 
             /* Update the return pointer to skip the header created. */
             ptr = (void *)((uint8_t *)block_p + sizeof (MemBlockInfo));
@@ -955,7 +1246,6 @@ CyU3PDmaBufferFree (
 {
 #ifdef CYFXTX_ERRORDETECTION
     MemBlockInfo *block_p;
-    uint32_t     *sig_p;
 #endif
 
     uint32_t status, start, count;
@@ -981,31 +1271,25 @@ CyU3PDmaBufferFree (
         return retVal;
     }
 
+    /* Buffers carved from the arena go back with the whole block. */
+    start = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(buffer));
+    if ((start >= glBufArenaStart) && (start < glBufArenaTop))
+    {
+        glBufArenaLive--;
+        CyU3PMutexPut (&glBufferManager.lock);
+        return 0;
+    }
+
 #ifdef CYFXTX_ERRORDETECTION
     /* Update the structures used for leak checking. */
     if (glBufMgrEnableChecks)
     {
         block_p = reinterpret_cast<MemBlockInfo *>(static_cast<uint8_t *>(buffer) - sizeof (MemBlockInfo));
-        sig_p   = reinterpret_cast<uint32_t *>(reinterpret_cast<uint8_t *>(block_p) + block_p->alloc_size - sizeof (uint32_t));
-        if ((block_p->start_sig != CY_U3P_MEM_START_SIG) || (*sig_p != CY_U3P_MEM_END_SIG))
-        {
-            /* Notify the user that memory has been corrupted. */
-            if (glBufBadCb != 0)
-                glBufBadCb (buffer);
-        }
 
+        /* Check the canaries and drop the block from the in-use list. */
+        CyFxMemTrackRemove (&glBufTrack, block_p, buffer);
         glBufFreeCnt++;
 
-        /* Update the in-use linked list to drop the freed-up block. */
-        if (block_p->next_blk != 0)
-            block_p->next_blk->prev_blk = block_p->prev_blk;
-        if (block_p->prev_blk != 0)
-            block_p->prev_blk->next_blk = block_p->next_blk;
-        if (glBufInUseList == block_p)
-        {
-            glBufInUseList = block_p->prev_blk;
-        }
-
         buffer = block_p;
     }
 #endif
@@ -1045,6 +1329,160 @@ CyU3PDmaBufferFree (
     return retVal;
 }
 
+/* Function     : CyFxDmaBufferArenaBegin
+ * Description  : Reserves a block of the buffer heap for a streaming session. Until
+ *                CyFxDmaBufferArenaEnd, the buffer allocations of the calling thread are
+ *                carved from it.
+ * Parameters   :
+ *                size : Size of the block in bytes.
+ * Return Value : CY_U3P_SUCCESS if the block has been reserved.
+ *                CY_U3P_ERROR_ALREADY_STARTED if a block is already reserved.
+ *                CY_U3P_ERROR_MEMORY_ERROR if the buffer heap cannot supply the block.
+ */
+CyU3PReturnStatus_t
+CyFxDmaBufferArenaBegin (
+        uint16_t size)
+{
+    if (glBufArenaStart != 0)
+    {
+        return CY_U3P_ERROR_ALREADY_STARTED;
+    }
+
+    /* The block itself comes from the heap, so it is taken before the arena is opened. */
+    void *block_p = CyU3PDmaBufferAlloc (size);
+    if (block_p == NULL)
+    {
+        return CY_U3P_ERROR_MEMORY_ERROR;
+    }
+
+    if (CyU3PMutexGet (&glBufferManager.lock, CYU3P_WAIT_FOREVER) != CY_U3P_SUCCESS)
+    {
+        CyU3PDmaBufferFree (block_p);
+        return CY_U3P_ERROR_MUTEX_FAILURE;
+    }
+    glBufArenaStart = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(block_p));
+    glBufArenaTop   = glBufArenaStart;
+    glBufArenaEnd   = glBufArenaStart + ROUND_UP (size, FX3_CACHE_LINE_SZ);
+    glBufArenaOwner = CyU3PThreadIdentify ();
+    glBufArenaOpen  = CyTrue;
+    glBufArenaLive  = 0;
+    CyU3PMutexPut (&glBufferManager.lock);
+
+    return CY_U3P_SUCCESS;
+}
+
+/* Function     : CyFxDmaBufferArenaEnd
+ * Description  : Stops carving buffer allocations from the arena. The block stays reserved
+ *                until CyFxDmaBufferArenaRelease.
+ * Parameters   : None
+ */
+void
+CyFxDmaBufferArenaEnd (
+        void)
+{
+    if (CyU3PMutexGet (&glBufferManager.lock, CYU3P_WAIT_FOREVER) == CY_U3P_SUCCESS)
+    {
+        glBufArenaOpen = CyFalse;
+        CyU3PMutexPut (&glBufferManager.lock);
+    }
+}
+
+/* Function     : CyFxDmaBufferArenaRelease
+ * Description  : Returns the arena block to the buffer heap in a single free.
+ * Parameters   : None
+ * Return Value : CY_U3P_SUCCESS if the block has been released, or if none was reserved.
+ *                CY_U3P_ERROR_INVALID_SEQUENCE if buffers carved from it are still in use;
+ *                the block is kept.
+ */
+CyU3PReturnStatus_t
+CyFxDmaBufferArenaRelease (
+        void)
+{
+    if (CyU3PMutexGet (&glBufferManager.lock, CYU3P_WAIT_FOREVER) != CY_U3P_SUCCESS)
+    {
+        return CY_U3P_ERROR_MUTEX_FAILURE;
+    }
+    if (glBufArenaLive != 0)
+    {
+        CyU3PMutexPut (&glBufferManager.lock);
+        return CY_U3P_ERROR_INVALID_SEQUENCE;
+    }
+
+    uint32_t start = glBufArenaStart;
+    glBufArenaStart = glBufArenaTop = glBufArenaEnd = 0;
+    glBufArenaOwner = NULL;
+    glBufArenaOpen  = CyFalse;
+    if (start != 0)
+    {
+        glBufArenaSessions++;
+    }
+    CyU3PMutexPut (&glBufferManager.lock);
+
+    if (start != 0)
+    {
+        CyU3PDmaBufferFree (reinterpret_cast<void *>(static_cast<uintptr_t>(start)));
+    }
+    return CY_U3P_SUCCESS;
+}
+
+/* Function     : CyFxDmaBufferHeapInfoGet
+ * Description  : Reports the buffer heap usage from the allocation bitmap, so that its
+ *                fragmentation can be followed across streaming sessions. Each allocation
+ *                leaves one free cache line after it as an end marker; these count as runs.
+ * Parameters   :
+ *                size_p      : Filled with the heap size in bytes.
+ *                available_p : Filled with the number of free bytes.
+ *                fragments_p : Filled with the number of free runs.
+ *                largest_p   : Filled with the size of the longest free run in bytes.
+ *                sessions_p  : Filled with the number of arena blocks released.
+ *                fallbacks_p : Filled with the number of allocations that did not fit an arena.
+ * Return Value : None
+ */
+void
+CyFxDmaBufferHeapInfoGet (
+        uint32_t *size_p,
+        uint32_t *available_p,
+        uint32_t *fragments_p,
+        uint32_t *largest_p,
+        uint32_t *sessions_p,
+        uint32_t *fallbacks_p)
+{
+    uint32_t freeLines = 0, runs = 0, run = 0, largest = 0;
+
+    *size_p = CY_U3P_BUFFER_HEAP_SIZE;
+    if (CyU3PMutexGet (&glBufferManager.lock, CYU3P_WAIT_FOREVER) == CY_U3P_SUCCESS)
+    {
+        for (uint32_t line = 0; line < CY_U3P_BUFFER_HEAP_SIZE / FX3_CACHE_LINE_SZ; line++)
+        {
+            if ((glBufferManager.usedStatus[line >> 5] & (1u << (line & 31))) == 0)
+            {
+                freeLines++;
+                run++;
+                if (run == 1)
+                {
+                    runs++;
+                }
+                largest = CY_U3P_MAX (largest, run);
+            }
+            else
+            {
+                run = 0;
+            }
+        }
+        *sessions_p  = glBufArenaSessions;
+        *fallbacks_p = glBufArenaFallbacks;
+        CyU3PMutexPut (&glBufferManager.lock);
+    }
+    else
+    {
+        *sessions_p = *fallbacks_p = 0;
+    }
+
+    *available_p = freeLines * FX3_CACHE_LINE_SZ;
+    *fragments_p = runs;
+    *largest_p   = largest * FX3_CACHE_LINE_SZ;
+}
+
 /* Function    : CyU3PFreeHeaps
  * Description : This function de-initializes both driver and buffer heap allocators.
  *               This is called from the SDK library and is not expected to be called
@@ -1066,6 +1504,7 @@ CyU3PFreeHeaps (
     glMemAllocCnt  = 0;
     glMemFreeCnt   = 0;
     glMemInUseList = 0;
+    glMemTrack.cursor_p = 0;
 #endif
 }
 
@@ -1120,7 +1559,6 @@ CyU3PBufCorruptionCheck (
         void)
 {
     MemBlockInfo *block_p;
-    uint32_t     *mem_p;
 
     /* Run through all in-use memory blocks and send a callback for any blocks that do
        not match the start and end signatures.
@@ -1128,11 +1566,11 @@ CyU3PBufCorruptionCheck (
     block_p = glBufInUseList;
     while (block_p != 0)
     {
-        if (((uint32_t)block_p < CY_U3P_BUFFER_HEAP_BASE) || ((uint32_t)block_p >= CY_U3P_SYS_MEM_TOP))
+        if ((static_cast<uint32_t>(reinterpret_cast<uintptr_t>(block_p)) < CY_U3P_BUFFER_HEAP_BASE) ||
+            (static_cast<uint32_t>(reinterpret_cast<uintptr_t>(block_p)) >= CY_U3P_SYS_MEM_TOP))
             return CY_U3P_ERROR_FAILURE;
 
-        mem_p = (uint32_t *)((uint8_t *)block_p + block_p->alloc_size - sizeof (uint32_t));
-        if ((block_p->start_sig != CY_U3P_MEM_START_SIG) || (*mem_p != CY_U3P_MEM_END_SIG))
+        if (!CyFxMemBlockValid (&glBufTrack, block_p))
         {
             if (glBufBadCb != 0)
                 glBufBadCb ((void *)((uint8_t *)block_p + sizeof (MemBlockInfo)));
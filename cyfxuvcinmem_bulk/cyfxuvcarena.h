@@ -0,0 +1,52 @@
+/*
+ ## UVC application streaming session arena (cyfxuvcarena.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCARENA_H_
+#define _INCLUDED_CYFXUVCARENA_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* One block of the buffer heap reserved for the life of a streaming session. Between
+ * CyFxDmaBufferArenaBegin and CyFxDmaBufferArenaEnd, the CyU3PDmaBufferAlloc calls made
+ * by the thread that began the arena (the DMA channel buffers created by
+ * CyFxUVCApplnStart) are carved from the block by bumping a pointer; CyU3PDmaBufferFree
+ * of those buffers only counts them. CyFxDmaBufferArenaRelease gives the whole block
+ * back in one free, so a start / stop cycle leaves the buffer heap as it found it
+ * whatever was allocated in between. Allocations that do not fit fall back to the heap
+ * and are counted. Defined in cyfxtx.cpp. */
+
+/* Reserve size bytes and serve the calling thread's buffer allocations from them. */
+extern CyU3PReturnStatus_t
+CyFxDmaBufferArenaBegin (
+        uint16_t size);
+
+/* Stop serving allocations from the arena; the block stays reserved. */
+extern void
+CyFxDmaBufferArenaEnd (
+        void);
+
+/* Give the block back to the buffer heap. The buffers carved from it must have been
+ * freed: CY_U3P_ERROR_INVALID_SEQUENCE and the block is kept otherwise. */
+extern CyU3PReturnStatus_t
+CyFxDmaBufferArenaRelease (
+        void);
+
+/* Buffer heap usage, for the report: free bytes, the number of free runs and the
+ * longest one, and the arena sessions released and allocations that fell back. */
+extern void
+CyFxDmaBufferHeapInfoGet (
+        uint32_t *size_p,
+        uint32_t *available_p,
+        uint32_t *fragments_p,
+        uint32_t *largest_p,
+        uint32_t *sessions_p,
+        uint32_t *fallbacks_p);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCARENA_H_ */
+
+/*[]*/
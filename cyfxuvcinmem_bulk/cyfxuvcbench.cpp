@@ -0,0 +1,184 @@
+/*
+ ## UVC application copy path benchmark (cyfxuvcbench.cpp)
+ ## ===========================
+*/
+
+/* Every case walks the frame store from the start, one streaming payload per round, so
+ * the source is read once per round as in the streaming loop. With the D-cache on it is
+ * cleaned and emptied before each case: every case starts cold and none profits from
+ * the lines the previous one brought in. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3mmu.h"
+#include "cyfxuvcinmem.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcbench.h"
+#include "cyfxuvccopy.h"
+#include "cyfxmemmap.h"
+
+#ifdef CYU3P_PROFILE_EN
+
+static volatile uint32_t glBenchStateSysmem = 0;                  /* State word in the data area. */
+CY_FX_HOT_DATA static volatile uint32_t glBenchStateDtcm = 0;     /* State word in D-TCM. */
+
+/* Payload bytes of a full streaming buffer. */
+constexpr uint32_t CY_FX_UVC_BENCH_PAYLOAD = CY_FX_UVC_STREAM_BUF_SIZE - CY_FX_UVC_HEADER_LEN;
+
+static void
+CyFxUVCBenchAdd (
+        CyFxUVCBenchResult_t *result_p,
+        uint32_t bytes,
+        uint32_t ticks)
+{
+    result_p->bytes       = bytes;
+    result_p->totalTicks += ticks;
+    if (ticks < result_p->minTicks)
+    {
+        result_p->minTicks = ticks;
+    }
+    if (ticks > result_p->maxTicks)
+    {
+        result_p->maxTicks = ticks;
+    }
+}
+
+/* Run the rounds of one case, source offset by source offset. */
+static void
+CyFxUVCBenchCase (
+        CyFxUVCBenchCase_t benchCase,
+        CyFxUVCBenchResult_t *result_p,
+        uint8_t *buffer_p,
+        uint32_t frameBytes)
+{
+    uint32_t offset = 0;
+    volatile uint32_t sink = 0;
+
+#ifdef CY_FX_UVC_DCACHE_EN
+    CyU3PSysClearDCache ();
+#endif
+    result_p->minTicks = 0xFFFFFFFF;
+
+    for (uint32_t round = 0; round < CY_FX_UVC_BENCH_ROUNDS; round++)
+    {
+        uint8_t *src_p = const_cast<uint8_t *>(&glUVCVidFrames[offset]);
+        uint32_t start = CyFxUVCClockTicks ();
+        uint32_t bytes = CY_FX_UVC_BENCH_PAYLOAD;
+
+        switch (benchCase)
+        {
+            case CY_FX_UVC_BENCH_READ:
+                {
+                    /* Round the source down to a word; the payload offsets are not aligned. */
+                    const uint32_t *word_p = reinterpret_cast<const uint32_t *>(
+                            reinterpret_cast<uintptr_t>(src_p) & ~static_cast<uintptr_t>(3));
+                    uint32_t sum = 0;
+
+                    bytes &= ~3u;
+                    for (uint32_t i = 0; i < bytes / sizeof (uint32_t); i++)
+                    {
+                        sum += word_p[i];
+                    }
+                    sink = sum;
+                }
+                break;
+
+            case CY_FX_UVC_BENCH_WRITE:
+                {
+                    uint32_t *word_p = reinterpret_cast<uint32_t *>(buffer_p);
+
+                    bytes = CY_FX_UVC_STREAM_BUF_SIZE;
+                    for (uint32_t i = 0; i < bytes / sizeof (uint32_t); i++)
+                    {
+                        word_p[i] = round;
+                    }
+                }
+                break;
+
+            case CY_FX_UVC_BENCH_MEMCOPY:
+                CyU3PMemCopy (buffer_p + CY_FX_UVC_HEADER_LEN, src_p, bytes);
+                break;
+
+            case CY_FX_UVC_BENCH_WORDCOPY:
+                CyFxUVCCopy (buffer_p + CY_FX_UVC_HEADER_LEN, src_p, bytes);
+                break;
+
+            case CY_FX_UVC_BENCH_STATE_SYSMEM:
+            case CY_FX_UVC_BENCH_STATE_DTCM:
+                {
+                    volatile uint32_t *state_p = (benchCase == CY_FX_UVC_BENCH_STATE_DTCM) ?
+                        &glBenchStateDtcm : &glBenchStateSysmem;
+
+                    bytes = CY_FX_UVC_BENCH_STATE_OPS * sizeof (uint32_t);
+                    for (uint32_t i = 0; i < CY_FX_UVC_BENCH_STATE_OPS; i++)
+                    {
+                        *state_p = *state_p + 1;
+                    }
+                }
+                break;
+
+            default:
+                CyFxUVCCopy (buffer_p + CY_FX_UVC_HEADER_LEN, src_p, bytes);
+#ifdef CY_FX_UVC_DCACHE_EN
+                CyU3PSysCleanDRegion (reinterpret_cast<uint32_t *>(buffer_p), CY_FX_UVC_STREAM_BUF_SIZE);
+#endif
+                break;
+        }
+        CyFxUVCBenchAdd (result_p, bytes, CyFxUVCClockTicks () - start);
+
+        offset += CY_FX_UVC_BENCH_PAYLOAD;
+        if (offset + CY_FX_UVC_BENCH_PAYLOAD > frameBytes)
+        {
+            offset = 0;
+        }
+    }
+    (void)sink;
+}
+
+void
+CyFxUVCBenchRun (
+        CyFxUVCBench_t *bench_p)
+{
+    uint32_t frameBytes = 0;
+    uint8_t *buffer_p;
+
+    CyU3PMemSet ((uint8_t *)bench_p, 0, sizeof (*bench_p));
+    bench_p->version   = CY_FX_UVC_BENCH_VERSION;
+    bench_p->length    = sizeof (CyFxUVCBench_t);
+    bench_p->clockHz   = CyFxUVCClockHz ();
+    bench_p->dcache    = CY_FX_UVC_DCACHE ? 1 : 0;
+    bench_p->rounds    = CY_FX_UVC_BENCH_ROUNDS;
+    bench_p->caseCount = CY_FX_UVC_BENCH_COUNT;
+    bench_p->stateOps  = CY_FX_UVC_BENCH_STATE_OPS;
+
+    for (uint32_t i = 0; i < CY_FX_UVC_MAX_VID_FRAMES; i++)
+    {
+        frameBytes += glVidFrameLen[i];
+    }
+    if (frameBytes < CY_FX_UVC_BENCH_PAYLOAD)
+    {
+        bench_p->status = CY_U3P_ERROR_BAD_ARGUMENT;
+        return;
+    }
+
+    buffer_p = static_cast<uint8_t *>(CyU3PDmaBufferAlloc (CY_FX_UVC_STREAM_BUF_SIZE));
+    if (buffer_p == NULL)
+    {
+        bench_p->status = CY_U3P_ERROR_MEMORY_ERROR;
+        return;
+    }
+
+    for (uint32_t c = 0; c < CY_FX_UVC_BENCH_COUNT; c++)
+    {
+        CyFxUVCBenchCase (static_cast<CyFxUVCBenchCase_t>(c), &bench_p->result[c], buffer_p, frameBytes);
+    }
+
+    CyU3PDmaBufferFree (buffer_p);
+    bench_p->status = CY_U3P_SUCCESS;
+}
+
+#endif /* CYU3P_PROFILE_EN */
+
+/*[]*/
@@ -0,0 +1,73 @@
+/*
+ ## UVC application copy path benchmark (cyfxuvcbench.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCBENCH_H_
+#define _INCLUDED_CYFXUVCBENCH_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* Memory bandwidth of the streaming copy path, measured on the device. Each case moves
+ * CY_FX_UVC_BENCH_ROUNDS buffers' worth of payload between the frame store and a DMA
+ * buffer from the buffer heap, timed with the timestamp clock. Run it once on a build
+ * with the D-cache off and once with CY_FX_UVC_DCACHE=1 to compare; the dcache field
+ * says which one answered. The two STATE cases time the accesses the streaming loop
+ * makes to its own state (header, channel handle, flags) in the data area and in D-TCM;
+ * the difference per access times the accesses per buffer is the saving per buffer. The
+ * benchmark runs in the control request, so do not run it while streaming. Profile
+ * builds only, through the CY_FX_UVC_VENDOR_RQT_GET_BENCH vendor request;
+ * CyFxUVCBench_t below is the wire format. */
+
+constexpr uint32_t CY_FX_UVC_BENCH_VERSION = 3;        // Layout version of CyFxUVCBench_t
+constexpr uint32_t CY_FX_UVC_BENCH_ROUNDS = 32;        // Buffers moved per case
+constexpr uint32_t CY_FX_UVC_BENCH_STATE_OPS = 1024;   // State updates per round of the STATE cases
+
+/* Measured cases. */
+enum CyFxUVCBenchCase_t
+{
+    CY_FX_UVC_BENCH_READ = 0,   /* Word reads of the frame store. */
+    CY_FX_UVC_BENCH_WRITE,      /* Word writes to the DMA buffer. */
+    CY_FX_UVC_BENCH_MEMCOPY,    /* CyU3PMemCopy from the frame store to the DMA buffer. */
+    CY_FX_UVC_BENCH_COMMIT,     /* The streaming loop copy followed by the cache clean done before a commit. */
+    CY_FX_UVC_BENCH_STATE_SYSMEM, /* Read-modify-writes of a state word in the data area. */
+    CY_FX_UVC_BENCH_STATE_DTCM, /* The same on a CY_FX_HOT_DATA word (D-TCM unless CY_FX_HOT_DATA=0). */
+    CY_FX_UVC_BENCH_WORDCOPY,   /* CyFxUVCCopy from the frame store to the DMA buffer. */
+    CY_FX_UVC_BENCH_COUNT
+};
+
+struct CyFxUVCBenchResult_t
+{
+    uint32_t bytes;                     // Bytes moved by one round
+    uint32_t totalTicks;                // All the rounds
+    uint32_t minTicks;                  // Fastest round
+    uint32_t maxTicks;                  // Slowest round
+};
+
+struct CyFxUVCBench_t
+{
+    uint32_t version;                   // CY_FX_UVC_BENCH_VERSION
+    uint32_t length;                    // Size of the block in bytes
+    uint32_t status;                    // CY_U3P_SUCCESS, or why the benchmark did not run
+    uint32_t clockHz;                   // Frequency of the timestamp clock
+    uint32_t dcache;                    // 1 if the D-cache is enabled
+    uint32_t rounds;                    // CY_FX_UVC_BENCH_ROUNDS
+    uint32_t caseCount;                 // CY_FX_UVC_BENCH_COUNT
+    uint32_t stateOps;                  // CY_FX_UVC_BENCH_STATE_OPS
+    CyFxUVCBenchResult_t result[CY_FX_UVC_BENCH_COUNT];
+};
+
+static_assert (sizeof (CyFxUVCBench_t) == (8 + CY_FX_UVC_BENCH_COUNT * 4) * sizeof (uint32_t),
+        "CyFxUVCBench_t must be a packed array of 32-bit words");
+
+/* Run all the cases. Takes a few milliseconds and a DMA buffer from the buffer heap. */
+extern void
+CyFxUVCBenchRun (
+        CyFxUVCBench_t *bench_p);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCBENCH_H_ */
+
+/*[]*/
@@ -0,0 +1,56 @@
+/*
+ ## UVC application boot timeline (cyfxuvcboot.cpp)
+ ## ===========================
+*/
+
+/* Phases are stamped from the application thread and from the USB event callback, so
+ * each stamp is taken with the interrupts masked. The timeline lives in .bss and is
+ * zeroed by the startup code before the first stamp. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3vic.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcboot.h"
+
+static CyFxUVCBoot_t glBoot;        /* Timeline; the header fields are filled in by the snapshot. */
+
+void
+CyFxUVCBootMark (
+        CyFxUVCBootPhase_t phase)
+{
+    uint32_t bit = 1u << phase;
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    if ((glBoot.reachedMask & bit) == 0)
+    {
+        glBoot.reachedMask |= bit;
+        glBoot.osMs[phase] = static_cast<uint32_t>(CyU3PGetTime ());
+        if (CyFxUVCClockHz () != 0)
+        {
+            glBoot.ticksMask |= bit;
+            glBoot.ticks[phase] = CyFxUVCClockTicks ();
+        }
+    }
+
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void
+CyFxUVCBootSnapshot (
+        CyFxUVCBoot_t *boot_p)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    *boot_p = glBoot;
+    CyU3PVicEnableInterrupts (mask);
+
+    boot_p->version    = CY_FX_UVC_BOOT_VERSION;
+    boot_p->length     = sizeof (CyFxUVCBoot_t);
+    boot_p->clockHz    = CyFxUVCClockHz ();
+#ifdef CY_FX_UVC_FAST_BOOT_EN
+    boot_p->fastBoot   = 1;
+#endif
+    boot_p->phaseCount = CY_FX_UVC_BOOT_COUNT;
+}
+
+/*[]*/
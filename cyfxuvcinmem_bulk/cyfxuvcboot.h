@@ -0,0 +1,69 @@
+/*
+ ## UVC application boot timeline (cyfxuvcboot.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCBOOT_H_
+#define _INCLUDED_CYFXUVCBOOT_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* Time at which each boot phase was first reached, from the RTOS start to the first
+ * SET_CONFIGURATION. Every phase is stamped with the OS time in ms and, once the
+ * timestamp clock runs, with clock ticks for the finer steps. The phases before the
+ * RTOS starts (BSS clear, CyU3PDeviceInit, IO matrix) run before any timer is available
+ * and are not covered: they end at the KERNEL phase. Read with the
+ * CY_FX_UVC_VENDOR_RQT_GET_BOOT vendor request; CyFxUVCBoot_t below is the wire format.
+ *
+ * The fast boot build (make CY_FX_UVC_FAST_BOOT=1) starts USB before the debug UART,
+ * so the host sees the device while the UART DMA channel is still being set up. */
+
+constexpr uint32_t CY_FX_UVC_BOOT_VERSION = 1;         // Layout version of CyFxUVCBoot_t
+
+/* Boot phases, in the order of the default build. */
+enum CyFxUVCBootPhase_t
+{
+    CY_FX_UVC_BOOT_KERNEL = 0,  /* CyFxApplicationDefine: RTOS and SDK drivers started. */
+    CY_FX_UVC_BOOT_THREAD,      /* UVC application thread running. */
+    CY_FX_UVC_BOOT_DEBUG,       /* Debug UART initialized. */
+    CY_FX_UVC_BOOT_CLOCK,       /* Timestamp clock started. */
+    CY_FX_UVC_BOOT_USB_START,   /* CyU3PUsbStart done. */
+    CY_FX_UVC_BOOT_DESCRIPTORS, /* Descriptors and the status endpoint set. */
+    CY_FX_UVC_BOOT_CONNECT,     /* CyU3PConnectState done: visible to the host. */
+    CY_FX_UVC_BOOT_USB_RESET,   /* First bus reset from the host. */
+    CY_FX_UVC_BOOT_SETCONF,     /* First SET_CONFIGURATION: enumeration complete. */
+    CY_FX_UVC_BOOT_COUNT
+};
+
+struct CyFxUVCBoot_t
+{
+    uint32_t version;                   // CY_FX_UVC_BOOT_VERSION
+    uint32_t length;                    // Size of the block in bytes
+    uint32_t clockHz;                   // Frequency of the timestamp clock
+    uint32_t fastBoot;                  // 1 for a CY_FX_UVC_FAST_BOOT build
+    uint32_t phaseCount;                // CY_FX_UVC_BOOT_COUNT
+    uint32_t reachedMask;               // Bit n set if phase n was reached
+    uint32_t ticksMask;                 // Bit n set if ticks[n] is valid (clock running)
+    uint32_t osMs[CY_FX_UVC_BOOT_COUNT];    // OS time of each phase
+    uint32_t ticks[CY_FX_UVC_BOOT_COUNT];   // Timestamp clock of each phase
+};
+
+static_assert (sizeof (CyFxUVCBoot_t) == (7 + 2 * CY_FX_UVC_BOOT_COUNT) * sizeof (uint32_t),
+        "CyFxUVCBoot_t must be a packed array of 32-bit words");
+
+/* Stamp a phase; only the first call for each phase counts. */
+extern void
+CyFxUVCBootMark (
+        CyFxUVCBootPhase_t phase);
+
+/* Copy of the timeline. */
+extern void
+CyFxUVCBootSnapshot (
+        CyFxUVCBoot_t *boot_p);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCBOOT_H_ */
+
+/*[]*/
@@ -0,0 +1,72 @@
+/*
+ ## UVC application free-running timestamp clock (cyfxuvcclock.cpp)
+ ## ===========================
+*/
+
+#include "cyu3system.h"
+#include "cyu3error.h"
+#include "cyu3gpio.h"
+#include "cyfxuvcclock.h"
+
+static uint32_t glClockHz = 0;          /* Frequency of the timestamp counter. */
+
+/* This function configures the GPIO block clocks and starts the free-running timer
+ * of the complex GPIO reserved for timestamps. The IO matrix must have the pin
+ * enabled as a complex GPIO. */
+CyU3PReturnStatus_t
+CyFxUVCClockInit (
+        void)
+{
+    CyU3PGpioClock_t gpioClock;
+    CyU3PGpioComplexConfig_t gpioConfig;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+    uint32_t sysClk = 0;
+
+    /* Fast clock = SYS_CLK / 2 / CY_FX_UVC_CLOCK_FAST_DIV (96 MHz for a 384 MHz SYS_CLK). */
+    gpioClock.fastClkDiv = CY_FX_UVC_CLOCK_FAST_DIV;
+    gpioClock.slowClkDiv = 0;
+    gpioClock.halfDiv    = CyFalse;
+    gpioClock.simpleDiv  = CY_U3P_GPIO_SIMPLE_DIV_BY_2;
+    gpioClock.clkSrc     = CY_U3P_SYS_CLK_BY_2;
+    apiRetStatus = CyU3PGpioInit (&gpioClock, NULL);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        return apiRetStatus;
+    }
+
+    /* Tri-stated pin, timer counting the fast clock over the full 32-bit range. */
+    gpioConfig.outValue    = CyFalse;
+    gpioConfig.driveLowEn  = CyFalse;
+    gpioConfig.driveHighEn = CyFalse;
+    gpioConfig.inputEn     = CyFalse;
+    gpioConfig.pinMode     = CY_U3P_GPIO_MODE_STATIC;
+    gpioConfig.intrMode    = CY_U3P_GPIO_NO_INTR;
+    gpioConfig.timerMode   = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+    gpioConfig.timer       = 0;
+    gpioConfig.period      = 0xFFFFFFFF;
+    gpioConfig.threshold   = 0xFFFFFFFF;
+    apiRetStatus = CyU3PGpioSetComplexConfig (CY_FX_UVC_CLOCK_GPIO, &gpioConfig);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        return apiRetStatus;
+    }
+
+    apiRetStatus = CyU3PDeviceGetSysClkFreq (&sysClk);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        return apiRetStatus;
+    }
+
+    glClockHz = sysClk / 2 / CY_FX_UVC_CLOCK_FAST_DIV;
+    return CY_U3P_SUCCESS;
+}
+
+/* Frequency of the timestamp counter in Hz; zero until the clock is started. */
+uint32_t
+CyFxUVCClockHz (
+        void)
+{
+    return glClockHz;
+}
+
+/*[]*/
@@ -0,0 +1,86 @@
+/*
+ ## UVC application free-running timestamp clock (cyfxuvcclock.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCCLOCK_H_
+#define _INCLUDED_CYFXUVCCLOCK_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+#include <cyu3error.h>
+#include <cyu3gpio.h>
+#include <cyu3utils.h>
+#ifndef CYFX_HOST_BUILD
+#include <cyu3vic.h>
+#include <gpio_regs.h>
+#endif
+
+/* The timestamp clock is the timer of a complex GPIO running from the GPIO fast clock.
+ * The pin itself is left tri-stated; only the 32-bit timer is used. The counter wraps
+ * around, so durations must be computed as unsigned differences of two readings.
+ *
+ * The timer runs in the GPIO clock domain and is read through a SAMPLE_NOW command,
+ * which latches the count into the threshold register. The command sequence is not
+ * re-entrant, so it is done with the interrupts masked; this keeps the clock usable
+ * from threads and callbacks alike. */
+
+constexpr uint8_t CY_FX_UVC_CLOCK_GPIO = 50;                    // Complex GPIO used as the timestamp timer
+constexpr uint8_t CY_FX_UVC_CLOCK_TIMER = CY_FX_UVC_CLOCK_GPIO % 8; // Complex GPIO block owning the timer
+constexpr uint8_t CY_FX_UVC_CLOCK_FAST_DIV = 2;                 // GPIO fast clock divider from SYS_CLK / 2
+constexpr uint32_t CY_FX_UVC_CLOCK_SYS_CLK = 384000000;         // SYS_CLK set by CyU3PDeviceInit (NULL) from a 19.2 MHz crystal
+
+/* The clock is also the device clock of the UVC PTS and SCR fields. Its frequency is
+ * advertised as dwClockFrequency by the VC header descriptors and the probe control. */
+constexpr uint32_t CY_FX_UVC_CLOCK_HZ = CY_FX_UVC_CLOCK_SYS_CLK / 2 / CY_FX_UVC_CLOCK_FAST_DIV;
+
+/* CY_FX_UVC_CLOCK_HZ as the four little endian bytes of a descriptor field. */
+#define CY_FX_UVC_CLOCK_HZ_BYTES                                                \
+    CY_U3P_DWORD_GET_BYTE0 (CY_FX_UVC_CLOCK_HZ), CY_U3P_DWORD_GET_BYTE1 (CY_FX_UVC_CLOCK_HZ), \
+    CY_U3P_DWORD_GET_BYTE2 (CY_FX_UVC_CLOCK_HZ), CY_U3P_DWORD_GET_BYTE3 (CY_FX_UVC_CLOCK_HZ)
+
+/* Configure the GPIO block and start the timestamp timer. */
+extern CyU3PReturnStatus_t
+CyFxUVCClockInit (
+        void);
+
+/* Frequency of the timestamp clock in Hz. Valid after CyFxUVCClockInit. */
+extern uint32_t
+CyFxUVCClockHz (
+        void);
+
+#ifdef CYFX_HOST_BUILD
+
+/* Host build: the counter is provided by the simulation layer (host/fx3host.cpp). */
+extern uint32_t
+CyFxUVCClockTicks (
+        void);
+
+#else
+
+/* Current value of the timestamp counter. */
+inline uint32_t
+CyFxUVCClockTicks (
+        void)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    uint32_t stat = static_cast<uint32_t>(CY_U3P_LPP_GPIO_PIN_STATUS (CY_FX_UVC_CLOCK_TIMER));
+
+    /* Latch the timer and wait for the command to complete. */
+    stat &= ~(CY_U3P_LPP_GPIO_INTR | CY_U3P_LPP_GPIO_MODE_MASK);
+    CY_U3P_LPP_GPIO_PIN_STATUS (CY_FX_UVC_CLOCK_TIMER) = stat | (CY_U3P_GPIO_MODE_SAMPLE_NOW << CY_U3P_LPP_GPIO_MODE_POS);
+    while ((CY_U3P_LPP_GPIO_PIN_STATUS (CY_FX_UVC_CLOCK_TIMER) & CY_U3P_LPP_GPIO_MODE_MASK) != 0)
+        ;
+
+    uint32_t ticks = static_cast<uint32_t>(CY_U3P_LPP_GPIO_PIN_THRESHOLD (CY_FX_UVC_CLOCK_TIMER));
+    CyU3PVicEnableInterrupts (mask);
+    return ticks;
+}
+
+#endif /* CYFX_HOST_BUILD */
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCCLOCK_H_ */
+
+/*[]*/
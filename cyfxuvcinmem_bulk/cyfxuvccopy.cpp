@@ -0,0 +1,94 @@
+/*
+ ## UVC application payload copy (cyfxuvccopy.cpp)
+ ## ===========================
+*/
+
+/* The rounds load all their words before storing any, which lets the compiler use one
+ * LDM / STM pair per round on the ARM926. The frame store is read through a may_alias
+ * word type, as it is declared as bytes. With a misaligned source, the last merge loads
+ * the aligned word holding the last source byte, never past it. */
+
+#include "cyu3system.h"
+#include "cyfxmemmap.h"
+#include "cyfxuvccopy.h"
+
+typedef uint32_t CyFxUVCWord_t __attribute__ ((may_alias));
+
+void CY_FX_HOT_CODE
+CyFxUVCCopy (
+        uint8_t *dest,
+        const uint8_t *src,
+        uint32_t count)
+{
+    if (count < CY_FX_UVC_COPY_THRESHOLD)
+    {
+        CyU3PMemCopy (dest, const_cast<uint8_t *>(src), count);
+        return;
+    }
+
+    /* Bytes up to a word aligned destination. */
+    while ((reinterpret_cast<uintptr_t>(dest) & 3) != 0)
+    {
+        *dest++ = *src++;
+        count--;
+    }
+
+    CyFxUVCWord_t *d_p = reinterpret_cast<CyFxUVCWord_t *>(dest);
+    uint32_t words = count >> 2;
+    uint32_t offset = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(src) & 3);
+
+    if (offset == 0)
+    {
+        const CyFxUVCWord_t *s_p = reinterpret_cast<const CyFxUVCWord_t *>(src);
+
+        for (; words >= 8; words -= 8)
+        {
+            uint32_t w0 = s_p[0], w1 = s_p[1], w2 = s_p[2], w3 = s_p[3];
+            uint32_t w4 = s_p[4], w5 = s_p[5], w6 = s_p[6], w7 = s_p[7];
+            d_p[0] = w0; d_p[1] = w1; d_p[2] = w2; d_p[3] = w3;
+            d_p[4] = w4; d_p[5] = w5; d_p[6] = w6; d_p[7] = w7;
+            s_p += 8;
+            d_p += 8;
+        }
+        for (; words != 0; words--)
+        {
+            *d_p++ = *s_p++;
+        }
+    }
+    else
+    {
+        /* Little endian: the low bytes of a destination word are the high bytes of one
+           aligned source word, the rest the low bytes of the next. */
+        const CyFxUVCWord_t *s_p = reinterpret_cast<const CyFxUVCWord_t *>(src - offset);
+        uint32_t lo = *s_p++;
+        uint32_t shr = offset * 8, shl = 32 - shr;
+
+        for (; words >= 4; words -= 4)
+        {
+            uint32_t w0 = s_p[0], w1 = s_p[1], w2 = s_p[2], w3 = s_p[3];
+            d_p[0] = (lo >> shr) | (w0 << shl);
+            d_p[1] = (w0 >> shr) | (w1 << shl);
+            d_p[2] = (w1 >> shr) | (w2 << shl);
+            d_p[3] = (w2 >> shr) | (w3 << shl);
+            lo = w3;
+            s_p += 4;
+            d_p += 4;
+        }
+        for (; words != 0; words--)
+        {
+            uint32_t hi = *s_p++;
+            *d_p++ = (lo >> shr) | (hi << shl);
+            lo = hi;
+        }
+    }
+
+    /* Trailing bytes. */
+    dest = reinterpret_cast<uint8_t *>(d_p);
+    src += count & ~3u;
+    for (count &= 3; count != 0; count--)
+    {
+        *dest++ = *src++;
+    }
+}
+
+/*[]*/
@@ -0,0 +1,31 @@
+/*
+ ## UVC application payload copy (cyfxuvccopy.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCCOPY_H_
+#define _INCLUDED_CYFXUVCCOPY_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* Word copy of the frame store into the DMA buffers. CyU3PMemCopy moves one byte per
+ * load and store; this copy aligns the destination, then moves eight words per round
+ * when the source has the same alignment and merges two aligned source words per
+ * destination word otherwise. Copies shorter than CY_FX_UVC_COPY_THRESHOLD go to
+ * CyU3PMemCopy, where the alignment work would not pay off. The buffers must not
+ * overlap. */
+
+constexpr uint32_t CY_FX_UVC_COPY_THRESHOLD = 64;      // Shorter copies use CyU3PMemCopy
+
+extern void
+CyFxUVCCopy (
+        uint8_t *dest,
+        const uint8_t *src,
+        uint32_t count);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCCOPY_H_ */
+
+/*[]*/
@@ -33,6 +33,7 @@
  */
 
 #include "cyfxuvcinmem.h"
+#include "cyfxuvcclock.h"
 
 /* Standard device descriptor for USB 3.0 */
 const uint8_t CyFxUSB30DeviceDscr[] __attribute__ ((aligned (32))) =
@@ -152,7 +153,7 @@ const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
     0x01,                           /* Descriptor sub type : VC_HEADER */
     0x10,0x01,                      /* Revision of class spec : 1.1 */
     0x51,0x00,                      /* Total size of class specific descriptors (till output terminal) */
-    0x00,0x6C,0xDC,0x02,            /* Clock frequency : 48MHz */
+    CY_FX_UVC_CLOCK_HZ_BYTES,       /* Clock frequency : timestamp clock */
     0x01,                           /* Number of streaming interfaces */
     0x01,                           /* Video streaming i/f 1 belongs to VC i/f */
 
@@ -294,7 +295,7 @@ const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
     /* Super speed endpoint companion descriptor */
     0x06,                           /* Descriptor size */
     CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */
-    0x07,                           /* Max no. of packets in a Burst : 8 */
+    CY_FX_BULK_BURST - 1,           /* Max no. of packets in a Burst : CY_FX_BULK_BURST */
     0x00,                           /* Mult.: Max number of packets : 1 */
     0x00,0x00                  	    /* Field Valid only for Periodic Endpoints */
 
@@ -340,7 +341,7 @@ const uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
     0x01,                           /* Descriptor sub type : VC_HEADER */
     0x10,0x01,                      /* Revision of class spec : 1.1 */
     0x51,0x00,                      /* Total size of class specific descriptors (till output terminal) */
-    0x00,0x6C,0xDC,0x02,            /* Clock frequency : 48MHz */
+    CY_FX_UVC_CLOCK_HZ_BYTES,       /* Clock frequency : timestamp clock */
     0x01,                           /* Number of streaming interfaces */
     0x01,                           /* Video streaming I/f 1 belongs to VC i/f */
 
@@ -0,0 +1,74 @@
+/*
+ ## UVC application background heap checker (cyfxuvcheap.cpp)
+ ## ===========================
+*/
+
+/* The checker runs below the application thread and only ever masks the interrupts for
+ * CY_FX_UVC_HEAP_CHECK_BLOCKS blocks at a time, so it takes the idle time of the
+ * streaming loop and never delays it by more than one step. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyfxuvcstats.h"
+#include "cyfxuvcstack.h"
+#include "cyfxuvcheap.h"
+
+#ifdef CY_FX_MEM_CHECK_EN
+
+static CyU3PThread glHeapCheckThread;   /* Checker thread structure */
+
+/* Called by the allocators, from any context, for each corrupted block found. */
+static void
+CyFxUVCHeapCorrupt (
+        void *mem_p)
+{
+    (void)mem_p;
+    CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_HEAP_CORRUPT);
+}
+
+void
+CyFxUVCHeapCheckEnable (
+        void)
+{
+    CyU3PMemEnableChecks (CyTrue, CyFxUVCHeapCorrupt);
+    CyU3PBufEnableChecks (CyTrue, CyFxUVCHeapCorrupt);
+    CyFxMemCheckSampling (CY_FX_UVC_HEAP_CHECK_SAMPLE);
+}
+
+static void
+CyFxUVCHeapCheckEntry (
+        uint32_t input)
+{
+    (void)input;
+
+    for (;;)
+    {
+        CyFxMemCorruptionCheckStep (CY_FX_UVC_HEAP_CHECK_BLOCKS);
+        CyFxBufCorruptionCheckStep (CY_FX_UVC_HEAP_CHECK_BLOCKS);
+        CyU3PThreadSleep (CY_FX_UVC_HEAP_CHECK_PERIOD_MS);
+    }
+}
+
+void
+CyFxUVCHeapCheckStart (
+        void)
+{
+    void *ptr = CyU3PMemAlloc (CY_FX_UVC_HEAP_CHECK_STACK);
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    CyFxUVCStackPaint (ptr, CY_FX_UVC_HEAP_CHECK_STACK);
+    if (CyU3PThreadCreate (&glHeapCheckThread, "31:UVC_heap_check", CyFxUVCHeapCheckEntry, 0, ptr,
+                CY_FX_UVC_HEAP_CHECK_STACK, CY_FX_UVC_HEAP_CHECK_PRIORITY, CY_FX_UVC_HEAP_CHECK_PRIORITY,
+                CYU3P_NO_TIME_SLICE, CYU3P_AUTO_START) != CY_U3P_SUCCESS)
+    {
+        CyU3PMemFree (ptr);
+    }
+}
+
+#endif /* CY_FX_MEM_CHECK_EN */
+
+/*[]*/
@@ -0,0 +1,54 @@
+/*
+ ## UVC application background heap checker (cyfxuvcheap.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCHEAP_H_
+#define _INCLUDED_CYFXUVCHEAP_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* Corruption checks cheap enough to leave on while streaming (make CY_FX_MEM_CHECK=N).
+ * Every block of both heaps gets a header and canaries derived from its address, checked
+ * when it is freed; 1 in N blocks is also linked into the in-use list, which a low
+ * priority thread walks a few blocks at a time. A corrupted block is counted in the
+ * CY_FX_UVC_STATS_EVT_HEAP_CORRUPT statistics event. N = 1 tracks every block. */
+
+#ifdef CY_FX_MEM_CHECK_EN
+constexpr uint32_t CY_FX_UVC_HEAP_CHECK_SAMPLE = CY_FX_MEM_CHECK_EN; // Link 1 in this many blocks
+static_assert (CY_FX_UVC_HEAP_CHECK_SAMPLE != 0, "CY_FX_MEM_CHECK must be 1 or more");
+#endif
+constexpr uint32_t CY_FX_UVC_HEAP_CHECK_BLOCKS = 8;       // Blocks of each heap checked per step
+constexpr uint32_t CY_FX_UVC_HEAP_CHECK_PERIOD_MS = 10;   // Time between steps
+constexpr uint32_t CY_FX_UVC_HEAP_CHECK_STACK = 0x400;    // Checker thread stack size
+constexpr uint32_t CY_FX_UVC_HEAP_CHECK_PRIORITY = 15;    // Below the UVC application thread
+
+/* Turn the checks on. Call from main, before CyU3PDeviceInit creates the heaps. */
+extern void
+CyFxUVCHeapCheckEnable (
+        void);
+
+/* Create the checker thread. Call from CyFxApplicationDefine. */
+extern void
+CyFxUVCHeapCheckStart (
+        void);
+
+/* Incremental checks of the heap allocators. Defined in cyfxtx.cpp. */
+extern CyU3PReturnStatus_t
+CyFxMemCheckSampling (
+        uint32_t period);
+
+extern CyU3PReturnStatus_t
+CyFxMemCorruptionCheckStep (
+        uint32_t maxBlocks);
+
+extern CyU3PReturnStatus_t
+CyFxBufCorruptionCheckStep (
+        uint32_t maxBlocks);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCHEAP_H_ */
+
+/*[]*/
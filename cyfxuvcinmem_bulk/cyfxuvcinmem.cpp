@@ -57,6 +57,32 @@
 #include "cyu3usb.h"
 #include "cyu3uart.h"
 #include "cyu3utils.h"
+#include "cyu3mmu.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcstats.h"
+#include "cyfxuvctrace.h"
+#include "cyfxuvcprofile.h"
+#include "cyfxuvcstack.h"
+#include "cyfxuvcbench.h"
+#include "cyfxuvcboot.h"
+#include "cyfxuvcarena.h"
+#include "cyfxuvcheap.h"
+#include "cyfxuvccopy.h"
+#include "cyfxuvcpayload.h"
+#include "cyfxuvcscr.h"
+#include "cyfxuvcmeta.h"
+#include "cyfxuvcring.h"
+#include "cyfxuvclive.h"
+#include "cyfxmemmap.h"
+
+/* The DMA ring comes out of the buffer heap in cache line multiples, next to the EP0
+   and debug buffers of the SDK. Grow CY_FX_MEM_BUF_HEAP_SIZE (cyfxmemmap.h) with it. */
+static_assert (CY_FX_UVC_SESSION_ARENA_SIZE + CY_FX_MEM_SDK_BUF_RESERVE
+        <= CY_FX_MEM_BUF_HEAP_SIZE, "the UVC DMA ring does not fit in the buffer heap");
+static_assert (CY_FX_UVC_SESSION_ARENA_SIZE <= 0xFFFF, "the session arena is a single buffer heap allocation");
+
+/* The streaming loop walks the segment table of its buffer size. */
+static_assert (CyFxUVCSegmentsSupported (CY_FX_UVC_STREAM_BUF_SIZE), "no segment table for the stream buffer size");
 
 CyU3PThread uvcAppThread;           /* Thread structure */
 
@@ -79,21 +105,19 @@ union UsbSetup
     uint32_t words[2];
 };
 
-/* UVC Header */
-uint8_t glUVCHeader[CY_FX_UVC_MAX_HEADER] =
-{
-    0x0C,                           /* Header Length */
-    0x8C,                           /* Bit field header field */
-    0x00,0x00,0x00,0x00,            /* Presentation time stamp field */
-    0x00,0x00,0x00,0x00,0x00,0x00   /* Source clock reference field */
-};
-
 /* Video Probe Commit Control */
 uint8_t glCommitCtrl[CY_FX_UVC_MAX_PROBE_SETTING_ALIGNED] __attribute__ ((aligned (32)));
 
-CyU3PDmaChannel          glChHandleUVCStream;           /* DMA Channel Handle  */
-static volatile CyBool_t glIsApplnActive = CyFalse;     /* Whether the loopback application is active or not. */
-static volatile CyBool_t glIsDevConfigured = CyFalse;   /* Whether SET_CONFIG is complete or not. */
+/* Data phase buffer for the vendor requests */
+static uint8_t glVendorBuffer[CY_FX_UVC_VENDOR_BUF_SIZE] __attribute__ ((aligned (32)));
+
+/* The channel handle and the flags are read on every buffer: they live in D-TCM. */
+CY_FX_HOT_DATA CyU3PDmaChannel          glChHandleUVCStream;           /* DMA Channel Handle  */
+CY_FX_HOT_DATA static volatile CyBool_t glIsApplnActive = CyFalse;     /* Whether the loopback application is active or not. */
+CY_FX_HOT_DATA static volatile CyBool_t glIsDevConfigured = CyFalse;   /* Whether SET_CONFIG is complete or not. */
+CY_FX_HOT_DATA static volatile CyBool_t glIsSuperSpeed = CyFalse;      /* Bus speed of the streaming session. */
+CY_FX_HOT_DATA static volatile uint32_t glStreamSession = 0;           /* Streaming sessions started so far. */
+static CyU3PMutex glChannelLock;    /* Held while the video channel is created or destroyed. */
 
 /* Application error handler */
 void
@@ -184,13 +208,66 @@ static void logUsbSetup(const UsbSetup& usbRqt)
         usbRqt.fields.wLength);
 }
 
+/* Create the video channel with a ring of count buffers. */
+static CyU3PReturnStatus_t
+CyFxUVCChannelCreate (
+        uint8_t count)
+{
+    CyU3PDmaChannelConfig_t dmaCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    dmaCfg.size = CY_FX_UVC_STREAM_BUF_SIZE;
+    dmaCfg.count = count;
+    dmaCfg.prodSckId = CY_U3P_CPU_SOCKET_PROD;
+    dmaCfg.consSckId = CY_FX_EP_VIDEO_CONS_SOCKET;
+    dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
+    dmaCfg.cb = NULL;
+    dmaCfg.prodHeader = 0;
+    dmaCfg.prodFooter = 0;
+
+
+    dmaCfg.consHeader = 0;
+    dmaCfg.prodAvailCount = 0;
+
+    /* The ring is carved from one block released as a whole on stop, so that start / stop
+     * cycles do not fragment the buffer heap. Without the block it comes from the heap. */
+    apiRetStatus = CyFxDmaBufferArenaBegin (static_cast<uint16_t>(count * CY_FX_UVC_RING_STRIDE));
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyFxDmaBufferArenaBegin failed, error code = %d\n", apiRetStatus);
+    }
+    apiRetStatus = CyU3PDmaChannelCreate (&glChHandleUVCStream, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaCfg);
+    CyFxDmaBufferArenaEnd ();
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, error code = %d\n",apiRetStatus);
+        CyFxDmaBufferArenaRelease ();
+        return apiRetStatus;
+    }
+
+#ifdef CY_FX_UVC_DCACHE_EN
+    /* The CPU only writes the video buffers and the endpoint only reads them: a clean of the
+     * committed bytes is all the maintenance needed, done in the streaming loop. This saves
+     * the flush of every buffer in GetBuffer and the clean of the full buffer in Commit. */
+    apiRetStatus = CyU3PDmaChannelCacheControl (&glChHandleUVCStream, CyFalse);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PDmaChannelCacheControl failed, error code = %d\n", apiRetStatus);
+        CyU3PDmaChannelDestroy (&glChHandleUVCStream);
+        CyFxDmaBufferArenaRelease ();
+        return apiRetStatus;
+    }
+#endif
+
+    return CY_U3P_SUCCESS;
+}
+
 /* This function starts the video streaming application. It is called
  * when there is a SET_INTERFACE event for alternate interface 1. */
 CyU3PReturnStatus_t
 CyFxUVCApplnStart (void)
 {
     CyU3PEpConfig_t epCfg;
-    CyU3PDmaChannelConfig_t dmaCfg;
     CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
     CyU3PUSBSpeed_t usbSpeed = CyU3PUsbGetSpeed();
 
@@ -209,22 +286,12 @@ CyFxUVCApplnStart (void)
         return apiRetStatus;
     }
 
-    dmaCfg.size = CY_FX_UVC_STREAM_BUF_SIZE;
-    dmaCfg.count = CY_FX_UVC_STREAM_BUF_COUNT;
-    dmaCfg.prodSckId = CY_U3P_CPU_SOCKET_PROD;
-    dmaCfg.consSckId = CY_FX_EP_VIDEO_CONS_SOCKET;
-    dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
-    dmaCfg.cb = NULL;
-    dmaCfg.prodHeader = 0;
-    dmaCfg.prodFooter = 0;
-
-
-    dmaCfg.consHeader = 0;
-    dmaCfg.prodAvailCount = 0;
-    apiRetStatus = CyU3PDmaChannelCreate (&glChHandleUVCStream, CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaCfg);
+    /* The ring depth is the one of the last session (cyfxuvcring.h). */
+    CyU3PMutexGet (&glChannelLock, CYU3P_WAIT_FOREVER);
+    apiRetStatus = CyFxUVCChannelCreate (CyFxUVCRingCount ());
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, error code = %d\n",apiRetStatus);
+        CyU3PMutexPut (&glChannelLock);
         return apiRetStatus;
     }
 
@@ -235,11 +302,26 @@ CyFxUVCApplnStart (void)
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
         CyU3PDebugPrint (4, "CyU3PDmaChannelSetXfer failed, error code = %d\n", apiRetStatus);
+
+        /* No stop follows a failed start: give the ring back here. */
+        CyU3PDmaChannelDestroy (&glChHandleUVCStream);
+        CyFxDmaBufferArenaRelease ();
+        CyU3PMutexPut (&glChannelLock);
         return apiRetStatus;
     }
 
-    /* Update the flag so that the application thread is notified of this. */
+    /* Update the flags so that the application thread is notified of this. The speed
+       cannot change before the next stop, so the loop does not ask for it per buffer. */
+    glIsSuperSpeed = (usbSpeed == CY_U3P_SUPER_SPEED) ? CyTrue : CyFalse;
+    if (CY_FX_UVC_HEADER_LEN == CY_FX_UVC_HEADER_PTS_SCR)
+    {
+        /* Latch the SCR of the payload headers from the SOF / ITP events */
+        CyFxUVCScrStart (glIsSuperSpeed);
+    }
+    glStreamSession = glStreamSession + 1;
     glIsApplnActive = CyTrue;
+    CyU3PMutexPut (&glChannelLock);
+    CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_STREAM_START);
 
     return CY_U3P_SUCCESS;
 }
@@ -254,9 +336,18 @@ CyFxUVCApplnStop (void)
 
     /* Update the flag so that the application thread is notified of this. */
     glIsApplnActive = CyFalse;
+    CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_STREAM_STOP);
+    CyFxUVCScrStop ();
 
-    /* Abort and destroy the video streaming channel */
+    /* Abort and destroy the video streaming channel, then give its buffers back at once */
+    CyU3PMutexGet (&glChannelLock, CYU3P_WAIT_FOREVER);
     CyU3PDmaChannelDestroy (&glChHandleUVCStream);
+    CyU3PReturnStatus_t status = CyFxDmaBufferArenaRelease ();
+    CyU3PMutexPut (&glChannelLock);
+    if (status != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyFxDmaBufferArenaRelease failed, error code = %d\n", status);
+    }
 
     /* Flush the endpoint memory */
     CyU3PUsbFlushEp(CY_FX_EP_BULK_VIDEO);
@@ -277,6 +368,7 @@ CyFxUVCApplnUSBEventCB (
     switch (evtype)
     {
         case CY_U3P_USB_EVENT_SETCONF:
+            CyFxUVCBootMark (CY_FX_UVC_BOOT_SETCONF);
             if (evdata != 0)
                 glIsDevConfigured = CyTrue;
             else
@@ -287,13 +379,24 @@ CyFxUVCApplnUSBEventCB (
             /* Stop the application before re-starting. */
             if (glIsApplnActive)
             {
+                CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_STREAM_RESTART);
                 CyFxUVCApplnStop ();
             }
             CyFxUVCApplnStart ();
             break;
 
+        case CY_U3P_USB_EVENT_SOF_ITP:
+            /* Interrupt context */
+            CyFxUVCScrSof ();
+            break;
+
         case CY_U3P_USB_EVENT_RESET:
         case CY_U3P_USB_EVENT_DISCONNECT:
+            if (evtype == CY_U3P_USB_EVENT_RESET)
+                CyFxUVCBootMark (CY_FX_UVC_BOOT_USB_RESET);
+            CyFxUVCStatsEvent ((evtype == CY_U3P_USB_EVENT_RESET) ?
+                    CY_FX_UVC_STATS_EVT_USB_RESET : CY_FX_UVC_STATS_EVT_USB_DISCONNECT);
+
             /* Stop the video streamer application. */
             if (glIsApplnActive)
             {
@@ -314,6 +417,24 @@ static CyBool_t CyFxUVCHandleStandardRequest(const UsbSetup& usbRqt)
     uint8_t bTarget = (usbRqt.fields.bmRequestType & CY_U3P_USB_TARGET_MASK);
     uint8_t bRequest = usbRqt.fields.bRequest;
     uint16_t wValue = usbRqt.fields.wValue;
+    uint16_t wIndex = usbRqt.fields.wIndex;
+
+    /* CLEAR_FEATURE(ENDPOINT_HALT) on the video endpoint: the host recovers from a
+       transfer error, or stops the stream (uvcvideo on Linux). Restart the session, so
+       that the next payload starts a frame, and reset the data toggle / sequence. */
+    if ((bTarget == CY_U3P_USB_TARGET_ENDPT) && (bRequest == CY_U3P_USB_SC_CLEAR_FEATURE) &&
+        (wValue == CY_U3P_USBX_FS_EP_HALT) && (wIndex == CY_FX_EP_BULK_VIDEO))
+    {
+        if (glIsApplnActive)
+        {
+            CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_STREAM_RESTART);
+            CyFxUVCApplnStop ();
+            CyFxUVCApplnStart ();
+        }
+        CyU3PUsbStall (CY_FX_EP_BULK_VIDEO, CyFalse, CyTrue);
+        CyU3PUsbAckSetup ();
+        isHandled = CyTrue;
+    }
 
     if ((bTarget == CY_U3P_USB_TARGET_INTF) &&
         ((bRequest == CY_U3P_USB_SC_SET_FEATURE) || (bRequest == CY_U3P_USB_SC_CLEAR_FEATURE)) &&
@@ -400,6 +521,113 @@ static CyBool_t CyFxUVCHandleVSRequest(const UsbSetup& usbRqt)
     return isHandled;
 }
 
+// Helper for vendor requests: diagnostics exported to the host tools, and the streaming mode
+static CyBool_t CyFxUVCHandleVendorRequest(const UsbSetup& usbRqt)
+{
+    CyBool_t isHandled = CyFalse;
+    uint8_t bReqType = usbRqt.fields.bmRequestType;
+    uint16_t wLength = usbRqt.fields.wLength;
+    uint16_t length = 0;
+    CyU3PReturnStatus_t status;
+
+    if (((bReqType & CY_U3P_USB_TARGET_MASK) != CY_U3P_USB_TARGET_DEVICE) ||
+        ((bReqType & CY_FX_USB_RQT_DIR_IN) == 0))
+        return CyFalse;
+
+    switch (usbRqt.fields.bRequest)
+    {
+        case CY_FX_UVC_VENDOR_RQT_GET_STATS:
+            static_assert(sizeof(CyFxUVCStats_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCStatsSnapshot(reinterpret_cast<CyFxUVCStats_t *>(glVendorBuffer),
+                    (usbRqt.fields.wValue & CY_FX_UVC_STATS_CLEAR) ? CyTrue : CyFalse);
+            length = sizeof(CyFxUVCStats_t);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_UVC_VENDOR_RQT_GET_EVENTS:
+            static_assert(sizeof(CyFxUVCStatsLog_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCStatsLogSnapshot(reinterpret_cast<CyFxUVCStatsLog_t *>(glVendorBuffer),
+                    (usbRqt.fields.wValue & CY_FX_UVC_STATS_CLEAR) ? CyTrue : CyFalse);
+            length = sizeof(CyFxUVCStatsLog_t);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_UVC_VENDOR_RQT_GET_BOOT:
+            static_assert(sizeof(CyFxUVCBoot_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCBootSnapshot(reinterpret_cast<CyFxUVCBoot_t *>(glVendorBuffer));
+            length = sizeof(CyFxUVCBoot_t);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_UVC_VENDOR_RQT_GET_STACKS:
+            static_assert(sizeof(CyFxUVCStacks_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCStackSnapshot(&uvcAppThread, reinterpret_cast<CyFxUVCStacks_t *>(glVendorBuffer));
+            length = sizeof(CyFxUVCStacks_t);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_UVC_VENDOR_RQT_LIVE_MODE:
+            static_assert(sizeof(CyFxUVCLive_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            /* An unknown mode stalls the request */
+            if ((usbRqt.fields.wValue & CY_FX_UVC_LIVE_SELECT) &&
+                    !CyFxUVCLiveSelect(CY_U3P_GET_MSB(usbRqt.fields.wValue)))
+            {
+                break;
+            }
+            CyFxUVCLiveSnapshot(reinterpret_cast<CyFxUVCLive_t *>(glVendorBuffer),
+                    (usbRqt.fields.wValue & CY_FX_UVC_LIVE_CLEAR) ? CyTrue : CyFalse);
+            length = sizeof(CyFxUVCLive_t);
+            isHandled = CyTrue;
+            break;
+
+#ifdef CY_FX_UVC_RING_ADAPT_EN
+        case CY_FX_UVC_VENDOR_RQT_GET_RING:
+            static_assert(sizeof(CyFxUVCRing_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCRingSnapshot(reinterpret_cast<CyFxUVCRing_t *>(glVendorBuffer),
+                    (usbRqt.fields.wValue & CY_FX_UVC_RING_CLEAR) ? CyTrue : CyFalse);
+            length = sizeof(CyFxUVCRing_t);
+            isHandled = CyTrue;
+            break;
+#endif
+
+#ifdef CYU3P_PROFILE_EN
+        case CY_FX_UVC_VENDOR_RQT_GET_BENCH:
+            static_assert(sizeof(CyFxUVCBench_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCBenchRun(reinterpret_cast<CyFxUVCBench_t *>(glVendorBuffer));
+            length = sizeof(CyFxUVCBench_t);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_UVC_VENDOR_RQT_GET_TRACE:
+            static_assert(sizeof(CyFxUVCTrace_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCTraceSnapshot(reinterpret_cast<CyFxUVCTrace_t *>(glVendorBuffer),
+                    (usbRqt.fields.wValue & CY_FX_UVC_TRACE_CLEAR) ? CyTrue : CyFalse);
+            length = sizeof(CyFxUVCTrace_t);
+            isHandled = CyTrue;
+            break;
+
+        case CY_FX_UVC_VENDOR_RQT_GET_PROFILE:
+            static_assert(sizeof(CyFxUVCProfile_t) <= CY_FX_UVC_VENDOR_BUF_SIZE, "vendor buffer too small");
+            CyFxUVCProfileSnapshot(reinterpret_cast<CyFxUVCProfile_t *>(glVendorBuffer));
+            length = sizeof(CyFxUVCProfile_t);
+            isHandled = CyTrue;
+            break;
+#endif
+
+        default:
+            break;
+    }
+
+    if (isHandled)
+    {
+        /* A short read returns the leading part of the block. */
+        status = CyU3PUsbSendEP0Data((wLength < length) ? wLength : length, glVendorBuffer);
+        if (status != CY_U3P_SUCCESS)
+            CyU3PDebugPrint(4, "CyU3PUsbSendEP0Data, error code = %d\n", status);
+    }
+    return isHandled;
+}
+
 static CyBool_t
 CyFxUVCApplnUSBSetupCB (
         uint32_t setupdat0,
@@ -440,6 +668,11 @@ CyFxUVCApplnUSBSetupCB (
         }
     }
 
+    if (bType == CY_U3P_USB_VENDOR_RQT)
+    {
+        isHandled = CyFxUVCHandleVendorRequest(usbRqt);
+    }
+
     return isHandled;
 }
 
@@ -466,6 +699,9 @@ CyFxUVCApplnInit (void)
 {
     CyU3PEpConfig_t endPointConfig;
 
+    /* The USB callbacks start and stop the video channel from here on. */
+    CyU3PMutexCreate (&glChannelLock, CYU3P_NO_INHERIT);
+
     /* Start the USB functionality */
     CyU3PReturnStatus_t apiRetStatus = CyU3PUsbStart();
     if (apiRetStatus != CY_U3P_SUCCESS)
@@ -473,6 +709,7 @@ CyFxUVCApplnInit (void)
         CyU3PDebugPrint (4, "USB Function Failed to Start, Error Code = %d\n",apiRetStatus);
         CyFxAppErrorHandler(apiRetStatus);
     }
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_USB_START);
 
     /* The fast enumeration is the easiest way to setup a USB connection,
      * where all enumeration phase is handled by the library. Only the
@@ -496,6 +733,7 @@ CyFxUVCApplnInit (void)
     CyFxUVCSetUsbDescOrFail(CY_U3P_USB_SET_STRING_DESCR, 0, CyFxUSBStringLangIDDscr);
     CyFxUVCSetUsbDescOrFail(CY_U3P_USB_SET_STRING_DESCR, 1, CyFxUSBManufactureDscr);
     CyFxUVCSetUsbDescOrFail(CY_U3P_USB_SET_STRING_DESCR, 2, CyFxUSBProductDscr);
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_DESCRIPTORS);
 
     /* Since the status interrupt endpoint is not used in this application,
      * just enable the EP in the beginning. */
@@ -520,100 +758,236 @@ CyFxUVCApplnInit (void)
         CyU3PDebugPrint (4, "USB connect failed, Error Code = %d\n",apiRetStatus);
         CyFxAppErrorHandler(apiRetStatus);
     }
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_CONNECT);
 }
 
-/* UVC header addition function */
+/* Whether the streaming session the loop started with is still running. A stop and a
+ * start can both happen between two checks (a SET_INTERFACE from the USB thread, which
+ * preempts this one): glIsApplnActive alone would then let the loop go on in the middle of
+ * a frame, and count the abort of its pending GetBuffer as a streamer error. */
+static inline CyBool_t
+CyFxUVCSessionLive (
+        uint32_t session)
+{
+    return (glIsApplnActive && (session == glStreamSession)) ? CyTrue : CyFalse;
+}
+
+#ifdef CY_FX_UVC_RING_ADAPT_EN
+/* Rebuild the video channel of the session with count buffers, between two frames. The
+ * committed buffers are sent first: the endpoint is left as it is, nothing of the stream
+ * is lost and the host sees no break in the framing. If the host does not drain the ring
+ * in time or the session stops, the resize waits for a later window. */
 static void
-CyFxUVCAddHeader (
-        uint8_t *buffer_p, /* Buffer pointer */
-        uint8_t frameInd   /* EOF or normal frame indication */
-    )
+CyFxUVCApplnResize (
+        uint32_t session,
+        uint8_t count)
 {
-    /* Copy header to buffer */
-    CyU3PMemCopy (buffer_p, (uint8_t *)glUVCHeader, CY_FX_UVC_MAX_HEADER);
+    uint8_t oldCount = CyFxUVCRingCount ();
+    uint32_t drainStart = CyFxUVCClockTicks ();
+    CyU3PReturnStatus_t status;
 
-    /* Check if last packet of the frame. */
-    if (frameInd == CY_FX_UVC_HEADER_EOF)
+    while (!CyFxUVCRingDrained ())
     {
-        /* Modify UVC header to toggle Frame ID */
-        glUVCHeader[1] ^= CY_FX_UVC_HEADER_FRAME_ID;
+        if ((!CyFxUVCSessionLive (session)) ||
+                (CyFxUVCClockTicks () - drainStart > CY_FX_UVC_CLOCK_HZ / 1000 * CY_FX_UVC_RING_DRAIN_MS))
+        {
+            CyFxUVCRingResized (count, CY_FX_UVC_RING_DEFERRED);
+            return;
+        }
+        CyU3PThreadSleep (1);
+    }
 
-        /* Indicate End of Frame in the buffer */
-        buffer_p[1] |=  CY_FX_UVC_HEADER_EOF;
+    /* A stop from the USB thread cannot come between the check and the rebuild. */
+    CyU3PMutexGet (&glChannelLock, CYU3P_WAIT_FOREVER);
+    if (!CyFxUVCSessionLive (session))
+    {
+        CyU3PMutexPut (&glChannelLock);
+        CyFxUVCRingResized (count, CY_FX_UVC_RING_DEFERRED);
+        return;
+    }
+
+    CyU3PDmaChannelDestroy (&glChHandleUVCStream);
+    CyFxDmaBufferArenaRelease ();
+    status = CyFxUVCChannelCreate (count);
+    if (status == CY_U3P_SUCCESS)
+    {
+        status = CyU3PDmaChannelSetXfer (&glChHandleUVCStream, 0);
+    }
+    if (status == CY_U3P_SUCCESS)
+    {
+        CyFxUVCRingResized (count, CY_FX_UVC_RING_APPLIED);
+    }
+    else
+    {
+        /* The old depth fitted before: go back to it. */
+        CyU3PDebugPrint (4, "Ring resize to %d failed, error code = %d\n", count, status);
+        CyU3PDmaChannelDestroy (&glChHandleUVCStream);
+        CyFxDmaBufferArenaRelease ();
+        status = CyFxUVCChannelCreate (oldCount);
+        if (status == CY_U3P_SUCCESS)
+        {
+            status = CyU3PDmaChannelSetXfer (&glChHandleUVCStream, 0);
+        }
+        CyFxUVCRingResized (count, CY_FX_UVC_RING_FAILED);
+    }
+    CyU3PMutexPut (&glChannelLock);
+
+    /* The new channel counts its bytes from 0. If it could not be set up, the next
+       GetBuffer fails and the loop reports the streamer error. */
+    CyFxUVCRingStart (&glChHandleUVCStream);
+    CyFxUVCMetaRingRestart ();
+    CyFxUVCLiveRingRestart (CyFxUVCRingCount ());
+    if (status != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "Ring rebuild failed, error code = %d\n", status);
     }
 }
+#endif
 
-/* Entry function for the UVC application thread. */
-void
+/* Entry function for the UVC application thread. It runs the streaming loop, so it lives in I-TCM. */
+void CY_FX_HOT_CODE
 UVCAppThread_Entry (
         uint32_t /*input*/)
 {
     CyU3PDmaBuffer_t dmaBuffer;
     uint16_t commitLength = 0;
-    uint32_t frameStart = 0, frameIndex = 0, frameOffset = 0;
+    uint32_t segCount = 0;
+    const CyFxUVCSegment_t *segments_p = CyFxUVCSegmentsGet (CY_FX_UVC_STREAM_BUF_SIZE, &segCount);
+    const CyFxUVCSegment_t *seg_p = segments_p, *segEnd_p = segments_p + segCount;
+    CyFxUVCStreamWriter_t writer;
+    uint32_t waitStart = 0, waitTicks = 0;
+    uint32_t session = 0;
     CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_THREAD);
+
+#ifndef CY_FX_UVC_FAST_BOOT_EN
     /* Initialize the Debug Module */
     CyFxUVCApplnDebugInit();
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_DEBUG);
+#endif
+
+    /* Start the timestamp clock used for the statistics and trace points */
+    status = CyFxUVCClockInit();
+    if (status != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "Timestamp clock init failed, Error Code = %d\n", status);
+        CyFxAppErrorHandler(status);
+    }
+    if (CyFxUVCClockHz() != CY_FX_UVC_CLOCK_HZ)
+    {
+        /* The PTS and SCR fields count at a rate the descriptors do not advertise */
+        CyU3PDebugPrint (4, "Timestamp clock at %d Hz, advertised %d Hz\n", CyFxUVCClockHz(), CY_FX_UVC_CLOCK_HZ);
+    }
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_CLOCK);
+    CyFxUVCStatsReset();
+#ifdef CYU3P_PROFILE_EN
+    CyFxUVCTraceReset();
+
+    /* Start sampling the ThreadX performance counters */
+    status = CyFxUVCProfileInit(&uvcAppThread, &glChHandleUVCStream);
+    if (status != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "Performance report init failed, Error Code = %d\n", status);
+    }
+#endif
 
     /* Initialize the UVC Application */
     CyFxUVCApplnInit();
 
+#ifdef CY_FX_UVC_FAST_BOOT_EN
+    /* Fast boot: the debug UART comes up while the host enumerates the device. Errors
+       printed before this point are lost. */
+    CyFxUVCApplnDebugInit();
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_DEBUG);
+#endif
+
     for (;;)
     {
-        frameStart = 0;
-        frameIndex = 0;
-        frameOffset = 0;
+        session = glStreamSession;
+        seg_p = segments_p;
 
-        /* Reset Frame Id in UVC Header */
-        glUVCHeader[1] = CY_FX_UVC_HEADER_DEFAULT_BFH;
+        /* Restart the Frame Id and the frame metadata */
+        writer.Reset ();
+        CyFxUVCMetaStart (&glChHandleUVCStream);
+        CyFxUVCRingStart (&glChHandleUVCStream);
+        CyFxUVCLiveStart (&glChHandleUVCStream, CyFxUVCRingCount (),
+                CY_U3P_MAKEDWORD (glCommitCtrl[7], glCommitCtrl[6], glCommitCtrl[5], glCommitCtrl[4]));
 
         /* Video streamer application. */
-        while (glIsApplnActive)
+        while (CyFxUVCSessionLive (session))
         {
-            CyU3PThreadSleep(250);
+            if (seg_p->start)
+            {
+                /* Live mode: the frame is not sent before it is due */
+                uint32_t wait;
+                while (((wait = CyFxUVCLiveFrameWait ()) != 0) && CyFxUVCSessionLive (session))
+                {
+                    CyU3PThreadSleep ((wait < CY_FX_UVC_LIVE_WAIT_STEP_MS) ? wait : CY_FX_UVC_LIVE_WAIT_STEP_MS);
+                }
+                if (!CyFxUVCSessionLive (session))
+                    continue;
+            }
+
             /* Wait for a free buffer. */
+            waitStart = CyFxUVCClockTicks();
             status = CyU3PDmaChannelGetBuffer (&glChHandleUVCStream,
                     &dmaBuffer,  CYU3P_WAIT_FOREVER);
+            waitTicks = CyFxUVCClockTicks() - waitStart;
             if (status != CY_U3P_SUCCESS)
             {
+                /* The channel is destroyed under a pending wait when streaming stops; not an error. */
+                if (CyFxUVCSessionLive (session))
+                    CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_GETBUF_ERROR);
             	break;
             }
-
-            /* Add headers on every frame. Need to check if the EOF bit has to be set. */
-            if (frameOffset + (CY_FX_UVC_STREAM_BUF_SIZE - CY_FX_UVC_MAX_HEADER) < glVidFrameLen[frameIndex])
-            {
-                /* Not the end of frame. */
-                CyFxUVCAddHeader (dmaBuffer.buffer, CY_FX_UVC_HEADER_FRAME);
-
-
-                CyU3PMemCopy ((dmaBuffer.buffer + CY_FX_UVC_MAX_HEADER),
-                        (uint8_t *)&glUVCVidFrames[frameStart + frameOffset],
-                        (CY_FX_UVC_STREAM_BUF_SIZE - CY_FX_UVC_MAX_HEADER));
-
-                commitLength = CY_FX_UVC_STREAM_BUF_SIZE;
-                frameOffset += (CY_FX_UVC_STREAM_BUF_SIZE - CY_FX_UVC_MAX_HEADER);
-            }
-            else
-            {
-                /* Short packet: End of frame. */
-                CyFxUVCAddHeader(dmaBuffer.buffer, CY_FX_UVC_HEADER_EOF);
-
-                commitLength = static_cast<uint16_t>((glVidFrameLen[frameIndex] - frameOffset) + CY_FX_UVC_MAX_HEADER);
-                CyU3PMemCopy ((dmaBuffer.buffer + CY_FX_UVC_MAX_HEADER),
-                        (uint8_t *)&glUVCVidFrames[frameStart + frameOffset],
-                        (glVidFrameLen[frameIndex] - frameOffset));
-            }
+            UVC_TP_RECORD (GETBUF, waitTicks);
+            UVC_TP_BEGIN (BUFFER);
+            CyFxUVCRingBuffer (waitTicks);
+
+            /* The segment says what goes in the buffer: header (EOF on the last segment of a
+               frame), payload and commit length. */
+            UVC_TP_BEGIN (HEADER);
+            writer.Write (dmaBuffer.buffer, seg_p);
+            UVC_TP_END (HEADER);
+
+            UVC_TP_BEGIN (MEMCPY);
+            CyFxUVCCopy ((dmaBuffer.buffer + (seg_p->commit - seg_p->length)), seg_p->src_p, seg_p->length);
+            UVC_TP_END (MEMCPY);
+
+            commitLength = seg_p->commit;
+
+#ifdef CY_FX_UVC_DCACHE_EN
+            /* Write the header and payload back to memory before the endpoint reads them. The
+               buffer is cache line aligned, so whole lines cover exactly the committed bytes. */
+            UVC_TP_BEGIN (CLEAN);
+            CyU3PSysCleanDRegion (reinterpret_cast<uint32_t *>(dmaBuffer.buffer), (commitLength + 31u) & ~31u);
+            UVC_TP_END (CLEAN);
+#endif
+
+            /* Restarted while the buffer was filled: the buffer is not part of the new session */
+            if (!CyFxUVCSessionLive (session))
+                break;
 
             /* Commit the buffer for transfer */
+            UVC_TP_BEGIN (COMMIT);
             status = CyU3PDmaChannelCommitBuffer (&glChHandleUVCStream, commitLength, 0);
+            UVC_TP_END (COMMIT);
             if (status != CY_U3P_SUCCESS)
             {
+                if (CyFxUVCSessionLive (session))
+                    CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_COMMIT_ERROR);
                 break;
             }
+            CyFxUVCStatsBufferDone (waitTicks, commitLength,
+                    (seg_p->header == CY_FX_UVC_HEADER_EOF) ? CyTrue : CyFalse);
+            CyFxUVCMetaCommitted (seg_p);
+            CyFxUVCRingCommitted (commitLength);
+            CyFxUVCLiveCommitted (commitLength);
+            UVC_TP_END (BUFFER);
 
             /* Move the USB link to U0 if we are stuck in U1/U2. */
-            if (CyU3PUsbGetSpeed () == CY_U3P_SUPER_SPEED)
+            if (glIsSuperSpeed)
             {
                 CyU3PUsbLinkPowerMode u3mode;
 
@@ -621,27 +995,43 @@ UVCAppThread_Entry (
                             (u3mode == CyU3PUsbLPM_U1) || (u3mode == CyU3PUsbLPM_U2)))
                 {
                     CyU3PUsbSetLinkPowerState (CyU3PUsbLPM_U0);
+                    CyFxUVCStatsEvent (CY_FX_UVC_STATS_EVT_LPM_FORCED_U0);
                 }
             }
 
-            if (commitLength < CY_FX_UVC_STREAM_BUF_SIZE)
+#ifdef CY_FX_UVC_RING_ADAPT_EN
+            /* Between two frames: adapt the ring depth to the way the host reads */
+            if (seg_p->header == CY_FX_UVC_HEADER_EOF)
             {
-                /* Finished the frame: Move to the next frame. */
-                frameOffset = 0;
-                frameStart += glVidFrameLen[frameIndex];
-                frameIndex++;
+                uint8_t count = CyFxUVCRingFrameEnd ();
+                if (count != CyFxUVCRingCount ())
+                {
+                    CyFxUVCApplnResize (session, count);
+                }
+            }
+#endif
+
+            /* Live mode: skip the frames the host has no time for after this one */
+            uint32_t skip = (seg_p->header == CY_FX_UVC_HEADER_EOF) ? CyFxUVCLiveFrameEnd () : 0;
 
-                /* If all frames are transferred then start from 0 */
-                if (frameIndex >= CY_FX_UVC_MAX_VID_FRAMES)
+            /* Next segment; after the last one of the last frame start from 0. The clip
+               repeats, so a skip only moves through one pass of it. */
+            if (++seg_p == segEnd_p)
+            {
+                seg_p = segments_p;
+            }
+            for (skip %= CY_FX_UVC_MAX_VID_FRAMES; skip != 0; )
+            {
+                if (++seg_p == segEnd_p)
                 {
-                    frameIndex = 0;
-                    frameStart = 0;
+                    seg_p = segments_p;
                 }
+                skip -= seg_p->start;
             }
         }
 
         /* There is a streamer error. Flag it. */
-        if ((status != CY_U3P_SUCCESS) && (glIsApplnActive))
+        if ((status != CY_U3P_SUCCESS) && CyFxUVCSessionLive (session))
         {
             CyU3PDebugPrint (4, "UVC video streamer error. Code %d.\n", status);
             CyFxAppErrorHandler (status);
@@ -661,8 +1051,15 @@ CyFxApplicationDefine (
     void *ptr = NULL;
     uint32_t retThrdCreate = CY_U3P_SUCCESS;
 
+    CyFxUVCBootMark (CY_FX_UVC_BOOT_KERNEL);
+
     /* Allocate the memory for the thread and create the thread */
     ptr = CyU3PMemAlloc (UVC_APP_THREAD_STACK);
+    if (ptr != NULL)
+    {
+        /* Paint the stack so that its high-water mark can be reported */
+        CyFxUVCStackPaint (ptr, UVC_APP_THREAD_STACK);
+    }
     retThrdCreate = CyU3PThreadCreate (&uvcAppThread,   /* UVC Thread structure */
                            "30:UVC_app_thread",         /* Thread Id and name */
                            UVCAppThread_Entry,          /* UVC Application Thread Entry function */
@@ -686,6 +1083,10 @@ CyFxApplicationDefine (
         /* Loop indefinitely */
         while(1);
     }
+
+#ifdef CY_FX_MEM_CHECK_EN
+    CyFxUVCHeapCheckStart ();
+#endif
 }
 
 /* [ ] */
@@ -31,8 +31,15 @@
 /* This header file comprises of the UVC application constants and
  * the video frame configurations */
 
-// Thread stack size and priority
+// Thread stack size and priority. Building with CY_FX_UVC_APP_STACK_USED=<bytes>, the high-water
+// mark reported by host/uvcstack for the same BLD_TYPE, sizes the stack from it plus a margin.
+constexpr uint32_t UVC_APP_THREAD_STACK_MARGIN = 256; // Fixed margin on top of 25 % of the measured usage
+constexpr uint32_t UVC_APP_THREAD_STACK_FOR(uint32_t used) { return (used + used / 4 + UVC_APP_THREAD_STACK_MARGIN + 31) & ~31u; }
+#ifdef CY_FX_UVC_APP_STACK_USED
+constexpr uint32_t UVC_APP_THREAD_STACK = UVC_APP_THREAD_STACK_FOR(CY_FX_UVC_APP_STACK_USED);
+#else
 constexpr uint32_t UVC_APP_THREAD_STACK = 0x1000;
+#endif
 constexpr uint32_t UVC_APP_THREAD_PRIORITY = 8;
 
 // Endpoint definition for UVC application
@@ -51,6 +58,14 @@ constexpr uint8_t CY_FX_EP_BULK_VIDEO_PKTS_COUNT = 0x01;
 
 constexpr uint8_t CY_FX_UVC_MAX_VID_FRAMES = 2; // Maximum number of video frames (4)
 
+// DMA ring geometry and SS burst. Building with CY_FX_UVC_TUNE=<header>, a header written by
+// host/uvctune for the target speed, takes them from the header instead.
+#ifdef CY_FX_UVC_TUNE_H
+#include CY_FX_UVC_TUNE_H
+constexpr uint8_t CY_FX_BULK_BURST = CY_FX_UVC_TUNE_BULK_BURST; // Burst size for SS operation only.
+constexpr uint32_t CY_FX_UVC_STREAM_BUF_SIZE = CY_FX_UVC_TUNE_STREAM_BUF_SIZE; // UVC Buffer size
+constexpr uint8_t CY_FX_UVC_STREAM_BUF_COUNT = CY_FX_UVC_TUNE_STREAM_BUF_COUNT; // UVC Buffer count
+#else
 constexpr uint8_t CY_FX_BULK_BURST = 8; // Burst size for SS operation only.
 
 // UVC Buffer size
@@ -58,8 +73,29 @@ constexpr uint32_t CY_FX_UVC_STREAM_BUF_SIZE = 4096;
 
 // UVC Buffer count
 constexpr uint8_t CY_FX_UVC_STREAM_BUF_COUNT = 10;
+#endif
+
+static_assert ((CY_FX_BULK_BURST >= 1) && (CY_FX_BULK_BURST <= 16), "SS bulk bursts are 1 to 16 packets");
+static_assert ((CY_FX_UVC_STREAM_BUF_SIZE % CY_FX_EP_BULK_VIDEO_PKT_SIZE) == 0,
+        "DMA buffers hold whole packets: only the last payload of a frame ends in a short packet");
+
+// Session arena holding the DMA ring of a streaming session (cyfxuvcarena.h)
+constexpr uint32_t CY_FX_UVC_SESSION_ARENA_SIZE = CY_FX_UVC_STREAM_BUF_COUNT * ((CY_FX_UVC_STREAM_BUF_SIZE + 31u) & ~31u);
+
+// D-cache (make CY_FX_UVC_DCACHE=1). The SDK keeps its own DMA channels coherent; the video
+// channel is excluded and the streaming loop cleans only the bytes it commits.
+#ifdef CY_FX_UVC_DCACHE_EN
+constexpr CyBool_t CY_FX_UVC_DCACHE = CyTrue;
+#else
+constexpr CyBool_t CY_FX_UVC_DCACHE = CyFalse;
+#endif
 
 constexpr uint8_t CY_FX_UVC_MAX_HEADER = 12; // Maximum number of header bytes in UVC
+#ifdef CY_FX_UVC_MIN_HEADER_EN
+constexpr uint8_t CY_FX_UVC_HEADER_LEN = 2; // Header bytes of the stream: length and bit field header only
+#else
+constexpr uint8_t CY_FX_UVC_HEADER_LEN = CY_FX_UVC_MAX_HEADER; // Header bytes of the stream, with PTS and SCR
+#endif
 constexpr uint8_t CY_FX_UVC_HEADER_DEFAULT_BFH = 0x8C; // Default BFH(Bit Field Header) for the UVC Header
 
 constexpr uint8_t CY_FX_UVC_MAX_PROBE_SETTING = 34; // Maximum number of bytes in Probe Control
@@ -86,6 +122,19 @@ constexpr uint16_t CY_FX_USB_UVC_VS_COMMIT_CONTROL = 0x0200; // Control selector
 constexpr uint16_t CY_FX_USB_UVC_VC_RQT_ERROR_CODE_CONTROL = 0x0200;
 constexpr uint8_t CY_FX_USB_UVC_RQT_STAT_INVALID_CTRL = 0x06;
 
+// Vendor requests (device recipient) used by the host-side diagnostic tools
+constexpr uint8_t CY_FX_USB_RQT_DIR_IN = 0x80; // bmRequestType direction bit: device to host
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_STATS = 0xE0; // IN: streaming statistics block, wValue bit 0 clears it
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_TRACE = 0xE1; // IN: trace point histograms (profile builds), wValue bit 0 clears them
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_PROFILE = 0xE2; // IN: latest ThreadX performance counter sample (profile builds)
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_STACKS = 0xE3; // IN: thread stack high-water marks and driver heap usage
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_BENCH = 0xE4; // IN: run the copy path benchmark (profile builds), not while streaming
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_BOOT = 0xE5; // IN: boot timeline, from the RTOS start to the first SET_CONFIGURATION
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_RING = 0xE6; // IN: adaptive DMA ring depth, decisions and occupancy (CY_FX_UVC_RING_ADAPT builds)
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_LIVE_MODE = 0xE7; // IN: live mode counters; wValue bit 1 first selects the streaming mode in its high byte
+constexpr uint8_t CY_FX_UVC_VENDOR_RQT_GET_EVENTS = 0xE8; // IN: log of the latest statistics events, wValue bit 0 clears it
+constexpr uint16_t CY_FX_UVC_VENDOR_BUF_SIZE = 1024; // Data phase buffer for vendor requests, multiple of 32 bytes
+
 /* Extern definitions of the USB Enumeration constant arrays used for the Application */
 extern const uint8_t CyFxUSB20DeviceDscr[];
 extern const uint8_t CyFxUSB30DeviceDscr[];
@@ -109,6 +158,40 @@ extern const uint32_t glVidFrameLen[CY_FX_UVC_MAX_VID_FRAMES];
 /* MJPEG Video Frames */
 extern const uint8_t glUVCVidFrames[];
 
+/* Payload segments of the frame store, generated at compile time (cyfxuvcvidframes.cpp).
+   Each entry is the payload of one DMA buffer: the frames cut in buffer sized pieces, the
+   last piece of a frame carrying the EOF header. The streaming loop walks the table of
+   its buffer size and wraps at the end. */
+struct CyFxUVCSegment_t
+{
+    const uint8_t *src_p;           // Payload in glUVCVidFrames
+    uint16_t       length;          // Payload bytes
+    uint16_t       commit;          // Bytes to commit: header and payload
+    uint8_t        header;          // CY_FX_UVC_HEADER_FRAME or CY_FX_UVC_HEADER_EOF
+    uint8_t        start;           // 1 on the first segment of a frame
+};
+
+/* DMA buffer sizes that have a segment table */
+constexpr uint32_t CY_FX_UVC_SEG_BUF_SIZES[] = { 1024, 2048, 4096, 8192, 16384 };
+
+constexpr bool
+CyFxUVCSegmentsSupported (
+        uint32_t bufSize)
+{
+    for (uint32_t size : CY_FX_UVC_SEG_BUF_SIZES)
+    {
+        if (size == bufSize)
+            return true;
+    }
+    return false;
+}
+
+/* Segment table of a buffer size and its number of entries; NULL if the size has none. */
+extern const CyFxUVCSegment_t *
+CyFxUVCSegmentsGet (
+        uint32_t bufSize,
+        uint32_t *count_p);
+
 #include <cyu3externcend.h>
 
 #endif /* _INCLUDED_CYFXUVCINMEM_H_ */
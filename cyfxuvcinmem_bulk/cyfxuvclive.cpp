@@ -0,0 +1,207 @@
+/*
+ ## UVC application live streaming mode (cyfxuvclive.cpp)
+ ## ===========================
+*/
+
+/* The schedule is kept by the streaming thread; the mode is written by the vendor request
+ * from the USB thread and read once per frame. As for the statistics, the counters are
+ * updated and read with the interrupts masked. Times are OS ms: a schedule in timestamp
+ * clock ticks would wrap within a long host stall. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3vic.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyfxuvclive.h"
+#include "cyfxuvcstats.h"
+#include "cyfxmemmap.h"
+
+/* Live mode state. */
+struct CyFxUVCLiveState_t
+{
+    volatile uint32_t mode;             // CyFxUVCStreamMode_t, from the vendor request
+    CyU3PDmaChannel *channel_p;         // Video channel, for the bytes the endpoint took
+    uint32_t ringBytes;                 // Size of its ring
+    uint32_t committedBytes;            // Committed since the channel was set up
+    uint32_t interval;                  // Frame interval in 100 ns
+    CyBool_t anchored;                  // Whether the frames are on the schedule below
+    uint32_t originMs;                  // OS time at which frame originIndex was due
+    uint32_t originIndex;
+    uint32_t index;                     // Frame being sent, counted from the session start
+    CyFxUVCLive_t report;               // Counters of the vendor request
+};
+
+static CyFxUVCLiveState_t glLive;
+
+/* OS time at which frame index is due. */
+static uint32_t
+CyFxUVCLiveDue (
+        uint32_t index)
+{
+    return glLive.originMs + static_cast<uint32_t>(static_cast<uint64_t>(index - glLive.originIndex) *
+            glLive.interval / 10000);
+}
+
+/* Start a new count of frames sent, frames dropped and skips, and forget the last skip and
+ * the latest frame seen, so that a read after -c covers one capture. The mode and the
+ * schedule are kept. The caller masks the interrupts. */
+static void
+CyFxUVCLiveClear (
+        void)
+{
+    CyU3PMemSet (reinterpret_cast<uint8_t *>(&glLive.report), 0, sizeof (glLive.report));
+    glLive.report.clearedMs = static_cast<uint32_t>(CyU3PGetTime ());
+}
+
+void
+CyFxUVCLiveStart (
+        CyU3PDmaChannel *channel_p,
+        uint8_t count,
+        uint32_t interval)
+{
+    glLive.channel_p = channel_p;
+    if (interval == 0)
+    {
+        interval = CY_FX_UVC_LIVE_DEFAULT_INTERVAL;
+    }
+    glLive.interval = (interval < CY_FX_UVC_LIVE_MIN_INTERVAL) ? CY_FX_UVC_LIVE_MIN_INTERVAL :
+            ((interval > CY_FX_UVC_LIVE_MAX_INTERVAL) ? CY_FX_UVC_LIVE_MAX_INTERVAL : interval);
+    glLive.index = 0;
+    glLive.originIndex = 0;
+    glLive.originMs = static_cast<uint32_t>(CyU3PGetTime ());
+    glLive.anchored = (glLive.mode == CY_FX_UVC_MODE_LIVE) ? CyTrue : CyFalse;
+    CyFxUVCLiveRingRestart (count);
+}
+
+void
+CyFxUVCLiveRingRestart (
+        uint8_t count)
+{
+    glLive.ringBytes = count * CY_FX_UVC_STREAM_BUF_SIZE;
+    glLive.committedBytes = 0;
+}
+
+uint32_t
+CyFxUVCLiveFrameWait (
+        void)
+{
+    if (!glLive.anchored)
+    {
+        return 0;
+    }
+
+    /* At most one frame interval once the frames are on schedule. */
+    int32_t wait = static_cast<int32_t>(CyFxUVCLiveDue (glLive.index) - static_cast<uint32_t>(CyU3PGetTime ()));
+    return (wait > 0) ? static_cast<uint32_t>(wait) : 0;
+}
+
+void CY_FX_HOT_CODE
+CyFxUVCLiveCommitted (
+        uint16_t length)
+{
+    glLive.committedBytes += length;
+}
+
+uint32_t
+CyFxUVCLiveFrameEnd (
+        void)
+{
+    glLive.index++;
+    if (glLive.mode != CY_FX_UVC_MODE_LIVE)
+    {
+        glLive.anchored = CyFalse;
+        return 0;
+    }
+
+    uint32_t now = static_cast<uint32_t>(CyU3PGetTime ());
+    if (!glLive.anchored)
+    {
+        /* Just switched to the live mode: the next frame is due now. */
+        glLive.originMs = now;
+        glLive.originIndex = glLive.index;
+        glLive.anchored = CyTrue;
+        return 0;
+    }
+
+    int32_t late = static_cast<int32_t>(now - CyFxUVCLiveDue (glLive.index));
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    glLive.report.frames++;
+    if ((late > 0) && (static_cast<uint32_t>(late) > glLive.report.maxLateMs))
+    {
+        glLive.report.maxLateMs = static_cast<uint32_t>(late);
+    }
+    CyU3PVicEnableInterrupts (mask);
+    if (late <= 0)
+    {
+        return 0;
+    }
+
+    /* Bytes committed and not taken by the endpoint yet. */
+    CyU3PDmaState_t state;
+    uint32_t prodBytes = 0, consBytes = 0, queued = 0;
+    if (CyU3PDmaChannelGetStatus (glLive.channel_p, &state, &prodBytes, &consBytes) == CY_U3P_SUCCESS)
+    {
+        queued = glLive.committedBytes - consBytes;
+    }
+
+    CyBool_t ageOver = (static_cast<uint32_t>(late) > CY_FX_UVC_LIVE_MAX_AGE_MS) ? CyTrue : CyFalse;
+    CyBool_t ringOver = (static_cast<uint64_t>(queued) * 100 > static_cast<uint64_t>(glLive.ringBytes) *
+            CY_FX_UVC_LIVE_MAX_RING_PERCENT) ? CyTrue : CyFalse;
+    uint32_t dropped = static_cast<uint32_t>(static_cast<uint64_t>(late) * 10000 / glLive.interval);
+    if ((!ageOver && !ringOver) || (dropped == 0))
+    {
+        return 0;
+    }
+
+    /* Skip to the latest frame due: the next one is less than an interval late. */
+    glLive.index += dropped;
+    mask = CyU3PVicDisableAllInterrupts ();
+    glLive.report.framesDropped += dropped;
+    glLive.report.skips++;
+    glLive.report.ageSkips += ageOver ? 1 : 0;
+    glLive.report.lastSkipMs = now;
+    glLive.report.lastLateMs = static_cast<uint32_t>(late);
+    glLive.report.lastRingBytes = queued;
+    glLive.report.lastDropped = dropped;
+    CyU3PVicEnableInterrupts (mask);
+    CyFxUVCStatsFramesDropped (dropped);
+    return dropped;
+}
+
+CyBool_t
+CyFxUVCLiveSelect (
+        uint32_t mode)
+{
+    if (mode >= CY_FX_UVC_MODE_COUNT)
+    {
+        return CyFalse;
+    }
+    glLive.mode = mode;
+    return CyTrue;
+}
+
+void
+CyFxUVCLiveSnapshot (
+        CyFxUVCLive_t *live_p,
+        CyBool_t clear)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    *live_p = glLive.report;
+    if (clear)
+    {
+        CyFxUVCLiveClear ();
+    }
+    CyU3PVicEnableInterrupts (mask);
+
+    live_p->version        = CY_FX_UVC_LIVE_VERSION;
+    live_p->length         = sizeof (CyFxUVCLive_t);
+    live_p->uptimeMs       = static_cast<uint32_t>(CyU3PGetTime ());
+    live_p->mode           = glLive.mode;
+    live_p->interval       = (glLive.interval != 0) ? glLive.interval : CY_FX_UVC_LIVE_DEFAULT_INTERVAL;
+    live_p->maxAgeMs       = CY_FX_UVC_LIVE_MAX_AGE_MS;
+    live_p->maxRingPercent = CY_FX_UVC_LIVE_MAX_RING_PERCENT;
+}
+
+/*[]*/
@@ -0,0 +1,115 @@
+/*
+ ## UVC application live streaming mode (cyfxuvclive.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCLIVE_H_
+#define _INCLUDED_CYFXUVCLIVE_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+#include <cyu3dma.h>
+#include "cyfxuvcinmem.h"
+
+/* Streaming modes, selected at run time with the CY_FX_UVC_VENDOR_RQT_LIVE_MODE request.
+ * The lossless mode, the default, sends every frame of the clip in turn as fast as the
+ * host reads them: after the host stops reading, the stream resumes where it stopped.
+ * The live mode sends the clip as a camera would: frame n of a session is due at the
+ * start of the session plus n frame intervals (dwFrameInterval of the committed probe,
+ * clamped to a sane range) and is not sent before. At the end of each frame the streamer
+ * checks how late the next frame is; when it is later than CY_FX_UVC_LIVE_MAX_AGE_MS, or
+ * when the DMA ring holds more than CY_FX_UVC_LIVE_MAX_RING_PERCENT of its bytes for the
+ * endpoint and the next frame is a full interval late, it skips ahead to the frame due now.
+ * Frames are only skipped whole, so the host sees no broken frame. The skipped frames are
+ * counted in the statistics block (framesDropped) and in CyFxUVCLive_t below, the wire
+ * format of the request (host/uvclive): 32-bit words only. */
+
+constexpr uint32_t CY_FX_UVC_LIVE_VERSION = 1;             // Layout version of CyFxUVCLive_t
+constexpr uint16_t CY_FX_UVC_LIVE_CLEAR = 1 << 0;          // wValue flag: clear the counters after reading
+constexpr uint16_t CY_FX_UVC_LIVE_SELECT = 1 << 1;         // wValue flag: first select the mode in the high byte
+constexpr uint32_t CY_FX_UVC_LIVE_MAX_AGE_MS = 100;        // Lateness of the next frame that makes the live mode skip
+constexpr uint32_t CY_FX_UVC_LIVE_MAX_RING_PERCENT = 50;   // Ring occupancy that makes it skip frames a full interval late
+constexpr uint32_t CY_FX_UVC_LIVE_DEFAULT_INTERVAL = 666666; // Frame interval in 100 ns without a committed probe: 15 fps
+constexpr uint32_t CY_FX_UVC_LIVE_MIN_INTERVAL = 10000;    // Committed frame intervals are clamped to 1 ms...
+constexpr uint32_t CY_FX_UVC_LIVE_MAX_INTERVAL = 10000000; // ...to 1 s: the probe bytes come from the host
+constexpr uint32_t CY_FX_UVC_LIVE_WAIT_STEP_MS = 10;       // Longest sleep of the loop while a frame is not due
+
+/* Streaming modes. */
+enum CyFxUVCStreamMode_t
+{
+    CY_FX_UVC_MODE_LOSSLESS = 0,        /* Every frame in turn, at the pace of the host. */
+    CY_FX_UVC_MODE_LIVE,                /* Frames on a wall-clock schedule, late ones skipped. */
+    CY_FX_UVC_MODE_COUNT
+};
+
+struct CyFxUVCLive_t
+{
+    uint32_t version;                   // CY_FX_UVC_LIVE_VERSION
+    uint32_t length;                    // Size of the block in bytes
+    uint32_t uptimeMs;                  // OS time at which the snapshot was taken
+    uint32_t clearedMs;                 // OS time at which the counters were last cleared
+    uint32_t mode;                      // CyFxUVCStreamMode_t
+    uint32_t interval;                  // Frame interval of the schedule in 100 ns
+    uint32_t maxAgeMs;                  // CY_FX_UVC_LIVE_MAX_AGE_MS
+    uint32_t maxRingPercent;            // CY_FX_UVC_LIVE_MAX_RING_PERCENT
+    uint32_t frames;                    // Frames sent in the live mode
+    uint32_t framesDropped;             // Frames skipped
+    uint32_t skips;                     // Skips of one or more frames
+    uint32_t ageSkips;                  // ...of them with the next frame over the age limit
+    uint32_t maxLateMs;                 // Latest the next frame was at the end of a frame
+    uint32_t lastSkipMs;                // OS time of the last skip
+    uint32_t lastLateMs;                // How late the next frame was then
+    uint32_t lastRingBytes;             // Ring bytes waiting for the endpoint then
+    uint32_t lastDropped;               // Frames it skipped
+};
+
+static_assert (sizeof (CyFxUVCLive_t) == 17 * sizeof (uint32_t), "CyFxUVCLive_t must be a packed array of 32-bit words");
+
+/* A streaming session starts on channel_p, a ring of count buffers, at the given frame
+ * interval: its first frame is due now. */
+extern void
+CyFxUVCLiveStart (
+        CyU3PDmaChannel *channel_p,
+        uint8_t count,
+        uint32_t interval);
+
+/* The video channel was rebuilt with count buffers between two frames (cyfxuvcring.h). */
+extern void
+CyFxUVCLiveRingRestart (
+        uint8_t count);
+
+/* Before the first buffer of a frame: the ms until the frame is due in the live mode, 0
+ * when it is due or in the lossless mode. The streaming loop sleeps in steps of at most
+ * CY_FX_UVC_LIVE_WAIT_STEP_MS while this is not 0, so that it sees a stop of the session. */
+extern uint32_t
+CyFxUVCLiveFrameWait (
+        void);
+
+/* Account for a committed buffer. */
+extern void
+CyFxUVCLiveCommitted (
+        uint16_t length);
+
+/* After the EOF buffer of a frame was committed. Returns the number of frames to skip
+ * before the next one sent, 0 in the lossless mode. */
+extern uint32_t
+CyFxUVCLiveFrameEnd (
+        void);
+
+/* Select the streaming mode; it applies from the next end of frame. False if mode is
+ * not a CyFxUVCStreamMode_t. */
+extern CyBool_t
+CyFxUVCLiveSelect (
+        uint32_t mode);
+
+/* Take a consistent copy of the live mode state, optionally clearing the counters. */
+extern void
+CyFxUVCLiveSnapshot (
+        CyFxUVCLive_t *live_p,
+        CyBool_t clear);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCLIVE_H_ */
+
+/*[]*/
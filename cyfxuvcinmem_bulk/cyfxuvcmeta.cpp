@@ -0,0 +1,71 @@
+/*
+ ## UVC application per-frame metadata (cyfxuvcmeta.cpp)
+ ## ===========================
+*/
+
+/* Called once per frame from the header writer. The channel status and the error
+ * counts are SDK calls; the error counts are cleared by each read, so they are summed
+ * here, and are only kept by a USB 3.0 link. */
+
+#include "cyu3system.h"
+#include "cyu3dma.h"
+#include "cyu3usb.h"
+#include "cyu3error.h"
+#include "cyfxuvcmeta.h"
+#include "cyfxmemmap.h"
+
+#ifdef CY_FX_UVC_METADATA_EN
+
+CY_FX_HOT_DATA CyFxUVCMetaState_t glUVCMeta;
+
+void
+CyFxUVCMetaStart (
+        CyU3PDmaChannel *channel_p)
+{
+    uint16_t phyErrors, linkErrors;
+
+    CyU3PMemSet (reinterpret_cast<uint8_t *>(&glUVCMeta), 0, sizeof (glUVCMeta));
+    glUVCMeta.channel_p = channel_p;
+
+    /* Drop the errors counted before the stream. */
+    CyU3PUsbGetErrorCounts (&phyErrors, &linkErrors);
+}
+
+void
+CyFxUVCMetaFill (
+        uint8_t *meta_p,
+        uint32_t ptsTicks,
+        const CyFxUVCSegment_t *seg_p)
+{
+    CyFxUVCFrameMeta_t *frame_p = reinterpret_cast<CyFxUVCFrameMeta_t *>(meta_p);
+    CyU3PDmaState_t state;
+    uint32_t prodBytes = 0, consBytes = 0;
+    uint16_t phyErrors = 0, linkErrors = 0;
+
+    if (CyU3PUsbGetErrorCounts (&phyErrors, &linkErrors) == CY_U3P_SUCCESS)
+    {
+        glUVCMeta.phyErrors  += phyErrors;
+        glUVCMeta.linkErrors += linkErrors;
+    }
+    if (CyU3PDmaChannelGetStatus (glUVCMeta.channel_p, &state, &prodBytes, &consBytes) != CY_U3P_SUCCESS)
+    {
+        consBytes = glUVCMeta.committedBytes;
+    }
+
+    frame_p->version        = CY_FX_UVC_META_VERSION;
+    frame_p->sequence       = glUVCMeta.sequence;
+    frame_p->ptsTicks       = ptsTicks;
+    frame_p->eofTicks       = CyFxUVCClockTicks ();
+    frame_p->firstSendTicks = seg_p->start ? frame_p->eofTicks : glUVCMeta.firstSendTicks;
+    frame_p->frameBytes     = glUVCMeta.frameBytes + seg_p->length;
+    frame_p->ringBytes      = glUVCMeta.committedBytes - consBytes;
+    frame_p->phyErrors      = glUVCMeta.phyErrors;
+    frame_p->linkErrors     = glUVCMeta.linkErrors;
+
+    glUVCMeta.sequence++;
+    glUVCMeta.frameBytes = 0;
+}
+
+#endif /* CY_FX_UVC_METADATA_EN */
+
+/*[]*/
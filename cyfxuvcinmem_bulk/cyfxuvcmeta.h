@@ -0,0 +1,116 @@
+/*
+ ## UVC application per-frame metadata (cyfxuvcmeta.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCMETA_H_
+#define _INCLUDED_CYFXUVCMETA_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+#include <cyu3dma.h>
+#include "cyfxuvcinmem.h"
+#include "cyfxuvcclock.h"
+
+/* Per-frame metadata for end-to-end latency analysis, sent as a UVC 1.5 payload header
+ * extension: the header of the last payload of each frame (EOF) is longer by
+ * CY_FX_UVC_META_LEN bytes and CyFxUVCFrameMeta_t follows the PTS and SCR fields.
+ * Hosts skip it through bHeaderLength; on Linux the uvcvideo metadata node hands the
+ * whole header to the application (host/uvcmeta). The header writer fills the block
+ * in place in the DMA buffer, once per frame. Built in with make CY_FX_UVC_METADATA=1;
+ * it needs the 12-byte header layout. All times are timestamp clock ticks
+ * (dwClockFrequency). */
+
+constexpr uint32_t CY_FX_UVC_META_VERSION = 1;         // Layout version of CyFxUVCFrameMeta_t
+
+struct CyFxUVCFrameMeta_t
+{
+    uint32_t version;                   // CY_FX_UVC_META_VERSION
+    uint32_t sequence;                  // Frame number since the stream started
+    uint32_t ptsTicks;                  // Scheduled: the capture time, also the PTS of the frame
+    uint32_t firstSendTicks;            // First payload of the frame committed to the endpoint
+    uint32_t eofTicks;                  // This payload, the last of the frame, prepared
+    uint32_t frameBytes;                // Payload bytes of the frame
+    uint32_t ringBytes;                 // Bytes committed and not yet sent by the endpoint
+    uint32_t phyErrors;                 // USB 3.0 PHY errors since the stream started
+    uint32_t linkErrors;                // USB 3.0 link errors since the stream started
+};
+
+static_assert (sizeof (CyFxUVCFrameMeta_t) == 9 * sizeof (uint32_t),
+        "CyFxUVCFrameMeta_t must be a packed array of 32-bit words");
+
+#ifdef CY_FX_UVC_METADATA_EN
+constexpr uint8_t CY_FX_UVC_META_LEN = sizeof (CyFxUVCFrameMeta_t); // Header extension of the EOF payloads
+static_assert (CY_FX_UVC_HEADER_LEN == CY_FX_UVC_MAX_HEADER, "the metadata follows the PTS and SCR fields");
+#else
+constexpr uint8_t CY_FX_UVC_META_LEN = 0;
+#endif
+
+constexpr uint8_t CY_FX_UVC_HEADER_EOF_LEN = CY_FX_UVC_HEADER_LEN + CY_FX_UVC_META_LEN; // Header of the EOF payloads
+
+#ifdef CY_FX_UVC_METADATA_EN
+
+/* Metadata of the stream in progress, kept by the streaming thread. */
+struct CyFxUVCMetaState_t
+{
+    uint32_t sequence;                  // Number of the frame being sent
+    uint32_t firstSendTicks;            // First commit of the frame being sent
+    uint32_t frameBytes;                // Payload committed for it so far
+    uint32_t committedBytes;            // Bytes committed since the stream started
+    uint32_t phyErrors;                 // Error counts accumulated since the stream started
+    uint32_t linkErrors;
+    CyU3PDmaChannel *channel_p;         // Video channel, for the bytes the endpoint sent
+};
+
+extern CyFxUVCMetaState_t glUVCMeta;
+
+/* Restart the counts for a new stream on the given channel. */
+extern void
+CyFxUVCMetaStart (
+        CyU3PDmaChannel *channel_p);
+
+/* Fill the metadata of the EOF payload seg_p at meta_p, in the DMA buffer. */
+extern void
+CyFxUVCMetaFill (
+        uint8_t *meta_p,
+        uint32_t ptsTicks,
+        const CyFxUVCSegment_t *seg_p);
+
+/* Account for a committed segment. */
+inline void
+CyFxUVCMetaCommitted (
+        const CyFxUVCSegment_t *seg_p)
+{
+    glUVCMeta.committedBytes += seg_p->commit;
+    if (seg_p->start)
+    {
+        glUVCMeta.firstSendTicks = CyFxUVCClockTicks ();
+    }
+    if (seg_p->header != CY_FX_UVC_HEADER_EOF)
+    {
+        glUVCMeta.frameBytes += seg_p->length;
+    }
+}
+
+/* The video channel was rebuilt between two frames (cyfxuvcring.h): its counts start from 0. */
+inline void
+CyFxUVCMetaRingRestart (
+        void)
+{
+    glUVCMeta.committedBytes = 0;
+}
+
+#else
+
+inline void CyFxUVCMetaStart (CyU3PDmaChannel *) { }
+inline void CyFxUVCMetaRingRestart (void) { }
+inline void CyFxUVCMetaFill (uint8_t *, uint32_t, const CyFxUVCSegment_t *) { }
+inline void CyFxUVCMetaCommitted (const CyFxUVCSegment_t *) { }
+
+#endif /* CY_FX_UVC_METADATA_EN */
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCMETA_H_ */
+
+/*[]*/
@@ -0,0 +1,143 @@
+/*
+ ## UVC application payload header writer (cyfxuvcpayload.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCPAYLOAD_H_
+#define _INCLUDED_CYFXUVCPAYLOAD_H_
+
+#include <cyu3types.h>
+#include "cyfxuvcinmem.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcscr.h"
+#include "cyfxuvcmeta.h"
+
+/* UVC payload header of the streaming loop, specialized on the header layout at compile
+ * time. The first word of the header (length, bit field header and the start of the PTS)
+ * is prebuilt for the four FID / EOF combinations, so a header costs a table load and one
+ * to three word stores: no copy and no branch. The FID toggles after each EOF header. The
+ * DMA buffers are cache line aligned, so the header stores are aligned.
+ *
+ * With PTS and SCR, the PTS is the timestamp clock when the first payload of the frame
+ * is prepared, the capture time of a frame of the frame store, and is repeated in every
+ * payload of the frame. It is kept pre-shifted into the header words. The SCR comes from
+ * the SOF / ITP latch (cyfxuvcscr.h). With MetaLen, the EOF headers are longer and carry
+ * the frame metadata (cyfxuvcmeta.h) after the SCR.
+ *
+ * The header is the same for every bus speed and for the one MJPEG format of the
+ * descriptors; neither is a template parameter. */
+
+/* Header layouts; the value is the header length. */
+enum CyFxUVCHeaderLayout_t
+{
+    CY_FX_UVC_HEADER_MINIMAL = 2,       /* Length and bit field header only. */
+    CY_FX_UVC_HEADER_PTS_SCR = 12       /* With the PTS and SCR fields. */
+};
+
+constexpr uint8_t CY_FX_UVC_HEADER_BFH_EOH = 1 << 7;   // End of header
+constexpr uint8_t CY_FX_UVC_HEADER_BFH_SCR = 1 << 3;   // SCR field present
+constexpr uint8_t CY_FX_UVC_HEADER_BFH_PTS = 1 << 2;   // PTS field present
+
+/* The FID and EOF bits index the prebuilt words. */
+static_assert ((CY_FX_UVC_HEADER_FRAME_ID == 1) && (CY_FX_UVC_HEADER_EOF == 2),
+        "FID and EOF must be the low two bits of the bit field header");
+static_assert (CY_FX_UVC_HEADER_DEFAULT_BFH ==
+        (CY_FX_UVC_HEADER_BFH_EOH | CY_FX_UVC_HEADER_BFH_SCR | CY_FX_UVC_HEADER_BFH_PTS),
+        "the default bit field header is the PTS / SCR layout");
+
+template <CyFxUVCHeaderLayout_t Layout, uint8_t MetaLen = 0>
+class CyFxUVCPayloadWriter
+{
+public:
+    static constexpr uint8_t length = static_cast<uint8_t>(Layout);
+
+    static_assert ((MetaLen == 0) || (Layout == CY_FX_UVC_HEADER_PTS_SCR), "the metadata follows the SCR");
+
+    /* Back to FID 0, for a new stream. */
+    void
+    Reset (
+            void)
+    {
+        fid = 0;
+    }
+
+    /* Write the header of segment seg_p at the start of a word aligned buffer. The first
+       segment of a frame takes its PTS. */
+    inline __attribute__ ((always_inline)) void
+    Write (
+            uint8_t *buffer_p,
+            const CyFxUVCSegment_t *seg_p)
+    {
+        uint8_t frameInd = seg_p->header;
+
+        if constexpr (Layout == CY_FX_UVC_HEADER_PTS_SCR)
+        {
+            if (seg_p->start)
+            {
+                pts = CyFxUVCClockTicks ();
+                ptsWord0 = pts << 16;
+                ptsWord1 = pts >> 16;
+            }
+        }
+
+        uint32_t first = firstWord[fid | frameInd];
+
+        if constexpr (Layout == CY_FX_UVC_HEADER_MINIMAL)
+        {
+            /* The payload starts right after: store the two header bytes only. */
+            *reinterpret_cast<Half_t *>(buffer_p) = static_cast<uint16_t>(first);
+        }
+        else
+        {
+            Word_t *word_p = reinterpret_cast<Word_t *>(buffer_p);
+            uint32_t scrWord1, scrWord2;
+
+            CyFxUVCScrGet (&scrWord1, &scrWord2);
+            word_p[0] = first | ptsWord0;
+            word_p[1] = ptsWord1 | scrWord1;
+            word_p[2] = scrWord2;
+
+            if constexpr (MetaLen != 0)
+            {
+                if (frameInd == CY_FX_UVC_HEADER_EOF)
+                {
+                    CyFxUVCMetaFill (buffer_p + length, pts, seg_p);
+                }
+            }
+        }
+        fid ^= static_cast<uint32_t>(frameInd >> 1);
+    }
+
+private:
+    typedef uint32_t Word_t __attribute__ ((may_alias));
+    typedef uint16_t Half_t __attribute__ ((may_alias));
+
+    static constexpr uint32_t bfh = CY_FX_UVC_HEADER_BFH_EOH |
+        ((Layout == CY_FX_UVC_HEADER_PTS_SCR) ? (CY_FX_UVC_HEADER_BFH_SCR | CY_FX_UVC_HEADER_BFH_PTS) : 0);
+
+    /* First header word, little endian: length (with the metadata at EOF), bit field
+       header; PTS bits 0-15 are ORed in. */
+    static constexpr uint32_t
+    FirstWord (
+            uint32_t bits)
+    {
+        return ((bits & CY_FX_UVC_HEADER_EOF) ? (length + MetaLen) : length) | ((bfh | bits) << 8);
+    }
+
+    static constexpr uint32_t firstWord[4] = { FirstWord (0), FirstWord (1), FirstWord (2), FirstWord (3) };
+
+    uint32_t fid = 0;                   /* Frame ID of the frame being sent. */
+    uint32_t pts = 0;                   /* PTS of the frame being sent. */
+    uint32_t ptsWord0 = 0;              /* PTS bits 0-15, in bits 16-31 of header word 0. */
+    uint32_t ptsWord1 = 0;              /* PTS bits 16-31, in bits 0-15 of header word 1. */
+};
+
+/* The writer of the streaming loop, for the CY_FX_UVC_HEADER_LEN of the build. */
+static_assert ((CY_FX_UVC_HEADER_LEN == CY_FX_UVC_HEADER_MINIMAL) || (CY_FX_UVC_HEADER_LEN == CY_FX_UVC_HEADER_PTS_SCR),
+        "CY_FX_UVC_HEADER_LEN must be one of the header layouts");
+typedef CyFxUVCPayloadWriter<static_cast<CyFxUVCHeaderLayout_t>(CY_FX_UVC_HEADER_LEN), CY_FX_UVC_META_LEN>
+    CyFxUVCStreamWriter_t;
+
+#endif /* _INCLUDED_CYFXUVCPAYLOAD_H_ */
+
+/*[]*/
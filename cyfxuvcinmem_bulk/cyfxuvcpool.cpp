@@ -0,0 +1,99 @@
+/*
+ ## UVC application fixed-size block pool (cyfxuvcpool.cpp)
+ ## ===========================
+*/
+
+/* The interrupt mask is held only around the list update, which has no loop, no wait
+ * and no call other than the VIC mask itself: the worst case masked time is the common
+ * case. The checks of the free, including a division done in software on the ARM926,
+ * run before masking. Alloc and free are hot code so that an interrupt handler does not
+ * take SYSMEM fetches for them. */
+
+#include "cyu3system.h"
+#include "cyu3error.h"
+#include "cyu3vic.h"
+#include "cyfxmemmap.h"
+#include "cyfxuvcpool.h"
+
+CyU3PReturnStatus_t
+CyFxUVCPoolCreate (
+        CyFxUVCPool_t *pool_p,
+        void *mem_p,
+        uint32_t size,
+        uint32_t count)
+{
+    uint32_t blockSize = CyFxUVCPoolBlockSize (size);
+
+    if ((pool_p == NULL) || (mem_p == NULL) || (count == 0) ||
+            ((reinterpret_cast<uintptr_t>(mem_p) & 3) != 0))
+    {
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+
+    /* Thread the free list through the blocks, lowest address first. */
+    uint8_t *block_p = static_cast<uint8_t *>(mem_p);
+    for (uint32_t i = 0; i + 1 < count; i++)
+    {
+        *reinterpret_cast<void **>(block_p) = block_p + blockSize;
+        block_p += blockSize;
+    }
+    *reinterpret_cast<void **>(block_p) = NULL;
+
+    pool_p->free_p     = mem_p;
+    pool_p->base_p     = static_cast<uint8_t *>(mem_p);
+    pool_p->end_p      = block_p + blockSize;
+    pool_p->blockSize  = blockSize;
+    pool_p->blockCount = count;
+    pool_p->freeCount  = count;
+    pool_p->minFree    = count;
+    pool_p->failCount  = 0;
+    return CY_U3P_SUCCESS;
+}
+
+void * CY_FX_HOT_CODE
+CyFxUVCPoolAlloc (
+        CyFxUVCPool_t *pool_p)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    void **block_p = static_cast<void **>(pool_p->free_p);
+
+    if (block_p != NULL)
+    {
+        pool_p->free_p = *block_p;
+        pool_p->freeCount--;
+        if (pool_p->freeCount < pool_p->minFree)
+        {
+            pool_p->minFree = pool_p->freeCount;
+        }
+    }
+    else
+    {
+        pool_p->failCount++;
+    }
+
+    CyU3PVicEnableInterrupts (mask);
+    return block_p;
+}
+
+CyU3PReturnStatus_t CY_FX_HOT_CODE
+CyFxUVCPoolFree (
+        CyFxUVCPool_t *pool_p,
+        void *block_p)
+{
+    uint8_t *byte_p = static_cast<uint8_t *>(block_p);
+
+    if ((byte_p < pool_p->base_p) || (byte_p >= pool_p->end_p) ||
+            (static_cast<uint32_t>(byte_p - pool_p->base_p) % pool_p->blockSize != 0))
+    {
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    *static_cast<void **>(block_p) = pool_p->free_p;
+    pool_p->free_p = block_p;
+    pool_p->freeCount++;
+    CyU3PVicEnableInterrupts (mask);
+    return CY_U3P_SUCCESS;
+}
+
+/*[]*/
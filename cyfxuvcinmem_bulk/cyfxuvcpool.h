@@ -0,0 +1,74 @@
+/*
+ ## UVC application fixed-size block pool (cyfxuvcpool.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCPOOL_H_
+#define _INCLUDED_CYFXUVCPOOL_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* Pool of equal sized blocks for small allocations made from callbacks and interrupt
+ * handlers (event records, trace entries), where CyU3PMemAlloc can only try the byte
+ * pool with CYU3P_NO_WAIT and fails under contention. The free blocks form a singly
+ * linked list through their first word; alloc and free pop and push its head with the
+ * interrupts masked, a constant handful of loads and stores that never waits. Alloc
+ * fails only when every block is in use. The memory is supplied by the caller, usually
+ * a static array sized with CyFxUVCPoolWords. */
+
+struct CyFxUVCPool_t
+{
+    void     *free_p;                   // First free block, NULL if none
+    uint8_t  *base_p;                   // First block
+    uint8_t  *end_p;                    // End of the last block
+    uint32_t  blockSize;                // Block size in bytes, a multiple of 4
+    uint32_t  blockCount;               // Number of blocks
+    uint32_t  freeCount;                // Blocks currently free
+    uint32_t  minFree;                  // Lowest freeCount seen since the pool was created
+    uint32_t  failCount;                // Allocations that found the pool empty
+};
+
+/* Block size actually used for an object of the given size. */
+constexpr uint32_t
+CyFxUVCPoolBlockSize (
+        uint32_t size)
+{
+    return (size < sizeof (void *)) ? static_cast<uint32_t>(sizeof (void *)) : ((size + 3u) & ~3u);
+}
+
+/* Number of 32-bit words of storage needed for count blocks of the given size. */
+constexpr uint32_t
+CyFxUVCPoolWords (
+        uint32_t size,
+        uint32_t count)
+{
+    return CyFxUVCPoolBlockSize (size) * count / sizeof (uint32_t);
+}
+
+/* Set up a pool over mem_p, which must be word aligned and hold
+ * CyFxUVCPoolWords (size, count) words. All the blocks start free. */
+extern CyU3PReturnStatus_t
+CyFxUVCPoolCreate (
+        CyFxUVCPool_t *pool_p,
+        void *mem_p,
+        uint32_t size,
+        uint32_t count);
+
+/* Take a block; NULL if the pool is empty. Callable from any context. */
+extern void *
+CyFxUVCPoolAlloc (
+        CyFxUVCPool_t *pool_p);
+
+/* Return a block taken from the same pool. Pointers that are not the start of one of
+ * its blocks are rejected with CY_U3P_ERROR_BAD_ARGUMENT. Callable from any context. */
+extern CyU3PReturnStatus_t
+CyFxUVCPoolFree (
+        CyFxUVCPool_t *pool_p,
+        void *block_p);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCPOOL_H_ */
+
+/*[]*/
@@ -0,0 +1,236 @@
+/*
+ ## UVC application ThreadX performance report (cyfxuvcprofile.cpp)
+ ## ===========================
+*/
+
+/* Only built into profiling builds; the counters do not exist in the other FX3 libraries.
+ *
+ * The sample is taken in the expiration function of an OS timer. Timers run in the
+ * ThreadX system timer thread, which has the highest priority, so no thread is created,
+ * deleted or scheduled while the created list is walked. The sample is collected into a
+ * scratch block and published with the interrupts masked, so the vendor request always
+ * copies a complete sample. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3vic.h"
+#include "cyfxuvcprofile.h"
+
+#ifdef CYU3P_PROFILE_EN
+
+static CyU3PTimer        glProfileTimer;            /* Sampling timer. */
+static CyU3PThread      *glProfileAnchor = NULL;    /* Start of the walk over the created threads. */
+static CyU3PDmaChannel  *glProfileChannel = NULL;   /* Video streaming channel. */
+static CyFxUVCProfile_t  glProfileScratch;          /* Sample being collected. */
+static CyFxUVCProfile_t  glProfile;                 /* Latest complete sample. */
+
+/* Keep the first error of a sample. */
+static inline void
+CyFxUVCProfileStatus (
+        CyFxUVCProfile_t *profile_p,
+        UINT status)
+{
+    if ((status != TX_SUCCESS) && (profile_p->status == TX_SUCCESS))
+    {
+        profile_p->status = status;
+    }
+}
+
+/* Store ThreadX counters into consecutive words of the report. ULONG is 32 bits on the
+ * FX3 but not in the host build. */
+static void
+CyFxUVCProfileCopy (
+        uint32_t *dst_p,
+        const ULONG *src_p,
+        uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        dst_p[i] = static_cast<uint32_t>(src_p[i]);
+    }
+}
+
+static void
+CyFxUVCProfileMutex (
+        CyU3PMutex *mutex_p,
+        CyFxUVCProfileMutexInfo_t *info_p)
+{
+    ULONG v[6] = {};
+
+    /* The channel lock only exists while streaming; a failed query reports zeroes. */
+    if ((mutex_p == NULL) || (tx_mutex_performance_info_get (mutex_p, &v[0], &v[1], &v[2], &v[3],
+                    &v[4], &v[5]) != TX_SUCCESS))
+    {
+        CyU3PMemSet ((uint8_t *)v, 0, sizeof (v));
+    }
+    static_assert (sizeof (*info_p) == 6 * sizeof (uint32_t), "counters out of step with the report");
+    CyFxUVCProfileCopy (&info_p->puts, v, 6);
+}
+
+static void
+CyFxUVCProfileEvent (
+        CyU3PEvent *event_p,
+        CyFxUVCProfileEventInfo_t *info_p)
+{
+    ULONG v[4] = {};
+
+    if ((event_p == NULL) || (tx_event_flags_performance_info_get (event_p, &v[0], &v[1], &v[2],
+                    &v[3]) != TX_SUCCESS))
+    {
+        CyU3PMemSet ((uint8_t *)v, 0, sizeof (v));
+    }
+    static_assert (sizeof (*info_p) == 4 * sizeof (uint32_t), "counters out of step with the report");
+    CyFxUVCProfileCopy (&info_p->sets, v, 4);
+}
+
+static void
+CyFxUVCProfileSystem (
+        CyFxUVCProfile_t *profile_p)
+{
+    ULONG v[11] = {};
+    UINT status;
+
+    status = tx_thread_performance_system_info_get (&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+            &v[7], &v[8], &v[9], &v[10]);
+    CyFxUVCProfileStatus (profile_p, status);
+    static_assert (sizeof (profile_p->system) == 11 * sizeof (uint32_t), "counters out of step with the report");
+    CyFxUVCProfileCopy (&profile_p->system.resumptions, v, 11);
+
+    status = tx_mutex_performance_system_info_get (&v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+    CyFxUVCProfileStatus (profile_p, status);
+    CyFxUVCProfileCopy (&profile_p->mutex[CY_FX_UVC_PROF_MUTEX_ALL].puts, v, 6);
+
+    status = tx_event_flags_performance_system_info_get (&v[0], &v[1], &v[2], &v[3]);
+    CyFxUVCProfileStatus (profile_p, status);
+    CyFxUVCProfileCopy (&profile_p->event[CY_FX_UVC_PROF_EVENT_ALL].sets, v, 4);
+}
+
+/* Walk the created thread list once around, starting at the application thread. */
+static void
+CyFxUVCProfileThreads (
+        CyFxUVCProfile_t *profile_p)
+{
+    TX_THREAD *table[CY_FX_UVC_PROFILE_MAX_THREADS];
+    TX_THREAD *preemptedBy[CY_FX_UVC_PROFILE_MAX_THREADS];
+    TX_THREAD *thread_p = glProfileAnchor;
+    uint32_t count = 0, total = 0;
+
+    do
+    {
+        CHAR *name = NULL;
+        UINT state = 0, priority = 0, threshold = 0;
+        ULONG runCount = 0, slice = 0;
+        TX_THREAD *next_p = NULL, *suspended_p = NULL;
+
+        UINT status = tx_thread_info_get (thread_p, &name, &state, &runCount, &priority, &threshold,
+                &slice, &next_p, &suspended_p);
+        if (status != TX_SUCCESS)
+        {
+            CyFxUVCProfileStatus (profile_p, status);
+            break;
+        }
+
+        if (count < CY_FX_UVC_PROFILE_MAX_THREADS)
+        {
+            CyFxUVCProfileThread_t *entry_p = &profile_p->thread[count];
+            ULONG v[9] = {};
+
+            status = tx_thread_performance_info_get (thread_p, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+                    &v[6], &v[7], &v[8], &preemptedBy[count]);
+            CyFxUVCProfileStatus (profile_p, status);
+            if (status != TX_SUCCESS)
+            {
+                preemptedBy[count] = NULL;
+            }
+
+            CyU3PMemSet ((uint8_t *)entry_p->name, 0, sizeof (entry_p->name));
+            for (uint32_t i = 0; (name != NULL) && (name[i] != 0) && (i < sizeof (entry_p->name) - 1); i++)
+            {
+                entry_p->name[i] = name[i];
+            }
+            /* Time slices (v[5]) and wait aborts (v[8]) are only in the system totals. */
+            entry_p->priority     = priority;
+            entry_p->state        = state;
+            entry_p->runCount     = static_cast<uint32_t>(runCount);
+            CyFxUVCProfileCopy (&entry_p->resumptions, v, 5);
+            entry_p->relinquishes = static_cast<uint32_t>(v[6]);
+            entry_p->timeouts     = static_cast<uint32_t>(v[7]);
+            table[count++] = thread_p;
+        }
+        total++;
+
+        thread_p = next_p;
+    } while ((thread_p != NULL) && (thread_p != glProfileAnchor) && (total < 256));
+
+    /* Preempting threads are reported by index into the table. */
+    for (uint32_t i = 0; i < count; i++)
+    {
+        profile_p->thread[i].lastPreemptedBy = CY_FX_UVC_PROFILE_NONE;
+        for (uint32_t j = 0; (j < count) && (preemptedBy[i] != NULL); j++)
+        {
+            if (table[j] == preemptedBy[i])
+            {
+                profile_p->thread[i].lastPreemptedBy = j;
+                break;
+            }
+        }
+    }
+
+    profile_p->threadCount = count;
+    profile_p->threadTotal = total;
+    profile_p->appThread   = 0;
+}
+
+/* Timer expiration function: take a sample and publish it. */
+static void
+CyFxUVCProfileSample (
+        uint32_t /*input*/)
+{
+    CyFxUVCProfile_t *profile_p = &glProfileScratch;
+
+    profile_p->status   = TX_SUCCESS;
+    profile_p->sampleMs = static_cast<uint32_t>(CyU3PGetTime ());
+    CyFxUVCProfileSystem (profile_p);
+    CyFxUVCProfileThreads (profile_p);
+
+    CyFxUVCProfileMutex (CyFxDmaBufferLockGet (), &profile_p->mutex[CY_FX_UVC_PROF_MUTEX_BUFMGR]);
+    CyFxUVCProfileMutex ((glProfileChannel != NULL) ? &glProfileChannel->lock : NULL,
+            &profile_p->mutex[CY_FX_UVC_PROF_MUTEX_CHANNEL]);
+    CyFxUVCProfileEvent ((glProfileChannel != NULL) ? &glProfileChannel->flags : NULL,
+            &profile_p->event[CY_FX_UVC_PROF_EVENT_CHANNEL]);
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    profile_p->samples = glProfile.samples + 1;
+    CyU3PMemCopy ((uint8_t *)&glProfile, (uint8_t *)profile_p, sizeof (glProfile));
+    CyU3PVicEnableInterrupts (mask);
+}
+
+CyU3PReturnStatus_t
+CyFxUVCProfileInit (
+        CyU3PThread *appThread_p,
+        CyU3PDmaChannel *channel_p)
+{
+    CyU3PMemSet ((uint8_t *)&glProfile, 0, sizeof (glProfile));
+    CyU3PMemSet ((uint8_t *)&glProfileScratch, 0, sizeof (glProfileScratch));
+    glProfile.version = glProfileScratch.version = CY_FX_UVC_PROFILE_VERSION;
+    glProfile.length  = glProfileScratch.length  = sizeof (CyFxUVCProfile_t);
+    glProfileAnchor  = appThread_p;
+    glProfileChannel = channel_p;
+
+    /* The OS tick is 1 ms. */
+    return CyU3PTimerCreate (&glProfileTimer, CyFxUVCProfileSample, 0, CY_FX_UVC_PROFILE_PERIOD_MS,
+            CY_FX_UVC_PROFILE_PERIOD_MS, CYU3P_AUTO_ACTIVATE);
+}
+
+void
+CyFxUVCProfileSnapshot (
+        CyFxUVCProfile_t *profile_p)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    CyU3PMemCopy ((uint8_t *)profile_p, (uint8_t *)&glProfile, sizeof (glProfile));
+    CyU3PVicEnableInterrupts (mask);
+}
+
+#endif /* CYU3P_PROFILE_EN */
+
+/*[]*/
@@ -0,0 +1,135 @@
+/*
+ ## UVC application ThreadX performance report (cyfxuvcprofile.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCPROFILE_H_
+#define _INCLUDED_CYFXUVCPROFILE_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+#include <cyu3os.h>
+#include <cyu3dma.h>
+
+/* ProfileRelease / ProfileDebug builds link the FX3 libraries with the ThreadX
+ * performance counters enabled (TX_*_ENABLE_PERFORMANCE_INFO in cyu3tx.h). A timer
+ * samples them once per CY_FX_UVC_PROFILE_PERIOD_MS: per-thread scheduling counts for
+ * every thread in the system, the system-wide thread, mutex and event flag counts, and
+ * the per-object counts of the locks the streaming loop contends for. The latest sample
+ * is read with the CY_FX_UVC_VENDOR_RQT_GET_PROFILE vendor request; CyFxUVCProfile_t
+ * below is the wire format. The ThreadX counters are cumulative since boot, so the host
+ * differences two samples to get rates. */
+
+constexpr uint32_t CY_FX_UVC_PROFILE_VERSION = 1;      // Layout version of CyFxUVCProfile_t
+constexpr uint32_t CY_FX_UVC_PROFILE_PERIOD_MS = 1000; // Sampling period of the counters
+constexpr uint32_t CY_FX_UVC_PROFILE_MAX_THREADS = 12; // Threads reported, in creation order
+constexpr uint32_t CY_FX_UVC_PROFILE_NAME_LEN = 16;    // Thread name bytes, NUL terminated
+constexpr uint32_t CY_FX_UVC_PROFILE_NONE = 0xFFFFFFFF; // No thread
+
+/* Mutexes reported individually. */
+enum CyFxUVCProfileMutex_t
+{
+    CY_FX_UVC_PROF_MUTEX_ALL = 0,       /* System-wide totals over all mutexes. */
+    CY_FX_UVC_PROF_MUTEX_BUFMGR,        /* DMA buffer manager lock (cyfxtx.cpp). */
+    CY_FX_UVC_PROF_MUTEX_CHANNEL,       /* Lock of the video streaming DMA channel. */
+    CY_FX_UVC_PROF_MUTEX_COUNT
+};
+
+/* Event flag groups reported individually. */
+enum CyFxUVCProfileEvent_t
+{
+    CY_FX_UVC_PROF_EVENT_ALL = 0,       /* System-wide totals over all event flag groups. */
+    CY_FX_UVC_PROF_EVENT_CHANNEL,       /* Event flags of the video streaming DMA channel. */
+    CY_FX_UVC_PROF_EVENT_COUNT
+};
+
+struct CyFxUVCProfileThread_t
+{
+    char     name[CY_FX_UVC_PROFILE_NAME_LEN]; // Thread name, truncated
+    uint32_t priority;                  // Current priority
+    uint32_t state;                     // ThreadX state (TX_READY, TX_SLEEP, ...)
+    uint32_t runCount;                  // Times the thread was scheduled
+    uint32_t resumptions;               // Resumes (made ready)
+    uint32_t suspensions;               // Suspensions on an OS object or sleep
+    uint32_t solicitedPreemptions;      // Preempted by a thread made ready by an OS call
+    uint32_t interruptPreemptions;      // Preempted by a thread made ready from an ISR
+    uint32_t priorityInversions;        // Waited on a lock held by a lower priority thread
+    uint32_t relinquishes;              // tx_thread_relinquish calls
+    uint32_t timeouts;                  // Suspensions that ended in a timeout
+    uint32_t lastPreemptedBy;           // Index of the thread that last preempted this one
+};
+
+struct CyFxUVCProfileSystem_t
+{
+    uint32_t resumptions;               // Thread resumes
+    uint32_t suspensions;               // Thread suspensions
+    uint32_t solicitedPreemptions;      // Preemptions caused by OS calls
+    uint32_t interruptPreemptions;      // Preemptions caused by ISRs
+    uint32_t priorityInversions;        // Priority inversions
+    uint32_t timeSlices;                // Time-slice expirations
+    uint32_t relinquishes;              // tx_thread_relinquish calls
+    uint32_t timeouts;                  // Suspension timeouts
+    uint32_t waitAborts;                // Suspensions aborted
+    uint32_t nonIdleReturns;            // Returns to the scheduler with another thread ready
+    uint32_t idleReturns;               // Returns to the scheduler with nothing ready
+};
+
+struct CyFxUVCProfileMutexInfo_t
+{
+    uint32_t puts;                      // Releases
+    uint32_t gets;                      // Acquisitions
+    uint32_t suspensions;               // Acquisitions that had to wait
+    uint32_t timeouts;                  // Waits that timed out
+    uint32_t inversions;                // Owner had a lower priority than the waiter
+    uint32_t inheritances;              // Owner priority raised by inheritance
+};
+
+struct CyFxUVCProfileEventInfo_t
+{
+    uint32_t sets;                      // Flag set calls
+    uint32_t gets;                      // Flag get calls
+    uint32_t suspensions;               // Gets that had to wait
+    uint32_t timeouts;                  // Waits that timed out
+};
+
+struct CyFxUVCProfile_t
+{
+    uint32_t version;                   // CY_FX_UVC_PROFILE_VERSION
+    uint32_t length;                    // Size of the block in bytes
+    uint32_t sampleMs;                  // OS time at which the counters were sampled
+    uint32_t samples;                   // Number of samples taken, 0 if none yet
+    uint32_t status;                    // First ThreadX error of the sample, 0 if none
+    uint32_t threadCount;               // Entries used in thread[]
+    uint32_t threadTotal;               // Threads in the system, may exceed threadCount
+    uint32_t appThread;                 // Index of the UVC application thread
+    CyFxUVCProfileSystem_t system;
+    CyFxUVCProfileMutexInfo_t mutex[CY_FX_UVC_PROF_MUTEX_COUNT];
+    CyFxUVCProfileEventInfo_t event[CY_FX_UVC_PROF_EVENT_COUNT];
+    CyFxUVCProfileThread_t thread[CY_FX_UVC_PROFILE_MAX_THREADS];
+};
+
+static_assert (sizeof (CyFxUVCProfile_t) % sizeof (uint32_t) == 0,
+        "CyFxUVCProfile_t must be a packed array of 32-bit words");
+
+/* Start sampling. The created thread list is walked from appThread_p, which is also
+ * the thread flagged as appThread in the report. Needs the OS timer running. */
+extern CyU3PReturnStatus_t
+CyFxUVCProfileInit (
+        CyU3PThread *appThread_p,
+        CyU3PDmaChannel *channel_p);
+
+/* Copy the latest sample. */
+extern void
+CyFxUVCProfileSnapshot (
+        CyFxUVCProfile_t *profile_p);
+
+/* Buffer manager lock, for the report. Defined in cyfxtx.cpp. */
+extern CyU3PMutex *
+CyFxDmaBufferLockGet (
+        void);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCPROFILE_H_ */
+
+/*[]*/
@@ -0,0 +1,269 @@
+/*
+ ## UVC application adaptive DMA ring depth (cyfxuvcring.cpp)
+ ## ===========================
+*/
+
+/* The samples are taken by the streaming thread once per buffer and read by the vendor
+ * request from the USB thread; as for the statistics, updates and the snapshot run with
+ * the interrupts masked. The channel status is read outside the critical section. The
+ * controller only decides; CyFxUVCApplnResize (cyfxuvcinmem.cpp) rebuilds the channel. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3vic.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyfxuvcring.h"
+
+#ifdef CY_FX_UVC_RING_ADAPT_EN
+
+constexpr uint32_t CY_FX_UVC_RING_BLOCK_TICKS = CY_FX_UVC_CLOCK_HZ / 1000000 * CY_FX_UVC_RING_BLOCK_US;
+
+/* Depth of the first session: the build's ring, within the ceiling. */
+constexpr uint8_t CY_FX_UVC_RING_START_COUNT = (CY_FX_UVC_STREAM_BUF_COUNT > CY_FX_UVC_RING_MAX_COUNT) ?
+    CY_FX_UVC_RING_MAX_COUNT : ((CY_FX_UVC_STREAM_BUF_COUNT < CY_FX_UVC_RING_MIN_COUNT) ?
+            CY_FX_UVC_RING_MIN_COUNT : CY_FX_UVC_STREAM_BUF_COUNT);
+
+/* Controller state, kept by the streaming thread. */
+struct CyFxUVCRingState_t
+{
+    CyU3PDmaChannel *channel_p;         // Video channel, for the bytes the endpoint took
+    uint8_t count = CY_FX_UVC_RING_START_COUNT; // Depth of the channel
+    uint32_t committedBytes;            // Committed since the channel was set up
+    uint32_t windowStartMs;             // OS time at which the window started
+    CyFxUVCRingWindow_t window;         // Samples of the window in progress
+    uint32_t spareRun;                  // Windows in a row with spare buffers
+    uint32_t spareMin;                  // Fewest spare buffers over them
+    CyFxUVCRingDecision_t pending;      // Decision waiting for its result
+    CyFxUVCRing_t report;               // Counters, histogram and log of the vendor request
+};
+
+static CyFxUVCRingState_t glUVCRing;
+
+/* Start a new window. Must be called with the interrupts masked. */
+static void
+CyFxUVCRingWindowClear (
+        void)
+{
+    CyU3PMemSet (reinterpret_cast<uint8_t *>(&glUVCRing.window), 0, sizeof (glUVCRing.window));
+    glUVCRing.window.minBuffers = 0xFFFFFFFF;
+}
+
+/* Clear the counters of the report. Must be called with the interrupts masked. */
+static void
+CyFxUVCRingClear (
+        void)
+{
+    CyU3PMemSet (reinterpret_cast<uint8_t *>(&glUVCRing.report), 0, sizeof (glUVCRing.report));
+    glUVCRing.report.clearedMs = static_cast<uint32_t>(CyU3PGetTime ());
+}
+
+uint8_t
+CyFxUVCRingCount (
+        void)
+{
+    return glUVCRing.count;
+}
+
+void
+CyFxUVCRingStart (
+        CyU3PDmaChannel *channel_p)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    glUVCRing.channel_p = channel_p;
+    glUVCRing.committedBytes = 0;
+    glUVCRing.windowStartMs = static_cast<uint32_t>(CyU3PGetTime ());
+    glUVCRing.spareRun = 0;
+    CyFxUVCRingWindowClear ();
+    CyU3PVicEnableInterrupts (mask);
+}
+
+/* Bytes committed and not taken by the endpoint yet. */
+static uint32_t
+CyFxUVCRingQueued (
+        void)
+{
+    CyU3PDmaState_t state;
+    uint32_t prodBytes = 0, consBytes = 0;
+
+    if (CyU3PDmaChannelGetStatus (glUVCRing.channel_p, &state, &prodBytes, &consBytes) != CY_U3P_SUCCESS)
+    {
+        return 0;
+    }
+    return glUVCRing.committedBytes - consBytes;
+}
+
+void CY_FX_HOT_CODE
+CyFxUVCRingBuffer (
+        uint32_t waitTicks)
+{
+    uint32_t queued = (CyFxUVCRingQueued () + CY_FX_UVC_STREAM_BUF_SIZE - 1) / CY_FX_UVC_STREAM_BUF_SIZE;
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    CyFxUVCRingWindow_t &window = glUVCRing.window;
+
+    window.samples++;
+    if (waitTicks > CY_FX_UVC_RING_BLOCK_TICKS)
+    {
+        window.full++;
+        window.blockedUs += waitTicks / (CY_FX_UVC_CLOCK_HZ / 1000000);
+    }
+    window.dry += (queued == 0) ? 1 : 0;
+    window.minBuffers = (queued < window.minBuffers) ? queued : window.minBuffers;
+    window.maxBuffers = (queued > window.maxBuffers) ? queued : window.maxBuffers;
+    glUVCRing.report.histogram[(queued < CY_FX_UVC_RING_HIST_BINS) ? queued : (CY_FX_UVC_RING_HIST_BINS - 1)]++;
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void CY_FX_HOT_CODE
+CyFxUVCRingCommitted (
+        uint16_t length)
+{
+    glUVCRing.committedBytes += length;
+}
+
+CyBool_t
+CyFxUVCRingDrained (
+        void)
+{
+    return (CyFxUVCRingQueued () == 0) ? CyTrue : CyFalse;
+}
+
+uint8_t
+CyFxUVCRingFrameEnd (
+        void)
+{
+    uint32_t now = static_cast<uint32_t>(CyU3PGetTime ());
+    uint32_t count = glUVCRing.count, target = count;
+    CyFxUVCRingReason_t reason = CY_FX_UVC_RING_GROW_BURSTY;
+    uint32_t windowStartMs = glUVCRing.windowStartMs;
+    CyFxUVCRingWindow_t window;
+
+    if (now - windowStartMs < CY_FX_UVC_RING_WINDOW_MS)
+    {
+        return glUVCRing.count;
+    }
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    window = glUVCRing.window;
+    CyFxUVCRingWindowClear ();
+    glUVCRing.report.windows++;
+    glUVCRing.report.last = window;
+    CyU3PVicEnableInterrupts (mask);
+    glUVCRing.windowStartMs = now;
+
+    if (window.samples == 0)
+    {
+        return glUVCRing.count;
+    }
+
+    if ((window.blockedUs >= (now - windowStartMs) * CY_FX_UVC_RING_GROW_PERMILLE) &&
+            (window.dry * 1000 >= window.samples * CY_FX_UVC_RING_GROW_PERMILLE) && (window.dry != 0))
+    {
+        /* Full while the host paused, dry while it read: deepen by half. */
+        target = count + ((count / 2 > 1) ? count / 2 : 1);
+        target = (target > CY_FX_UVC_RING_MAX_COUNT) ? CY_FX_UVC_RING_MAX_COUNT : target;
+        glUVCRing.spareRun = 0;
+    }
+    else
+    {
+        /* A sample sees at most count - 1 buffers queued, the loop holds the last one.
+           Buffers above the highest occupancy were never used, those below the lowest
+           never drained. */
+        uint32_t top = (count - 1 > window.maxBuffers) ? (count - 1 - window.maxBuffers) : 0;
+        uint32_t spare = (top > window.minBuffers) ? top : window.minBuffers;
+
+        spare = (spare > CY_FX_UVC_RING_MARGIN) ? (spare - CY_FX_UVC_RING_MARGIN) : 0;
+        if (spare == 0)
+        {
+            glUVCRing.spareRun = 0;
+        }
+        else
+        {
+            glUVCRing.spareMin = ((glUVCRing.spareRun == 0) || (spare < glUVCRing.spareMin)) ? spare : glUVCRing.spareMin;
+            glUVCRing.spareRun++;
+        }
+        if (glUVCRing.spareRun >= CY_FX_UVC_RING_SHRINK_WINDOWS)
+        {
+            target = (count > CY_FX_UVC_RING_MIN_COUNT + glUVCRing.spareMin) ? (count - glUVCRing.spareMin) :
+                CY_FX_UVC_RING_MIN_COUNT;
+            reason = CY_FX_UVC_RING_SHRINK_SPARE;
+            glUVCRing.spareRun = 0;
+        }
+    }
+
+    if (target == count)
+    {
+        return glUVCRing.count;
+    }
+    glUVCRing.pending.timeMs    = now;
+    glUVCRing.pending.fromCount = count;
+    glUVCRing.pending.toCount   = target;
+    glUVCRing.pending.reason    = reason;
+    glUVCRing.pending.window    = window;
+    return static_cast<uint8_t>(target);
+}
+
+void
+CyFxUVCRingResized (
+        uint8_t count,
+        CyFxUVCRingResult_t result)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    CyFxUVCRing_t &report = glUVCRing.report;
+
+    glUVCRing.pending.toCount = count;
+    glUVCRing.pending.result  = result;
+    report.log[report.decisions % CY_FX_UVC_RING_LOG_SIZE] = glUVCRing.pending;
+    report.decisions++;
+    if (result == CY_FX_UVC_RING_APPLIED)
+    {
+        if (count > glUVCRing.count)
+        {
+            report.grows++;
+        }
+        else
+        {
+            report.shrinks++;
+        }
+        glUVCRing.count = count;
+    }
+    else if (result == CY_FX_UVC_RING_DEFERRED)
+    {
+        report.deferred++;
+    }
+    else
+    {
+        report.failed++;
+    }
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void
+CyFxUVCRingSnapshot (
+        CyFxUVCRing_t *ring_p,
+        CyBool_t clear)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    *ring_p = glUVCRing.report;
+    ring_p->count = glUVCRing.count;
+    if (clear)
+    {
+        CyFxUVCRingClear ();
+    }
+    CyU3PVicEnableInterrupts (mask);
+
+    ring_p->version      = CY_FX_UVC_RING_VERSION;
+    ring_p->length       = sizeof (CyFxUVCRing_t);
+    ring_p->uptimeMs     = static_cast<uint32_t>(CyU3PGetTime ());
+    ring_p->bufSize      = CY_FX_UVC_STREAM_BUF_SIZE;
+    ring_p->minCount     = CY_FX_UVC_RING_MIN_COUNT;
+    ring_p->maxCount     = CY_FX_UVC_RING_MAX_COUNT;
+    ring_p->ceilingBytes = CY_FX_UVC_RING_CEILING;
+    ring_p->windowMs     = CY_FX_UVC_RING_WINDOW_MS;
+}
+
+#endif /* CY_FX_UVC_RING_ADAPT_EN */
+
+/*[]*/
@@ -0,0 +1,182 @@
+/*
+ ## UVC application adaptive DMA ring depth (cyfxuvcring.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCRING_H_
+#define _INCLUDED_CYFXUVCRING_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+#include <cyu3dma.h>
+#include "cyfxuvcinmem.h"
+#include "cyfxuvcclock.h"
+#include "cyfxmemmap.h"
+
+/* Depth of the video DMA ring, adapted to the way the host reads (make
+ * CY_FX_UVC_RING_ADAPT=1). Each time the streaming loop gets a buffer it samples the
+ * ring occupancy, the bytes committed and not yet taken by the endpoint rounded up to
+ * buffers, and the time GetBuffer waited. Every CY_FX_UVC_RING_WINDOW_MS the window is
+ * judged at the next end of frame:
+ *   - grow by half when the ring both ran full (GetBuffer blocked for some of the
+ *     window) and ran dry (nothing queued for the endpoint) in the window: the host
+ *     reads in bursts, and a deeper ring turns the producer's waits into data for the
+ *     next burst. A host that is just slower than the loop keeps the ring full and
+ *     never dry, one that is faster never blocks it: neither grows the ring;
+ *   - shrink when for CY_FX_UVC_RING_SHRINK_WINDOWS windows in a row the top of the ring
+ *     was never used (a host faster than the loop) or its bottom never drained (a host
+ *     slower than the loop, where queued buffers only add latency), keeping a margin.
+ * The streaming loop resizes the ring between two frames: it waits for the committed
+ * buffers to be sent and rebuilds the channel from a new session arena, within
+ * CY_FX_UVC_RING_MAX_BYTES (make CY_FX_UVC_RING_MAX=<bytes>). The depth carries over to
+ * the next streaming session. CyFxUVCRing_t below is the wire format of the
+ * CY_FX_UVC_VENDOR_RQT_GET_RING request (host/uvcring): 32-bit words only. */
+
+constexpr uint32_t CY_FX_UVC_RING_VERSION = 1;         // Layout version of CyFxUVCRing_t
+constexpr uint16_t CY_FX_UVC_RING_CLEAR = 1 << 0;      // wValue flag: clear the counters after reading
+constexpr uint32_t CY_FX_UVC_RING_HIST_BINS = 16;      // Occupancy histogram: 0 to 15 and more buffers
+constexpr uint32_t CY_FX_UVC_RING_LOG_SIZE = 8;        // Decisions kept
+constexpr uint32_t CY_FX_UVC_RING_WINDOW_MS = 250;     // Observation window
+constexpr uint32_t CY_FX_UVC_RING_SHRINK_WINDOWS = 8;  // Windows with spare buffers before a shrink
+constexpr uint32_t CY_FX_UVC_RING_GROW_PERMILLE = 10;  // Time blocked and dry samples of a window that make it bursty
+constexpr uint32_t CY_FX_UVC_RING_MARGIN = 1;          // Buffers kept beyond the occupancy seen
+constexpr uint32_t CY_FX_UVC_RING_BLOCK_US = 100;      // A longer GetBuffer wait means the ring was full
+constexpr uint32_t CY_FX_UVC_RING_DRAIN_MS = 20;       // Longest wait for the ring to drain before a resize
+constexpr uint8_t CY_FX_UVC_RING_MIN_COUNT = 2;        // One buffer filled while one is sent
+
+constexpr uint32_t CY_FX_UVC_RING_STRIDE = (CY_FX_UVC_STREAM_BUF_SIZE + 31u) & ~31u; // Arena bytes per buffer
+#ifdef CY_FX_UVC_RING_MAX_BYTES
+constexpr uint32_t CY_FX_UVC_RING_CEILING = CY_FX_UVC_RING_MAX_BYTES; // RAM ceiling of the ring
+#else
+constexpr uint32_t CY_FX_UVC_RING_CEILING = (CY_FX_MEM_BUF_HEAP_SIZE - CY_FX_MEM_SDK_BUF_RESERVE < 0xFFFF) ?
+    (CY_FX_MEM_BUF_HEAP_SIZE - CY_FX_MEM_SDK_BUF_RESERVE) : 0xFFFF; // RAM ceiling: the buffer heap, one arena
+#endif
+constexpr uint8_t CY_FX_UVC_RING_MAX_COUNT = (CY_FX_UVC_RING_CEILING / CY_FX_UVC_RING_STRIDE > 255) ?
+    255 : static_cast<uint8_t>(CY_FX_UVC_RING_CEILING / CY_FX_UVC_RING_STRIDE); // Deepest ring
+
+static_assert (CY_FX_UVC_RING_CEILING + CY_FX_MEM_SDK_BUF_RESERVE <= CY_FX_MEM_BUF_HEAP_SIZE,
+        "the ring ceiling does not fit in the buffer heap");
+static_assert (CY_FX_UVC_RING_CEILING <= 0xFFFF, "the session arena is a single buffer heap allocation");
+static_assert (CY_FX_UVC_RING_MAX_COUNT >= CY_FX_UVC_RING_MIN_COUNT, "the ring ceiling holds less than two buffers");
+
+/* Why the depth was changed. */
+enum CyFxUVCRingReason_t
+{
+    CY_FX_UVC_RING_GROW_BURSTY = 1,     /* The ring ran full and dry in the same window. */
+    CY_FX_UVC_RING_SHRINK_SPARE,        /* Buffers unused or never drained for a while. */
+};
+
+/* What came of a decision. */
+enum CyFxUVCRingResult_t
+{
+    CY_FX_UVC_RING_APPLIED = 0,         /* The ring was rebuilt with the new depth. */
+    CY_FX_UVC_RING_DEFERRED,            /* The ring did not drain in time or the stream stopped: try again later. */
+    CY_FX_UVC_RING_FAILED,              /* No channel with the new depth; the old one was rebuilt. */
+};
+
+/* One window of samples. */
+struct CyFxUVCRingWindow_t
+{
+    uint32_t samples;                   // Buffers got in the window
+    uint32_t full;                      // ...after a GetBuffer wait over CY_FX_UVC_RING_BLOCK_US
+    uint32_t dry;                       // ...with nothing queued for the endpoint
+    uint32_t minBuffers;                // Lowest occupancy seen
+    uint32_t maxBuffers;                // Highest occupancy seen
+    uint32_t blockedUs;                 // Time GetBuffer waited over CY_FX_UVC_RING_BLOCK_US
+};
+
+struct CyFxUVCRingDecision_t
+{
+    uint32_t timeMs;                    // OS time of the decision
+    uint32_t fromCount;                 // Depth before
+    uint32_t toCount;                   // Depth asked for
+    uint32_t reason;                    // CyFxUVCRingReason_t
+    uint32_t result;                    // CyFxUVCRingResult_t
+    CyFxUVCRingWindow_t window;         // The window that led to it
+};
+
+struct CyFxUVCRing_t
+{
+    uint32_t version;                   // CY_FX_UVC_RING_VERSION
+    uint32_t length;                    // Size of the block in bytes
+    uint32_t uptimeMs;                  // OS time at which the snapshot was taken
+    uint32_t clearedMs;                 // OS time at which the counters were last cleared
+    uint32_t bufSize;                   // CY_FX_UVC_STREAM_BUF_SIZE
+    uint32_t count;                     // Current depth
+    uint32_t minCount;                  // CY_FX_UVC_RING_MIN_COUNT
+    uint32_t maxCount;                  // Deepest ring under the ceiling
+    uint32_t ceilingBytes;              // CY_FX_UVC_RING_CEILING
+    uint32_t windowMs;                  // CY_FX_UVC_RING_WINDOW_MS
+    uint32_t windows;                   // Windows judged
+    uint32_t grows;                     // Decisions by result and kind
+    uint32_t shrinks;
+    uint32_t deferred;
+    uint32_t failed;
+    uint32_t decisions;                 // Decisions made; the last CY_FX_UVC_RING_LOG_SIZE are in the log
+    uint32_t histogram[CY_FX_UVC_RING_HIST_BINS]; // Samples per occupancy in buffers, the last bin holds the rest
+    CyFxUVCRingWindow_t last;           // Latest window judged
+    CyFxUVCRingDecision_t log[CY_FX_UVC_RING_LOG_SIZE]; // Decision n is at log[n % CY_FX_UVC_RING_LOG_SIZE]
+};
+
+static_assert (sizeof (CyFxUVCRing_t) == (16 + CY_FX_UVC_RING_HIST_BINS + 6 + CY_FX_UVC_RING_LOG_SIZE * 11) *
+        sizeof (uint32_t), "CyFxUVCRing_t must be a packed array of 32-bit words");
+
+#ifdef CY_FX_UVC_RING_ADAPT_EN
+
+/* Depth for the next video channel. */
+extern uint8_t
+CyFxUVCRingCount (
+        void);
+
+/* A video channel of CyFxUVCRingCount buffers was set up: its counts start from 0. */
+extern void
+CyFxUVCRingStart (
+        CyU3PDmaChannel *channel_p);
+
+/* Sample the occupancy after GetBuffer returned. */
+extern void
+CyFxUVCRingBuffer (
+        uint32_t waitTicks);
+
+/* Account for a committed buffer. */
+extern void
+CyFxUVCRingCommitted (
+        uint16_t length);
+
+/* Whether the endpoint took all the committed bytes. */
+extern CyBool_t
+CyFxUVCRingDrained (
+        void);
+
+/* At the end of a frame: judge the window if it is over. Returns the depth the ring
+ * should have, CyFxUVCRingCount when it is fine as it is. */
+extern uint8_t
+CyFxUVCRingFrameEnd (
+        void);
+
+/* Log the result of the resize to count asked by CyFxUVCRingFrameEnd. */
+extern void
+CyFxUVCRingResized (
+        uint8_t count,
+        CyFxUVCRingResult_t result);
+
+/* Take a consistent copy of the controller state, optionally clearing the counters. */
+extern void
+CyFxUVCRingSnapshot (
+        CyFxUVCRing_t *ring_p,
+        CyBool_t clear);
+
+#else
+
+inline uint8_t CyFxUVCRingCount (void) { return CY_FX_UVC_STREAM_BUF_COUNT; }
+inline void CyFxUVCRingStart (CyU3PDmaChannel *) { }
+inline void CyFxUVCRingBuffer (uint32_t) { }
+inline void CyFxUVCRingCommitted (uint16_t) { }
+
+#endif /* CY_FX_UVC_RING_ADAPT_EN */
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCRING_H_ */
+
+/*[]*/
@@ -0,0 +1,58 @@
+/*
+ ## UVC application source clock reference (cyfxuvcscr.cpp)
+ ## ===========================
+*/
+
+/* The SOF / ITP events come 8000 times a second at high and super speed, so they are
+ * only enabled while streaming and the latch does one clock read and one property read
+ * per event. */
+
+#include "cyu3system.h"
+#include "cyu3usb.h"
+#include "cyu3error.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcscr.h"
+#include "cyfxmemmap.h"
+
+CY_FX_HOT_DATA CyFxUVCScr_t glUVCScr;                  /* Latched SCR, read on every buffer. */
+static CyU3PUsbDevProperty glScrCounter = CY_U3P_USB_PROP_FRAMECNT; /* Bus counter of the session. */
+
+void
+CyFxUVCScrStart (
+        CyBool_t superSpeed)
+{
+    glScrCounter = superSpeed ? CY_U3P_USB_PROP_ITPINFO : CY_U3P_USB_PROP_FRAMECNT;
+
+    /* Latch once now: the payloads sent before the first event carry a valid SCR. */
+    CyFxUVCScrSof ();
+    CyU3PUsbEnableITPEvent (CyTrue);
+}
+
+void
+CyFxUVCScrStop (
+        void)
+{
+    CyU3PUsbEnableITPEvent (CyFalse);
+}
+
+void CY_FX_HOT_CODE
+CyFxUVCScrSof (
+        void)
+{
+    uint32_t stc = CyFxUVCClockTicks ();
+    uint32_t counter = 0;
+
+    if (CyU3PUsbGetDevProperty (glScrCounter, &counter) != CY_U3P_SUCCESS)
+    {
+        return;
+    }
+
+    uint32_t sof = (counter >> CY_FX_UVC_SCR_SOF_SHIFT) & CY_FX_UVC_SCR_SOF_MASK;
+
+    glUVCScr.seq   = glUVCScr.seq + 1;
+    glUVCScr.word1 = stc << 16;
+    glUVCScr.word2 = (stc >> 16) | (sof << 16);
+    glUVCScr.seq   = glUVCScr.seq + 1;
+}
+
+/*[]*/
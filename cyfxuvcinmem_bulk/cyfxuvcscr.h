@@ -0,0 +1,71 @@
+/*
+ ## UVC application source clock reference (cyfxuvcscr.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCSCR_H_
+#define _INCLUDED_CYFXUVCSCR_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* SCR field of the payload headers: the timestamp clock (the device clock of
+ * dwClockFrequency) paired with the 11-bit 1 kHz SOF counter of the bus. While streaming,
+ * the SOF / ITP event of every (micro)frame latches the pair, already shifted into the
+ * two header words it occupies, so the streaming loop only loads two words per buffer.
+ *
+ * The latch is written from interrupt context and read by the streaming thread under a
+ * sequence count: odd while an update is in progress, the reader retries when it
+ * changed under it. Both bus counters count 125 us intervals in bits 0-2 (the USB 2.0
+ * microframe, the USB 3.0 bus interval); bits 3-13 are the 1 ms SOF count. */
+
+constexpr uint32_t CY_FX_UVC_SCR_SOF_SHIFT = 3;        // 125 us intervals to the 1 ms SOF count
+constexpr uint32_t CY_FX_UVC_SCR_SOF_MASK = 0x7FF;     // The SOF count is 11 bits
+
+struct CyFxUVCScr_t
+{
+    volatile uint32_t seq;              // Odd while the words are being updated
+    volatile uint32_t word1;            // STC bits 0-15, in bits 16-31 of header word 1
+    volatile uint32_t word2;            // STC bits 16-31 and the SOF count: header word 2
+};
+
+extern CyFxUVCScr_t glUVCScr;
+
+/* Enable the SOF / ITP events and latch the SCR from them, for a session at the
+   given speed. */
+extern void
+CyFxUVCScrStart (
+        CyBool_t superSpeed);
+
+/* Disable the SOF / ITP events. */
+extern void
+CyFxUVCScrStop (
+        void);
+
+/* Latch the SCR; called from the USB event callback on CY_U3P_USB_EVENT_SOF_ITP,
+   in interrupt context. */
+extern void
+CyFxUVCScrSof (
+        void);
+
+/* The SCR bits of header words 1 and 2. */
+inline void
+CyFxUVCScrGet (
+        uint32_t *word1_p,
+        uint32_t *word2_p)
+{
+    uint32_t seq;
+
+    do
+    {
+        seq = glUVCScr.seq;
+        *word1_p = glUVCScr.word1;
+        *word2_p = glUVCScr.word2;
+    } while (((seq & 1) != 0) || (seq != glUVCScr.seq));
+}
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCSCR_H_ */
+
+/*[]*/
@@ -0,0 +1,94 @@
+/*
+ ## UVC application thread stack usage (cyfxuvcstack.cpp)
+ ## ===========================
+*/
+
+/* The created thread list is copied with the interrupts masked, which keeps it stable
+ * without holding the mask for the scan itself; a stack is at most a few KB of reads. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3vic.h"
+#include "cyfxuvcstack.h"
+#include "cyfxuvcarena.h"
+
+static_assert (CY_FX_UVC_STACK_FILL == TX_STACK_FILL, "paint pattern differs from ThreadX");
+
+void
+CyFxUVCStackPaint (
+        void *stack_p,
+        uint32_t size)
+{
+    uint32_t *word_p = static_cast<uint32_t *>(stack_p);
+
+    /* Stacks and the heap are word aligned: one store per word rather than the byte
+     * stores of CyU3PMemSet, as the whole driver heap is painted at boot. */
+    for (uint32_t i = 0; i < size / sizeof (uint32_t); i++)
+    {
+        word_p[i] = CY_FX_UVC_STACK_FILL;
+    }
+}
+
+uint32_t
+CyFxUVCStackUsed (
+        const void *stack_p,
+        uint32_t size)
+{
+    const uint32_t *word_p = static_cast<const uint32_t *>(stack_p);
+    uint32_t words = size / sizeof (uint32_t), painted = 0;
+
+    /* Stacks grow down: the untouched words are at the low end. */
+    while ((painted < words) && (word_p[painted] == CY_FX_UVC_STACK_FILL))
+    {
+        painted++;
+    }
+    return size - painted * static_cast<uint32_t>(sizeof (uint32_t));
+}
+
+void
+CyFxUVCStackSnapshot (
+        CyU3PThread *appThread_p,
+        CyFxUVCStacks_t *stacks_p)
+{
+    const void *stack[CY_FX_UVC_STACK_MAX_THREADS];
+    uint32_t count = 0, total = 0;
+    CyU3PThread *thread_p = appThread_p;
+
+    CyU3PMemSet ((uint8_t *)stacks_p, 0, sizeof (*stacks_p));
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    do
+    {
+        if (count < CY_FX_UVC_STACK_MAX_THREADS)
+        {
+            CyFxUVCStackThread_t *entry_p = &stacks_p->thread[count];
+            const CHAR *name = thread_p->tx_thread_name;
+
+            for (uint32_t i = 0; (name != NULL) && (name[i] != 0) && (i < sizeof (entry_p->name) - 1); i++)
+            {
+                entry_p->name[i] = name[i];
+            }
+            entry_p->stackSize = static_cast<uint32_t>(thread_p->tx_thread_stack_size);
+            stack[count++] = thread_p->tx_thread_stack_start;
+        }
+        total++;
+        thread_p = thread_p->tx_thread_created_next;
+    } while ((thread_p != NULL) && (thread_p != appThread_p) && (total < 256));
+    CyU3PVicEnableInterrupts (mask);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        stacks_p->thread[i].stackUsed = CyFxUVCStackUsed (stack[i], stacks_p->thread[i].stackSize);
+    }
+
+    CyFxMemHeapInfoGet (&stacks_p->heapSize, &stacks_p->heapAvailable, &stacks_p->heapFragments);
+    CyFxDmaBufferHeapInfoGet (&stacks_p->bufHeapSize, &stacks_p->bufHeapAvailable, &stacks_p->bufHeapFragments,
+            &stacks_p->bufHeapLargest, &stacks_p->arenaSessions, &stacks_p->arenaFallbacks);
+    stacks_p->version     = CY_FX_UVC_STACK_VERSION;
+    stacks_p->length      = sizeof (CyFxUVCStacks_t);
+    stacks_p->threadCount = count;
+    stacks_p->threadTotal = total;
+    stacks_p->appThread   = 0;
+}
+
+/*[]*/
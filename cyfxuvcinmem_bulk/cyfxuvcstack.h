@@ -0,0 +1,87 @@
+/*
+ ## UVC application thread stack usage (cyfxuvcstack.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCSTACK_H_
+#define _INCLUDED_CYFXUVCSTACK_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+#include <cyu3os.h>
+
+/* Thread stacks are painted with the ThreadX fill pattern before the thread first runs:
+ * the application thread stack explicitly, the SDK thread stacks by painting the whole
+ * driver heap when it is created (cyfxtx.cpp). The high-water mark of a stack is then
+ * the deepest word that no longer holds the pattern. A stack carved from heap memory
+ * that was used and freed before reads as fully used, so the figures are upper bounds.
+ *
+ * The scan runs on request, through the CY_FX_UVC_VENDOR_RQT_GET_STACKS vendor request;
+ * CyFxUVCStacks_t below is the wire format. The figures depend on the build type: size
+ * a Release stack from a Release measurement. The block also carries the usage of both
+ * heaps and the streaming session arena counters (cyfxuvcarena.h). */
+
+constexpr uint32_t CY_FX_UVC_STACK_VERSION = 2;        // Layout version of CyFxUVCStacks_t
+constexpr uint32_t CY_FX_UVC_STACK_FILL = 0xEFEFEFEF;  // Paint pattern, same as TX_STACK_FILL
+constexpr uint32_t CY_FX_UVC_STACK_MAX_THREADS = 16;   // Threads reported, in creation order
+constexpr uint32_t CY_FX_UVC_STACK_NAME_LEN = 16;      // Thread name bytes, NUL terminated
+
+struct CyFxUVCStackThread_t
+{
+    char     name[CY_FX_UVC_STACK_NAME_LEN]; // Thread name, truncated
+    uint32_t stackSize;                 // Stack size in bytes
+    uint32_t stackUsed;                 // High-water mark in bytes
+};
+
+struct CyFxUVCStacks_t
+{
+    uint32_t version;                   // CY_FX_UVC_STACK_VERSION
+    uint32_t length;                    // Size of the block in bytes
+    uint32_t threadCount;               // Entries used in thread[]
+    uint32_t threadTotal;               // Threads in the system, may exceed threadCount
+    uint32_t heapSize;                  // Driver heap size (CyU3PMemAlloc)
+    uint32_t heapAvailable;             // Driver heap bytes free now
+    uint32_t heapFragments;             // Driver heap free fragments
+    uint32_t appThread;                 // Index of the UVC application thread
+    CyFxUVCStackThread_t thread[CY_FX_UVC_STACK_MAX_THREADS];
+    uint32_t bufHeapSize;               // Buffer heap size (CyU3PDmaBufferAlloc)
+    uint32_t bufHeapAvailable;          // Buffer heap bytes free now
+    uint32_t bufHeapFragments;          // Buffer heap free runs
+    uint32_t bufHeapLargest;            // Longest buffer heap free run in bytes
+    uint32_t arenaSessions;             // Streaming session arenas released
+    uint32_t arenaFallbacks;            // Session allocations that did not fit the arena
+};
+
+static_assert (sizeof (CyFxUVCStacks_t) % sizeof (uint32_t) == 0,
+        "CyFxUVCStacks_t must be a packed array of 32-bit words");
+
+/* Fill a word aligned stack with the paint pattern. Call before the thread is created. */
+extern void
+CyFxUVCStackPaint (
+        void *stack_p,
+        uint32_t size);
+
+/* Bytes of a painted stack that have been written at some point. */
+extern uint32_t
+CyFxUVCStackUsed (
+        const void *stack_p,
+        uint32_t size);
+
+/* Scan the stacks of all the threads, walking the created list from appThread_p. */
+extern void
+CyFxUVCStackSnapshot (
+        CyU3PThread *appThread_p,
+        CyFxUVCStacks_t *stacks_p);
+
+/* Driver heap usage, for the report. Defined in cyfxtx.cpp. */
+extern void
+CyFxMemHeapInfoGet (
+        uint32_t *size_p,
+        uint32_t *available_p,
+        uint32_t *fragments_p);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCSTACK_H_ */
+
+/*[]*/
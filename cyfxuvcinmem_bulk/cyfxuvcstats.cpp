@@ -0,0 +1,218 @@
+/*
+ ## UVC application streaming statistics (cyfxuvcstats.cpp)
+ ## ===========================
+*/
+
+/* The counters are updated from the streaming thread (once per buffer) and from the
+ * USB event callback (rarely). Every update and the snapshot run with the interrupts
+ * masked, which keeps the 64-bit sums and the min/max pairs consistent without a
+ * mutex in the streaming path. Each critical section is a handful of instructions.
+ * The event log is a list of pool blocks, oldest first, updated under the same mask. */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3vic.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcpool.h"
+#include "cyfxuvcstats.h"
+#include "cyfxmemmap.h"
+
+/* One event log entry; the link is not part of the wire format. */
+struct CyFxUVCStatsLogEntry_t
+{
+    CyFxUVCStatsLogEntry_t *next_p;
+    CyFxUVCStatsLogRecord_t record;
+};
+
+static CyFxUVCStats_t glStats;      /* Counters; the derived fields are filled in by the snapshot. */
+static uint64_t glBytesSent = 0;    /* Bytes committed since the last clear. */
+static uint64_t glWaitSum = 0;      /* Sum of the GetBuffer waits since the last clear. */
+
+static uint32_t glLogMem[CyFxUVCPoolWords (sizeof (CyFxUVCStatsLogEntry_t), CY_FX_UVC_STATS_LOG_DEPTH)];
+static CyFxUVCPool_t glLogPool;                 /* Empty until the first reset: events are then only counted. */
+static CyFxUVCStatsLogEntry_t *glLogHead = NULL;    /* Oldest entry. */
+static CyFxUVCStatsLogEntry_t *glLogTail = NULL;    /* Latest entry. */
+static uint32_t glLogOverwritten = 0;           /* Entries reused since the last clear. */
+
+/* Empty the event log. Must be called with the interrupts masked. */
+static void
+CyFxUVCStatsLogClear (
+        void)
+{
+    CyFxUVCPoolCreate (&glLogPool, glLogMem, sizeof (CyFxUVCStatsLogEntry_t), CY_FX_UVC_STATS_LOG_DEPTH);
+    glLogHead = glLogTail = NULL;
+    glLogOverwritten = 0;
+}
+
+/* Append an event to the log, reusing the oldest entry if the pool is empty. Must be
+ * called with the interrupts masked. */
+static void
+CyFxUVCStatsLogAppend (
+        CyFxUVCStatsEvent_t event)
+{
+    CyFxUVCStatsLogEntry_t *entry_p = static_cast<CyFxUVCStatsLogEntry_t *>(CyFxUVCPoolAlloc (&glLogPool));
+
+    if (entry_p == NULL)
+    {
+        entry_p = glLogHead;
+        if (entry_p == NULL)
+        {
+            return;
+        }
+        glLogHead = entry_p->next_p;
+        if (glLogHead == NULL)
+        {
+            glLogTail = NULL;
+        }
+        glLogOverwritten++;
+    }
+
+    entry_p->next_p        = NULL;
+    entry_p->record.timeMs = static_cast<uint32_t>(CyU3PGetTime ());
+    entry_p->record.event  = event;
+    if (glLogTail != NULL)
+    {
+        glLogTail->next_p = entry_p;
+    }
+    else
+    {
+        glLogHead = entry_p;
+    }
+    glLogTail = entry_p;
+}
+
+/* Clear the counters. Must be called with the interrupts masked. */
+static void
+CyFxUVCStatsClear (
+        void)
+{
+    CyU3PMemSet ((uint8_t *)&glStats, 0, sizeof (glStats));
+    glStats.waitMinTicks = 0xFFFFFFFF;
+    glStats.clearedMs    = static_cast<uint32_t>(CyU3PGetTime ());
+    glBytesSent = 0;
+    glWaitSum   = 0;
+}
+
+void
+CyFxUVCStatsReset (
+        void)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    CyFxUVCStatsClear ();
+    CyFxUVCStatsLogClear ();
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void CY_FX_HOT_CODE
+CyFxUVCStatsBufferDone (
+        uint32_t waitTicks,
+        uint32_t length,
+        CyBool_t endOfFrame)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    glStats.buffersCommitted++;
+    if (endOfFrame)
+    {
+        glStats.framesSent++;
+    }
+    glBytesSent += length;
+
+    glStats.waitCount++;
+    glWaitSum += waitTicks;
+    if (waitTicks < glStats.waitMinTicks)
+    {
+        glStats.waitMinTicks = waitTicks;
+    }
+    if (waitTicks > glStats.waitMaxTicks)
+    {
+        glStats.waitMaxTicks = waitTicks;
+    }
+
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void
+CyFxUVCStatsFramesDropped (
+        uint32_t count)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    glStats.framesDropped += count;
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void
+CyFxUVCStatsEvent (
+        CyFxUVCStatsEvent_t event)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    glStats.eventCount[event]++;
+    CyFxUVCStatsLogAppend (event);
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void
+CyFxUVCStatsSnapshot (
+        CyFxUVCStats_t *stats_p,
+        CyBool_t clear)
+{
+    uint64_t bytesSent, waitSum;
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    *stats_p  = glStats;
+    bytesSent = glBytesSent;
+    waitSum   = glWaitSum;
+    if (clear)
+    {
+        CyFxUVCStatsClear ();
+    }
+
+    CyU3PVicEnableInterrupts (mask);
+
+    /* Derived fields are computed outside the critical section. */
+    stats_p->bytesSentLo = static_cast<uint32_t>(bytesSent);
+    stats_p->bytesSentHi = static_cast<uint32_t>(bytesSent >> 32);
+    if (stats_p->waitCount != 0)
+    {
+        stats_p->waitAvgTicks = static_cast<uint32_t>(waitSum / stats_p->waitCount);
+    }
+    else
+    {
+        stats_p->waitMinTicks = 0;
+    }
+
+    stats_p->version  = CY_FX_UVC_STATS_VERSION;
+    stats_p->length   = sizeof (CyFxUVCStats_t);
+    stats_p->uptimeMs = static_cast<uint32_t>(CyU3PGetTime ());
+    stats_p->clockHz  = CyFxUVCClockHz ();
+}
+
+void
+CyFxUVCStatsLogSnapshot (
+        CyFxUVCStatsLog_t *log_p,
+        CyBool_t clear)
+{
+    uint32_t count = 0;
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    for (CyFxUVCStatsLogEntry_t *entry_p = glLogHead; entry_p != NULL; entry_p = entry_p->next_p)
+    {
+        log_p->record[count++] = entry_p->record;
+    }
+    log_p->overwritten = glLogOverwritten;
+    log_p->minFree     = glLogPool.minFree;
+    if (clear)
+    {
+        CyFxUVCStatsLogClear ();
+    }
+
+    CyU3PVicEnableInterrupts (mask);
+
+    CyU3PMemSet ((uint8_t *)&log_p->record[count], 0, (CY_FX_UVC_STATS_LOG_DEPTH - count) * sizeof (CyFxUVCStatsLogRecord_t));
+    log_p->version  = CY_FX_UVC_STATS_LOG_VERSION;
+    log_p->length   = sizeof (CyFxUVCStatsLog_t);
+    log_p->uptimeMs = static_cast<uint32_t>(CyU3PGetTime ());
+    log_p->count    = count;
+}
+
+/*[]*/
@@ -0,0 +1,127 @@
+/*
+ ## UVC application streaming statistics (cyfxuvcstats.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCSTATS_H_
+#define _INCLUDED_CYFXUVCSTATS_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+
+/* The statistics block is maintained by the streaming thread and the USB callbacks and
+ * is read by the host through the CY_FX_UVC_VENDOR_RQT_GET_STATS vendor request. The
+ * structure below is also the wire format of that request, so it is made of 32-bit
+ * little-endian words only. The event counters stay last, so that an event appended to
+ * CyFxUVCStatsEvent_t only lengthens the block; a new fixed counter goes before them
+ * and bumps CY_FX_UVC_STATS_VERSION. The host tools include this header to decode the
+ * block and read the events up to its length. */
+
+constexpr uint32_t CY_FX_UVC_STATS_VERSION = 2;        // Layout version of CyFxUVCStats_t
+constexpr uint16_t CY_FX_UVC_STATS_CLEAR = 1 << 0;     // wValue flag: clear the counters after reading
+
+/* Rare events counted by the statistics block. */
+enum CyFxUVCStatsEvent_t
+{
+    CY_FX_UVC_STATS_EVT_GETBUF_ERROR = 0,   /* CyU3PDmaChannelGetBuffer failed. */
+    CY_FX_UVC_STATS_EVT_COMMIT_ERROR,       /* CyU3PDmaChannelCommitBuffer failed. */
+    CY_FX_UVC_STATS_EVT_LPM_FORCED_U0,      /* Link forced back to U0 from U1/U2. */
+    CY_FX_UVC_STATS_EVT_STREAM_START,       /* Streaming channel set up. */
+    CY_FX_UVC_STATS_EVT_STREAM_STOP,        /* Streaming channel torn down. */
+    CY_FX_UVC_STATS_EVT_STREAM_RESTART,     /* SET_CONFIG / SET_INTERFACE while streaming. */
+    CY_FX_UVC_STATS_EVT_USB_RESET,          /* USB bus reset. */
+    CY_FX_UVC_STATS_EVT_USB_DISCONNECT,     /* USB disconnect. */
+    CY_FX_UVC_STATS_EVT_HEAP_CORRUPT,       /* Corrupted heap block found (CY_FX_MEM_CHECK builds). */
+    CY_FX_UVC_STATS_EVT_COUNT
+};
+
+struct CyFxUVCStats_t
+{
+    uint32_t version;               // CY_FX_UVC_STATS_VERSION
+    uint32_t length;                // Size of the block in bytes
+    uint32_t uptimeMs;              // OS time at which the snapshot was taken
+    uint32_t clearedMs;             // OS time at which the counters were last cleared
+    uint32_t clockHz;               // Frequency of the tick counter used for wait times
+    uint32_t framesSent;            // Frames completed (EOF committed)
+    uint32_t buffersCommitted;      // DMA buffers committed to the endpoint
+    uint32_t bytesSentLo;           // Bytes committed, including UVC headers (low word)
+    uint32_t bytesSentHi;           // Bytes committed, including UVC headers (high word)
+    uint32_t waitCount;             // Number of GetBuffer waits measured
+    uint32_t waitMinTicks;          // Shortest GetBuffer wait
+    uint32_t waitAvgTicks;          // Average GetBuffer wait
+    uint32_t waitMaxTicks;          // Longest GetBuffer wait
+    uint32_t framesDropped;         // Frames skipped by the live streaming mode (cyfxuvclive.h), version 2
+    uint32_t eventCount[CY_FX_UVC_STATS_EVT_COUNT]; // Counters indexed by CyFxUVCStatsEvent_t, to the end of the block
+};
+
+static_assert (sizeof (CyFxUVCStats_t) == (14 + CY_FX_UVC_STATS_EVT_COUNT) * sizeof (uint32_t),
+        "CyFxUVCStats_t must be a packed array of 32-bit words");
+
+/* Besides counting it, CyFxUVCStatsEvent records each event with its time in a log of
+ * the latest CY_FX_UVC_STATS_LOG_DEPTH, read with the CY_FX_UVC_VENDOR_RQT_GET_EVENTS
+ * vendor request. The records come from a block pool (cyfxuvcpool.h), as the events are
+ * raised from the USB callbacks; when the pool is empty the oldest record is reused. */
+
+constexpr uint32_t CY_FX_UVC_STATS_LOG_VERSION = 1;    // Layout version of CyFxUVCStatsLog_t
+constexpr uint32_t CY_FX_UVC_STATS_LOG_DEPTH = 16;     // Records kept
+
+struct CyFxUVCStatsLogRecord_t
+{
+    uint32_t timeMs;                // OS time of the event
+    uint32_t event;                 // CyFxUVCStatsEvent_t
+};
+
+struct CyFxUVCStatsLog_t
+{
+    uint32_t version;               // CY_FX_UVC_STATS_LOG_VERSION
+    uint32_t length;                // Size of the block in bytes
+    uint32_t uptimeMs;              // OS time at which the snapshot was taken
+    uint32_t count;                 // Records filled in, oldest first
+    uint32_t overwritten;           // Records reused for a newer event since the last clear
+    uint32_t minFree;               // Fewest free records in the pool since the last clear
+    CyFxUVCStatsLogRecord_t record[CY_FX_UVC_STATS_LOG_DEPTH];
+};
+
+static_assert (sizeof (CyFxUVCStatsLog_t) == (6 + 2 * CY_FX_UVC_STATS_LOG_DEPTH) * sizeof (uint32_t),
+        "CyFxUVCStatsLog_t must be a packed array of 32-bit words");
+
+/* Clear all the counters and the event log. */
+extern void
+CyFxUVCStatsReset (
+        void);
+
+/* Account for one committed buffer and the time spent waiting for it. */
+extern void
+CyFxUVCStatsBufferDone (
+        uint32_t waitTicks,     /* Ticks spent in CyU3PDmaChannelGetBuffer */
+        uint32_t length,        /* Bytes committed */
+        CyBool_t endOfFrame     /* Whether the buffer completed a frame */
+        );
+
+/* Account for frames skipped by the live streaming mode. */
+extern void
+CyFxUVCStatsFramesDropped (
+        uint32_t count);
+
+/* Count one occurrence of an event and log it. Callable from any context. */
+extern void
+CyFxUVCStatsEvent (
+        CyFxUVCStatsEvent_t event);
+
+/* Take a consistent copy of the statistics, optionally clearing them. */
+extern void
+CyFxUVCStatsSnapshot (
+        CyFxUVCStats_t *stats_p,
+        CyBool_t clear);
+
+/* Take a copy of the event log, optionally clearing it. */
+extern void
+CyFxUVCStatsLogSnapshot (
+        CyFxUVCStatsLog_t *log_p,
+        CyBool_t clear);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCSTATS_H_ */
+
+/*[]*/
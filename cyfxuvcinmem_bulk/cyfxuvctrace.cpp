@@ -0,0 +1,122 @@
+/*
+ ## UVC application hot-path trace points (cyfxuvctrace.cpp)
+ ## ===========================
+*/
+
+/* Only built into profiling builds; release builds keep the empty translation unit
+ * and the trace points in the streaming loop expand to nothing. */
+
+#include "cyu3system.h"
+#include "cyu3vic.h"
+#include "cyfxuvctrace.h"
+
+#ifdef CYU3P_PROFILE_EN
+
+static CyFxUVCTraceHist_t glTraceHist[CY_FX_UVC_TP_COUNT];    /* Per-site histograms. */
+static uint64_t glTraceSum[CY_FX_UVC_TP_COUNT];               /* Per-site sums of the samples. */
+static uint32_t glTraceOverhead = 0;                          /* Cost of an empty BEGIN/END pair. */
+
+/* Histogram bucket of a duration: 0 for 0 ticks, else the bit length of the value. */
+static inline uint32_t
+CyFxUVCTraceBucket (
+        uint32_t ticks)
+{
+    uint32_t bucket = (ticks != 0) ? static_cast<uint32_t>(32 - __builtin_clz (ticks)) : 0;
+    return (bucket < CY_FX_UVC_TRACE_BUCKETS) ? bucket : (CY_FX_UVC_TRACE_BUCKETS - 1);
+}
+
+/* Clear the histograms. Must be called with the interrupts masked. */
+static void
+CyFxUVCTraceClear (
+        void)
+{
+    CyU3PMemSet ((uint8_t *)glTraceHist, 0, sizeof (glTraceHist));
+    for (uint32_t i = 0; i < CY_FX_UVC_TP_COUNT; i++)
+    {
+        glTraceHist[i].minTicks = 0xFFFFFFFF;
+        glTraceSum[i] = 0;
+    }
+}
+
+void
+CyFxUVCTraceReset (
+        void)
+{
+    uint32_t overhead = 0xFFFFFFFF;
+
+    /* The smallest of a few back-to-back clock reads is the fixed cost in every sample. */
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        uint32_t start = CyFxUVCClockTicks ();
+        uint32_t ticks = CyFxUVCClockTicks () - start;
+        if (ticks < overhead)
+        {
+            overhead = ticks;
+        }
+    }
+
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+    CyFxUVCTraceClear ();
+    glTraceOverhead = overhead;
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void
+CyFxUVCTraceRecord (
+        CyFxUVCTraceSite_t site,
+        uint32_t ticks)
+{
+    CyFxUVCTraceHist_t *hist_p = &glTraceHist[site];
+    uint32_t bucket = CyFxUVCTraceBucket (ticks);
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    hist_p->count++;
+    hist_p->bucket[bucket]++;
+    glTraceSum[site] += ticks;
+    if (ticks < hist_p->minTicks)
+    {
+        hist_p->minTicks = ticks;
+    }
+    if (ticks > hist_p->maxTicks)
+    {
+        hist_p->maxTicks = ticks;
+    }
+
+    CyU3PVicEnableInterrupts (mask);
+}
+
+void
+CyFxUVCTraceSnapshot (
+        CyFxUVCTrace_t *trace_p,
+        CyBool_t clear)
+{
+    uint32_t mask = CyU3PVicDisableAllInterrupts ();
+
+    for (uint32_t i = 0; i < CY_FX_UVC_TP_COUNT; i++)
+    {
+        trace_p->site[i] = glTraceHist[i];
+        trace_p->site[i].sumTicksLo = static_cast<uint32_t>(glTraceSum[i]);
+        trace_p->site[i].sumTicksHi = static_cast<uint32_t>(glTraceSum[i] >> 32);
+        if (trace_p->site[i].count == 0)
+        {
+            trace_p->site[i].minTicks = 0;
+        }
+    }
+    if (clear)
+    {
+        CyFxUVCTraceClear ();
+    }
+
+    CyU3PVicEnableInterrupts (mask);
+
+    trace_p->version       = CY_FX_UVC_TRACE_VERSION;
+    trace_p->length        = sizeof (CyFxUVCTrace_t);
+    trace_p->clockHz       = CyFxUVCClockHz ();
+    trace_p->overheadTicks = glTraceOverhead;
+    trace_p->siteCount     = CY_FX_UVC_TP_COUNT;
+    trace_p->bucketCount   = CY_FX_UVC_TRACE_BUCKETS;
+}
+
+#endif /* CYU3P_PROFILE_EN */
+
+/*[]*/
@@ -0,0 +1,102 @@
+/*
+ ## UVC application hot-path trace points (cyfxuvctrace.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_CYFXUVCTRACE_H_
+#define _INCLUDED_CYFXUVCTRACE_H_
+
+#include <cyu3externcstart.h>
+#include <cyu3types.h>
+#include "cyfxuvcclock.h"
+
+/* Trace points time a section of code with the timestamp clock and fold the duration
+ * into a per-site log2 histogram along with count, min, max and sum:
+ *
+ *     UVC_TP_BEGIN (MEMCPY);
+ *     CyU3PMemCopy (...);
+ *     UVC_TP_END (MEMCPY);
+ *
+ * The site name is the CyFxUVCTraceSite_t enumerator without its CY_FX_UVC_TP_ prefix.
+ * BEGIN declares a local, so BEGIN and END must be in the same scope. The macros expand
+ * to nothing unless CYU3P_PROFILE_EN is defined (ProfileRelease / ProfileDebug builds and
+ * the host build). The histograms are read with the CY_FX_UVC_VENDOR_RQT_GET_TRACE
+ * vendor request; CyFxUVCTrace_t below is the wire format. */
+
+constexpr uint32_t CY_FX_UVC_TRACE_VERSION = 2;        // Layout version of CyFxUVCTrace_t
+constexpr uint32_t CY_FX_UVC_TRACE_BUCKETS = 20;       // Bucket 0 = 0 ticks, bucket n = [2^(n-1), 2^n), last is open
+constexpr uint16_t CY_FX_UVC_TRACE_CLEAR = 1 << 0;     // wValue flag: clear the histograms after reading
+
+/* Instrumented sites in the streaming loop. */
+enum CyFxUVCTraceSite_t
+{
+    CY_FX_UVC_TP_GETBUF = 0,    /* CyU3PDmaChannelGetBuffer, including the wait for a free buffer. */
+    CY_FX_UVC_TP_HEADER,        /* UVC payload header insertion. */
+    CY_FX_UVC_TP_MEMCPY,        /* Payload copy from the frame store. */
+    CY_FX_UVC_TP_COMMIT,        /* CyU3PDmaChannelCommitBuffer. */
+    CY_FX_UVC_TP_CLEAN,         /* D-cache clean of the committed bytes (CY_FX_UVC_DCACHE builds). */
+    CY_FX_UVC_TP_BUFFER,        /* Whole buffer from GetBuffer return to commit done. */
+    CY_FX_UVC_TP_COUNT
+};
+
+struct CyFxUVCTraceHist_t
+{
+    uint32_t count;                             // Number of samples
+    uint32_t minTicks;                          // Shortest sample (0 if count is 0)
+    uint32_t maxTicks;                          // Longest sample
+    uint32_t sumTicksLo;                        // Sum of the samples (low word)
+    uint32_t sumTicksHi;                        // Sum of the samples (high word)
+    uint32_t bucket[CY_FX_UVC_TRACE_BUCKETS];   // log2 histogram of the samples
+};
+
+struct CyFxUVCTrace_t
+{
+    uint32_t version;                           // CY_FX_UVC_TRACE_VERSION
+    uint32_t length;                            // Size of the block in bytes
+    uint32_t clockHz;                           // Frequency of the timestamp clock
+    uint32_t overheadTicks;                     // Cost of an empty BEGIN/END pair, included in every sample
+    uint32_t siteCount;                         // CY_FX_UVC_TP_COUNT
+    uint32_t bucketCount;                       // CY_FX_UVC_TRACE_BUCKETS
+    CyFxUVCTraceHist_t site[CY_FX_UVC_TP_COUNT];
+};
+
+static_assert (sizeof (CyFxUVCTrace_t) ==
+        (6 + CY_FX_UVC_TP_COUNT * (5 + CY_FX_UVC_TRACE_BUCKETS)) * sizeof (uint32_t),
+        "CyFxUVCTrace_t must be a packed array of 32-bit words");
+
+#ifdef CYU3P_PROFILE_EN
+
+#define UVC_TP_BEGIN(site)          const uint32_t uvcTp##site = CyFxUVCClockTicks ()
+#define UVC_TP_END(site)            CyFxUVCTraceRecord (CY_FX_UVC_TP_##site, CyFxUVCClockTicks () - uvcTp##site)
+#define UVC_TP_RECORD(site, ticks)  CyFxUVCTraceRecord (CY_FX_UVC_TP_##site, (ticks))
+
+#else
+
+#define UVC_TP_BEGIN(site)          do { } while (0)
+#define UVC_TP_END(site)            do { } while (0)
+#define UVC_TP_RECORD(site, ticks)  do { } while (0)
+
+#endif /* CYU3P_PROFILE_EN */
+
+/* Clear the histograms and measure the trace point overhead. Needs the clock running. */
+extern void
+CyFxUVCTraceReset (
+        void);
+
+/* Add one sample to a site. */
+extern void
+CyFxUVCTraceRecord (
+        CyFxUVCTraceSite_t site,
+        uint32_t ticks);
+
+/* Take a consistent copy of the histograms, optionally clearing them. */
+extern void
+CyFxUVCTraceSnapshot (
+        CyFxUVCTrace_t *trace_p,
+        CyBool_t clear);
+
+#include <cyu3externcend.h>
+
+#endif /* _INCLUDED_CYFXUVCTRACE_H_ */
+
+/*[]*/
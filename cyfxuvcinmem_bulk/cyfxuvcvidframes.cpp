@@ -21,6 +21,8 @@
 */
 
 #include "cyfxuvcinmem.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcmeta.h"
 
 /* This file contains the MJPEG-1 video frames and Video frame related data. */
 
@@ -36,18 +38,23 @@ const uint8_t glProbeCtrl[CY_FX_UVC_MAX_PROBE_SETTING] __attribute__ ((aligned (
     0x00,0x00,                       /* Window size for average bit rate */
     0x00,0x00,                       /* Internal video streaming i/f latency in ms */
     0x00,0x90,0x01,0x00,             /* Max video frame size in bytes (100KB) */
-    0x00,0x10,0x00,0x00,             /* No. of bytes device can transmit in single payload */
-    0x00,0x60,0xE3,0x16,             /* Device clock. */
+    /* No. of bytes device can transmit in single payload: one DMA buffer */
+    CY_U3P_DWORD_GET_BYTE0 (CY_FX_UVC_STREAM_BUF_SIZE), CY_U3P_DWORD_GET_BYTE1 (CY_FX_UVC_STREAM_BUF_SIZE),
+    CY_U3P_DWORD_GET_BYTE2 (CY_FX_UVC_STREAM_BUF_SIZE), CY_U3P_DWORD_GET_BYTE3 (CY_FX_UVC_STREAM_BUF_SIZE),
+    CY_FX_UVC_CLOCK_HZ_BYTES,        /* Device clock: the timestamp clock of PTS and SCR */
     0x00,0x00,0x00,0x00              /* Framing and format information. */
 };
 
 /* Video frame lengths */
-const uint32_t glVidFrameLen[CY_FX_UVC_MAX_VID_FRAMES] = {
+static constexpr uint32_t CY_FX_UVC_VID_FRAME_LEN[CY_FX_UVC_MAX_VID_FRAMES] = {
     13711, 13417
 };
+const uint32_t glVidFrameLen[CY_FX_UVC_MAX_VID_FRAMES] = {
+    CY_FX_UVC_VID_FRAME_LEN[0], CY_FX_UVC_VID_FRAME_LEN[1]
+};
 
 /* MJPEG Video Frames */
-const uint8_t glUVCVidFrames[] =
+const uint8_t glUVCVidFrames[] __attribute__ ((aligned (32))) =
 {
     /* Video frame 1 */
     0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46,
@@ -3446,3 +3453,104 @@ const uint8_t glUVCVidFrames[] =
     0xd9
 };
 
+/* Payload bytes of the next segment of a frame, with remaining bytes left to send. The
+   frame ends in the first segment whose payload fits next to the EOF header, which may
+   be longer (metadata); that can leave an EOF segment without payload. */
+static constexpr uint32_t
+CyFxUVCSegmentBytes (
+        uint32_t bufSize,
+        uint32_t remaining,
+        bool *eof_p)
+{
+    uint32_t payload = bufSize - CY_FX_UVC_HEADER_LEN;
+
+    *eof_p = (remaining <= bufSize - CY_FX_UVC_HEADER_EOF_LEN);
+    return (*eof_p || (remaining < payload)) ? remaining : payload;
+}
+
+/* Number of payload segments of all the frames for a buffer size. */
+static constexpr uint32_t
+CyFxUVCSegmentCount (
+        uint32_t bufSize)
+{
+    uint32_t count = 0;
+
+    for (uint32_t len : CY_FX_UVC_VID_FRAME_LEN)
+    {
+        bool eof = false;
+
+        for (uint32_t offset = 0; !eof; count++)
+        {
+            offset += CyFxUVCSegmentBytes (bufSize, len - offset, &eof);
+        }
+    }
+    return count;
+}
+
+/* Segment table of one buffer size, built by the compiler. */
+template <uint32_t BufSize>
+struct CyFxUVCSegTable_t
+{
+    CyFxUVCSegment_t seg[CyFxUVCSegmentCount (BufSize)];
+
+    constexpr CyFxUVCSegTable_t () : seg {}
+    {
+        uint32_t start = 0, n = 0;
+
+        for (uint32_t len : CY_FX_UVC_VID_FRAME_LEN)
+        {
+            bool eof = false;
+
+            for (uint32_t offset = 0; !eof; n++)
+            {
+                uint32_t bytes = CyFxUVCSegmentBytes (BufSize, len - offset, &eof);
+                seg[n].src_p  = &glUVCVidFrames[start + offset];
+                seg[n].length = static_cast<uint16_t>(bytes);
+                seg[n].commit = static_cast<uint16_t>(bytes + (eof ? CY_FX_UVC_HEADER_EOF_LEN : CY_FX_UVC_HEADER_LEN));
+                seg[n].header = eof ? CY_FX_UVC_HEADER_EOF : CY_FX_UVC_HEADER_FRAME;
+                seg[n].start  = (offset == 0) ? 1 : 0;
+                offset += bytes;
+            }
+            start += len;
+        }
+    }
+};
+
+static constexpr uint32_t
+CyFxUVCFrameStoreSize (
+        void)
+{
+    uint32_t size = 0;
+
+    for (uint32_t len : CY_FX_UVC_VID_FRAME_LEN)
+    {
+        size += len;
+    }
+    return size;
+}
+
+static_assert (sizeof (glUVCVidFrames) == CyFxUVCFrameStoreSize (), "frame lengths do not match the frame store");
+static_assert (sizeof (CY_FX_UVC_SEG_BUF_SIZES) / sizeof (CY_FX_UVC_SEG_BUF_SIZES[0]) == 5,
+        "add the table of the new buffer size below");
+
+static constexpr CyFxUVCSegTable_t<1024>  glUVCSeg1K {};
+static constexpr CyFxUVCSegTable_t<2048>  glUVCSeg2K {};
+static constexpr CyFxUVCSegTable_t<4096>  glUVCSeg4K {};
+static constexpr CyFxUVCSegTable_t<8192>  glUVCSeg8K {};
+static constexpr CyFxUVCSegTable_t<16384> glUVCSeg16K {};
+
+const CyFxUVCSegment_t *
+CyFxUVCSegmentsGet (
+        uint32_t bufSize,
+        uint32_t *count_p)
+{
+    switch (bufSize)
+    {
+        case 1024:  *count_p = CyFxUVCSegmentCount (1024);  return glUVCSeg1K.seg;
+        case 2048:  *count_p = CyFxUVCSegmentCount (2048);  return glUVCSeg2K.seg;
+        case 4096:  *count_p = CyFxUVCSegmentCount (4096);  return glUVCSeg4K.seg;
+        case 8192:  *count_p = CyFxUVCSegmentCount (8192);  return glUVCSeg8K.seg;
+        case 16384: *count_p = CyFxUVCSegmentCount (16384); return glUVCSeg16K.seg;
+        default:    *count_p = 0;                           return NULL;
+    }
+}
@@ -0,0 +1,929 @@
+/*
+ ## Linux host build of the streamer: simulated FX3 SDK layer (fx3host.cpp)
+ ## ===========================
+*/
+
+/* Only what the application sources call is implemented, with the behaviour the
+ * streaming code depends on:
+ *   - CyU3PDmaChannelGetBuffer hands out the free buffers of the MANUAL_OUT ring in
+ *     order and blocks while the host side holds all of them;
+ *   - CyU3PDmaChannelGetBuffer called again before the commit returns the same buffer;
+ *   - CyU3PDmaChannelDestroy fails a pending or later GetBuffer / CommitBuffer, even
+ *     when a new channel is created before the waiting thread runs;
+ *   - callbacks run on the thread of whoever calls FxHostUsbEvent / FxHostControl,
+ *     standing in for the USB driver thread;
+ *   - once enabled, SOF / ITP events come every 1 ms from a thread of their own,
+ *     holding the interrupt mask as an interrupt would (the device gets one per
+ *     125 us; the lower rate keeps the simulation usable on a single CPU).
+ * Buffer memory of a destroyed channel stays valid until the producer thread asks
+ * for a buffer of a newer channel, as the real buffer heap would still be mapped.
+ *
+ * The heaps and memory primitives are those of the firmware (cyfxtx.cpp), over System
+ * RAM mapped at its FX3 address; this layer supplies the ThreadX byte pool and mutexes
+ * under them. The ring buffers of the video channel are not taken from the buffer heap. */
+
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyu3uart.h"
+#include "cyu3vic.h"
+#include "cyfxmemmap.h"
+#include "cyfxuvcclock.h"
+#include "fx3host.h"
+
+using Clock = std::chrono::steady_clock;
+
+static FxHostConfig glHostCfg;
+static Clock::time_point glHostEpoch = Clock::now ();
+static std::recursive_mutex glHostIrqLock;             /* Stands in for the VIC interrupt mask. */
+
+/* USB device state. */
+static std::mutex glUsbLock;
+static std::condition_variable glUsbCond;
+static bool glUsbConnected = false;
+static CyU3PUSBSetupCb_t glSetupCb = nullptr;
+static CyU3PUSBEventCb_t glEventCb = nullptr;
+static CyU3PUsbLPMReqCb_t glLpmCb = nullptr;
+static std::atomic<bool> glSofEnabled (false);
+static bool glSofThread = false;
+static std::map<uint16_t, const uint8_t *> glUsbDesc;   /* By type and index. */
+
+/* Control transfer in progress, filled by the EP0 calls made from the setup callback. */
+struct FxHostControlXfer
+{
+    uint8_t *data_p = nullptr;
+    uint16_t wLength = 0;
+    int result = -1;
+    bool stalled = false;
+};
+static FxHostControlXfer *glCtrl_p = nullptr;
+
+/* The MANUAL_OUT video channel. */
+struct FxHostBufferSet
+{
+    std::vector<std::unique_ptr<uint8_t[]>> mem;
+    uint16_t size = 0;
+};
+
+struct FxHostCommit
+{
+    uint32_t index;
+    uint16_t count;
+    Clock::time_point time;
+};
+
+struct FxHostChannel
+{
+    std::mutex lock;
+    std::condition_variable cond;
+    std::shared_ptr<FxHostBufferSet> set;                   /* Buffers of the live channel. */
+    std::vector<std::shared_ptr<FxHostBufferSet>> retired;  /* Buffers of destroyed channels. */
+    std::deque<uint32_t> freeQ;                             /* Buffers the producer may fill. */
+    std::deque<FxHostCommit> fullQ;                         /* Committed buffers. */
+    int32_t prodIndex = -1;                                 /* Buffer held by the producer. */
+    int32_t consIndex = -1;                                 /* Buffer held by the host side. */
+    std::shared_ptr<FxHostBufferSet> consSet;               /* Set the consumer buffer belongs to. */
+    uint32_t consBytes = 0;                                 /* Bytes read by the host since SetXfer. */
+    bool active = false;
+    uint32_t generation = 0;                                /* Channels destroyed so far. */
+};
+static FxHostChannel glChannel;
+
+/************************************* Host side *************************************/
+
+bool
+FxHostStart (
+        const FxHostConfig &cfg,
+        unsigned timeoutMs)
+{
+    glHostCfg = cfg;
+    glHostEpoch = Clock::now ();
+
+    if (!FxHostMemInit ())
+    {
+        return false;
+    }
+    CyFxApplicationDefine ();
+
+    std::unique_lock<std::mutex> lk (glUsbLock);
+    return glUsbCond.wait_for (lk, std::chrono::milliseconds (timeoutMs), [] { return glUsbConnected; });
+}
+
+void
+FxHostUsbEvent (
+        CyU3PUsbEventType_t evtype,
+        uint16_t evdata)
+{
+    if (glEventCb != nullptr)
+    {
+        glEventCb (evtype, evdata);
+    }
+}
+
+void
+FxHostSetSpeed (
+        CyU3PUSBSpeed_t speed)
+{
+    glHostCfg.speed = speed;
+}
+
+const uint8_t *
+FxHostDescriptor (
+        CyU3PUSBSetDescType_t type,
+        uint8_t index)
+{
+    auto it = glUsbDesc.find (static_cast<uint16_t>((type << 8) | index));
+    return (it != glUsbDesc.end ()) ? it->second : nullptr;
+}
+
+int
+FxHostControl (
+        uint8_t bmRequestType,
+        uint8_t bRequest,
+        uint16_t wValue,
+        uint16_t wIndex,
+        void *data_p,
+        uint16_t wLength)
+{
+    if (glSetupCb == nullptr)
+    {
+        return -1;
+    }
+
+    FxHostControlXfer xfer;
+    xfer.data_p  = static_cast<uint8_t *>(data_p);
+    xfer.wLength = wLength;
+    glCtrl_p = &xfer;
+
+    uint32_t setupdat0 = bmRequestType | (static_cast<uint32_t>(bRequest) << 8) | (static_cast<uint32_t>(wValue) << 16);
+    uint32_t setupdat1 = wIndex | (static_cast<uint32_t>(wLength) << 16);
+    CyBool_t handled = glSetupCb (setupdat0, setupdat1);
+
+    glCtrl_p = nullptr;
+    if (!handled || xfer.stalled)
+    {
+        return -1;
+    }
+    return (xfer.result < 0) ? 0 : xfer.result;
+}
+
+bool
+FxHostBulkRead (
+        FxHostBuffer *buf_p,
+        unsigned timeoutMs)
+{
+    std::unique_lock<std::mutex> lk (glChannel.lock);
+    if (!glChannel.cond.wait_for (lk, std::chrono::milliseconds (timeoutMs),
+                [] { return !glChannel.fullQ.empty (); }))
+    {
+        return false;
+    }
+
+    FxHostCommit commit = glChannel.fullQ.front ();
+    glChannel.fullQ.pop_front ();
+    glChannel.consIndex = static_cast<int32_t>(commit.index);
+    glChannel.consSet   = glChannel.set;
+    glChannel.consBytes += commit.count;
+    buf_p->data     = glChannel.consSet->mem[commit.index].get ();
+    buf_p->count    = commit.count;
+    buf_p->size     = glChannel.consSet->size;
+    buf_p->commitNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds> (
+                commit.time.time_since_epoch ()).count ());
+    return true;
+}
+
+void
+FxHostBulkRelease (
+        void)
+{
+    std::lock_guard<std::mutex> lk (glChannel.lock);
+    if ((glChannel.consIndex >= 0) && (glChannel.consSet == glChannel.set) && glChannel.active)
+    {
+        glChannel.freeQ.push_back (static_cast<uint32_t>(glChannel.consIndex));
+        glChannel.cond.notify_all ();
+    }
+    glChannel.consIndex = -1;
+    glChannel.consSet.reset ();
+}
+
+/*********************************** ThreadX / OS ***********************************/
+
+static TX_THREAD *glThreadList = nullptr;              /* Created threads, as a ThreadX circular list. */
+static thread_local TX_THREAD *glThreadSelf = nullptr; /* Thread of the caller, nullptr outside the firmware threads. */
+
+UINT
+_txe_thread_create (
+        TX_THREAD *thread_ptr, CHAR *name_ptr, VOID (*entry_function)(ULONG), ULONG entry_input,
+        VOID *stack_start, ULONG stack_size, UINT priority, UINT preempt_threshold, ULONG, UINT, UINT)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lk (glHostIrqLock);
+        thread_ptr->tx_thread_name = name_ptr;
+        thread_ptr->tx_thread_priority = priority;
+        thread_ptr->tx_thread_preempt_threshold = preempt_threshold;
+        thread_ptr->tx_thread_stack_start = stack_start;
+        thread_ptr->tx_thread_stack_size = stack_size;
+        thread_ptr->tx_thread_stack_end = static_cast<uint8_t *>(stack_start) + stack_size - 1;
+        if (glThreadList == nullptr)
+        {
+            thread_ptr->tx_thread_created_next = thread_ptr->tx_thread_created_previous = thread_ptr;
+            glThreadList = thread_ptr;
+        }
+        else
+        {
+            thread_ptr->tx_thread_created_next = glThreadList;
+            thread_ptr->tx_thread_created_previous = glThreadList->tx_thread_created_previous;
+            glThreadList->tx_thread_created_previous->tx_thread_created_next = thread_ptr;
+            glThreadList->tx_thread_created_previous = thread_ptr;
+        }
+    }
+
+    std::thread ([=] {
+        glThreadSelf = thread_ptr;
+        entry_function (entry_input);
+    }).detach ();
+    return TX_SUCCESS;
+}
+
+/* The runner threads stand in for the USB driver and interrupt context: they identify
+ * as no thread, as an interrupt handler does. */
+TX_THREAD *
+_tx_thread_identify (
+        VOID)
+{
+    return glThreadSelf;
+}
+
+UINT
+_txe_thread_info_get (
+        TX_THREAD *thread_ptr, CHAR **name, UINT *state, ULONG *run_count, UINT *priority,
+        UINT *preemption_threshold, ULONG *time_slice, TX_THREAD **next_thread, TX_THREAD **next_suspended_thread)
+{
+    std::lock_guard<std::recursive_mutex> lk (glHostIrqLock);
+    if (name) *name = thread_ptr->tx_thread_name;
+    if (state) *state = TX_READY;
+    if (run_count) *run_count = 0;
+    if (priority) *priority = thread_ptr->tx_thread_priority;
+    if (preemption_threshold) *preemption_threshold = thread_ptr->tx_thread_preempt_threshold;
+    if (time_slice) *time_slice = 0;
+    if (next_thread) *next_thread = thread_ptr->tx_thread_created_next;
+    if (next_suspended_thread) *next_suspended_thread = nullptr;
+    return TX_SUCCESS;
+}
+
+/* Host threads are not scheduled by this layer, so there are no performance counters;
+ * the queries fail as they do with the non-profiling FX3 libraries. */
+UINT _tx_thread_performance_info_get (TX_THREAD *, ULONG *, ULONG *, ULONG *, ULONG *, ULONG *, ULONG *,
+        ULONG *, ULONG *, ULONG *, TX_THREAD **) { return TX_FEATURE_NOT_ENABLED; }
+UINT _tx_thread_performance_system_info_get (ULONG *, ULONG *, ULONG *, ULONG *, ULONG *, ULONG *, ULONG *,
+        ULONG *, ULONG *, ULONG *, ULONG *) { return TX_FEATURE_NOT_ENABLED; }
+UINT _tx_mutex_performance_info_get (TX_MUTEX *, ULONG *, ULONG *, ULONG *, ULONG *, ULONG *,
+        ULONG *) { return TX_FEATURE_NOT_ENABLED; }
+UINT _tx_mutex_performance_system_info_get (ULONG *, ULONG *, ULONG *, ULONG *, ULONG *,
+        ULONG *) { return TX_FEATURE_NOT_ENABLED; }
+UINT _tx_event_flags_performance_info_get (TX_EVENT_FLAGS_GROUP *, ULONG *, ULONG *, ULONG *,
+        ULONG *) { return TX_FEATURE_NOT_ENABLED; }
+UINT _tx_event_flags_performance_system_info_get (ULONG *, ULONG *, ULONG *,
+        ULONG *) { return TX_FEATURE_NOT_ENABLED; }
+
+/* Timers run on a thread of their own, in real milliseconds. They are never deleted. */
+UINT
+_txe_timer_create (
+        TX_TIMER *, CHAR *, VOID (*expiration_function)(ULONG), ULONG expiration_input, ULONG initial_ticks,
+        ULONG reschedule_ticks, UINT auto_activate, UINT)
+{
+    if (auto_activate == TX_AUTO_ACTIVATE)
+    {
+        std::thread ([=] {
+            std::this_thread::sleep_for (std::chrono::milliseconds (initial_ticks));
+            for (;;)
+            {
+                expiration_function (expiration_input);
+                if (reschedule_ticks == 0)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for (std::chrono::milliseconds (reschedule_ticks));
+            }
+        }).detach ();
+    }
+    return TX_SUCCESS;
+}
+
+UINT
+_tx_thread_sleep (
+        ULONG timer_ticks)
+{
+    if (glHostCfg.sleepScale > 0)
+    {
+        std::this_thread::sleep_for (std::chrono::duration<double, std::milli> (timer_ticks * glHostCfg.sleepScale));
+    }
+    else
+    {
+        std::this_thread::yield ();
+    }
+    return TX_SUCCESS;
+}
+
+ULONG
+_tx_time_get (
+        VOID)
+{
+    return static_cast<ULONG>(std::chrono::duration_cast<std::chrono::milliseconds> (Clock::now () - glHostEpoch).count ());
+}
+
+uint32_t
+CyU3PVicDisableAllInterrupts (
+        void)
+{
+    glHostIrqLock.lock ();
+    return 1;
+}
+
+void
+CyU3PVicEnableInterrupts (
+        uint32_t)
+{
+    glHostIrqLock.unlock ();
+}
+
+/* ThreadX mutexes, recursive as in ThreadX. The wait option is in ticks of 1 ms. */
+static std::mutex glMutexLock;
+static std::map<TX_MUTEX *, std::unique_ptr<std::recursive_timed_mutex>> glMutexes;
+
+static std::recursive_timed_mutex *
+FxHostMutex (
+        TX_MUTEX *mutex_ptr)
+{
+    std::lock_guard<std::mutex> lk (glMutexLock);
+    auto it = glMutexes.find (mutex_ptr);
+    return (it != glMutexes.end ()) ? it->second.get () : nullptr;
+}
+
+UINT
+_txe_mutex_create (
+        TX_MUTEX *mutex_ptr, CHAR *name_ptr, UINT inherit, UINT)
+{
+    std::lock_guard<std::mutex> lk (glMutexLock);
+    mutex_ptr->tx_mutex_name = name_ptr;
+    mutex_ptr->tx_mutex_inherit = inherit;
+    glMutexes[mutex_ptr] = std::make_unique<std::recursive_timed_mutex> ();
+    return TX_SUCCESS;
+}
+
+UINT
+_txe_mutex_delete (
+        TX_MUTEX *mutex_ptr)
+{
+    std::lock_guard<std::mutex> lk (glMutexLock);
+    return (glMutexes.erase (mutex_ptr) != 0) ? TX_SUCCESS : TX_MUTEX_ERROR;
+}
+
+UINT
+_txe_mutex_get (
+        TX_MUTEX *mutex_ptr,
+        ULONG wait_option)
+{
+    std::recursive_timed_mutex *mutex_p = FxHostMutex (mutex_ptr);
+    if (mutex_p == nullptr)
+    {
+        return TX_MUTEX_ERROR;
+    }
+    if (wait_option == TX_WAIT_FOREVER)
+    {
+        mutex_p->lock ();
+        return TX_SUCCESS;
+    }
+    bool locked = (wait_option == TX_NO_WAIT) ? mutex_p->try_lock () :
+        mutex_p->try_lock_for (std::chrono::milliseconds (wait_option));
+    return locked ? TX_SUCCESS : TX_NOT_AVAILABLE;
+}
+
+UINT
+_txe_mutex_put (
+        TX_MUTEX *mutex_ptr)
+{
+    std::recursive_timed_mutex *mutex_p = FxHostMutex (mutex_ptr);
+    if (mutex_p == nullptr)
+    {
+        return TX_MUTEX_ERROR;
+    }
+    mutex_p->unlock ();
+    return TX_SUCCESS;
+}
+
+/*************************************** Memory **************************************/
+
+/* System RAM is mapped at its FX3 address, so that the allocators of cyfxtx.cpp run
+ * unmodified: they hand out and check 32-bit addresses inside their heap regions. */
+static bool glSysMemMapped = false;
+
+/* ThreadX byte pools, backing the driver heap of cyfxtx.cpp. First fit over the
+ * allocated blocks, without the block headers of the ThreadX pool. */
+struct FxHostBytePool
+{
+    uintptr_t start;
+    ULONG size;
+    std::map<uintptr_t, ULONG> blocks;                  /* Allocated blocks by address. */
+};
+static std::mutex glPoolLock;
+static std::map<TX_BYTE_POOL *, FxHostBytePool> glPools;
+
+bool
+FxHostMemInit (
+        void)
+{
+    if (!glSysMemMapped)
+    {
+        void *mem_p = mmap (reinterpret_cast<void *>(CY_FX_MEM_SYSMEM_BASE), CY_FX_MEM_SYSMEM_TOP - CY_FX_MEM_SYSMEM_BASE,
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (mem_p != reinterpret_cast<void *>(CY_FX_MEM_SYSMEM_BASE))
+        {
+            fprintf (stderr, "System RAM cannot be mapped at 0x%08x: %s\n", CY_FX_MEM_SYSMEM_BASE,
+                    (mem_p == MAP_FAILED) ? strerror (errno) : "address taken");
+            return false;
+        }
+        glSysMemMapped = true;
+    }
+
+    /* The SDK initializes the heaps before it calls tx_application_define. */
+    CyU3PMemInit ();
+    CyU3PDmaBufferInit ();
+    return true;
+}
+
+UINT
+_txe_byte_pool_create (
+        TX_BYTE_POOL *pool_ptr, CHAR *name_ptr, VOID *pool_start, ULONG pool_size, UINT)
+{
+    std::lock_guard<std::mutex> lk (glPoolLock);
+    pool_ptr->tx_byte_pool_name = name_ptr;
+    glPools[pool_ptr] = FxHostBytePool { reinterpret_cast<uintptr_t>(pool_start), pool_size, {} };
+    return TX_SUCCESS;
+}
+
+UINT
+_txe_byte_pool_delete (
+        TX_BYTE_POOL *pool_ptr)
+{
+    std::lock_guard<std::mutex> lk (glPoolLock);
+    return (glPools.erase (pool_ptr) != 0) ? TX_SUCCESS : TX_POOL_ERROR;
+}
+
+UINT
+_txe_byte_allocate (
+        TX_BYTE_POOL *pool_ptr,
+        VOID **memory_ptr,
+        ULONG memory_size,
+        ULONG)
+{
+    std::lock_guard<std::mutex> lk (glPoolLock);
+    auto it = glPools.find (pool_ptr);
+    if (it == glPools.end ())
+    {
+        return TX_POOL_ERROR;
+    }
+
+    FxHostBytePool &pool = it->second;
+    ULONG size = (memory_size + 7) & ~7ul;
+    uintptr_t addr = pool.start;
+    for (const auto &block : pool.blocks)
+    {
+        if (block.first - addr >= size)
+        {
+            break;
+        }
+        addr = block.first + block.second;
+    }
+    if (addr + size > pool.start + pool.size)
+    {
+        *memory_ptr = nullptr;
+        return TX_NO_MEMORY;
+    }
+    pool.blocks[addr] = size;
+    *memory_ptr = reinterpret_cast<void *>(addr);
+    return TX_SUCCESS;
+}
+
+UINT
+_txe_byte_release (
+        VOID *memory_ptr)
+{
+    std::lock_guard<std::mutex> lk (glPoolLock);
+    for (auto &pool : glPools)
+    {
+        if (pool.second.blocks.erase (reinterpret_cast<uintptr_t>(memory_ptr)) != 0)
+        {
+            return TX_SUCCESS;
+        }
+    }
+    return TX_PTR_ERROR;
+}
+
+UINT
+_txe_byte_pool_info_get (
+        TX_BYTE_POOL *pool_ptr, CHAR **name, ULONG *available_bytes, ULONG *fragments,
+        TX_THREAD **first_suspended, ULONG *suspended_count, TX_BYTE_POOL **next_pool)
+{
+    std::lock_guard<std::mutex> lk (glPoolLock);
+    auto it = glPools.find (pool_ptr);
+    if (it == glPools.end ())
+    {
+        return TX_POOL_ERROR;
+    }
+
+    const FxHostBytePool &pool = it->second;
+    ULONG used = 0, gaps = 0;
+    uintptr_t addr = pool.start;
+    for (const auto &block : pool.blocks)
+    {
+        gaps += (block.first != addr) ? 1 : 0;
+        used += block.second;
+        addr = block.first + block.second;
+    }
+    gaps += (addr != pool.start + pool.size) ? 1 : 0;
+
+    if (name) *name = pool_ptr->tx_byte_pool_name;
+    if (available_bytes) *available_bytes = pool.size - used;
+    if (fragments) *fragments = gaps;
+    if (first_suspended) *first_suspended = nullptr;
+    if (suspended_count) *suspended_count = 0;
+    if (next_pool) *next_pool = nullptr;
+    return TX_SUCCESS;
+}
+
+/*********************************** Clock, debug ***********************************/
+
+CyU3PReturnStatus_t
+CyFxUVCClockInit (
+        void)
+{
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyFxUVCClockHz (
+        void)
+{
+    return 1000000000u;
+}
+
+uint32_t
+CyFxUVCClockTicks (
+        void)
+{
+    timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return static_cast<uint32_t>(static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec));
+}
+
+CyU3PReturnStatus_t
+CyU3PDebugInit (
+        CyU3PDmaSocketId_t,
+        uint8_t)
+{
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PDebugPrint (
+        uint8_t,
+        char *message,
+        ...)
+{
+    if (glHostCfg.verbose)
+    {
+        va_list args;
+        va_start (args, message);
+        vfprintf (stderr, message, args);
+        va_end (args);
+    }
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t CyU3PUartInit (void) { return CY_U3P_SUCCESS; }
+CyU3PReturnStatus_t CyU3PUartSetConfig (CyU3PUartConfig_t *, CyU3PUartIntrCb_t) { return CY_U3P_SUCCESS; }
+CyU3PReturnStatus_t CyU3PUartTxSetBlockXfer (uint32_t) { return CY_U3P_SUCCESS; }
+
+/*************************************** USB ***************************************/
+
+CyU3PReturnStatus_t CyU3PUsbStart (void) { return CY_U3P_SUCCESS; }
+
+CyU3PReturnStatus_t
+CyU3PUsbSetDesc (
+        CyU3PUSBSetDescType_t desc_type,
+        uint8_t desc_index,
+        uint8_t *desc)
+{
+    glUsbDesc[static_cast<uint16_t>((desc_type << 8) | desc_index)] = desc;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t CyU3PSetEpConfig (uint8_t, CyU3PEpConfig_t *) { return CY_U3P_SUCCESS; }
+CyU3PReturnStatus_t CyU3PUsbFlushEp (uint8_t) { return CY_U3P_SUCCESS; }
+CyU3PReturnStatus_t CyU3PUsbLPMDisable (void) { return CY_U3P_SUCCESS; }
+CyU3PReturnStatus_t CyU3PUsbSetLinkPowerState (CyU3PUsbLinkPowerMode) { return CY_U3P_SUCCESS; }
+
+void CyU3PUsbRegisterSetupCallback (CyU3PUSBSetupCb_t callback, CyBool_t) { glSetupCb = callback; }
+void CyU3PUsbRegisterEventCallback (CyU3PUSBEventCb_t callback) { glEventCb = callback; }
+void CyU3PUsbRegisterLPMRequestCallback (CyU3PUsbLPMReqCb_t cb) { glLpmCb = cb; }
+
+/* 125 us (micro)frame count since the start, as the bus counters of the FX3 count. */
+static uint32_t
+FxHostBusIntervals (
+        void)
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds> (
+                Clock::now () - glHostEpoch).count () / 125);
+}
+
+CyU3PReturnStatus_t
+CyU3PUsbEnableITPEvent (
+        CyBool_t enable)
+{
+    glSofEnabled = (enable != CyFalse);
+    if (enable && !glSofThread)
+    {
+        /* The thread lives as long as the process and idles while the events are off. */
+        glSofThread = true;
+        std::thread ([] {
+            for (;;)
+            {
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
+                if (glSofEnabled && (glEventCb != nullptr))
+                {
+                    std::lock_guard<std::recursive_mutex> irq (glHostIrqLock);
+                    glEventCb (CY_U3P_USB_EVENT_SOF_ITP, 0);
+                }
+            }
+        }).detach ();
+    }
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PUsbGetErrorCounts (
+        uint16_t *phy_err_cnt,
+        uint16_t *lnk_err_cnt)
+{
+    if (glHostCfg.speed != CY_U3P_SUPER_SPEED)
+    {
+        return CY_U3P_ERROR_INVALID_SEQUENCE;
+    }
+    *phy_err_cnt = 0;
+    *lnk_err_cnt = 0;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PUsbGetDevProperty (
+        CyU3PUsbDevProperty type,
+        uint32_t *buf)
+{
+    if ((type != CY_U3P_USB_PROP_FRAMECNT) && (type != CY_U3P_USB_PROP_ITPINFO))
+    {
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+    *buf = FxHostBusIntervals () & 0x3FFF;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PUSBSpeed_t
+CyU3PUsbGetSpeed (
+        void)
+{
+    return glHostCfg.speed;
+}
+
+CyU3PReturnStatus_t
+CyU3PUsbGetLinkPowerState (
+        CyU3PUsbLinkPowerMode *mode_p)
+{
+    *mode_p = CyU3PUsbLPM_U0;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PConnectState (
+        CyBool_t connect,
+        CyBool_t)
+{
+    std::lock_guard<std::mutex> lk (glUsbLock);
+    glUsbConnected = (connect != CyFalse);
+    glUsbCond.notify_all ();
+    return CY_U3P_SUCCESS;
+}
+
+void
+CyU3PUsbAckSetup (
+        void)
+{
+    if (glCtrl_p != nullptr)
+    {
+        glCtrl_p->result = 0;
+    }
+}
+
+CyU3PReturnStatus_t
+CyU3PUsbStall (
+        uint8_t ep,
+        CyBool_t stall,
+        CyBool_t)
+{
+    if ((ep == 0) && stall && (glCtrl_p != nullptr))
+    {
+        glCtrl_p->stalled = true;
+    }
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PUsbSendEP0Data (
+        uint16_t count,
+        uint8_t *buffer)
+{
+    if (glCtrl_p == nullptr)
+    {
+        return CY_U3P_ERROR_INVALID_SEQUENCE;
+    }
+
+    uint16_t length = (count < glCtrl_p->wLength) ? count : glCtrl_p->wLength;
+    memcpy (glCtrl_p->data_p, buffer, length);
+    glCtrl_p->result = length;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PUsbGetEP0Data (
+        uint16_t count,
+        uint8_t *buffer,
+        uint16_t *readCount)
+{
+    if (glCtrl_p == nullptr)
+    {
+        return CY_U3P_ERROR_INVALID_SEQUENCE;
+    }
+
+    uint16_t length = (count < glCtrl_p->wLength) ? count : glCtrl_p->wLength;
+    memcpy (buffer, glCtrl_p->data_p, length);
+    glCtrl_p->result = length;
+    if (readCount != nullptr)
+    {
+        *readCount = length;
+    }
+    return CY_U3P_SUCCESS;
+}
+
+/*************************************** DMA ***************************************/
+
+CyU3PReturnStatus_t
+CyU3PDmaChannelCreate (
+        CyU3PDmaChannel *,
+        CyU3PDmaType_t,
+        CyU3PDmaChannelConfig_t *config)
+{
+    auto set = std::make_shared<FxHostBufferSet> ();
+    set->size = config->size;
+    for (uint16_t i = 0; i < config->count; i++)
+    {
+        set->mem.emplace_back (new uint8_t[config->size]);
+    }
+
+    std::lock_guard<std::mutex> lk (glChannel.lock);
+    glChannel.set = set;
+    glChannel.freeQ.clear ();
+    glChannel.fullQ.clear ();
+    for (uint32_t i = 0; i < config->count; i++)
+    {
+        glChannel.freeQ.push_back (i);
+    }
+    glChannel.prodIndex = -1;
+    glChannel.active = false;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PDmaChannelSetXfer (
+        CyU3PDmaChannel *,
+        uint32_t)
+{
+    std::lock_guard<std::mutex> lk (glChannel.lock);
+    glChannel.active = true;
+    glChannel.consBytes = 0;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PDmaChannelGetStatus (
+        CyU3PDmaChannel *,
+        CyU3PDmaState_t *state,
+        uint32_t *prodXferCount,
+        uint32_t *consXferCount)
+{
+    std::lock_guard<std::mutex> lk (glChannel.lock);
+    *state = glChannel.active ? CY_U3P_DMA_ACTIVE : CY_U3P_DMA_CONFIGURED;
+    *prodXferCount = 0;
+    *consXferCount = glChannel.consBytes;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PDmaChannelDestroy (
+        CyU3PDmaChannel *)
+{
+    std::lock_guard<std::mutex> lk (glChannel.lock);
+    if (glChannel.set)
+    {
+        glChannel.retired.push_back (glChannel.set);
+    }
+    glChannel.set.reset ();
+    glChannel.active = false;
+    glChannel.generation++;
+    glChannel.freeQ.clear ();
+    glChannel.fullQ.clear ();
+    glChannel.prodIndex = -1;
+    glChannel.cond.notify_all ();
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PDmaChannelGetBuffer (
+        CyU3PDmaChannel *,
+        CyU3PDmaBuffer_t *buffer_p,
+        uint32_t waitOption)
+{
+    std::unique_lock<std::mutex> lk (glChannel.lock);
+    uint32_t generation = glChannel.generation;
+    auto ready = [&] { return !glChannel.active || (glChannel.generation != generation) ||
+        (glChannel.prodIndex >= 0) || !glChannel.freeQ.empty (); };
+
+    if (waitOption == CYU3P_WAIT_FOREVER)
+    {
+        glChannel.cond.wait (lk, ready);
+    }
+    else if (!glChannel.cond.wait_for (lk, std::chrono::milliseconds (waitOption), ready))
+    {
+        return CY_U3P_ERROR_TIMEOUT;
+    }
+
+    if (!glChannel.active || (glChannel.generation != generation))
+    {
+        return CY_U3P_ERROR_ABORTED;
+    }
+
+    /* The producer has moved on to this channel: older buffer sets are unused now,
+     * except the one the host side may still be reading. */
+    std::erase_if (glChannel.retired, [] (const auto &set) { return set != glChannel.consSet; });
+
+    if (glChannel.prodIndex < 0)
+    {
+        glChannel.prodIndex = static_cast<int32_t>(glChannel.freeQ.front ());
+        glChannel.freeQ.pop_front ();
+    }
+    uint32_t index = static_cast<uint32_t>(glChannel.prodIndex);
+
+    buffer_p->buffer = glChannel.set->mem[index].get ();
+    buffer_p->count  = 0;
+    buffer_p->size   = glChannel.set->size;
+    buffer_p->status = 0;
+    return CY_U3P_SUCCESS;
+}
+
+CyU3PReturnStatus_t
+CyU3PDmaChannelCommitBuffer (
+        CyU3PDmaChannel *,
+        uint16_t count,
+        uint16_t)
+{
+    std::lock_guard<std::mutex> lk (glChannel.lock);
+    if (!glChannel.active || (glChannel.prodIndex < 0))
+    {
+        return CY_U3P_ERROR_INVALID_SEQUENCE;
+    }
+
+    glChannel.fullQ.push_back ({static_cast<uint32_t>(glChannel.prodIndex), count, Clock::now ()});
+    glChannel.prodIndex = -1;
+    glChannel.cond.notify_all ();
+    return CY_U3P_SUCCESS;
+}
+
+/*[]*/
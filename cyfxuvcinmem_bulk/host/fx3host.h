@@ -0,0 +1,94 @@
+/*
+ ## Linux host build of the streamer: simulated FX3 SDK layer (fx3host.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_FX3HOST_H_
+#define _INCLUDED_FX3HOST_H_
+
+/* fx3host.cpp implements the subset of the FX3 SDK and ThreadX API used by the
+ * application sources, so that cyfxuvcinmem.cpp and its modules build and run
+ * unmodified on Linux (CYFX_HOST_BUILD). Threads are std::threads, the interrupt
+ * mask is a process-wide lock, time is CLOCK_MONOTONIC and the MANUAL_OUT DMA
+ * channel is a ring of heap buffers. This header is the other side of that layer:
+ * the runner plays the USB host, injecting events and control requests and
+ * draining the buffers the firmware commits on the video endpoint. The runner is either
+ * a simulated host (uvcprof) or a bridge to a real one (uvcgadget). */
+
+#include <cstdint>
+
+#include "cyu3types.h"
+#include "cyu3usb.h"
+
+struct FxHostConfig
+{
+    CyU3PUSBSpeed_t speed = CY_U3P_SUPER_SPEED;    // Speed reported by CyU3PUsbGetSpeed
+    double sleepScale = 1.0;                       // Scale of CyU3PThreadSleep; 0 only yields
+    bool verbose = false;                          // Echo CyU3PDebugPrint output to stderr
+};
+
+/* A buffer committed on the video endpoint. Valid until FxHostBulkRelease. */
+struct FxHostBuffer
+{
+    const uint8_t *data;
+    uint16_t count;
+    uint16_t size;                                 // Buffer size of the channel
+    uint64_t commitNs;                             // steady_clock time of the commit, in ns
+};
+
+/* Map System RAM at its FX3 address and initialize the driver and buffer heaps of
+ * cyfxtx.cpp, as the SDK does before starting the application. Called by FxHostStart;
+ * runners that only exercise the allocators call it themselves. */
+bool
+FxHostMemInit (
+        void);
+
+/* Run CyFxApplicationDefine and wait until the firmware connects to the bus. */
+bool
+FxHostStart (
+        const FxHostConfig &cfg,
+        unsigned timeoutMs);
+
+/* Deliver a USB event to the registered event callback, from the calling thread. */
+void
+FxHostUsbEvent (
+        CyU3PUsbEventType_t evtype,
+        uint16_t evdata);
+
+/* Run a control request through the registered setup callback. For IN requests the
+ * data phase is copied to data_p, for OUT requests it is taken from data_p. Returns
+ * the data phase length, or -1 if the request was stalled or not handled. */
+int
+FxHostControl (
+        uint8_t bmRequestType,
+        uint8_t bRequest,
+        uint16_t wValue,
+        uint16_t wIndex,
+        void *data_p,
+        uint16_t wLength);
+
+/* Set the speed reported by CyU3PUsbGetSpeed, once the bus speed is known. */
+void
+FxHostSetSpeed (
+        CyU3PUSBSpeed_t speed);
+
+/* A descriptor registered by the firmware with CyU3PUsbSetDesc, or nullptr. */
+const uint8_t *
+FxHostDescriptor (
+        CyU3PUSBSetDescType_t type,
+        uint8_t index);
+
+/* Wait for the next buffer committed on the video endpoint. */
+bool
+FxHostBulkRead (
+        FxHostBuffer *buf_p,
+        unsigned timeoutMs);
+
+/* Hand the buffer returned by FxHostBulkRead back to the producer. */
+void
+FxHostBulkRelease (
+        void);
+
+#endif /* _INCLUDED_FX3HOST_H_ */
+
+/*[]*/
@@ -0,0 +1,169 @@
+/*
+ ## Copy path benchmark reader for the UVC bulk streamer (uvcbench.cpp)
+ ## ===========================
+*/
+
+/* Runs the CY_FX_UVC_VENDOR_RQT_GET_BENCH vendor request of a ProfileRelease /
+ * ProfileDebug streamer and prints the bandwidth of each case of the copy path. The
+ * benchmark runs in the control request, so stop streaming first. To compare two
+ * builds (typically without and with CY_FX_UVC_DCACHE=1), save the result of the
+ * first with -o, flash the second and run again with -b on the saved file. */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "cyfxuvcbench.h"
+#include "uvchost.h"
+
+static const char *const glCaseNames[CY_FX_UVC_BENCH_COUNT] =
+{
+    "read", "write", "memcopy", "copy+clean", "state sysmem", "state dtcm", "wordcopy"
+};
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d vid:pid] [-o file] [-b file]\n"
+            "  -d  device to benchmark (default %04x:%04x)\n"
+            "  -o  save the result to file\n"
+            "  -b  compare with a result saved earlier with -o\n",
+            prog, CY_FX_HOST_DEFAULT_VID, CY_FX_HOST_DEFAULT_PID);
+}
+
+static bool
+Valid (
+        const CyFxUVCBench_t &bench,
+        int len)
+{
+    return (len == static_cast<int>(sizeof (bench))) && (bench.version == CY_FX_UVC_BENCH_VERSION) &&
+        (bench.caseCount == CY_FX_UVC_BENCH_COUNT);
+}
+
+/* Average bandwidth of a case in MB/s. */
+static double
+MBps (
+        const CyFxUVCBench_t &bench,
+        const CyFxUVCBenchResult_t &result)
+{
+    double seconds = static_cast<double>(result.totalTicks) / bench.clockHz;
+    return (seconds > 0) ? (static_cast<double>(result.bytes) * bench.rounds / seconds / 1e6) : 0.0;
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    const char *saveFile = nullptr, *baseFile = nullptr;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:o:b:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'o': saveFile = optarg; break;
+            case 'b': baseFile = optarg; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    static CyFxUVCBench_t bench, base;
+    bool haveBase = false;
+
+    if (baseFile != nullptr)
+    {
+        FILE *f = fopen (baseFile, "rb");
+        int len = (f != nullptr) ? static_cast<int>(fread (&base, 1, sizeof (base), f)) : -1;
+        if (f != nullptr)
+        {
+            fclose (f);
+        }
+        if (!Valid (base, len))
+        {
+            fprintf (stderr, "%s: not a saved benchmark result\n", baseFile);
+            return 1;
+        }
+        haveBase = true;
+    }
+
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_BENCH, 0, &bench, sizeof (bench));
+    close (fd);
+    if (len < 0)
+    {
+        fprintf (stderr, "GET_BENCH failed: %s (not a profiling build?)\n", strerror (errno));
+        return 1;
+    }
+    if (!Valid (bench, len))
+    {
+        fprintf (stderr, "unexpected benchmark block (%d bytes, version %u)\n", len, bench.version);
+        return 1;
+    }
+    if (bench.status != 0)
+    {
+        fprintf (stderr, "benchmark did not run, status %u\n", bench.status);
+        return 1;
+    }
+
+    printf ("D-cache %s, %u rounds per case, clock %u Hz%s\n", bench.dcache ? "on" : "off", bench.rounds,
+            bench.clockHz, haveBase ? (base.dcache ? ", baseline D-cache on" : ", baseline D-cache off") : "");
+    printf ("%-14s %8s %10s %10s %10s%s\n", "case", "bytes", "MB/s", "best us", "worst us",
+            haveBase ? "   baseline  speedup" : "");
+    for (uint32_t i = 0; i < CY_FX_UVC_BENCH_COUNT; i++)
+    {
+        const CyFxUVCBenchResult_t &r = bench.result[i];
+        double mbps = MBps (bench, r);
+
+        printf ("%-14s %8u %10.1f %10.1f %10.1f", glCaseNames[i], r.bytes, mbps,
+                1e6 * r.minTicks / bench.clockHz, 1e6 * r.maxTicks / bench.clockHz);
+        if (haveBase)
+        {
+            double baseMbps = MBps (base, base.result[i]);
+            printf ("  %9.1f  %6.2fx", baseMbps, (baseMbps > 0) ? (mbps / baseMbps) : 0.0);
+        }
+        printf ("\n");
+    }
+
+    /* The state cases do one load and one store per operation. */
+    const CyFxUVCBenchResult_t &sys = bench.result[CY_FX_UVC_BENCH_STATE_SYSMEM];
+    const CyFxUVCBenchResult_t &tcm = bench.result[CY_FX_UVC_BENCH_STATE_DTCM];
+    double ops = static_cast<double>(bench.stateOps) * bench.rounds;
+    printf ("state update: %.1f ns in SYSMEM, %.1f ns in D-TCM (%.1f ns saved per access)\n",
+            1e9 * sys.totalTicks / bench.clockHz / ops, 1e9 * tcm.totalTicks / bench.clockHz / ops,
+            1e9 * (static_cast<double>(sys.totalTicks) - tcm.totalTicks) / bench.clockHz / ops);
+
+    if (saveFile != nullptr)
+    {
+        FILE *f = fopen (saveFile, "wb");
+        if ((f == nullptr) || (fwrite (&bench, 1, sizeof (bench), f) != sizeof (bench)))
+        {
+            fprintf (stderr, "%s: %s\n", saveFile, strerror (errno));
+        }
+        if (f != nullptr)
+        {
+            fclose (f);
+        }
+    }
+    return 0;
+}
+
+/*[]*/
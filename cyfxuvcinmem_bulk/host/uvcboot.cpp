@@ -0,0 +1,133 @@
+/*
+ ## Boot timeline reader for the UVC bulk streamer (uvcboot.cpp)
+ ## ===========================
+*/
+
+/* Reads the CY_FX_UVC_VENDOR_RQT_GET_BOOT vendor request and prints the time at which
+ * each boot phase was reached, in the order the phases ran. Times are in ms from the
+ * RTOS start; once the timestamp clock runs, the step from the previous phase is also
+ * given in us. Compare a default build with a CY_FX_UVC_FAST_BOOT=1 build to see the
+ * time moved out of the path to CONNECT. */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "cyfxuvcboot.h"
+#include "uvchost.h"
+
+static const char *const glPhaseNames[CY_FX_UVC_BOOT_COUNT] =
+{
+    "kernel", "thread", "debug uart", "clock", "usb start", "descriptors", "connect", "usb reset", "setconf"
+};
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d vid:pid]\n"
+            "  -d  device to read (default %04x:%04x)\n",
+            prog, CY_FX_HOST_DEFAULT_VID, CY_FX_HOST_DEFAULT_PID);
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    static CyFxUVCBoot_t boot;
+    int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_BOOT, 0, &boot, sizeof (boot));
+    close (fd);
+    if (len < 0)
+    {
+        fprintf (stderr, "GET_BOOT failed: %s\n", strerror (errno));
+        return 1;
+    }
+    if ((len != static_cast<int>(sizeof (boot))) || (boot.version != CY_FX_UVC_BOOT_VERSION) ||
+            (boot.phaseCount != CY_FX_UVC_BOOT_COUNT))
+    {
+        fprintf (stderr, "unexpected boot block (%d bytes, version %u)\n", len, boot.version);
+        return 1;
+    }
+
+    /* The fast boot build reaches the phases out of enum order: sort them by time. The
+     * sort is stable, so phases stamped in the same ms keep their enum order. */
+    uint32_t order[CY_FX_UVC_BOOT_COUNT], count = 0;
+    for (uint32_t i = 0; i < CY_FX_UVC_BOOT_COUNT; i++)
+    {
+        if (boot.reachedMask & (1u << i))
+        {
+            order[count++] = i;
+        }
+    }
+    std::stable_sort (order, order + count, [] (uint32_t a, uint32_t b)
+            {
+                bool ticksA = (boot.ticksMask & (1u << a)) != 0, ticksB = (boot.ticksMask & (1u << b)) != 0;
+                if (boot.osMs[a] != boot.osMs[b])
+                {
+                    return boot.osMs[a] < boot.osMs[b];
+                }
+                return (ticksA && ticksB) ? (boot.ticks[a] < boot.ticks[b]) : false;
+            });
+
+    printf ("%s boot, clock %u Hz\n", boot.fastBoot ? "fast" : "default", boot.clockHz);
+    printf ("%-12s %8s %10s\n", "phase", "ms", "step us");
+    int prev = -1;
+    for (uint32_t n = 0; n < count; n++)
+    {
+        uint32_t i = order[n];
+        printf ("%-12s %8u", glPhaseNames[i], boot.osMs[i]);
+        if ((prev >= 0) && (boot.clockHz != 0) && (boot.ticksMask & (1u << i)) &&
+                (boot.ticksMask & (1u << prev)))
+        {
+            printf (" %10.1f", 1e6 * (boot.ticks[i] - boot.ticks[prev]) / boot.clockHz);
+        }
+        printf ("\n");
+        prev = static_cast<int>(i);
+    }
+    for (uint32_t i = 0; i < CY_FX_UVC_BOOT_COUNT; i++)
+    {
+        if ((boot.reachedMask & (1u << i)) == 0)
+        {
+            printf ("%-12s %8s\n", glPhaseNames[i], "-");
+        }
+    }
+
+    if ((boot.reachedMask & (1u << CY_FX_UVC_BOOT_KERNEL)) && (boot.reachedMask & (1u << CY_FX_UVC_BOOT_CONNECT)))
+    {
+        printf ("kernel to connect: %u ms\n", boot.osMs[CY_FX_UVC_BOOT_CONNECT] - boot.osMs[CY_FX_UVC_BOOT_KERNEL]);
+    }
+    return 0;
+}
+
+/*[]*/
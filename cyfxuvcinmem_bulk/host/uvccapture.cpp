@@ -0,0 +1,624 @@
+/*
+ ## Capture readers for the UVC stream analyzer (uvccapture.cpp)
+ ## ===========================
+*/
+
+/* The input is read in 4 MB blocks into one buffer; a record is parsed in place once
+ * all of it is in the buffer, and the unread tail is moved to the front before the
+ * next block is read. Payloads are never copied on the way to the analyzer, except
+ * those of usbmon text, which are decoded from hex. */
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "uvccapture.h"
+
+constexpr size_t UVC_CAPTURE_BLOCK = 4u << 20;         // Read size
+
+constexpr uint32_t PCAP_MAGIC_US = 0xA1B2C3D4;         // pcap, microsecond timestamps
+constexpr uint32_t PCAP_MAGIC_NS = 0xA1B23C4D;         // pcap, nanosecond timestamps
+constexpr uint32_t PCAPNG_SHB = 0x0A0D0D0A;            // pcapng section header block
+constexpr uint32_t PCAPNG_BYTE_ORDER = 0x1A2B3C4D;
+constexpr uint32_t PCAPNG_IDB = 1;                     // Interface description block
+constexpr uint32_t PCAPNG_EPB = 6;                     // Enhanced packet block
+constexpr uint16_t PCAPNG_OPT_TSRESOL = 9;             // if_tsresol option of the IDB
+
+constexpr uint32_t LINKTYPE_USB_LINUX = 189;           // usbmon header of 48 bytes
+constexpr uint32_t LINKTYPE_USB_LINUX_MMAPPED = 220;   // usbmon header of 64 bytes
+
+constexpr uint8_t USBMON_COMPLETE = 'C';
+constexpr uint8_t USBMON_XFER_BULK = 3;
+constexpr uint8_t USBMON_DIR_IN = 0x80;
+
+/* Fields of struct usbmon_packet (Documentation/usb/usbmon.rst). */
+constexpr size_t USBMON_TYPE = 8;
+constexpr size_t USBMON_XFER_TYPE = 9;
+constexpr size_t USBMON_EPNUM = 10;
+constexpr size_t USBMON_DEVNUM = 11;
+constexpr size_t USBMON_BUSNUM = 12;
+constexpr size_t USBMON_FLAG_DATA = 15;
+constexpr size_t USBMON_TS_SEC = 16;
+constexpr size_t USBMON_TS_USEC = 24;
+constexpr size_t USBMON_STATUS = 28;
+constexpr size_t USBMON_LENGTH = 32;
+constexpr size_t USBMON_LEN_CAP = 36;
+
+static uint16_t
+Get16 (
+        const UvcCapture *cap_p,
+        const uint8_t *p)
+{
+    uint16_t v;
+    memcpy (&v, p, sizeof (v));
+    return cap_p->swapped ? __builtin_bswap16 (v) : v;
+}
+
+static uint32_t
+Get32 (
+        const UvcCapture *cap_p,
+        const uint8_t *p)
+{
+    uint32_t v;
+    memcpy (&v, p, sizeof (v));
+    return cap_p->swapped ? __builtin_bswap32 (v) : v;
+}
+
+static uint64_t
+Get64 (
+        const UvcCapture *cap_p,
+        const uint8_t *p)
+{
+    uint64_t v;
+    memcpy (&v, p, sizeof (v));
+    return cap_p->swapped ? __builtin_bswap64 (v) : v;
+}
+
+/* Make n unread bytes available. Returns false at the end of the input or on an error
+   (eof set either way; errno kept for the error). */
+static bool
+Ensure (
+        UvcCapture *cap_p,
+        size_t n)
+{
+    while (cap_p->end - cap_p->start < n)
+    {
+        if (cap_p->eof)
+        {
+            return false;
+        }
+
+        size_t unread = cap_p->end - cap_p->start;
+        if (cap_p->start != 0)
+        {
+            memmove (cap_p->buffer.data (), cap_p->buffer.data () + cap_p->start, unread);
+            cap_p->start = 0;
+            cap_p->end = unread;
+        }
+        if (cap_p->buffer.size () < n + UVC_CAPTURE_BLOCK)
+        {
+            cap_p->buffer.resize (n + UVC_CAPTURE_BLOCK);
+        }
+
+        ssize_t got = read (cap_p->fd, cap_p->buffer.data () + cap_p->end, cap_p->buffer.size () - cap_p->end);
+        if (got < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf (stderr, "read: %s\n", strerror (errno));
+            cap_p->eof = true;
+            return false;
+        }
+        cap_p->eof = (got == 0);
+        cap_p->end += static_cast<size_t>(got);
+        cap_p->bytesRead += static_cast<uint64_t>(got);
+    }
+    return true;
+}
+
+/* Whether data looks like the start of a UVC payload: the usbmon endpoint search. */
+static bool
+LooksLikeUvc (
+        const uint8_t *data,
+        uint32_t captured,
+        uint32_t length)
+{
+    return (captured >= 2) && (data[0] >= 2) && (data[0] <= length) && ((data[1] & 0x80) != 0);
+}
+
+/* Take a usbmon completion if it is on the endpoint followed. Returns 1 with a payload,
+   2 for an error completion, 0 to skip it. */
+static int
+UsbmonEvent (
+        UvcCapture *cap_p,
+        uint8_t type,
+        uint8_t xferType,
+        uint8_t epnum,
+        int device,
+        int bus,
+        int32_t status,
+        uint64_t ns,
+        const uint8_t *data,
+        uint32_t captured,
+        uint32_t length,
+        UvcPayload *payload_p)
+{
+    UvcCaptureFilter &filter = cap_p->filter;
+    int endpoint = epnum & 0x7F;
+
+    if ((type != USBMON_COMPLETE) || (xferType != USBMON_XFER_BULK) || ((epnum & USBMON_DIR_IN) == 0))
+    {
+        return 0;
+    }
+    if (((filter.bus >= 0) && (filter.bus != bus)) || ((filter.device >= 0) && (filter.device != device)) ||
+            ((filter.endpoint >= 0) && (filter.endpoint != endpoint)))
+    {
+        return 0;
+    }
+
+    if (!cap_p->locked)
+    {
+        if ((status != 0) || !LooksLikeUvc (data, captured, length))
+        {
+            return 0;
+        }
+        filter.bus = bus;
+        filter.device = device;
+        filter.endpoint = endpoint;
+        cap_p->locked = true;
+        fprintf (stderr, "following bus %d device %d endpoint %d IN\n", bus, device, endpoint);
+    }
+
+    if (status != 0)
+    {
+        cap_p->urbErrors++;
+        cap_p->lastErrorNs = ns;
+        return 2;
+    }
+
+    payload_p->data = data;
+    payload_p->length = length;
+    payload_p->captured = (captured < length) ? captured : length;
+    payload_p->ns = ns;
+    return 1;
+}
+
+/* A usbmon binary record of caplen bytes at p. */
+static int
+UsbmonPacket (
+        UvcCapture *cap_p,
+        uint32_t linkType,
+        const uint8_t *p,
+        uint32_t caplen,
+        UvcPayload *payload_p)
+{
+    uint32_t headerLen;
+
+    if (linkType == LINKTYPE_USB_LINUX)
+    {
+        headerLen = 48;
+    }
+    else if (linkType == LINKTYPE_USB_LINUX_MMAPPED)
+    {
+        headerLen = 64;
+    }
+    else
+    {
+        return 0;
+    }
+    if (caplen < headerLen)
+    {
+        return 0;
+    }
+
+    uint32_t captured = 0;
+    if (p[USBMON_FLAG_DATA] == 0)
+    {
+        captured = Get32 (cap_p, p + USBMON_LEN_CAP);
+        captured = (captured < caplen - headerLen) ? captured : (caplen - headerLen);
+    }
+    uint64_t ns = Get64 (cap_p, p + USBMON_TS_SEC) * 1000000000ull + Get32 (cap_p, p + USBMON_TS_USEC) * 1000ull;
+
+    return UsbmonEvent (cap_p, p[USBMON_TYPE], p[USBMON_XFER_TYPE], p[USBMON_EPNUM], p[USBMON_DEVNUM],
+            Get16 (cap_p, p + USBMON_BUSNUM), static_cast<int32_t>(Get32 (cap_p, p + USBMON_STATUS)), ns,
+            p + headerLen, captured, Get32 (cap_p, p + USBMON_LENGTH), payload_p);
+}
+
+static int
+NextRaw (
+        UvcCapture *cap_p,
+        UvcPayload *payload_p)
+{
+    if (!Ensure (cap_p, sizeof (UvcDumpRecord)))
+    {
+        return (cap_p->end == cap_p->start) ? 0 : -1;
+    }
+
+    UvcDumpRecord record;
+    memcpy (&record, cap_p->buffer.data () + cap_p->start, sizeof (record));
+    if (!Ensure (cap_p, sizeof (record) + record.length))
+    {
+        fprintf (stderr, "raw dump: last record truncated\n");
+        return -1;
+    }
+
+    payload_p->data = cap_p->buffer.data () + cap_p->start + sizeof (record);
+    payload_p->length = record.length;
+    payload_p->captured = record.length;
+    payload_p->ns = record.ns;
+    cap_p->start += sizeof (record) + record.length;
+    return 1;
+}
+
+static int
+NextPcap (
+        UvcCapture *cap_p,
+        UvcPayload *payload_p)
+{
+    for (;;)
+    {
+        if (!Ensure (cap_p, 16))
+        {
+            return (cap_p->end == cap_p->start) ? 0 : -1;
+        }
+
+        const uint8_t *rec = cap_p->buffer.data () + cap_p->start;
+        uint32_t caplen = Get32 (cap_p, rec + 8);
+        if (!Ensure (cap_p, 16 + static_cast<size_t>(caplen)))
+        {
+            fprintf (stderr, "pcap: last packet truncated\n");
+            return -1;
+        }
+
+        rec = cap_p->buffer.data () + cap_p->start;
+        cap_p->start += 16 + static_cast<size_t>(caplen);
+        int taken = UsbmonPacket (cap_p, cap_p->linkType, rec + 16, caplen, payload_p);
+        if (taken != 0)
+        {
+            return taken;
+        }
+    }
+}
+
+/* An interface description block: its link type and timestamp resolution. */
+static void
+PcapngInterface (
+        UvcCapture *cap_p,
+        const uint8_t *body,
+        size_t bodyLen)
+{
+    uint64_t tsPerSec = 1000000;
+
+    if (bodyLen >= 8)
+    {
+        for (size_t pos = 8; pos + 4 <= bodyLen; )
+        {
+            uint16_t code = Get16 (cap_p, body + pos);
+            uint16_t len = Get16 (cap_p, body + pos + 2);
+            if ((code == 0) || (pos + 4 + len > bodyLen))
+            {
+                break;
+            }
+            if ((code == PCAPNG_OPT_TSRESOL) && (len >= 1))
+            {
+                uint8_t res = body[pos + 4];
+                uint64_t base = (res & 0x80) ? 2 : 10;
+                tsPerSec = 1;
+                for (unsigned i = 0; i < (res & 0x7Fu) && (tsPerSec < 1000000000000ull); i++)
+                {
+                    tsPerSec *= base;
+                }
+            }
+            pos += 4 + ((len + 3u) & ~3u);
+        }
+    }
+    cap_p->ifLinkType.push_back ((bodyLen >= 2) ? Get16 (cap_p, body) : 0);
+    cap_p->ifTsPerSec.push_back (tsPerSec);
+}
+
+static int
+NextPcapng (
+        UvcCapture *cap_p,
+        UvcPayload *payload_p)
+{
+    for (;;)
+    {
+        if (!Ensure (cap_p, 12))
+        {
+            return (cap_p->end == cap_p->start) ? 0 : -1;
+        }
+
+        const uint8_t *block = cap_p->buffer.data () + cap_p->start;
+        uint32_t type;
+        memcpy (&type, block, sizeof (type));
+        if (type == PCAPNG_SHB)
+        {
+            /* A new section may change the byte order; its interfaces are numbered afresh. */
+            uint32_t order;
+            memcpy (&order, block + 8, sizeof (order));
+            cap_p->swapped = (order != PCAPNG_BYTE_ORDER);
+            cap_p->ifLinkType.clear ();
+            cap_p->ifTsPerSec.clear ();
+        }
+        else
+        {
+            type = Get32 (cap_p, block);
+        }
+
+        uint32_t total = Get32 (cap_p, block + 4);
+        if ((total < 12) || !Ensure (cap_p, total))
+        {
+            fprintf (stderr, "pcapng: bad or truncated block\n");
+            return -1;
+        }
+
+        block = cap_p->buffer.data () + cap_p->start;
+        cap_p->start += total;
+        const uint8_t *body = block + 8;
+        size_t bodyLen = total - 12;
+
+        if (type == PCAPNG_IDB)
+        {
+            PcapngInterface (cap_p, body, bodyLen);
+        }
+        else if ((type == PCAPNG_EPB) && (bodyLen >= 20))
+        {
+            uint32_t intf = Get32 (cap_p, body);
+            uint32_t caplen = Get32 (cap_p, body + 12);
+            if ((intf >= cap_p->ifLinkType.size ()) || (caplen > bodyLen - 20))
+            {
+                continue;
+            }
+            int taken = UsbmonPacket (cap_p, cap_p->ifLinkType[intf], body + 20, caplen, payload_p);
+            if (taken != 0)
+            {
+                return taken;
+            }
+        }
+    }
+}
+
+/* One line of usbmon text: "tag timestamp_us C Bi:bus:dev:ep status length = data...". */
+static int
+TextLine (
+        UvcCapture *cap_p,
+        char *line,
+        UvcPayload *payload_p)
+{
+    char *save = nullptr;
+    char *tag = strtok_r (line, " ", &save);
+    char *ts = strtok_r (nullptr, " ", &save);
+    char *event = strtok_r (nullptr, " ", &save);
+    char *addr = strtok_r (nullptr, " ", &save);
+    char *status = strtok_r (nullptr, " ", &save);
+    char *length = strtok_r (nullptr, " ", &save);
+    if ((tag == nullptr) || (length == nullptr) || (event[0] != USBMON_COMPLETE) || (event[1] != 0) ||
+            (strncmp (addr, "Bi:", 3) != 0))
+    {
+        return 0;
+    }
+
+    /* "Bi:bus:dev:ep" in the 1u format, "Bi:dev:ep" in the older 0u. */
+    int fields[3] = {-1, -1, -1};
+    int count = 0;
+    for (char *p = addr + 3; (p != nullptr) && (*p != 0) && (count < 3); count++)
+    {
+        fields[count] = static_cast<int>(strtol (p, &p, 10));
+        p = (*p == ':') ? (p + 1) : nullptr;
+    }
+    int bus = (count == 3) ? fields[0] : -1;
+    int device = (count == 3) ? fields[1] : fields[0];
+    int endpoint = (count == 3) ? fields[2] : fields[1];
+
+    cap_p->text.clear ();
+    char *dataTag = strtok_r (nullptr, " ", &save);
+    if ((dataTag != nullptr) && (strcmp (dataTag, "=") == 0))
+    {
+        for (char *word = strtok_r (nullptr, " ", &save); word != nullptr; word = strtok_r (nullptr, " ", &save))
+        {
+            for (size_t i = 0; isxdigit (static_cast<unsigned char>(word[i])) && isxdigit (static_cast<unsigned char>(word[i + 1])); i += 2)
+            {
+                char hex[3] = {word[i], word[i + 1], 0};
+                cap_p->text.push_back (static_cast<uint8_t>(strtoul (hex, nullptr, 16)));
+            }
+        }
+    }
+
+    uint64_t ns = strtoull (ts, nullptr, 10) * 1000ull;
+    return UsbmonEvent (cap_p, USBMON_COMPLETE, USBMON_XFER_BULK, static_cast<uint8_t>(USBMON_DIR_IN | endpoint),
+            device, (bus >= 0) ? bus : cap_p->filter.bus, static_cast<int32_t>(strtol (status, nullptr, 10)), ns,
+            cap_p->text.data (), static_cast<uint32_t>(cap_p->text.size ()),
+            static_cast<uint32_t>(strtoul (length, nullptr, 10)), payload_p);
+}
+
+static int
+NextText (
+        UvcCapture *cap_p,
+        UvcPayload *payload_p)
+{
+    for (;;)
+    {
+        size_t scanned = 0;
+        char *nl;
+        for (;;)
+        {
+            uint8_t *from = cap_p->buffer.data () + cap_p->start;
+            nl = static_cast<char *>(memchr (from + scanned, '\n', cap_p->end - cap_p->start - scanned));
+            if (nl != nullptr)
+            {
+                break;
+            }
+            scanned = cap_p->end - cap_p->start;
+            if (!Ensure (cap_p, scanned + 1))
+            {
+                return 0;
+            }
+        }
+
+        char *line = reinterpret_cast<char *>(cap_p->buffer.data () + cap_p->start);
+        *nl = 0;
+        cap_p->start += static_cast<size_t>(nl - line) + 1;
+        int taken = TextLine (cap_p, line, payload_p);
+        if (taken != 0)
+        {
+            return taken;
+        }
+    }
+}
+
+bool
+UvcCaptureOpen (
+        UvcCapture *cap_p,
+        const char *path,
+        UvcCaptureFormat format,
+        const UvcCaptureFilter &filter)
+{
+    *cap_p = UvcCapture {};
+    cap_p->filter = filter;
+    cap_p->locked = (filter.device >= 0) && (filter.endpoint >= 0);
+    cap_p->fd = (strcmp (path, "-") == 0) ? STDIN_FILENO : open (path, O_RDONLY);
+    if (cap_p->fd < 0)
+    {
+        fprintf (stderr, "%s: %s\n", path, strerror (errno));
+        return false;
+    }
+    if (cap_p->fd != STDIN_FILENO)
+    {
+        posix_fadvise (cap_p->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    uint32_t magic = 0;
+    if (Ensure (cap_p, 8))
+    {
+        memcpy (&magic, cap_p->buffer.data (), sizeof (magic));
+    }
+    if (format == UVC_CAPTURE_AUTO)
+    {
+        if ((cap_p->end >= 8) && (memcmp (cap_p->buffer.data (), UVC_DUMP_MAGIC, 8) == 0))
+        {
+            format = UVC_CAPTURE_RAW;
+        }
+        else if ((magic == PCAP_MAGIC_US) || (magic == PCAP_MAGIC_NS) || (magic == __builtin_bswap32 (PCAP_MAGIC_US)) ||
+                (magic == __builtin_bswap32 (PCAP_MAGIC_NS)) || (magic == PCAPNG_SHB))
+        {
+            format = UVC_CAPTURE_PCAP;
+        }
+        else
+        {
+            format = UVC_CAPTURE_USBMON_TEXT;
+        }
+    }
+    cap_p->format = format;
+
+    if (format == UVC_CAPTURE_RAW)
+    {
+        UvcDumpHeader header;
+        if (!Ensure (cap_p, sizeof (header)))
+        {
+            fprintf (stderr, "%s: not a raw dump\n", path);
+            return false;
+        }
+        memcpy (&header, cap_p->buffer.data (), sizeof (header));
+        if ((memcmp (header.magic, UVC_DUMP_MAGIC, sizeof (header.magic)) != 0) || (header.version != UVC_DUMP_VERSION) ||
+                (header.recordSize != sizeof (UvcDumpRecord)))
+        {
+            fprintf (stderr, "%s: not a raw dump of version %u\n", path, UVC_DUMP_VERSION);
+            return false;
+        }
+        cap_p->start = sizeof (header);
+    }
+    else if (format == UVC_CAPTURE_PCAP)
+    {
+        if (magic == PCAPNG_SHB)
+        {
+            cap_p->pcapng = true;
+            return true;
+        }
+        if (!Ensure (cap_p, 24))
+        {
+            fprintf (stderr, "%s: not a pcap file\n", path);
+            return false;
+        }
+        cap_p->swapped = (magic == __builtin_bswap32 (PCAP_MAGIC_US)) || (magic == __builtin_bswap32 (PCAP_MAGIC_NS));
+        cap_p->linkType = Get32 (cap_p, cap_p->buffer.data () + 20);
+        if ((cap_p->linkType != LINKTYPE_USB_LINUX) && (cap_p->linkType != LINKTYPE_USB_LINUX_MMAPPED))
+        {
+            fprintf (stderr, "%s: link type %u is not a usbmon capture\n", path, cap_p->linkType);
+            return false;
+        }
+        cap_p->start = 24;
+    }
+    return true;
+}
+
+int
+UvcCaptureNext (
+        UvcCapture *cap_p,
+        UvcPayload *payload_p)
+{
+    switch (cap_p->format)
+    {
+        case UVC_CAPTURE_RAW:
+            return NextRaw (cap_p, payload_p);
+        case UVC_CAPTURE_PCAP:
+            return cap_p->pcapng ? NextPcapng (cap_p, payload_p) : NextPcap (cap_p, payload_p);
+        case UVC_CAPTURE_USBMON_TEXT:
+            return NextText (cap_p, payload_p);
+        default:
+            return -1;
+    }
+}
+
+void
+UvcCaptureClose (
+        UvcCapture *cap_p)
+{
+    if ((cap_p->fd >= 0) && (cap_p->fd != STDIN_FILENO))
+    {
+        close (cap_p->fd);
+    }
+    cap_p->fd = -1;
+}
+
+FILE *
+UvcDumpOpen (
+        const char *path)
+{
+    FILE *file_p = fopen (path, "wb");
+    if (file_p == nullptr)
+    {
+        fprintf (stderr, "%s: %s\n", path, strerror (errno));
+        return nullptr;
+    }
+    setvbuf (file_p, nullptr, _IOFBF, UVC_CAPTURE_BLOCK);
+
+    UvcDumpHeader header {};
+    memcpy (header.magic, UVC_DUMP_MAGIC, sizeof (header.magic));
+    header.version = UVC_DUMP_VERSION;
+    header.recordSize = sizeof (UvcDumpRecord);
+    if (fwrite (&header, sizeof (header), 1, file_p) != 1)
+    {
+        fprintf (stderr, "%s: %s\n", path, strerror (errno));
+        fclose (file_p);
+        return nullptr;
+    }
+    return file_p;
+}
+
+bool
+UvcDumpWrite (
+        FILE *file_p,
+        const uint8_t *data,
+        uint32_t length,
+        uint64_t ns)
+{
+    UvcDumpRecord record {ns, length, 0};
+    return (fwrite (&record, sizeof (record), 1, file_p) == 1) && (fwrite (data, 1, length, file_p) == length);
+}
+
+/*[]*/
@@ -0,0 +1,126 @@
+/*
+ ## Capture readers for the UVC stream analyzer (uvccapture.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_UVCCAPTURE_H_
+#define _INCLUDED_UVCCAPTURE_H_
+
+/* Reads the bulk payloads of a capture file or pipe, one UvcPayload per transfer:
+ *
+ *  - raw dumps: the payload records written by UvcDumpWrite (uvcprof -w), a file header
+ *    followed by one UvcDumpRecord and the payload bytes per transfer;
+ *  - usbmon binary captures saved as pcap or pcapng (tcpdump -i usbmonN, Wireshark),
+ *    link types LINUX_USB and LINUX_USB_MMAPPED;
+ *  - usbmon text (cat /sys/kernel/debug/usb/usbmon/Nu), which keeps only the first
+ *    32 bytes of each transfer: headers are checked, frame contents are not.
+ *
+ * From usbmon captures the completed bulk IN transfers of one endpoint are taken. The
+ * endpoint is given, or is the first bulk IN endpoint whose data starts with a UVC
+ * payload header. The input is read in large blocks and payloads are handed out in place
+ * when they are contiguous in the read buffer. */
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "uvcstream.h"
+
+constexpr char UVC_DUMP_MAGIC[8] = {'U', 'V', 'C', 'D', 'U', 'M', 'P', 0};
+constexpr uint32_t UVC_DUMP_VERSION = 1;
+
+/* Raw dump layout, little endian. */
+struct UvcDumpHeader
+{
+    char magic[8];                      // UVC_DUMP_MAGIC
+    uint32_t version;                   // UVC_DUMP_VERSION
+    uint32_t recordSize;                // sizeof (UvcDumpRecord)
+};
+
+struct UvcDumpRecord
+{
+    uint64_t ns;                        // Time the transfer completed
+    uint32_t length;                    // Payload bytes that follow
+    uint32_t reserved;
+};
+
+static_assert ((sizeof (UvcDumpHeader) == 16) && (sizeof (UvcDumpRecord) == 16), "dump layout changed");
+
+enum UvcCaptureFormat
+{
+    UVC_CAPTURE_AUTO = 0,               /* From the first bytes. */
+    UVC_CAPTURE_RAW,
+    UVC_CAPTURE_PCAP,                   /* pcap or pcapng. */
+    UVC_CAPTURE_USBMON_TEXT
+};
+
+/* Which transfers of a usbmon capture to take; -1 matches any. */
+struct UvcCaptureFilter
+{
+    int bus = -1;
+    int device = -1;
+    int endpoint = -1;                  // Endpoint number, without the direction bit
+};
+
+struct UvcCapture
+{
+    int fd = -1;
+    UvcCaptureFormat format = UVC_CAPTURE_AUTO;
+    UvcCaptureFilter filter;
+    bool locked = false;                // filter is complete: found or given
+    std::vector<uint8_t> buffer;
+    size_t start = 0;                   // Unread bytes are buffer[start, end)
+    size_t end = 0;
+    bool eof = false;
+    uint64_t bytesRead = 0;
+    std::vector<uint8_t> text;          // Decoded data of a usbmon text line
+
+    /* pcap / pcapng state */
+    bool swapped = false;               // File written on a machine of the other byte order
+    bool pcapng = false;
+    uint32_t linkType = 0;
+    uint32_t tsDivisor = 1000;          // Timestamp units per ns divisor (pcap) or units per second (pcapng)
+    std::vector<uint32_t> ifLinkType;   // pcapng interfaces
+    std::vector<uint64_t> ifTsPerSec;
+
+    uint64_t urbErrors = 0;             // Completions with an error status: reported, not handed out
+    uint64_t lastErrorNs = 0;
+};
+
+/* Open a capture; path "-" reads standard input. Returns false after printing the
+   reason. */
+bool
+UvcCaptureOpen (
+        UvcCapture *cap_p,
+        const char *path,
+        UvcCaptureFormat format,
+        const UvcCaptureFilter &filter);
+
+/* Next payload; valid until the next call. Returns 1 with a payload, 0 at the end of the
+   capture, 2 after a completion with an error status (urbErrors counts it, lastErrorNs
+   is its time) and -1 on a read or format error, printed. */
+int
+UvcCaptureNext (
+        UvcCapture *cap_p,
+        UvcPayload *payload_p);
+
+void
+UvcCaptureClose (
+        UvcCapture *cap_p);
+
+/* Start a raw dump. Returns nullptr after printing the reason. */
+FILE *
+UvcDumpOpen (
+        const char *path);
+
+/* Append a payload to a raw dump. */
+bool
+UvcDumpWrite (
+        FILE *file_p,
+        const uint8_t *data,
+        uint32_t length,
+        uint64_t ns);
+
+#endif /* _INCLUDED_UVCCAPTURE_H_ */
+
+/*[]*/
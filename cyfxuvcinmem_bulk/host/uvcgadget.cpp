@@ -0,0 +1,712 @@
+/*
+ ## USB gadget bridge for the UVC bulk streamer (uvcgadget.cpp)
+ ## ===========================
+*/
+
+/* Runs the streamer (the firmware sources on the simulated SDK layer, fx3host.cpp) as
+ * a real USB device of the local machine, so that the uvcvideo driver enumerates it,
+ * runs probe / commit and streams from it like from an FX3:
+ *
+ *     modprobe dummy_hcd is_super_speed=1      (loopback UDC and HCD)
+ *     modprobe raw_gadget
+ *     uvcgadget &                              (as root)
+ *     v4l2-ctl -d /dev/videoN --stream-mmap --stream-count=1000
+ *
+ * The bridge plays the part of the FX3 USB driver with fast enumeration on a Raw Gadget
+ * instance (/dev/raw-gadget, the gadget-side equivalent of usbdevfs):
+ *   - GET_DESCRIPTOR is answered from the descriptors registered with CyU3PUsbSetDesc,
+ *     the SuperSpeed or high speed set according to the speed of the bus;
+ *   - every other control request goes to the setup callback first, and the requests
+ *     it does not handle get the driver's default answer;
+ *   - SET_CONFIGURATION and SET_INTERFACE enable the endpoints and raise the SETCONF /
+ *     SETINTF events; bus reset, disconnect, suspend and resume raise their events;
+ *   - a pump thread writes the buffers committed on the MANUAL_OUT channel to the bulk
+ *     IN endpoint, one transfer each, and hands a buffer back once the host has read
+ *     it, so the DMA ring sees the host's flow control as on the device. A short
+ *     buffer ends with a zero-length packet if needed, as the FX3 socket does.
+ * The endpoints of the UDC are fixed by its driver (dummy_udc has ep1in-bulk,
+ * ep5in-int, ...); endpoints of the descriptors the UDC does not have at their number
+ * are moved to a free one of the same type and direction, in the descriptors given to
+ * the host and in the wIndex of requests passed to the firmware.
+ *
+ * FunctionFS was the other candidate, but it takes no class-specific interface
+ * descriptors besides HID and CCID, and the UVC descriptors are mostly that. */
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/raw_gadget.h>
+#include <linux/usb/video.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "cyfxuvcinmem.h"
+#include "fx3host.h"
+
+constexpr unsigned CY_FX_GADGET_EP0_MAX = 4096;        // Largest control data stage handled
+constexpr uint8_t CY_FX_GADGET_NO_EP = 0;              // Endpoint map: not mapped
+
+/* Raw Gadget bus events of Linux 6.4 and later; older UAPI headers only have CONNECT
+   and CONTROL, and older kernels never report these. */
+constexpr uint32_t CY_FX_GADGET_EVENT_SUSPEND = 3;
+constexpr uint32_t CY_FX_GADGET_EVENT_RESUME = 4;
+constexpr uint32_t CY_FX_GADGET_EVENT_RESET = 5;
+constexpr uint32_t CY_FX_GADGET_EVENT_DISCONNECT = 6;
+
+/* Maps from endpoint address (number, plus 16 for IN) to endpoint address / handle. */
+static int
+EpIndex (
+        uint8_t addr)
+{
+    return (addr & USB_ENDPOINT_NUMBER_MASK) | (((addr & USB_DIR_IN) != 0) ? 16 : 0);
+}
+
+struct GadgetState
+{
+    int fd = -1;
+    bool verbose = false;
+    CyU3PUSBSpeed_t speed = CY_U3P_SUPER_SPEED;
+    const char *device = "dummy_udc.0";
+
+    usb_raw_eps_info eps {};
+    int epCount = 0;
+    uint8_t toGadget[32] = {};          // Firmware endpoint address to UDC address
+    uint8_t toFirmware[32] = {};        // And back
+    std::vector<uint8_t> config;        // Configuration descriptor given to the host
+
+    uint8_t configuration = 0;
+    std::vector<int> handles;           // Enabled endpoints
+    int videoHandle = -1;               // The bulk IN endpoint the pump writes
+
+    std::thread pump;
+    std::atomic<bool> pumpRun {false};
+    std::atomic<bool> pumpDone {true};
+    std::atomic<uint64_t> pumpBytes {0};
+};
+static GadgetState glGadget;
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d driver] [-D device] [-H] [-r seconds] [-v]\n"
+            "  -d  UDC driver (default dummy_udc)\n"
+            "  -D  UDC device (default dummy_udc.0)\n"
+            "  -H  connect at high speed, not super speed\n"
+            "  -r  print the streaming rate every this many seconds (default 0, off)\n"
+            "  -v  echo firmware debug output and the control requests\n",
+            prog);
+}
+
+static void
+WakeSignal (
+        int)
+{
+}
+
+/* Config descriptor of the speed of the bus, as the firmware registered it. */
+static const uint8_t *
+FirmwareConfig (
+        void)
+{
+    return FxHostDescriptor ((glGadget.speed == CY_U3P_SUPER_SPEED) ? CY_U3P_USB_SET_SS_CONFIG_DESCR :
+            (glGadget.speed == CY_U3P_HIGH_SPEED) ? CY_U3P_USB_SET_HS_CONFIG_DESCR : CY_U3P_USB_SET_FS_CONFIG_DESCR, 0);
+}
+
+static uint16_t
+TotalLength (
+        const uint8_t *desc)
+{
+    return static_cast<uint16_t>(desc[2] | (desc[3] << 8));
+}
+
+/* Bus speed from the UDC, once connected. */
+static CyU3PUSBSpeed_t
+ReadSpeed (
+        void)
+{
+    char path[256], speed[32] = {};
+    snprintf (path, sizeof (path), "/sys/class/udc/%s/current_speed", glGadget.device);
+
+    FILE *file_p = fopen (path, "r");
+    if (file_p != nullptr)
+    {
+        if (fgets (speed, sizeof (speed), file_p) == nullptr)
+        {
+            speed[0] = 0;
+        }
+        fclose (file_p);
+    }
+    if (strncmp (speed, "super-speed", 11) == 0)
+    {
+        return CY_U3P_SUPER_SPEED;
+    }
+    return (strncmp (speed, "full-speed", 10) == 0) ? CY_U3P_FULL_SPEED : CY_U3P_HIGH_SPEED;
+}
+
+/* Give each endpoint of the configuration a UDC endpoint, at the same number when the
+   UDC has one of the right type and direction there, and copy the configuration with
+   the addresses changed accordingly. */
+static bool
+MapEndpoints (
+        void)
+{
+    const uint8_t *fw = FirmwareConfig ();
+    if (fw == nullptr)
+    {
+        fprintf (stderr, "no configuration descriptor registered for this speed\n");
+        return false;
+    }
+
+    glGadget.config.assign (fw, fw + TotalLength (fw));
+    memset (glGadget.toGadget, CY_FX_GADGET_NO_EP, sizeof (glGadget.toGadget));
+    memset (glGadget.toFirmware, CY_FX_GADGET_NO_EP, sizeof (glGadget.toFirmware));
+
+    std::vector<bool> used (static_cast<size_t>(glGadget.epCount), false);
+    auto fits = [] (const usb_raw_ep_info &info, uint8_t addr, uint8_t type) {
+        bool in = (addr & USB_DIR_IN) != 0;
+        bool typeOk = (type == USB_ENDPOINT_XFER_BULK) ? info.caps.type_bulk :
+                (type == USB_ENDPOINT_XFER_INT) ? info.caps.type_int :
+                (type == USB_ENDPOINT_XFER_ISOC) ? info.caps.type_iso : false;
+        return typeOk && (in ? info.caps.dir_in : info.caps.dir_out);
+    };
+
+    uint8_t *p = glGadget.config.data ();
+    uint8_t *end = p + glGadget.config.size ();
+    for (; (p + 2 <= end) && (p[0] >= 2) && (p + p[0] <= end); p += p[0])
+    {
+        if ((p[1] != USB_DT_ENDPOINT) || (p[0] < USB_DT_ENDPOINT_SIZE))
+        {
+            continue;
+        }
+
+        uint8_t addr = p[2];
+        uint8_t type = p[3] & USB_ENDPOINT_XFERTYPE_MASK;
+        int chosen = -1;
+        for (int pass = 0; (pass < 2) && (chosen < 0); pass++)
+        {
+            for (int i = 0; i < glGadget.epCount; i++)
+            {
+                const usb_raw_ep_info &info = glGadget.eps.eps[i];
+                bool numberOk = (pass == 0) ? (info.addr == (addr & USB_ENDPOINT_NUMBER_MASK)) || (info.addr == USB_RAW_EP_ADDR_ANY) : true;
+                if (!used[static_cast<size_t>(i)] && numberOk && fits (info, addr, type))
+                {
+                    chosen = i;
+                    break;
+                }
+            }
+        }
+        if (chosen < 0)
+        {
+            fprintf (stderr, "the UDC has no endpoint for 0x%02x\n", addr);
+            return false;
+        }
+
+        used[static_cast<size_t>(chosen)] = true;
+        uint32_t number = glGadget.eps.eps[chosen].addr;
+        uint8_t mapped = static_cast<uint8_t>((addr & USB_DIR_IN) |
+                ((number == USB_RAW_EP_ADDR_ANY) ? (addr & USB_ENDPOINT_NUMBER_MASK) : number));
+        glGadget.toGadget[EpIndex (addr)] = mapped;
+        glGadget.toFirmware[EpIndex (mapped)] = addr;
+        if (mapped != addr)
+        {
+            fprintf (stderr, "endpoint 0x%02x is 0x%02x (%s) on the UDC\n", addr, mapped,
+                    reinterpret_cast<const char *>(glGadget.eps.eps[chosen].name));
+        }
+    }
+
+    /* Endpoint descriptors, and the video endpoint named in the VS input header. */
+    bool videoStreaming = false;
+    for (p = glGadget.config.data (); (p + 2 <= end) && (p[0] >= 2) && (p + p[0] <= end); p += p[0])
+    {
+        if ((p[1] == USB_DT_INTERFACE) && (p[0] >= USB_DT_INTERFACE_SIZE))
+        {
+            videoStreaming = (p[5] == USB_CLASS_VIDEO) && (p[6] == UVC_SC_VIDEOSTREAMING);
+        }
+        else if ((p[1] == USB_DT_ENDPOINT) && (p[0] >= USB_DT_ENDPOINT_SIZE))
+        {
+            p[2] = glGadget.toGadget[EpIndex (p[2])];
+        }
+        else if (videoStreaming && (p[1] == USB_DT_CS_INTERFACE) && (p[0] > 6) && (p[2] == UVC_VS_INPUT_HEADER) &&
+                (glGadget.toGadget[EpIndex (p[6])] != CY_FX_GADGET_NO_EP))
+        {
+            p[6] = glGadget.toGadget[EpIndex (p[6])];
+        }
+    }
+    return true;
+}
+
+/* Write the committed buffers to the video endpoint until stopped. */
+static void
+PumpThread (
+        void)
+{
+    std::vector<uint8_t> io (sizeof (usb_raw_ep_io));
+    FxHostBuffer buf;
+
+    while (glGadget.pumpRun)
+    {
+        if (!FxHostBulkRead (&buf, 100))
+        {
+            continue;
+        }
+
+        if (io.size () < sizeof (usb_raw_ep_io) + buf.count)
+        {
+            io.resize (sizeof (usb_raw_ep_io) + buf.count);
+        }
+        usb_raw_ep_io *io_p = reinterpret_cast<usb_raw_ep_io *>(io.data ());
+        io_p->ep = static_cast<uint16_t>(glGadget.videoHandle);
+        io_p->flags = (buf.count < buf.size) ? USB_RAW_IO_FLAGS_ZERO : 0;
+        io_p->length = buf.count;
+        memcpy (io.data () + sizeof (usb_raw_ep_io), buf.data, buf.count);
+
+        /* Blocks until the host has read the transfer; a stop interrupts it. */
+        int rv = ioctl (glGadget.fd, USB_RAW_IOCTL_EP_WRITE, io_p);
+        FxHostBulkRelease ();
+        if (rv >= 0)
+        {
+            glGadget.pumpBytes += static_cast<uint64_t>(rv);
+        }
+        else if (errno != EINTR)
+        {
+            if (glGadget.verbose)
+            {
+                fprintf (stderr, "EP_WRITE: %s\n", strerror (errno));
+            }
+            std::this_thread::sleep_for (std::chrono::milliseconds (10));
+        }
+    }
+    glGadget.pumpDone = true;
+}
+
+static void
+PumpStart (
+        void)
+{
+    if ((glGadget.videoHandle < 0) || glGadget.pump.joinable ())
+    {
+        return;
+    }
+    glGadget.pumpRun = true;
+    glGadget.pumpDone = false;
+    glGadget.pump = std::thread (PumpThread);
+}
+
+static void
+PumpStop (
+        void)
+{
+    if (!glGadget.pump.joinable ())
+    {
+        return;
+    }
+
+    /* The signal interrupts a blocked EP_WRITE; repeated in case it came just before. */
+    glGadget.pumpRun = false;
+    while (!glGadget.pumpDone)
+    {
+        pthread_kill (glGadget.pump.native_handle (), SIGUSR1);
+        std::this_thread::sleep_for (std::chrono::milliseconds (5));
+    }
+    glGadget.pump.join ();
+}
+
+static void
+DisableEndpoints (
+        void)
+{
+    PumpStop ();
+    for (int handle : glGadget.handles)
+    {
+        uint32_t h = static_cast<uint32_t>(handle);
+        ioctl (glGadget.fd, USB_RAW_IOCTL_EP_DISABLE, h);
+    }
+    glGadget.handles.clear ();
+    glGadget.videoHandle = -1;
+}
+
+/* Enable the endpoints of the configuration given to the host. */
+static bool
+EnableEndpoints (
+        void)
+{
+    const uint8_t *p = glGadget.config.data ();
+    const uint8_t *end = p + glGadget.config.size ();
+
+    for (; (p + 2 <= end) && (p[0] >= 2) && (p + p[0] <= end); p += p[0])
+    {
+        if ((p[1] != USB_DT_ENDPOINT) || (p[0] < USB_DT_ENDPOINT_SIZE))
+        {
+            continue;
+        }
+
+        usb_endpoint_descriptor desc {};
+        memcpy (&desc, p, USB_DT_ENDPOINT_SIZE);
+        int handle = ioctl (glGadget.fd, USB_RAW_IOCTL_EP_ENABLE, &desc);
+        if (handle < 0)
+        {
+            fprintf (stderr, "EP_ENABLE 0x%02x: %s\n", desc.bEndpointAddress, strerror (errno));
+            return false;
+        }
+        glGadget.handles.push_back (handle);
+        if (glGadget.toFirmware[EpIndex (desc.bEndpointAddress)] == CY_FX_EP_BULK_VIDEO)
+        {
+            glGadget.videoHandle = handle;
+        }
+    }
+    return true;
+}
+
+static void
+Ep0Write (
+        const void *data_p,
+        uint32_t length)
+{
+    std::vector<uint8_t> io (sizeof (usb_raw_ep_io) + length);
+    usb_raw_ep_io *io_p = reinterpret_cast<usb_raw_ep_io *>(io.data ());
+    io_p->ep = 0;
+    io_p->flags = 0;
+    io_p->length = length;
+    memcpy (io.data () + sizeof (usb_raw_ep_io), data_p, length);
+    if (ioctl (glGadget.fd, USB_RAW_IOCTL_EP0_WRITE, io_p) < 0)
+    {
+        fprintf (stderr, "EP0_WRITE: %s\n", strerror (errno));
+    }
+}
+
+/* Data stage of an OUT request, or the status stage of a request without data. */
+static int
+Ep0Read (
+        void *data_p,
+        uint32_t length)
+{
+    std::vector<uint8_t> io (sizeof (usb_raw_ep_io) + length);
+    usb_raw_ep_io *io_p = reinterpret_cast<usb_raw_ep_io *>(io.data ());
+    io_p->ep = 0;
+    io_p->flags = 0;
+    io_p->length = length;
+    int rv = ioctl (glGadget.fd, USB_RAW_IOCTL_EP0_READ, io_p);
+    if (rv < 0)
+    {
+        fprintf (stderr, "EP0_READ: %s\n", strerror (errno));
+        return -1;
+    }
+    memcpy (data_p, io.data () + sizeof (usb_raw_ep_io), static_cast<size_t>(rv));
+    return rv;
+}
+
+static void
+Ep0Stall (
+        void)
+{
+    ioctl (glGadget.fd, USB_RAW_IOCTL_EP0_STALL, 0);
+}
+
+/* GET_DESCRIPTOR: returns the descriptor and its length, or nullptr. */
+static const uint8_t *
+Descriptor (
+        uint8_t type,
+        uint8_t index,
+        uint32_t *length_p)
+{
+    const uint8_t *desc = nullptr;
+
+    switch (type)
+    {
+        case USB_DT_DEVICE:
+            desc = FxHostDescriptor ((glGadget.speed == CY_U3P_SUPER_SPEED) ? CY_U3P_USB_SET_SS_DEVICE_DESCR :
+                    CY_U3P_USB_SET_HS_DEVICE_DESCR, 0);
+            break;
+        case USB_DT_CONFIG:
+            if (index == 0)
+            {
+                *length_p = static_cast<uint32_t>(glGadget.config.size ());
+                return glGadget.config.data ();
+            }
+            break;
+        case USB_DT_BOS:
+            desc = FxHostDescriptor (CY_U3P_USB_SET_SS_BOS_DESCR, 0);
+            if (desc != nullptr)
+            {
+                *length_p = TotalLength (desc);
+                return desc;
+            }
+            break;
+        case USB_DT_DEVICE_QUALIFIER:
+            desc = FxHostDescriptor (CY_U3P_USB_SET_DEVQUAL_DESCR, 0);
+            break;
+        case USB_DT_STRING:
+            desc = FxHostDescriptor (CY_U3P_USB_SET_STRING_DESCR, index);
+            break;
+        default:
+            break;
+    }
+
+    if (desc != nullptr)
+    {
+        *length_p = desc[0];
+    }
+    return desc;
+}
+
+static void
+Control (
+        const usb_ctrlrequest &ctrl)
+{
+    static uint8_t data[CY_FX_GADGET_EP0_MAX];
+    uint16_t wValue = ctrl.wValue, wIndex = ctrl.wIndex, wLength = ctrl.wLength;
+    bool in = (ctrl.bRequestType & USB_DIR_IN) != 0;
+    bool standard = (ctrl.bRequestType & USB_TYPE_MASK) == USB_TYPE_STANDARD;
+    uint8_t recipient = ctrl.bRequestType & USB_RECIP_MASK;
+
+    if (glGadget.verbose)
+    {
+        fprintf (stderr, "setup %02x %02x %04x %04x %04x\n", ctrl.bRequestType, ctrl.bRequest, wValue, wIndex, wLength);
+    }
+    if (wLength > sizeof (data))
+    {
+        Ep0Stall ();
+        return;
+    }
+
+    if (standard && (ctrl.bRequest == USB_REQ_GET_DESCRIPTOR))
+    {
+        uint32_t length = 0;
+        const uint8_t *desc = Descriptor (static_cast<uint8_t>(wValue >> 8), static_cast<uint8_t>(wValue), &length);
+        if (desc == nullptr)
+        {
+            Ep0Stall ();
+            return;
+        }
+        Ep0Write (desc, (length < wLength) ? length : wLength);
+        return;
+    }
+
+    if (standard && (ctrl.bRequest == USB_REQ_SET_CONFIGURATION))
+    {
+        uint8_t value = static_cast<uint8_t>(wValue);
+        DisableEndpoints ();
+        if ((value != 0) && !EnableEndpoints ())
+        {
+            DisableEndpoints ();
+            Ep0Stall ();
+            return;
+        }
+        if (value != 0)
+        {
+            /* bMaxPower is in 8 mA units at super speed, 2 mA otherwise. */
+            uint32_t mA = glGadget.config[8] * ((glGadget.speed == CY_U3P_SUPER_SPEED) ? 8u : 2u);
+            ioctl (glGadget.fd, USB_RAW_IOCTL_VBUS_DRAW, mA);
+            ioctl (glGadget.fd, USB_RAW_IOCTL_CONFIGURE, 0);
+        }
+        glGadget.configuration = value;
+        Ep0Read (data, 0);
+        FxHostUsbEvent (CY_U3P_USB_EVENT_SETCONF, value);
+        PumpStart ();
+        return;
+    }
+
+    /* The setup callback sees the rest first; endpoint numbers are the firmware's. */
+    uint16_t fwIndex = wIndex;
+    if (recipient == USB_RECIP_ENDPOINT)
+    {
+        uint8_t fwAddr = glGadget.toFirmware[EpIndex (static_cast<uint8_t>(wIndex))];
+        fwIndex = static_cast<uint16_t>((wIndex & 0xFF00) | ((fwAddr != CY_FX_GADGET_NO_EP) ? fwAddr : (wIndex & 0xFF)));
+    }
+    if (!in && (wLength != 0) && (Ep0Read (data, wLength) < 0))
+    {
+        return;
+    }
+    int result = FxHostControl (ctrl.bRequestType, ctrl.bRequest, wValue, fwIndex, data, wLength);
+
+    if ((result < 0) && standard)
+    {
+        /* What the driver answers for the requests the firmware leaves to it. */
+        switch (ctrl.bRequest)
+        {
+            case USB_REQ_GET_STATUS:
+                memset (data, 0, 2);
+                result = 2;
+                break;
+            case USB_REQ_GET_CONFIGURATION:
+                data[0] = glGadget.configuration;
+                result = 1;
+                break;
+            case USB_REQ_GET_INTERFACE:
+                data[0] = 0;
+                result = 1;
+                break;
+            case USB_REQ_SET_INTERFACE:
+                Ep0Read (data, 0);
+                PumpStop ();
+                FxHostUsbEvent (CY_U3P_USB_EVENT_SETINTF, static_cast<uint16_t>(((wIndex & 0xFF) << 8) | (wValue & 0xFF)));
+                PumpStart ();
+                return;
+            case USB_REQ_SET_FEATURE:
+            case USB_REQ_CLEAR_FEATURE:
+            case USB_REQ_SET_SEL:
+            case USB_REQ_SET_ISOCH_DELAY:
+                result = 0;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (result < 0)
+    {
+        Ep0Stall ();
+    }
+    else if (in)
+    {
+        Ep0Write (data, static_cast<uint32_t>((result < wLength) ? result : wLength));
+    }
+    else if (wLength == 0)
+    {
+        Ep0Read (data, 0);
+    }
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    FxHostConfig cfg;
+    const char *driver = "dummy_udc";
+    double reportSec = 0;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:D:Hr:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': driver = optarg; break;
+            case 'D': glGadget.device = optarg; break;
+            case 'H': glGadget.speed = CY_U3P_HIGH_SPEED; break;
+            case 'r': reportSec = strtod (optarg, nullptr); break;
+            case 'v': glGadget.verbose = cfg.verbose = true; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    struct sigaction sa {};
+    sa.sa_handler = WakeSignal;
+    sigaction (SIGUSR1, &sa, nullptr);
+
+    cfg.speed = glGadget.speed;
+    if (!FxHostStart (cfg, 1000))
+    {
+        fprintf (stderr, "firmware did not connect\n");
+        return 1;
+    }
+
+    glGadget.fd = open ("/dev/raw-gadget", O_RDWR);
+    if (glGadget.fd < 0)
+    {
+        fprintf (stderr, "/dev/raw-gadget: %s (modprobe raw_gadget, run as root)\n", strerror (errno));
+        return 1;
+    }
+
+    usb_raw_init init {};
+    snprintf (reinterpret_cast<char *>(init.driver_name), sizeof (init.driver_name), "%s", driver);
+    snprintf (reinterpret_cast<char *>(init.device_name), sizeof (init.device_name), "%s", glGadget.device);
+    init.speed = (glGadget.speed == CY_U3P_SUPER_SPEED) ? USB_SPEED_SUPER : USB_SPEED_HIGH;
+    if ((ioctl (glGadget.fd, USB_RAW_IOCTL_INIT, &init) < 0) || (ioctl (glGadget.fd, USB_RAW_IOCTL_RUN, 0) < 0))
+    {
+        fprintf (stderr, "raw gadget on %s / %s: %s (modprobe dummy_hcd?)\n", driver, glGadget.device, strerror (errno));
+        return 1;
+    }
+
+    if (reportSec > 0)
+    {
+        std::thread ([reportSec] {
+            uint64_t last = 0;
+            for (;;)
+            {
+                std::this_thread::sleep_for (std::chrono::duration<double> (reportSec));
+                uint64_t bytes = glGadget.pumpBytes;
+                fprintf (stderr, "%.1f MB/s\n", (bytes - last) / reportSec / 1e6);
+                last = bytes;
+            }
+        }).detach ();
+    }
+
+    alignas (8) uint8_t eventBuf[sizeof (usb_raw_event) + sizeof (usb_ctrlrequest)];
+    usb_raw_event *event_p = reinterpret_cast<usb_raw_event *>(eventBuf);
+    for (;;)
+    {
+        event_p->type = USB_RAW_EVENT_INVALID;
+        event_p->length = sizeof (usb_ctrlrequest);
+        if (ioctl (glGadget.fd, USB_RAW_IOCTL_EVENT_FETCH, event_p) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf (stderr, "EVENT_FETCH: %s\n", strerror (errno));
+            break;
+        }
+
+        switch (event_p->type)
+        {
+            case USB_RAW_EVENT_CONNECT:
+                glGadget.speed = ReadSpeed ();
+                FxHostSetSpeed (glGadget.speed);
+                glGadget.epCount = ioctl (glGadget.fd, USB_RAW_IOCTL_EPS_INFO, &glGadget.eps);
+                if ((glGadget.epCount < 0) || !MapEndpoints ())
+                {
+                    fprintf (stderr, "cannot map the endpoints on %s\n", glGadget.device);
+                    return 1;
+                }
+                fprintf (stderr, "connected at %s speed\n", (glGadget.speed == CY_U3P_SUPER_SPEED) ? "super" :
+                        (glGadget.speed == CY_U3P_HIGH_SPEED) ? "high" : "full");
+                break;
+
+            case USB_RAW_EVENT_CONTROL:
+            {
+                usb_ctrlrequest ctrl;
+                memcpy (&ctrl, event_p->data, sizeof (ctrl));
+                Control (ctrl);
+                break;
+            }
+
+            case CY_FX_GADGET_EVENT_RESET:
+            case CY_FX_GADGET_EVENT_DISCONNECT:
+                DisableEndpoints ();
+                glGadget.configuration = 0;
+                FxHostUsbEvent ((event_p->type == CY_FX_GADGET_EVENT_RESET) ? CY_U3P_USB_EVENT_RESET :
+                        CY_U3P_USB_EVENT_DISCONNECT, 0);
+                break;
+
+            case CY_FX_GADGET_EVENT_SUSPEND:
+                FxHostUsbEvent (CY_U3P_USB_EVENT_SUSPEND, 0);
+                break;
+
+            case CY_FX_GADGET_EVENT_RESUME:
+                FxHostUsbEvent (CY_U3P_USB_EVENT_RESUME, 0);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /* Firmware threads are still parked; do not wait for them. */
+    _exit (1);
+}
+
+/*[]*/
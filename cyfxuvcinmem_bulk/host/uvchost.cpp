@@ -0,0 +1,143 @@
+/*
+ ## Host-side helpers shared by the UVC streamer tools (uvchost.cpp)
+ ## ===========================
+*/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/usbdevice_fs.h>
+
+#include "uvchost.h"
+
+static constexpr const char *SYSFS_USB_DEVICES = "/sys/bus/usb/devices";
+
+/* Read a hexadecimal or decimal attribute of a sysfs USB device. */
+static bool
+ReadSysfsNumber (
+        const char *dev,
+        const char *attr,
+        int base,
+        unsigned long *value_p)
+{
+    char path[512], buf[32];
+    snprintf (path, sizeof (path), "%s/%s/%s", SYSFS_USB_DEVICES, dev, attr);
+
+    FILE *f = fopen (path, "r");
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    bool ok = (fgets (buf, sizeof (buf), f) != nullptr);
+    fclose (f);
+    if (ok)
+    {
+        *value_p = strtoul (buf, nullptr, base);
+    }
+    return ok;
+}
+
+bool
+UvcHostParseVidPid (
+        const char *arg,
+        uint16_t *vid_p,
+        uint16_t *pid_p)
+{
+    unsigned vid, pid;
+    if ((sscanf (arg, "%x:%x", &vid, &pid) != 2) || (vid > 0xFFFF) || (pid > 0xFFFF))
+    {
+        return false;
+    }
+
+    *vid_p = static_cast<uint16_t>(vid);
+    *pid_p = static_cast<uint16_t>(pid);
+    return true;
+}
+
+int
+UvcHostOpen (
+        uint16_t vid,
+        uint16_t pid)
+{
+    DIR *dir = opendir (SYSFS_USB_DEVICES);
+    if (dir == nullptr)
+    {
+        perror (SYSFS_USB_DEVICES);
+        return -1;
+    }
+
+    int fd = -1;
+    bool found = false;
+    for (dirent *ent = readdir (dir); (ent != nullptr) && !found; ent = readdir (dir))
+    {
+        unsigned long devVid, devPid, busnum, devnum;
+
+        /* Interfaces ("1-2:1.0") and hubs' root nodes do not match the IDs. */
+        if ((ent->d_name[0] == '.') || (strchr (ent->d_name, ':') != nullptr) ||
+                !ReadSysfsNumber (ent->d_name, "idVendor", 16, &devVid) ||
+                !ReadSysfsNumber (ent->d_name, "idProduct", 16, &devPid) ||
+                (devVid != vid) || (devPid != pid) ||
+                !ReadSysfsNumber (ent->d_name, "busnum", 10, &busnum) ||
+                !ReadSysfsNumber (ent->d_name, "devnum", 10, &devnum))
+        {
+            continue;
+        }
+
+        char node[64];
+        snprintf (node, sizeof (node), "/dev/bus/usb/%03lu/%03lu", busnum, devnum);
+        found = true;
+        fd = open (node, O_RDWR);
+        if (fd < 0)
+        {
+            perror (node);
+        }
+    }
+    closedir (dir);
+
+    if (!found)
+    {
+        fprintf (stderr, "no device %04x:%04x found\n", vid, pid);
+    }
+    return fd;
+}
+
+int
+UvcHostVendorIn (
+        int fd,
+        uint8_t bRequest,
+        uint16_t wValue,
+        void *data_p,
+        uint16_t length)
+{
+    usbdevfs_ctrltransfer ctrl = {};
+    ctrl.bRequestType = CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_VENDOR_RQT | CY_U3P_USB_TARGET_DEVICE;
+    ctrl.bRequest     = bRequest;
+    ctrl.wValue       = wValue;
+    ctrl.wIndex       = 0;
+    ctrl.wLength      = length;
+    ctrl.timeout      = CY_FX_HOST_CTRL_TIMEOUT;
+    ctrl.data         = data_p;
+
+    return ioctl (fd, USBDEVFS_CONTROL, &ctrl);
+}
+
+int
+UvcHostSetInterface (
+        int fd,
+        unsigned intf,
+        unsigned alt)
+{
+    usbdevfs_setinterface setintf = {};
+    setintf.interface  = intf;
+    setintf.altsetting = alt;
+
+    return ioctl (fd, USBDEVFS_SETINTERFACE, &setintf);
+}
+
+/*[]*/
@@ -0,0 +1,53 @@
+/*
+ ## Host-side helpers shared by the UVC streamer tools (uvchost.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_UVCHOST_H_
+#define _INCLUDED_UVCHOST_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cyfxuvcinmem.h"
+#include "cyfxuvcstats.h"
+
+constexpr uint16_t CY_FX_HOST_DEFAULT_VID = 0x04B4;    // Vendor ID from cyfxuvcdscr.cpp
+constexpr uint16_t CY_FX_HOST_DEFAULT_PID = 0x4722;    // Product ID from cyfxuvcdscr.cpp
+constexpr unsigned CY_FX_HOST_CTRL_TIMEOUT = 1000;     // Control transfer timeout in ms
+
+/* Parse a "vid:pid" pair of hexadecimal numbers. */
+bool
+UvcHostParseVidPid (
+        const char *arg,
+        uint16_t *vid_p,
+        uint16_t *pid_p);
+
+/* Find the first device with the given IDs in sysfs and open its usbdevfs node.
+ * Returns the file descriptor, or -1 after printing the reason. */
+int
+UvcHostOpen (
+        uint16_t vid,
+        uint16_t pid);
+
+/* Issue a device-recipient vendor IN request. Returns the number of bytes
+ * received, or -1 with errno set. */
+int
+UvcHostVendorIn (
+        int fd,
+        uint8_t bRequest,
+        uint16_t wValue,
+        void *data_p,
+        uint16_t length);
+
+/* Select an alternate setting, claiming the interface if needed. Returns 0, or -1
+ * with errno set (EBUSY if a kernel driver holds the interface). */
+int
+UvcHostSetInterface (
+        int fd,
+        unsigned intf,
+        unsigned alt);
+
+#endif /* _INCLUDED_UVCHOST_H_ */
+
+/*[]*/
@@ -0,0 +1,111 @@
+/*
+ ## Streaming mode selector for the UVC bulk streamer (uvclive.cpp)
+ ## ===========================
+*/
+
+/* Selects the streaming mode of the device with the CY_FX_UVC_VENDOR_RQT_LIVE_MODE
+ * vendor request (-m) and prints the live mode counters: frames sent on the schedule,
+ * frames skipped and how late the stream was when it skipped. The mode applies from the
+ * next end of frame and is kept across streaming sessions until the device resets. Like
+ * uvcstat, this runs alongside the uvcvideo driver while a capture application streams. */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "cyfxuvclive.h"
+#include "uvchost.h"
+
+static const char *const glModeNames[CY_FX_UVC_MODE_COUNT] = { "lossless", "live" };
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d vid:pid] [-m lossless|live] [-c]\n"
+            "  -d  device to use (default %04x:%04x)\n"
+            "  -m  select the streaming mode\n"
+            "  -c  clear the counters after reading them\n",
+            prog, CY_FX_HOST_DEFAULT_VID, CY_FX_HOST_DEFAULT_PID);
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    uint16_t wValue = 0, mode = 0;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:m:ch")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'm':
+                mode = 0;
+                while ((mode < CY_FX_UVC_MODE_COUNT) && (strcmp (optarg, glModeNames[mode]) != 0))
+                {
+                    mode++;
+                }
+                if (mode == CY_FX_UVC_MODE_COUNT)
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                wValue = static_cast<uint16_t>((wValue & 0xFF) | (mode << 8) | CY_FX_UVC_LIVE_SELECT);
+                break;
+            case 'c':
+                wValue |= CY_FX_UVC_LIVE_CLEAR;
+                break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    static CyFxUVCLive_t live;
+    int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_LIVE_MODE, wValue, &live, sizeof (live));
+    close (fd);
+    if (len < 0)
+    {
+        fprintf (stderr, "LIVE_MODE failed: %s\n", strerror (errno));
+        return 1;
+    }
+    if ((len != static_cast<int>(sizeof (live))) || (live.version != CY_FX_UVC_LIVE_VERSION))
+    {
+        fprintf (stderr, "unexpected live mode block (%d bytes, version %u)\n", len, live.version);
+        return 1;
+    }
+
+    printf ("mode: %s, frame interval %.3f ms, skip past %u ms late or %u%% of the ring queued\n",
+            (live.mode < CY_FX_UVC_MODE_COUNT) ? glModeNames[live.mode] : "?", live.interval / 10000.0,
+            live.maxAgeMs, live.maxRingPercent);
+    printf ("over %.1f s: %u frames sent live, %u dropped in %u skips (%u over the age limit), latest %u ms\n",
+            (live.uptimeMs - live.clearedMs) / 1000.0, live.frames, live.framesDropped, live.skips, live.ageSkips,
+            live.maxLateMs);
+    if (live.skips != 0)
+    {
+        printf ("last skip: %u ms, %u frames, %u ms late, %u ring bytes queued\n", live.lastSkipMs,
+                live.lastDropped, live.lastLateMs, live.lastRingBytes);
+    }
+    return 0;
+}
+
+/*[]*/
@@ -0,0 +1,228 @@
+/*
+ ## Frame metadata reader for the UVC bulk streamer (uvcmeta.cpp)
+ ## ===========================
+*/
+
+/* Reads the uvcvideo metadata node of a CY_FX_UVC_METADATA=1 streamer while another
+ * application streams the video node, and prints one CSV line per frame: the device
+ * metadata of the EOF header (cyfxuvcmeta.h) with the times relative to the frame's
+ * PTS, the host receive time and the interval since the previous frame. Sequence gaps
+ * are counted as lost frames. The metadata node is the video node's sibling, usually
+ * the next /dev/video number. */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/usb/video.h>
+#include <linux/uvcvideo.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "cyfxuvcmeta.h"
+#include "cyfxuvcclock.h"
+
+constexpr unsigned CY_FX_HOST_META_BUFFERS = 4;        // Metadata buffers queued to the driver
+
+struct MetaBuffer
+{
+    void *mem;
+    size_t length;
+};
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-m device] [-n frames] [-f hz]\n"
+            "  -m  uvcvideo metadata node (default /dev/video1)\n"
+            "  -n  stop after this many frames (default: run until interrupted)\n"
+            "  -f  device clock frequency (default %u, the dwClockFrequency of the firmware)\n",
+            prog, CY_FX_UVC_CLOCK_HZ);
+}
+
+/* Device ticks to microseconds. */
+static double
+Us (
+        uint32_t ticks,
+        double hz)
+{
+    return 1e6 * static_cast<int32_t>(ticks) / hz;
+}
+
+/* Walk the uvc_meta_buf blocks of one metadata buffer and print the frames found in
+ * them. Returns the number of frames printed. */
+static unsigned
+ParseBuffer (
+        const uint8_t *data,
+        size_t bytes,
+        double hz,
+        uint64_t *lastNs_p,
+        uint32_t *nextSeq_p,
+        unsigned *lost_p)
+{
+    constexpr size_t prefix = offsetof (uvc_meta_buf, length);
+    unsigned frames = 0;
+
+    while (bytes > prefix)
+    {
+        const uvc_meta_buf *block_p = reinterpret_cast<const uvc_meta_buf *>(data);
+        size_t headerLen = block_p->length;
+        if ((headerLen < 2) || (prefix + headerLen > bytes))
+        {
+            break;
+        }
+
+        /* The header is copied whole, from bHeaderLength on; the metadata follows PTS and SCR. */
+        if ((headerLen >= CY_FX_UVC_MAX_HEADER + sizeof (CyFxUVCFrameMeta_t)) &&
+                ((block_p->flags & UVC_STREAM_EOF) != 0))
+        {
+            CyFxUVCFrameMeta_t meta;
+            uint64_t ns;
+
+            memcpy (&meta, data + prefix + CY_FX_UVC_MAX_HEADER, sizeof (meta));
+            memcpy (&ns, &block_p->ns, sizeof (ns));
+            if (meta.version == CY_FX_UVC_META_VERSION)
+            {
+                if ((*lastNs_p != 0) && (meta.sequence != *nextSeq_p))
+                {
+                    *lost_p += meta.sequence - *nextSeq_p;
+                }
+                printf ("%u,%llu,%.1f,%.1f,%.1f,%u,%u,%u,%u,%u\n", meta.sequence,
+                        static_cast<unsigned long long>(ns),
+                        (*lastNs_p != 0) ? (ns - *lastNs_p) / 1e3 : 0.0,
+                        Us (meta.firstSendTicks - meta.ptsTicks, hz), Us (meta.eofTicks - meta.ptsTicks, hz),
+                        meta.frameBytes, meta.ringBytes, meta.phyErrors, meta.linkErrors, *lost_p);
+                *lastNs_p = ns;
+                *nextSeq_p = meta.sequence + 1;
+                frames++;
+            }
+        }
+
+        data  += prefix + headerLen;
+        bytes -= prefix + headerLen;
+    }
+    return frames;
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    const char *device = "/dev/video1";
+    unsigned limit = 0;
+    double hz = CY_FX_UVC_CLOCK_HZ;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "m:n:f:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': device = optarg; break;
+            case 'n': limit = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'f': hz = strtod (optarg, nullptr); break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+    if (hz <= 0)
+    {
+        Usage (argv[0]);
+        return 1;
+    }
+
+    int fd = open (device, O_RDWR);
+    if (fd < 0)
+    {
+        fprintf (stderr, "%s: %s\n", device, strerror (errno));
+        return 1;
+    }
+
+    v4l2_format fmt {};
+    fmt.type = V4L2_BUF_TYPE_META_CAPTURE;
+    if ((ioctl (fd, VIDIOC_G_FMT, &fmt) < 0) || (fmt.fmt.meta.dataformat != V4L2_META_FMT_UVC))
+    {
+        fprintf (stderr, "%s: not a UVC metadata node\n", device);
+        return 1;
+    }
+
+    v4l2_requestbuffers req {};
+    req.count  = CY_FX_HOST_META_BUFFERS;
+    req.type   = V4L2_BUF_TYPE_META_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (ioctl (fd, VIDIOC_REQBUFS, &req) < 0)
+    {
+        fprintf (stderr, "VIDIOC_REQBUFS: %s\n", strerror (errno));
+        return 1;
+    }
+
+    MetaBuffer buffers[CY_FX_HOST_META_BUFFERS] = {};
+    for (unsigned i = 0; (i < req.count) && (i < CY_FX_HOST_META_BUFFERS); i++)
+    {
+        v4l2_buffer buf {};
+        buf.type   = V4L2_BUF_TYPE_META_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index  = i;
+        if (ioctl (fd, VIDIOC_QUERYBUF, &buf) < 0)
+        {
+            fprintf (stderr, "VIDIOC_QUERYBUF: %s\n", strerror (errno));
+            return 1;
+        }
+        buffers[i].length = buf.length;
+        buffers[i].mem = mmap (nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
+        if ((buffers[i].mem == MAP_FAILED) || (ioctl (fd, VIDIOC_QBUF, &buf) < 0))
+        {
+            fprintf (stderr, "buffer %u: %s\n", i, strerror (errno));
+            return 1;
+        }
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_META_CAPTURE;
+    if (ioctl (fd, VIDIOC_STREAMON, &type) < 0)
+    {
+        fprintf (stderr, "VIDIOC_STREAMON: %s\n", strerror (errno));
+        return 1;
+    }
+
+    printf ("sequence,host_ns,interval_us,first_send_us,eof_us,frame_bytes,ring_bytes,phy_errors,link_errors,lost\n");
+
+    uint64_t lastNs = 0;
+    uint32_t nextSeq = 0;
+    unsigned frames = 0, lost = 0;
+
+    while ((limit == 0) || (frames < limit))
+    {
+        v4l2_buffer buf {};
+        buf.type   = V4L2_BUF_TYPE_META_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (ioctl (fd, VIDIOC_DQBUF, &buf) < 0)
+        {
+            fprintf (stderr, "VIDIOC_DQBUF: %s\n", strerror (errno));
+            break;
+        }
+        if (buf.index < CY_FX_HOST_META_BUFFERS)
+        {
+            frames += ParseBuffer (static_cast<const uint8_t *>(buffers[buf.index].mem), buf.bytesused, hz,
+                    &lastNs, &nextSeq, &lost);
+        }
+        fflush (stdout);
+        if (ioctl (fd, VIDIOC_QBUF, &buf) < 0)
+        {
+            fprintf (stderr, "VIDIOC_QBUF: %s\n", strerror (errno));
+            break;
+        }
+    }
+
+    ioctl (fd, VIDIOC_STREAMOFF, &type);
+    close (fd);
+    return 0;
+}
+
+/*[]*/
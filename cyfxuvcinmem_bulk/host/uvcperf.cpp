@@ -0,0 +1,205 @@
+/*
+ ## ThreadX performance report reader for the UVC bulk streamer (uvcperf.cpp)
+ ## ===========================
+*/
+
+/* Polls the CY_FX_UVC_VENDOR_RQT_GET_PROFILE vendor request of a ProfileRelease /
+ * ProfileDebug streamer and prints, for every new sample, what changed since the
+ * previous one: scheduling counts per thread, the system-wide totals, and the gets,
+ * waits and inversions of the mutexes and event flags the streaming loop uses. A
+ * UVC thread that is resumed less often than frames are sent, or is repeatedly
+ * preempted by the same driver thread, or waits on the buffer manager or channel
+ * lock, shows up here. With -c the counters since boot are printed instead. */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "cyfxuvcprofile.h"
+#include "uvchost.h"
+
+static const char *const glMutexNames[CY_FX_UVC_PROF_MUTEX_COUNT] = { "all mutexes", "buffer mgr", "channel lock" };
+static const char *const glEventNames[CY_FX_UVC_PROF_EVENT_COUNT] = { "all events", "channel flags" };
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d vid:pid] [-i interval_ms] [-n count] [-c]\n"
+            "  -d  device to poll (default %04x:%04x)\n"
+            "  -i  poll interval in milliseconds (default %u, the sampling period)\n"
+            "  -n  number of reports, 0 = until interrupted (default 0)\n"
+            "  -c  print the counters since boot instead of the changes\n",
+            prog, CY_FX_HOST_DEFAULT_VID, CY_FX_HOST_DEFAULT_PID, CY_FX_UVC_PROFILE_PERIOD_MS);
+}
+
+static const char *
+StateName (
+        uint32_t state)
+{
+    static const char *const names[] =
+    {
+        "ready", "completed", "terminated", "suspended", "sleep", "queue", "semaphore",
+        "event", "block", "byte", "io", "file", "tcpip", "mutex"
+    };
+    return (state < sizeof (names) / sizeof (names[0])) ? names[state] : "?";
+}
+
+/* Find the entry of a thread in an earlier sample; the table order can change if
+ * threads are created or deleted between samples. */
+static const CyFxUVCProfileThread_t *
+FindThread (
+        const CyFxUVCProfile_t &profile,
+        const CyFxUVCProfileThread_t &thread)
+{
+    for (uint32_t i = 0; i < profile.threadCount; i++)
+    {
+        if (strncmp (profile.thread[i].name, thread.name, CY_FX_UVC_PROFILE_NAME_LEN) == 0)
+        {
+            return &profile.thread[i];
+        }
+    }
+    return nullptr;
+}
+
+static void
+Report (
+        const CyFxUVCProfile_t &cur,
+        const CyFxUVCProfile_t *prev_p)
+{
+    static const CyFxUVCProfile_t zero = {};
+    const CyFxUVCProfile_t &prev = (prev_p != nullptr) ? *prev_p : zero;
+    auto d = [] (uint32_t now, uint32_t then) { return now - then; };
+
+    printf ("\n%s %u ms at %u ms, %u of %u threads", (prev_p != nullptr) ? "last" : "since boot,",
+            cur.sampleMs - prev.sampleMs, cur.sampleMs, cur.threadCount, cur.threadTotal);
+    if (cur.status != 0)
+    {
+        printf (", ThreadX status 0x%x (counters disabled in the libraries?)", cur.status);
+    }
+    printf ("\n%-16s %4s %-9s %8s %8s %8s %8s %8s %6s %6s  %s\n", "thread", "prio", "state", "runs",
+            "resumes", "suspends", "pre/os", "pre/irq", "inv", "tmo", "last preempted by");
+
+    for (uint32_t i = 0; i < cur.threadCount; i++)
+    {
+        const CyFxUVCProfileThread_t &t = cur.thread[i];
+        const CyFxUVCProfileThread_t *p_p = (prev_p != nullptr) ? FindThread (prev, t) : nullptr;
+        const CyFxUVCProfileThread_t &p = (p_p != nullptr) ? *p_p : zero.thread[0];
+
+        printf ("%-16.*s %4u %-9s %8u %8u %8u %8u %8u %6u %6u  %.*s%s\n",
+                static_cast<int>(CY_FX_UVC_PROFILE_NAME_LEN), t.name, t.priority, StateName (t.state),
+                d (t.runCount, p.runCount), d (t.resumptions, p.resumptions), d (t.suspensions, p.suspensions),
+                d (t.solicitedPreemptions, p.solicitedPreemptions), d (t.interruptPreemptions, p.interruptPreemptions),
+                d (t.priorityInversions, p.priorityInversions), d (t.timeouts, p.timeouts),
+                static_cast<int>(CY_FX_UVC_PROFILE_NAME_LEN),
+                (t.lastPreemptedBy < cur.threadCount) ? cur.thread[t.lastPreemptedBy].name : "-",
+                (i == cur.appThread) ? "  <- UVC application" : "");
+    }
+
+    const CyFxUVCProfileSystem_t &s = cur.system, &ps = prev.system;
+    uint32_t idle = d (s.idleReturns, ps.idleReturns), busy = d (s.nonIdleReturns, ps.nonIdleReturns);
+    printf ("system: %u resumes, %u suspends, %u+%u preemptions (os+irq), %u inversions, %u timeouts, "
+            "%.0f%% of thread returns went idle\n",
+            d (s.resumptions, ps.resumptions), d (s.suspensions, ps.suspensions),
+            d (s.solicitedPreemptions, ps.solicitedPreemptions), d (s.interruptPreemptions, ps.interruptPreemptions),
+            d (s.priorityInversions, ps.priorityInversions), d (s.timeouts, ps.timeouts),
+            (idle + busy != 0) ? (100.0 * idle / (idle + busy)) : 0.0);
+
+    for (uint32_t i = 0; i < CY_FX_UVC_PROF_MUTEX_COUNT; i++)
+    {
+        const CyFxUVCProfileMutexInfo_t &m = cur.mutex[i], &pm = prev.mutex[i];
+        uint32_t gets = d (m.gets, pm.gets), waits = d (m.suspensions, pm.suspensions);
+        printf ("%-14s %8u gets, %6u waited (%5.1f%%), %u timeouts, %u inversions, %u inheritances\n",
+                glMutexNames[i], gets, waits, (gets != 0) ? (100.0 * waits / gets) : 0.0,
+                d (m.timeouts, pm.timeouts), d (m.inversions, pm.inversions), d (m.inheritances, pm.inheritances));
+    }
+    for (uint32_t i = 0; i < CY_FX_UVC_PROF_EVENT_COUNT; i++)
+    {
+        const CyFxUVCProfileEventInfo_t &e = cur.event[i], &pe = prev.event[i];
+        uint32_t gets = d (e.gets, pe.gets), waits = d (e.suspensions, pe.suspensions);
+        printf ("%-14s %8u gets, %6u waited (%5.1f%%), %u timeouts, %u sets\n",
+                glEventNames[i], gets, waits, (gets != 0) ? (100.0 * waits / gets) : 0.0,
+                d (e.timeouts, pe.timeouts), d (e.sets, pe.sets));
+    }
+    fflush (stdout);
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    unsigned intervalMs = CY_FX_UVC_PROFILE_PERIOD_MS, count = 0;
+    bool cumulative = false;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:i:n:ch")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'i': intervalMs = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'n': count = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'c': cumulative = true; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    static CyFxUVCProfile_t prev, cur;
+    bool havePrev = false;
+
+    for (unsigned reports = 0; (count == 0) || (reports < count); )
+    {
+        int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_PROFILE, 0, &cur, sizeof (cur));
+        if (len < 0)
+        {
+            fprintf (stderr, "GET_PROFILE failed: %s (not a profiling build?)\n", strerror (errno));
+            break;
+        }
+        if ((len != static_cast<int>(sizeof (cur))) || (cur.version != CY_FX_UVC_PROFILE_VERSION))
+        {
+            fprintf (stderr, "unexpected profile block (%d bytes, version %u)\n", len, cur.version);
+            break;
+        }
+
+        /* Only report new samples; the first one is the reference unless -c is given. */
+        if ((cur.samples != 0) && (!havePrev || (cur.samples != prev.samples)))
+        {
+            if (cumulative || havePrev)
+            {
+                Report (cur, cumulative ? nullptr : &prev);
+                reports++;
+            }
+            prev = cur;
+            havePrev = true;
+        }
+
+        if ((count == 0) || (reports < count))
+        {
+            usleep (intervalMs * 1000);
+        }
+    }
+
+    close (fd);
+    return 0;
+}
+
+/*[]*/
@@ -0,0 +1,192 @@
+/*
+ ## Block pool stress test for the UVC bulk streamer (uvcpool.cpp)
+ ## ===========================
+*/
+
+/* Runs the block pool of cyfxuvcpool.cpp on the simulated SDK layer (fx3host.cpp),
+ * where the interrupt mask is a process-wide lock. Several threads allocate and free
+ * blocks as fast as they can, each holding a few at a time, and the latency of every
+ * call is recorded. A block handed out twice, a free that is rejected or a pool that
+ * does not end full fails the run. The latencies are host nanoseconds and include the
+ * wait for the lock held by another thread, which plays the interrupt masked by the
+ * holder on the device: the maximum is the figure to compare between versions. */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "cyu3error.h"
+#include "cyfxuvcpool.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t CY_FX_POOL_TEST_SIZE = 24;          // Block size under test (an event record)
+constexpr uint32_t CY_FX_POOL_TEST_HELD = 4;           // Blocks a thread holds at a time
+
+struct Latency
+{
+    std::vector<uint32_t> allocNs;
+    std::vector<uint32_t> freeNs;
+};
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-t threads] [-n operations] [-b blocks]\n"
+            "  -t  contending threads (default 4)\n"
+            "  -n  alloc / free pairs per thread (default 200000)\n"
+            "  -b  blocks in the pool (default 12)\n",
+            prog);
+}
+
+static uint32_t
+ElapsedNs (
+        Clock::time_point start)
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now () - start).count ());
+}
+
+static void
+Report (
+        const char *name,
+        std::vector<uint32_t> &ns)
+{
+    std::sort (ns.begin (), ns.end ());
+    if (ns.empty ())
+    {
+        return;
+    }
+    printf ("%-6s %10zu %8u %8u %8u %10u\n", name, ns.size (), ns[ns.size () / 2], ns[ns.size () * 99 / 100],
+            ns[ns.size () * 999 / 1000], ns.back ());
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint32_t threads = 4, ops = 200000, blocks = 12;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "t:n:b:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': threads = static_cast<uint32_t>(atoi (optarg)); break;
+            case 'n': ops = static_cast<uint32_t>(atoi (optarg)); break;
+            case 'b': blocks = static_cast<uint32_t>(atoi (optarg)); break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+    if ((threads == 0) || (blocks == 0))
+    {
+        Usage (argv[0]);
+        return 1;
+    }
+
+    static CyFxUVCPool_t pool;
+    std::vector<uint32_t> mem (CyFxUVCPoolWords (CY_FX_POOL_TEST_SIZE, blocks));
+    std::vector<std::atomic<uint32_t>> owner (blocks);
+    std::atomic<uint32_t> errors {0};
+
+    if (CyFxUVCPoolCreate (&pool, mem.data (), CY_FX_POOL_TEST_SIZE, blocks) != CY_U3P_SUCCESS)
+    {
+        fprintf (stderr, "pool create failed\n");
+        return 1;
+    }
+
+    std::vector<Latency> lat (threads);
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back ([&, t] ()
+                {
+                    void *held[CY_FX_POOL_TEST_HELD] = {};
+                    lat[t].allocNs.reserve (ops);
+                    lat[t].freeNs.reserve (ops);
+
+                    for (uint32_t i = 0; i < ops; i++)
+                    {
+                        uint32_t slot = i % CY_FX_POOL_TEST_HELD;
+                        if (held[slot] != nullptr)
+                        {
+                            uint32_t index = static_cast<uint32_t>((static_cast<uint8_t *>(held[slot]) - pool.base_p) /
+                                    pool.blockSize);
+                            owner[index].store (0);
+                            Clock::time_point start = Clock::now ();
+                            CyU3PReturnStatus_t status = CyFxUVCPoolFree (&pool, held[slot]);
+                            lat[t].freeNs.push_back (ElapsedNs (start));
+                            if (status != CY_U3P_SUCCESS)
+                            {
+                                errors++;
+                            }
+                            held[slot] = nullptr;
+                        }
+
+                        Clock::time_point start = Clock::now ();
+                        void *block_p = CyFxUVCPoolAlloc (&pool);
+                        lat[t].allocNs.push_back (ElapsedNs (start));
+                        if (block_p != nullptr)
+                        {
+                            uint32_t index = static_cast<uint32_t>((static_cast<uint8_t *>(block_p) - pool.base_p) /
+                                    pool.blockSize);
+                            uint32_t expected = 0;
+                            if (!owner[index].compare_exchange_strong (expected, t + 1))
+                            {
+                                errors++;       /* Handed out while another thread holds it. */
+                            }
+                            held[slot] = block_p;
+                        }
+                    }
+
+                    for (void *block_p : held)
+                    {
+                        if (block_p != nullptr)
+                        {
+                            owner[static_cast<uint32_t>((static_cast<uint8_t *>(block_p) - pool.base_p) /
+                                    pool.blockSize)].store (0);
+                            CyFxUVCPoolFree (&pool, block_p);
+                        }
+                    }
+                });
+    }
+    for (std::thread &w : workers)
+    {
+        w.join ();
+    }
+
+    /* A pointer into the middle of a block must be rejected. */
+    if (CyFxUVCPoolFree (&pool, reinterpret_cast<uint8_t *>(mem.data ()) + 4) != CY_U3P_ERROR_BAD_ARGUMENT)
+    {
+        errors++;
+    }
+    if (pool.freeCount != blocks)
+    {
+        errors++;
+    }
+
+    Latency all;
+    for (Latency &l : lat)
+    {
+        all.allocNs.insert (all.allocNs.end (), l.allocNs.begin (), l.allocNs.end ());
+        all.freeNs.insert (all.freeNs.end (), l.freeNs.begin (), l.freeNs.end ());
+    }
+
+    printf ("%u threads, %u blocks of %u bytes: %u failed allocs, min free %u, %u errors\n", threads, blocks,
+            pool.blockSize, pool.failCount, pool.minFree, errors.load ());
+    printf ("%-6s %10s %8s %8s %8s %10s\n", "call", "count", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+    Report ("alloc", all.allocNs);
+    Report ("free", all.freeNs);
+    return (errors.load () == 0) ? 0 : 1;
+}
+
+/*[]*/
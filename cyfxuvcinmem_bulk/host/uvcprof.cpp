@@ -0,0 +1,292 @@
+/*
+ ## Trace point profiler for the UVC bulk streamer (uvcprof.cpp)
+ ## ===========================
+*/
+
+/* Reports the trace point histograms of the streaming loop (cyfxuvctrace.h).
+ *
+ * By default the streaming code runs in-process on the simulated SDK layer
+ * (fx3host.cpp): the firmware is configured, streams for the requested time into
+ * a consumer that drains the ring as fast as it can (or at a set rate), and the
+ * histograms are read back through the same vendor request the device serves.
+ * This gives a like-for-like comparison of code versions off-target; the absolute
+ * numbers are host nanoseconds, not FX3 cycles.
+ *
+ * With -d the histograms are read from a ProfileRelease / ProfileDebug device
+ * instead, and the figures are in device clock ticks converted to nanoseconds.
+ *
+ * With -w the payloads of the host run are also saved as a raw dump, for uvcscan. */
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+#include "cyfxuvctrace.h"
+#include "fx3host.h"
+#include "uvccapture.h"
+#include "uvchost.h"
+
+static const char *const glSiteNames[CY_FX_UVC_TP_COUNT] =
+{
+    "getbuf", "header", "memcpy", "commit", "clean", "buffer"
+};
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-t seconds] [-r MB/s] [-s sleep_scale] [-H] [-v] [-w dump] [-d vid:pid] [-m] [-x]\n"
+            "  -t  streaming time of the host run (default 2)\n"
+            "  -r  drain rate of the simulated host in MB/s, 0 = unthrottled (default 0)\n"
+            "  -s  scale applied to CyU3PThreadSleep in the host run, 0 = yield only (default 0)\n"
+            "  -H  report high speed instead of super speed to the firmware\n"
+            "  -v  echo firmware debug output\n"
+            "  -w  save the payloads of the host run as a raw dump\n"
+            "  -d  read the histograms from device vid:pid instead of a host run\n"
+            "  -m  machine-readable output (CSV, one line per site)\n"
+            "  -x  print the histograms\n",
+            prog);
+}
+
+/* Upper bound in ticks of the bucket holding the given fraction of the samples. */
+static uint32_t
+Percentile (
+        const CyFxUVCTraceHist_t &hist,
+        double fraction)
+{
+    uint64_t target = static_cast<uint64_t>(std::ceil (hist.count * fraction));
+    uint64_t seen = 0;
+
+    for (uint32_t b = 0; b < CY_FX_UVC_TRACE_BUCKETS; b++)
+    {
+        seen += hist.bucket[b];
+        if ((seen >= target) && (hist.bucket[b] != 0))
+        {
+            return (b == 0) ? 0 : ((b == CY_FX_UVC_TRACE_BUCKETS - 1) ? hist.maxTicks : (1u << b) - 1);
+        }
+    }
+    return hist.maxTicks;
+}
+
+static void
+Report (
+        const CyFxUVCTrace_t &trace,
+        bool machine,
+        bool histograms)
+{
+    double nsPerTick = (trace.clockHz != 0) ? (1e9 / trace.clockHz) : 1.0;
+    auto ns = [&] (double ticks) { return ticks * nsPerTick; };
+    auto net = [&] (uint32_t ticks) { return (ticks > trace.overheadTicks) ? (ticks - trace.overheadTicks) : 0u; };
+
+    if (machine)
+    {
+        printf ("site,count,min_ns,avg_ns,max_ns,p50_ns,p90_ns,p99_ns\n");
+    }
+    else
+    {
+        printf ("clock %u Hz, trace point overhead %.0f ns (subtracted)\n\n", trace.clockHz, ns (trace.overheadTicks));
+        printf ("%-8s %10s %10s %10s %10s %10s %10s %10s\n", "site", "count", "min ns", "avg ns", "max ns",
+                "p50 ns<", "p90 ns<", "p99 ns<");
+    }
+
+    for (uint32_t i = 0; i < CY_FX_UVC_TP_COUNT; i++)
+    {
+        const CyFxUVCTraceHist_t &hist = trace.site[i];
+        uint64_t sum = (static_cast<uint64_t>(hist.sumTicksHi) << 32) | hist.sumTicksLo;
+        double avg = (hist.count != 0) ? static_cast<double>(sum) / hist.count : 0.0;
+        avg = (avg > trace.overheadTicks) ? (avg - trace.overheadTicks) : 0.0;
+
+        printf (machine ? "%s,%u,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f\n" : "%-8s %10u %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f\n",
+                glSiteNames[i], hist.count, ns (net (hist.minTicks)), ns (avg), ns (net (hist.maxTicks)),
+                ns (net (Percentile (hist, 0.50))), ns (net (Percentile (hist, 0.90))),
+                ns (net (Percentile (hist, 0.99))));
+    }
+
+    if (!histograms || machine)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < CY_FX_UVC_TP_COUNT; i++)
+    {
+        const CyFxUVCTraceHist_t &hist = trace.site[i];
+        uint32_t peak = 1;
+        for (uint32_t b = 0; b < CY_FX_UVC_TRACE_BUCKETS; b++)
+        {
+            peak = (hist.bucket[b] > peak) ? hist.bucket[b] : peak;
+        }
+
+        printf ("\n%s\n", glSiteNames[i]);
+        for (uint32_t b = 0; b < CY_FX_UVC_TRACE_BUCKETS; b++)
+        {
+            if (hist.bucket[b] == 0)
+            {
+                continue;
+            }
+            double lo = (b == 0) ? 0 : ns (1u << (b - 1));
+            printf ("  >= %10.0f ns %10u |%.*s\n", lo, hist.bucket[b],
+                    static_cast<int>(hist.bucket[b] * 50ull / peak), "##################################################");
+        }
+    }
+}
+
+/* Run the streaming code on the simulated SDK and collect its histograms. */
+static bool
+HostRun (
+        const FxHostConfig &cfg,
+        double seconds,
+        double drainMBps,
+        FILE *dump_p,
+        CyFxUVCTrace_t *trace_p)
+{
+    using Clock = std::chrono::steady_clock;
+
+    if (!FxHostStart (cfg, 1000))
+    {
+        fprintf (stderr, "firmware did not connect\n");
+        return false;
+    }
+
+    /* Clear what was recorded during start-up, then configure to start streaming. */
+    FxHostControl (CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_VENDOR_RQT, CY_FX_UVC_VENDOR_RQT_GET_TRACE,
+            CY_FX_UVC_TRACE_CLEAR, 0, trace_p, sizeof (*trace_p));
+    FxHostUsbEvent (CY_U3P_USB_EVENT_SETCONF, 1);
+
+    auto start = Clock::now ();
+    auto end = start + std::chrono::duration<double> (seconds);
+    uint64_t bytes = 0;
+    FxHostBuffer buf;
+
+    while (Clock::now () < end)
+    {
+        if (!FxHostBulkRead (&buf, 100))
+        {
+            continue;
+        }
+        bytes += buf.count;
+        if ((dump_p != nullptr) && !UvcDumpWrite (dump_p, buf.data, buf.count,
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now () - start).count ())))
+        {
+            fprintf (stderr, "dump write failed\n");
+            dump_p = nullptr;
+        }
+        FxHostBulkRelease ();
+
+        if (drainMBps > 0)
+        {
+            std::this_thread::sleep_until (start + std::chrono::duration<double> (bytes / (drainMBps * 1e6)));
+        }
+    }
+
+    int len = FxHostControl (CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_VENDOR_RQT, CY_FX_UVC_VENDOR_RQT_GET_TRACE,
+            0, 0, trace_p, sizeof (*trace_p));
+    FxHostUsbEvent (CY_U3P_USB_EVENT_DISCONNECT, 0);
+
+    double elapsed = std::chrono::duration<double> (Clock::now () - start).count ();
+    fprintf (stderr, "host run: %.2f s, %.1f MB/s\n", elapsed, bytes / elapsed / 1e6);
+    if (len < 0)
+    {
+        fprintf (stderr, "GET_TRACE stalled: trace points not built in (PROFILE=0)\n");
+    }
+    return (len == static_cast<int>(sizeof (*trace_p)));
+}
+
+/* Read the histograms of a device running a profiling build. */
+static bool
+DeviceRead (
+        uint16_t vid,
+        uint16_t pid,
+        CyFxUVCTrace_t *trace_p)
+{
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_TRACE, 0, trace_p, sizeof (*trace_p));
+    if (len < 0)
+    {
+        fprintf (stderr, "GET_TRACE failed: %s (not a profiling build?)\n", strerror (errno));
+    }
+    close (fd);
+    return (len == static_cast<int>(sizeof (*trace_p)));
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    FxHostConfig cfg;
+    double seconds = 2, drainMBps = 0;
+    bool device = false, machine = false, histograms = false;
+    const char *dumpPath = nullptr;
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    int opt;
+
+    cfg.sleepScale = 0;
+    while ((opt = getopt (argc, argv, "t:r:s:Hvw:d:mxh")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': seconds = strtod (optarg, nullptr); break;
+            case 'r': drainMBps = strtod (optarg, nullptr); break;
+            case 's': cfg.sleepScale = strtod (optarg, nullptr); break;
+            case 'H': cfg.speed = CY_U3P_HIGH_SPEED; break;
+            case 'v': cfg.verbose = true; break;
+            case 'w': dumpPath = optarg; break;
+            case 'd':
+                device = true;
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'm': machine = true; break;
+            case 'x': histograms = true; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    FILE *dump_p = nullptr;
+    if (!device && (dumpPath != nullptr) && ((dump_p = UvcDumpOpen (dumpPath)) == nullptr))
+    {
+        return 1;
+    }
+
+    static CyFxUVCTrace_t trace;
+    bool ok = device ? DeviceRead (vid, pid, &trace) : HostRun (cfg, seconds, drainMBps, dump_p, &trace);
+    if ((dump_p != nullptr) && (fclose (dump_p) != 0))
+    {
+        fprintf (stderr, "%s: write failed\n", dumpPath);
+        ok = false;
+    }
+    if (!ok)
+    {
+        return 1;
+    }
+    if ((trace.version != CY_FX_UVC_TRACE_VERSION) || (trace.siteCount != CY_FX_UVC_TP_COUNT) ||
+            (trace.bucketCount != CY_FX_UVC_TRACE_BUCKETS))
+    {
+        fprintf (stderr, "trace block layout mismatch (version %u)\n", trace.version);
+        return 1;
+    }
+
+    Report (trace, machine, histograms);
+
+    /* Streaming threads of the host run are still parked; do not wait for them. */
+    fflush (stdout);
+    _exit (0);
+}
+
+/*[]*/
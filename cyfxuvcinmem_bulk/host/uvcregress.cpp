@@ -0,0 +1,812 @@
+/*
+ ## Performance regression suite of the UVC bulk streamer (uvcregress.cpp)
+ ## ===========================
+*/
+
+/* Times the code on the per-buffer path and its allocators in the host build, writes the
+ * results as "case value unit" lines and compares them with a baseline of the same format:
+ *   - mem.*     the memory primitives of cyfxtx.cpp (CyU3PMemCopy, CyU3PMemSet, CyU3PMemCmp);
+ *   - copy.*    the payload copy of cyfxuvccopy.cpp, aligned, shifted and below its threshold;
+ *   - header.*  the payload header writer of the build (cyfxuvcpayload.h) over the segment table;
+ *   - loop.*    header and copy of one buffer, the streaming loop without the DMA calls;
+ *   - dma.*     the buffer heap of cyfxtx.cpp: alloc / free on an empty heap and on a heap
+ *               fragmented by blocks of mixed sizes, and the session arena of cyfxuvcarena.h;
+ *   - stream.*  the streaming code on the simulated SDK layer (fx3host.cpp) drained as fast
+ *               as possible: frames and MB per second, CPU time and cycles per byte. The
+ *               cycles come from the perf hardware counter and are skipped without it.
+ * The host speed changes from run to run and within a run, by far more than the changes
+ * to be caught, so the timed cases are given relative to a reference operation of host
+ * code (a 4 KiB memcpy) timed in between their batches: the figure is the median of the
+ * per-batch ratios, in reference operations ("ref"). The host time of the reference is
+ * reported as ref.ns and not compared. The stream cases are absolute; lower is better
+ * except for fps and MB/s.
+ *
+ * With -q the ARM instruction counts of the same cases are added as <case>.insns: an ARM
+ * Linux build of this tool (make arm) runs each case a fixed number of times under QEMU
+ * user mode with the instruction counting plugin, and the count of an empty run is taken
+ * off. The firmware is built with -Os for the ARM926EJ-S, and so is that build.
+ *
+ * A baseline line may carry a fourth field, the threshold in percent for that case; the
+ * others use -t. The exit status is 0 without regressions, 2 with one and 1 on errors. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cyu3os.h"
+#include "cyu3utils.h"
+#include "cyu3usb.h"
+#include "cyfxuvcarena.h"
+#include "cyfxuvccopy.h"
+#include "cyfxuvcinmem.h"
+#include "cyfxuvcpayload.h"
+#include "fx3host.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double CY_FX_REGRESS_BATCH_NS = 2e6;         // Minimum length of a timed batch
+constexpr uint32_t CY_FX_REGRESS_ARM_COUNT = 1000;     // Operations per instruction count run
+constexpr uint32_t CY_FX_REGRESS_FRAG_SIZES = 64;      // Block sizes cycled by the fragmented heap cases
+constexpr uint32_t CY_FX_REGRESS_REF_BYTES = 4096;     // Bytes copied by one reference operation
+constexpr const char *CY_FX_REGRESS_REF_CASE = "ref.ns"; // Host time of a reference operation, not compared
+
+struct RegressCase
+{
+    const char *name;
+    void (*setup) (void);                              // Before the timed batches, may be nullptr
+    void (*op) (uint32_t i);                           // One operation; i counts the calls
+    void (*teardown) (void);                           // After the timed batches, may be nullptr
+};
+
+struct RegressResult
+{
+    std::string name;
+    double value;
+    std::string unit;
+    double threshold;                                  // Percent, < 0 for the default (baselines only)
+};
+
+static struct
+{
+    alignas (32) uint8_t src[CY_FX_UVC_STREAM_BUF_SIZE + 64];
+    alignas (32) uint8_t dst[CY_FX_UVC_STREAM_BUF_SIZE + 64];
+    const CyFxUVCSegment_t *segments_p;
+    uint32_t segCount;
+    CyFxUVCStreamWriter_t writer;
+    std::vector<void *> held;                          // Blocks kept by the fragmented heap cases
+    uint16_t fragSizes[CY_FX_REGRESS_FRAG_SIZES];
+    void *ring[CY_FX_UVC_STREAM_BUF_COUNT];
+    volatile int32_t sink;                             // Keeps results that are not stored otherwise
+} glRegress;
+
+/************************************** The cases *************************************/
+
+static void
+MemSetup (
+        void)
+{
+    for (uint32_t i = 0; i < sizeof (glRegress.src); i++)
+    {
+        glRegress.src[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    memcpy (glRegress.dst, glRegress.src, sizeof (glRegress.dst));
+}
+
+static void MemCopy4K (uint32_t) { CyU3PMemCopy (glRegress.dst, glRegress.src, CY_FX_UVC_STREAM_BUF_SIZE); }
+static void MemCopy64 (uint32_t) { CyU3PMemCopy (glRegress.dst, glRegress.src, 64); }
+static void MemSet4K (uint32_t i) { CyU3PMemSet (glRegress.dst, static_cast<uint8_t>(i), CY_FX_UVC_STREAM_BUF_SIZE); }
+static void MemCmp4K (uint32_t) { glRegress.sink = CyU3PMemCmp (glRegress.dst, glRegress.src, CY_FX_UVC_STREAM_BUF_SIZE); }
+
+static void Copy4K (uint32_t) { CyFxUVCCopy (glRegress.dst, glRegress.src, CY_FX_UVC_STREAM_BUF_SIZE); }
+static void Copy4KShifted (uint32_t) { CyFxUVCCopy (glRegress.dst, glRegress.src + 1, CY_FX_UVC_STREAM_BUF_SIZE); }
+static void Copy48 (uint32_t) { CyFxUVCCopy (glRegress.dst, glRegress.src, 48); }
+
+static void
+SegmentSetup (
+        void)
+{
+    glRegress.segments_p = CyFxUVCSegmentsGet (CY_FX_UVC_STREAM_BUF_SIZE, &glRegress.segCount);
+    glRegress.writer.Reset ();
+}
+
+static void
+HeaderWrite (
+        uint32_t i)
+{
+    glRegress.writer.Write (glRegress.dst, &glRegress.segments_p[i % glRegress.segCount]);
+}
+
+/* The body of the streaming loop between GetBuffer and CommitBuffer. */
+static void
+LoopBuffer (
+        uint32_t i)
+{
+    const CyFxUVCSegment_t *seg_p = &glRegress.segments_p[i % glRegress.segCount];
+
+    glRegress.writer.Write (glRegress.dst, seg_p);
+    CyFxUVCCopy (glRegress.dst + (seg_p->commit - seg_p->length), seg_p->src_p, seg_p->length);
+}
+
+static void
+DmaAllocFree4K (
+        uint32_t)
+{
+    CyU3PDmaBufferFree (CyU3PDmaBufferAlloc (CY_FX_UVC_STREAM_BUF_SIZE));
+}
+
+/* Fill the buffer heap with blocks of mixed sizes, then free every other one: the heap is
+ * left with holes of every size between live blocks, as after many sessions of different
+ * buffer sizes without the arena. */
+static void
+DmaFragSetup (
+        void)
+{
+    uint32_t seed = 1;
+
+    for (uint32_t i = 0; i < CY_FX_REGRESS_FRAG_SIZES; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        glRegress.fragSizes[i] = static_cast<uint16_t>(32 + (seed >> 16) % 2048);
+    }
+
+    std::vector<void *> blocks;
+    for (uint32_t i = 0; ; i++)
+    {
+        void *block_p = CyU3PDmaBufferAlloc (glRegress.fragSizes[i % CY_FX_REGRESS_FRAG_SIZES]);
+        if (block_p == nullptr)
+        {
+            break;
+        }
+        blocks.push_back (block_p);
+    }
+    for (size_t i = 0; i < blocks.size (); i++)
+    {
+        if ((i & 1) != 0)
+        {
+            CyU3PDmaBufferFree (blocks[i]);
+        }
+        else
+        {
+            glRegress.held.push_back (blocks[i]);
+        }
+    }
+}
+
+static void
+DmaFragTeardown (
+        void)
+{
+    for (void *block_p : glRegress.held)
+    {
+        CyU3PDmaBufferFree (block_p);
+    }
+    glRegress.held.clear ();
+}
+
+static void
+DmaAllocFreeFrag (
+        uint32_t i)
+{
+    void *block_p = CyU3PDmaBufferAlloc (glRegress.fragSizes[i % CY_FX_REGRESS_FRAG_SIZES]);
+    if (block_p != nullptr)
+    {
+        CyU3PDmaBufferFree (block_p);
+    }
+}
+
+/* The buffer heap work of a streaming session start and stop (CyFxUVCApplnStart / Stop). */
+static void
+DmaArenaSession (
+        uint32_t)
+{
+    CyFxDmaBufferArenaBegin (static_cast<uint16_t>(CY_FX_UVC_SESSION_ARENA_SIZE));
+    for (void *&buffer_p : glRegress.ring)
+    {
+        buffer_p = CyU3PDmaBufferAlloc (CY_FX_UVC_STREAM_BUF_SIZE);
+    }
+    CyFxDmaBufferArenaEnd ();
+    for (void *buffer_p : glRegress.ring)
+    {
+        CyU3PDmaBufferFree (buffer_p);
+    }
+    CyFxDmaBufferArenaRelease ();
+}
+
+/* The reference of the timed cases: host code only, so that no change of the firmware moves
+ * it. A copy of 4 KiB with the C library, between the buffers of the mem and copy cases. */
+static void
+Reference (
+        uint32_t i)
+{
+    memcpy (glRegress.dst, glRegress.src, CY_FX_REGRESS_REF_BYTES);
+    glRegress.sink = glRegress.dst[i % CY_FX_REGRESS_REF_BYTES];
+}
+
+static const RegressCase glReference = { "ref", MemSetup, Reference, nullptr };
+
+static const RegressCase glCases[] =
+{
+    { "mem.copy.4096",          MemSetup,     MemCopy4K,        nullptr },
+    { "mem.copy.64",            MemSetup,     MemCopy64,        nullptr },
+    { "mem.set.4096",           MemSetup,     MemSet4K,         nullptr },
+    { "mem.cmp.4096",           MemSetup,     MemCmp4K,         nullptr },
+    { "copy.4096",              MemSetup,     Copy4K,           nullptr },
+    { "copy.4096.shifted",      MemSetup,     Copy4KShifted,    nullptr },
+    { "copy.48",                MemSetup,     Copy48,           nullptr },
+    { "header.write",           SegmentSetup, HeaderWrite,      nullptr },
+    { "loop.buffer",            SegmentSetup, LoopBuffer,       nullptr },
+    { "dma.alloc_free.4096",    nullptr,      DmaAllocFree4K,   nullptr },
+    { "dma.alloc_free.frag",    DmaFragSetup, DmaAllocFreeFrag, DmaFragTeardown },
+    { "dma.arena.session",      nullptr,      DmaArenaSession,  nullptr },
+};
+
+/************************************** Timing **************************************/
+
+static double
+RunBatch (
+        const RegressCase &c,
+        uint32_t first,
+        uint32_t count)
+{
+    auto start = Clock::now ();
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        c.op (i);
+    }
+    return std::chrono::duration<double, std::nano> (Clock::now () - start).count ();
+}
+
+/* Number of operations of a batch of at least CY_FX_REGRESS_BATCH_NS, from calls on. */
+static uint32_t
+BatchSize (
+        const RegressCase &c,
+        uint32_t *calls_p)
+{
+    uint32_t batch = 1;
+
+    while ((RunBatch (c, *calls_p, batch) < CY_FX_REGRESS_BATCH_NS) && (batch < (1u << 24)))
+    {
+        *calls_p += batch;
+        batch *= 2;
+    }
+    return batch;
+}
+
+/* Time of one operation in reference operations: the median over repeated batches of the
+ * batch time over that of a reference batch run right after it. The host speed drifts
+ * within a run (frequency scaling, other tenants); the two batches of a pair see the same. */
+static double
+TimeCase (
+        const RegressCase &c,
+        unsigned repeats,
+        double *refNs_p)
+{
+    static uint32_t refBatch, refCalls;
+    std::vector<double> ratios, refs;
+    uint32_t calls = 0;
+
+    if (refBatch == 0)
+    {
+        glReference.setup ();
+        refBatch = BatchSize (glReference, &refCalls);
+    }
+    if (c.setup != nullptr)
+    {
+        c.setup ();
+    }
+    uint32_t batch = BatchSize (c, &calls);
+    for (unsigned r = 0; r < repeats; r++)
+    {
+        double ns = RunBatch (c, calls, batch) / batch;
+        double ref = RunBatch (glReference, refCalls, refBatch) / refBatch;
+        ratios.push_back (ns / ref);
+        refs.push_back (ref);
+        calls += batch;
+        refCalls += refBatch;
+    }
+    if (c.teardown != nullptr)
+    {
+        c.teardown ();
+    }
+
+    std::sort (ratios.begin (), ratios.end ());
+    std::sort (refs.begin (), refs.end ());
+    if (refNs_p != nullptr)
+    {
+        *refNs_p = refs[refs.size () / 2];
+    }
+    return ratios[ratios.size () / 2];
+}
+
+static double
+CpuNs (
+        void)
+{
+    timespec ts;
+    clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* CPU cycle counter of this process and of the threads it creates from now on, or -1. */
+static int
+CyclesOpen (
+        void)
+{
+    perf_event_attr attr = {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof (attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+static uint64_t
+CyclesRead (
+        int fd)
+{
+    uint64_t value = 0;
+    return (read (fd, &value, sizeof (value)) == static_cast<ssize_t>(sizeof (value))) ? value : 0;
+}
+
+/* Stream for the given time into a host that reads and releases every buffer at once. The
+ * CPU time and cycles include that host, which does no more than the bookkeeping. */
+static bool
+StreamRun (
+        double seconds,
+        std::vector<RegressResult> *results_p)
+{
+    FxHostConfig cfg;
+    FxHostBuffer buf;
+
+    cfg.sleepScale = 0;
+    int cyclesFd = CyclesOpen ();
+    if (!FxHostStart (cfg, 1000))
+    {
+        fprintf (stderr, "firmware did not connect\n");
+        return false;
+    }
+    FxHostUsbEvent (CY_U3P_USB_EVENT_SETCONF, 1);
+
+    /* Let the ring fill and the first frames go before timing. */
+    auto warm = Clock::now () + std::chrono::milliseconds (200);
+    while (Clock::now () < warm)
+    {
+        if (FxHostBulkRead (&buf, 100))
+        {
+            FxHostBulkRelease ();
+        }
+    }
+
+    uint64_t bytes = 0, frames = 0;
+    uint64_t cycles = (cyclesFd >= 0) ? CyclesRead (cyclesFd) : 0;
+    double cpu = CpuNs ();
+    auto start = Clock::now ();
+    auto end = start + std::chrono::duration_cast<Clock::duration> (std::chrono::duration<double> (seconds));
+    while (Clock::now () < end)
+    {
+        if (!FxHostBulkRead (&buf, 100))
+        {
+            continue;
+        }
+        bytes += buf.count;
+        frames += ((buf.count >= 2) && ((buf.data[1] & CY_FX_UVC_HEADER_EOF) != 0)) ? 1 : 0;
+        FxHostBulkRelease ();
+    }
+    double elapsed = std::chrono::duration<double> (Clock::now () - start).count ();
+    cpu = CpuNs () - cpu;
+    cycles = (cyclesFd >= 0) ? CyclesRead (cyclesFd) - cycles : 0;
+    FxHostUsbEvent (CY_U3P_USB_EVENT_DISCONNECT, 0);
+
+    if (bytes == 0)
+    {
+        fprintf (stderr, "no data streamed\n");
+        return false;
+    }
+    results_p->push_back ({ "stream.fps", frames / elapsed, "fps", -1 });
+    results_p->push_back ({ "stream.throughput", bytes / elapsed / 1e6, "MB/s", -1 });
+    results_p->push_back ({ "stream.cpu", cpu / bytes, "ns/B", -1 });
+    if (cycles != 0)
+    {
+        results_p->push_back ({ "stream.cycles", static_cast<double>(cycles) / bytes, "cycles/B", -1 });
+    }
+    return true;
+}
+
+/******************************** Instruction counts ********************************/
+
+/* Run the ARM build of one case under QEMU and return the instructions it executed. */
+static bool
+ArmRun (
+        const std::string &qemu,
+        const char *armPath,
+        const char *name,
+        uint32_t count,
+        double *insns_p)
+{
+    std::string cmd = qemu + " " + armPath + " -N " + std::to_string (count) + " -k " + name + " 2>&1";
+    FILE *pipe_p = popen (cmd.c_str (), "r");
+    if (pipe_p == nullptr)
+    {
+        perror ("popen");
+        return false;
+    }
+
+    char line[256];
+    bool found = false;
+    while (fgets (line, sizeof (line), pipe_p) != nullptr)
+    {
+        const char *field = strstr (line, "insns: ");
+        if (field != nullptr)
+        {
+            *insns_p = strtod (field + 7, nullptr);
+            found = true;
+        }
+    }
+    if ((pclose (pipe_p) != 0) || !found)
+    {
+        fprintf (stderr, "%s: no instruction count (is the insn plugin loaded with -d plugin?)\n", cmd.c_str ());
+        return false;
+    }
+    return true;
+}
+
+static bool
+ArmCount (
+        const std::string &qemu,
+        const char *armPath,
+        const RegressCase &c,
+        std::vector<RegressResult> *results_p)
+{
+    double empty, full;
+
+    if (!ArmRun (qemu, armPath, c.name, 0, &empty) || !ArmRun (qemu, armPath, c.name, CY_FX_REGRESS_ARM_COUNT, &full))
+    {
+        return false;
+    }
+    results_p->push_back ({ std::string (c.name) + ".insns", (full - empty) / CY_FX_REGRESS_ARM_COUNT, "insns", -1 });
+    return true;
+}
+
+/* Instruction count mode, run by ArmRun: the case alone, count times, without timing. */
+static int
+CountCase (
+        const char *name,
+        uint32_t count)
+{
+    for (const RegressCase &c : glCases)
+    {
+        if (strcmp (c.name, name) == 0)
+        {
+            if (c.setup != nullptr)
+            {
+                c.setup ();
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                c.op (i);
+            }
+            if (c.teardown != nullptr)
+            {
+                c.teardown ();
+            }
+            return 0;
+        }
+    }
+    fprintf (stderr, "%s: no such case\n", name);
+    return 1;
+}
+
+/********************************* Results, baseline *********************************/
+
+/* The build options that change the figures; a baseline of another build is compared anyway. */
+static std::string
+BuildConfig (
+        void)
+{
+    char config[128];
+    snprintf (config, sizeof (config), "header %u, metadata %u, profile %u, %s",
+            static_cast<unsigned>(CY_FX_UVC_HEADER_LEN), static_cast<unsigned>(CY_FX_UVC_META_LEN),
+#ifdef CYU3P_PROFILE_EN
+            1u,
+#else
+            0u,
+#endif
+#if defined (__x86_64__)
+            "x86_64"
+#elif defined (__aarch64__)
+            "aarch64"
+#elif defined (__arm__)
+            "arm"
+#else
+            "host"
+#endif
+            );
+    return config;
+}
+
+static bool
+WriteResults (
+        FILE *file_p,
+        const std::vector<RegressResult> &results)
+{
+    fprintf (file_p, "# uvcregress: case value unit [threshold %%]; lower is better except fps and MB/s\n");
+    fprintf (file_p, "# build %s\n", BuildConfig ().c_str ());
+    for (const RegressResult &result : results)
+    {
+        fprintf (file_p, "%-24s %12.5g %s\n", result.name.c_str (), result.value, result.unit.c_str ());
+    }
+    return (fflush (file_p) == 0) && !ferror (file_p);
+}
+
+static bool
+ReadBaseline (
+        const char *path,
+        std::vector<RegressResult> *baseline_p,
+        std::string *config_p)
+{
+    FILE *file_p = fopen (path, "r");
+    if (file_p == nullptr)
+    {
+        perror (path);
+        return false;
+    }
+
+    char line[256];
+    unsigned lineNo = 0;
+    bool ok = true;
+    while (fgets (line, sizeof (line), file_p) != nullptr)
+    {
+        lineNo++;
+        if (strncmp (line, "# build ", 8) == 0)
+        {
+            *config_p = std::string (line + 8, strcspn (line + 8, "\r\n"));
+            continue;
+        }
+        if ((line[strspn (line, " \t\r\n")] == '\0') || (line[strspn (line, " \t")] == '#'))
+        {
+            continue;
+        }
+
+        char name[64], unit[16];
+        double value, threshold = -1;
+        int fields = sscanf (line, "%63s %lf %15s %lf", name, &value, unit, &threshold);
+        if (fields < 3)
+        {
+            fprintf (stderr, "%s:%u: expected \"case value unit [threshold]\"\n", path, lineNo);
+            ok = false;
+            continue;
+        }
+        baseline_p->push_back ({ name, value, unit, (fields == 4) ? threshold : -1 });
+    }
+    fclose (file_p);
+    return ok;
+}
+
+static bool
+HigherIsBetter (
+        const std::string &unit)
+{
+    return (unit == "fps") || (unit == "MB/s");
+}
+
+/* Print the comparison; returns the number of regressions. */
+static unsigned
+Compare (
+        const std::vector<RegressResult> &results,
+        const std::vector<RegressResult> &baseline,
+        const std::string &baseConfig,
+        double defaultThreshold)
+{
+    unsigned regressions = 0;
+
+    if (!baseConfig.empty () && (baseConfig != BuildConfig ()))
+    {
+        printf ("baseline build: %s\nthis build:     %s\n\n", baseConfig.c_str (), BuildConfig ().c_str ());
+    }
+    printf ("%-24s %12s %12s %9s %7s\n", "case", "baseline", "now", "change", "limit");
+    for (const RegressResult &base : baseline)
+    {
+        double threshold = (base.threshold >= 0) ? base.threshold : defaultThreshold;
+        auto it = std::find_if (results.begin (), results.end (),
+                [&] (const RegressResult &result) { return result.name == base.name; });
+        if (it == results.end ())
+        {
+            printf ("%-24s %12.5g %12s %9s %6.0f%%  not run\n", base.name.c_str (), base.value, "-", "-", threshold);
+            continue;
+        }
+
+        double change = (base.value != 0) ? (it->value - base.value) / base.value * 100 : 0;
+        double worse = HigherIsBetter (base.unit) ? -change : change;
+        const char *verdict = "ok";
+        if (base.name == CY_FX_REGRESS_REF_CASE)
+        {
+            /* The speed of the host, which the other times are relative to. */
+            verdict = "host";
+        }
+        else if (it->unit != base.unit)
+        {
+            verdict = "UNIT CHANGED";
+            regressions++;
+        }
+        else if (worse > threshold)
+        {
+            verdict = "REGRESSION";
+            regressions++;
+        }
+        else if (worse < -threshold)
+        {
+            verdict = "improved";
+        }
+        printf ("%-24s %12.5g %12.5g %+8.1f%% %6.0f%%  %s\n", base.name.c_str (), base.value, it->value, change,
+                threshold, verdict);
+    }
+    for (const RegressResult &result : results)
+    {
+        if (std::none_of (baseline.begin (), baseline.end (),
+                    [&] (const RegressResult &base) { return base.name == result.name; }))
+        {
+            printf ("%-24s %12s %12.5g %9s %7s  new\n", result.name.c_str (), "-", result.value, "-", "-");
+        }
+    }
+    printf ("\n%u regression%s\n", regressions, (regressions == 1) ? "" : "s");
+    return regressions;
+}
+
+/*************************************** main ***************************************/
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-o results] [-b baseline] [-t percent] [-k prefix] [-r repeats] [-s seconds]\n"
+            "          [-q \"qemu-arm -plugin libinsn.so -d plugin\" -a arm_build] [-l]\n"
+            "  -o  write the results to a file (default: standard output, or none with -b)\n"
+            "  -b  compare with a baseline and exit 2 on a regression\n"
+            "  -t  regression threshold in percent for cases without their own (default 10)\n"
+            "  -k  run only the cases whose name starts with prefix\n"
+            "  -r  timed batches per case, the median ratio is kept (default 21)\n"
+            "  -s  streaming time of the stream cases, 0 to skip them (default 2)\n"
+            "  -q  QEMU user mode command line counting instructions (insn plugin)\n"
+            "  -a  ARM Linux build of this tool to run under -q (make arm)\n"
+            "  -l  list the cases\n",
+            prog);
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    const char *outPath = nullptr, *basePath = nullptr, *prefix = "", *armPath = nullptr;
+    std::string qemu;
+    double threshold = 10, seconds = 2;
+    unsigned repeats = 21;
+    long countOps = -1;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "o:b:t:k:r:s:q:a:N:lh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o': outPath = optarg; break;
+            case 'b': basePath = optarg; break;
+            case 't': threshold = strtod (optarg, nullptr); break;
+            case 'k': prefix = optarg; break;
+            case 'r': repeats = std::max (1u, static_cast<unsigned>(strtoul (optarg, nullptr, 0))); break;
+            case 's': seconds = strtod (optarg, nullptr); break;
+            case 'q': qemu = optarg; break;
+            case 'a': armPath = optarg; break;
+            case 'N': countOps = strtol (optarg, nullptr, 0); break;
+            case 'l':
+                for (const RegressCase &c : glCases)
+                {
+                    printf ("%s\n", c.name);
+                }
+                printf ("stream.fps\nstream.throughput\nstream.cpu\nstream.cycles\n%s\n", CY_FX_REGRESS_REF_CASE);
+                return 0;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+    if ((optind != argc) || (qemu.empty () != (armPath == nullptr)))
+    {
+        Usage (argv[0]);
+        return 1;
+    }
+
+    /* Before anything else can take the address range of System RAM. */
+    if (!FxHostMemInit ())
+    {
+        return 1;
+    }
+    if (countOps >= 0)
+    {
+        return CountCase (prefix, static_cast<uint32_t>(countOps));
+    }
+
+    std::vector<RegressResult> results;
+    std::vector<double> refs;
+    for (const RegressCase &c : glCases)
+    {
+        if (strncmp (c.name, prefix, strlen (prefix)) != 0)
+        {
+            continue;
+        }
+        fprintf (stderr, "%s\n", c.name);
+        refs.push_back (0);
+        results.push_back ({ c.name, TimeCase (c, repeats, &refs.back ()), "ref", -1 });
+        if (!qemu.empty () && !ArmCount (qemu, armPath, c, &results))
+        {
+            return 1;
+        }
+    }
+    if ((seconds > 0) && (strncmp ("stream.", prefix, std::min (strlen (prefix), strlen ("stream."))) == 0))
+    {
+        fprintf (stderr, "stream\n");
+        if (!StreamRun (seconds, &results))
+        {
+            return 1;
+        }
+    }
+
+    if (!refs.empty ())
+    {
+        std::sort (refs.begin (), refs.end ());
+        results.push_back ({ CY_FX_REGRESS_REF_CASE, refs[refs.size () / 2], "ns", -1 });
+    }
+
+    int status = 0;
+    if (outPath != nullptr)
+    {
+        FILE *file_p = fopen (outPath, "w");
+        if ((file_p == nullptr) || !WriteResults (file_p, results) || (fclose (file_p) != 0))
+        {
+            perror (outPath);
+            status = 1;
+        }
+    }
+    else if (basePath == nullptr)
+    {
+        WriteResults (stdout, results);
+    }
+
+    if ((status == 0) && (basePath != nullptr))
+    {
+        std::vector<RegressResult> baseline;
+        std::string baseConfig;
+        if (!ReadBaseline (basePath, &baseline, &baseConfig))
+        {
+            status = 1;
+        }
+        else
+        {
+            /* Cases left out with -k are not reported as not run. */
+            std::erase_if (baseline, [&] (const RegressResult &base) {
+                return strncmp (base.name.c_str (), prefix, strlen (prefix)) != 0;
+            });
+            if (Compare (results, baseline, baseConfig, threshold) != 0)
+            {
+                status = 2;
+            }
+        }
+    }
+
+    /* The firmware threads are still running: leave without the static destructors. */
+    fflush (stdout);
+    _exit (status);
+}
+
+/*[]*/
@@ -0,0 +1,143 @@
+/*
+ ## Adaptive DMA ring reader for the UVC bulk streamer (uvcring.cpp)
+ ## ===========================
+*/
+
+/* Reads the CY_FX_UVC_VENDOR_RQT_GET_RING vendor request of a CY_FX_UVC_RING_ADAPT=1
+ * device and prints the depth of the video DMA ring, the occupancy histogram since the
+ * counters were cleared, the last window judged and the latest resize decisions with the
+ * window that led to each. With -c the counters are cleared after the read, so that the
+ * next read covers one scenario (a host, an application) only. */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "cyfxuvcring.h"
+#include "uvchost.h"
+
+constexpr unsigned CY_FX_RING_BAR_WIDTH = 40;          // Characters of the longest histogram bar
+
+static const char *const glReasonNames[] = { "-", "grow", "shrink" };
+static const char *const glResultNames[] = { "applied", "deferred", "failed" };
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d vid:pid] [-c]\n"
+            "  -d  device to read (default %04x:%04x)\n"
+            "  -c  clear the counters after reading them\n",
+            prog, CY_FX_HOST_DEFAULT_VID, CY_FX_HOST_DEFAULT_PID);
+}
+
+static void
+PrintWindow (
+        const char *label,
+        const CyFxUVCRingWindow_t &window)
+{
+    if (window.samples == 0)
+    {
+        printf ("%s: no samples\n", label);
+        return;
+    }
+    printf ("%s: %u buffers, %.1f%% full (%.1f ms blocked), %.1f%% dry, occupancy %u to %u\n", label,
+            window.samples, 100.0 * window.full / window.samples, window.blockedUs / 1000.0,
+            100.0 * window.dry / window.samples, window.minBuffers, window.maxBuffers);
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    uint16_t wValue = 0;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:ch")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'c':
+                wValue |= CY_FX_UVC_RING_CLEAR;
+                break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    static CyFxUVCRing_t ring;
+    int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_RING, wValue, &ring, sizeof (ring));
+    close (fd);
+    if (len < 0)
+    {
+        fprintf (stderr, "GET_RING failed: %s (not a CY_FX_UVC_RING_ADAPT=1 build?)\n", strerror (errno));
+        return 1;
+    }
+    if ((len != static_cast<int>(sizeof (ring))) || (ring.version != CY_FX_UVC_RING_VERSION))
+    {
+        fprintf (stderr, "unexpected ring block (%d bytes, version %u)\n", len, ring.version);
+        return 1;
+    }
+
+    printf ("ring: %u x %u bytes (%u bytes), depth %u to %u, ceiling %u bytes\n", ring.count, ring.bufSize,
+            ring.count * ring.bufSize, ring.minCount, ring.maxCount, ring.ceilingBytes);
+    printf ("over %.1f s: %u windows of %u ms, %u grows, %u shrinks, %u deferred, %u failed\n",
+            (ring.uptimeMs - ring.clearedMs) / 1000.0, ring.windows, ring.windowMs, ring.grows, ring.shrinks,
+            ring.deferred, ring.failed);
+
+    uint64_t samples = 0;
+    uint32_t peak = 0;
+    for (uint32_t i = 0; i < CY_FX_UVC_RING_HIST_BINS; i++)
+    {
+        samples += ring.histogram[i];
+        peak = (ring.histogram[i] > peak) ? ring.histogram[i] : peak;
+    }
+    printf ("\noccupancy (buffers queued when the loop got one)\n");
+    for (uint32_t i = 0; (samples != 0) && (i < CY_FX_UVC_RING_HIST_BINS); i++)
+    {
+        unsigned bar = static_cast<unsigned>(static_cast<uint64_t>(ring.histogram[i]) * CY_FX_RING_BAR_WIDTH / peak);
+        printf ("%3u%s %10u %5.1f%% %.*s\n", i, (i == CY_FX_UVC_RING_HIST_BINS - 1) ? "+" : " ", ring.histogram[i],
+                100.0 * ring.histogram[i] / samples, bar, "########################################");
+    }
+    printf ("\n");
+    PrintWindow ("last window", ring.last);
+
+    uint32_t first = (ring.decisions > CY_FX_UVC_RING_LOG_SIZE) ? (ring.decisions - CY_FX_UVC_RING_LOG_SIZE) : 0;
+    if (ring.decisions != 0)
+    {
+        printf ("\ndecisions (%u, the last %u)\n", ring.decisions, ring.decisions - first);
+    }
+    for (uint32_t n = first; n < ring.decisions; n++)
+    {
+        const CyFxUVCRingDecision_t &decision = ring.log[n % CY_FX_UVC_RING_LOG_SIZE];
+        char label[64];
+
+        snprintf (label, sizeof (label), "%10u ms %-6s %3u -> %-3u %-8s",
+                decision.timeMs, (decision.reason <= CY_FX_UVC_RING_SHRINK_SPARE) ? glReasonNames[decision.reason] : "?",
+                decision.fromCount, decision.toCount,
+                (decision.result <= CY_FX_UVC_RING_FAILED) ? glResultNames[decision.result] : "?");
+        PrintWindow (label, decision.window);
+    }
+    return 0;
+}
+
+/*[]*/
@@ -0,0 +1,237 @@
+/*
+ ## Payload stream analyzer for the UVC bulk streamer (uvcscan.cpp)
+ ## ===========================
+*/
+
+/* Runs the payloads of a capture through the stream analyzer (uvcstream.h) and prints a
+ * report: payload and frame counts, the throughput on the capture clock, frame sizes,
+ * frame interval jitter on the capture clock and on the PTS, and the protocol violations
+ * with the position of the first ones. With -c one CSV line per frame is printed instead.
+ * The capture is a raw dump (uvcprof -w), a usbmon pcap / pcapng or usbmon text
+ * (uvccapture.h); "-" reads standard input, so a live capture can be piped in:
+ *
+ *     tcpdump -i usbmon2 -s 0 -U -w - | uvcscan -
+ *
+ * The exit status is 0 for a clean capture, 2 when violations were found and 1 when
+ * the capture could not be read. */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "cyfxuvcclock.h"
+#include "uvccapture.h"
+#include "uvcstream.h"
+
+using Clock = std::chrono::steady_clock;
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-F raw|pcap|text] [-D [bus:]device] [-e endpoint] [-f hz] [-n events] [-c] capture|-\n"
+            "  -F  capture format (default: from the first bytes)\n"
+            "  -D  usbmon captures: device address, optionally with the bus number\n"
+            "  -e  usbmon captures: bulk IN endpoint number (default: the first carrying UVC payloads)\n"
+            "  -f  PTS clock frequency in Hz, 0 for ticks (default %u, the dwClockFrequency of the firmware)\n"
+            "  -n  violations listed with their position (default 16)\n"
+            "  -c  print one CSV line per frame instead of the report\n",
+            prog, CY_FX_UVC_CLOCK_HZ);
+}
+
+static void
+FrameCsv (
+        const UvcStreamFrame &frame,
+        void *)
+{
+    printf ("%llu,%llu,%u,%u,%llu,%llu,%u,%d,%d,%d,%u\n", static_cast<unsigned long long>(frame.index),
+            static_cast<unsigned long long>(frame.firstPayload), frame.payloads, frame.bytes,
+            static_cast<unsigned long long>(frame.firstNs), static_cast<unsigned long long>(frame.lastNs),
+            frame.pts, frame.eof, frame.truncated, frame.jpegOk, frame.violations);
+}
+
+static void
+Series (
+        const char *name,
+        const UvcStreamSeries &series,
+        const char *unit)
+{
+    if (series.count == 0)
+    {
+        printf ("%-16s -\n", name);
+        return;
+    }
+    printf ("%-16s avg %.1f, std %.1f, min %.1f, max %.1f %s (%llu)\n", name, series.Mean (), series.StdDev (),
+            series.min, series.max, unit, static_cast<unsigned long long>(series.count));
+}
+
+static void
+Report (
+        const UvcStream &stream,
+        const UvcCapture &cap,
+        double analysisSec)
+{
+    const UvcStreamStats &stats = stream.stats;
+    double captureSec = (stats.lastNs - stats.firstNs) / 1e9;
+    uint64_t video = stats.payloadBytes - stats.headerBytes;
+
+    printf ("payloads         %llu, %.1f MB (%.1f MB video)", static_cast<unsigned long long>(stats.payloads),
+            stats.payloadBytes / 1e6, video / 1e6);
+    if (stats.truncatedPayloads != 0)
+    {
+        printf (", %llu captured in part", static_cast<unsigned long long>(stats.truncatedPayloads));
+    }
+    printf ("\n");
+    if (captureSec > 0)
+    {
+        printf ("throughput       %.1f MB/s payload, %.1f MB/s video over %.3f s\n",
+                stats.payloadBytes / captureSec / 1e6, video / captureSec / 1e6, captureSec);
+    }
+    printf ("analysis         %.3f s, %.1f MB/s of capture", analysisSec, cap.bytesRead / analysisSec / 1e6);
+    if (captureSec > 0)
+    {
+        printf (", %.1fx real time", captureSec / analysisSec);
+    }
+    printf ("\n");
+
+    printf ("frames           %llu: %llu with EOF, %llu MJPEG checked good, %llu with metadata\n",
+            static_cast<unsigned long long>(stats.frames), static_cast<unsigned long long>(stats.eofFrames),
+            static_cast<unsigned long long>(stats.jpegFrames), static_cast<unsigned long long>(stats.metaFrames));
+    Series ("frame bytes", stats.frameBytes, "B");
+    Series ("frame interval", stats.intervalUs, "us");
+    Series ("pts interval", stats.ptsIntervalUs, (stream.cfg.clockHz > 0) ? "us" : "ticks");
+    if (stats.intervalUs.count != 0)
+    {
+        printf ("frame rate       %.2f fps, interval jitter %.1f us peak to peak\n",
+                1e6 / stats.intervalUs.Mean (), stats.intervalUs.max - stats.intervalUs.min);
+    }
+
+    uint64_t total = 0;
+    for (unsigned i = 0; i < UVC_VIOL_COUNT; i++)
+    {
+        total += stats.violations[i];
+    }
+    printf ("violations       %llu\n", static_cast<unsigned long long>(total));
+    for (unsigned i = 0; i < UVC_VIOL_COUNT; i++)
+    {
+        if (stats.violations[i] != 0)
+        {
+            printf ("  %-14s %llu\n", glUvcStreamViolationNames[i], static_cast<unsigned long long>(stats.violations[i]));
+        }
+    }
+    for (const UvcStreamEvent &event : stats.events)
+    {
+        printf ("  payload %llu, frame %llu, +%.6f s: %s\n", static_cast<unsigned long long>(event.payload),
+                static_cast<unsigned long long>(event.frame), (event.ns - stats.firstNs) / 1e9,
+                glUvcStreamViolationNames[event.kind]);
+    }
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    UvcCaptureFormat format = UVC_CAPTURE_AUTO;
+    UvcCaptureFilter filter;
+    UvcStreamConfig cfg;
+    bool csv = false;
+    int opt;
+
+    cfg.clockHz = CY_FX_UVC_CLOCK_HZ;
+    while ((opt = getopt (argc, argv, "F:D:e:f:n:ch")) != -1)
+    {
+        switch (opt)
+        {
+            case 'F':
+                format = (strcmp (optarg, "raw") == 0) ? UVC_CAPTURE_RAW :
+                        (strcmp (optarg, "pcap") == 0) ? UVC_CAPTURE_PCAP :
+                        (strcmp (optarg, "text") == 0) ? UVC_CAPTURE_USBMON_TEXT : UVC_CAPTURE_AUTO;
+                if (format == UVC_CAPTURE_AUTO)
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'D':
+                if (strchr (optarg, ':') != nullptr)
+                {
+                    filter.bus = atoi (optarg);
+                    filter.device = atoi (strchr (optarg, ':') + 1);
+                }
+                else
+                {
+                    filter.device = atoi (optarg);
+                }
+                break;
+            case 'e': filter.endpoint = atoi (optarg) & 0x7F; break;
+            case 'f': cfg.clockHz = strtod (optarg, nullptr); break;
+            case 'n': cfg.keepEvents = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'c': csv = true; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+    if (optind + 1 != argc)
+    {
+        Usage (argv[0]);
+        return 1;
+    }
+
+    static UvcCapture cap;
+    if (!UvcCaptureOpen (&cap, argv[optind], format, filter))
+    {
+        return 1;
+    }
+
+    if (csv)
+    {
+        cfg.frameCb = FrameCsv;
+        printf ("frame,first_payload,payloads,bytes,first_ns,last_ns,pts,eof,truncated,jpeg_ok,violations\n");
+    }
+
+    static UvcStream stream;
+    UvcStreamInit (&stream, cfg);
+
+    auto start = Clock::now ();
+    UvcPayload payload;
+    int status;
+    while ((status = UvcCaptureNext (&cap, &payload)) > 0)
+    {
+        if (status == 1)
+        {
+            UvcStreamPayload (&stream, payload);
+        }
+        else
+        {
+            UvcStreamUrbError (&stream, cap.lastErrorNs);
+        }
+    }
+    UvcStreamFinish (&stream);
+    double analysisSec = std::chrono::duration<double> (Clock::now () - start).count ();
+    UvcCaptureClose (&cap);
+
+    if (!csv)
+    {
+        Report (stream, cap, analysisSec);
+    }
+    if (status < 0)
+    {
+        return 1;
+    }
+
+    for (unsigned i = 0; i < UVC_VIOL_COUNT; i++)
+    {
+        if (stream.stats.violations[i] != 0)
+        {
+            return 2;
+        }
+    }
+    return 0;
+}
+
+/*[]*/
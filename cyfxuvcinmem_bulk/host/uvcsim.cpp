@@ -0,0 +1,887 @@
+/*
+ ## Simulated USB host for pacing and recovery tests of the UVC bulk streamer (uvcsim.cpp)
+ ## ===========================
+*/
+
+/* Runs the streaming code on the simulated SDK layer (fx3host.cpp) against a host that
+ * follows a script. The host drains the video endpoint at a set bandwidth and holds each
+ * transfer for a time drawn from a latency distribution; it stops reading for a while,
+ * and it sends what a real host sends when it sets up or recovers a stream: the probe /
+ * commit sequence, SET_CONFIGURATION, SET_INTERFACE, CLEAR_FEATURE(ENDPOINT_HALT) on the
+ * video endpoint, bus resets and disconnects. Faults can be held back until the host is
+ * in the middle of a frame. It can also switch the firmware to its live streaming mode
+ * (cyfxuvclive.h), where a paused host makes it skip frames instead.
+ *
+ * Each streaming session, from the event that starts it to the one that ends it, runs
+ * through a stream analyzer of its own (uvcstream.h): FID / EOF framing and the MJPEG
+ * structure of every frame. As the first frame of a session must start with SOI, this
+ * also shows a restarted stream resuming inside the frame it was cut in. The host adds:
+ *   - the stream resumes within a second of a restart and stays silent while stopped;
+ *   - payloads and frames fit the dwMaxPayloadTransferSize and dwMaxVideoFrameSize of
+ *     the committed probe, and the probe / commit requests succeed;
+ *   - the firmware counts no GetBuffer or CommitBuffer error: a restart is not one;
+ *   - start / stop cycles give the buffer heap back as they found it: the free bytes,
+ *     free runs and longest run of CyFxDmaBufferHeapInfoGet ("cycles").
+ * The report gives the percentiles of the buffer latency (commit to host read), the
+ * frame latency (first commit to the read of the EOF payload) and, per kind of event,
+ * the restart latency (event to the first commit of the new session).
+ *
+ * The exit status is 0 when every check passed, 2 when one failed and 1 on errors. */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "cyfxuvcarena.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvclive.h"
+#include "cyfxuvcring.h"
+#include "fx3host.h"
+#include "uvchost.h"
+#include "uvcstream.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double SIM_RESTART_TIMEOUT_SEC = 1.0;        // Longest wait for the first payload of a session
+constexpr unsigned SIM_POLL_MS = 10;                    // Longest single wait for a buffer
+
+/* Script commands. */
+enum SimOp
+{
+    SIM_OP_RATE = 0,                    /* rate MB/s */
+    SIM_OP_LATENCY,                     /* latency fixed|uniform|exp us [us] */
+    SIM_OP_RUN,                         /* run ms */
+    SIM_OP_PAUSE,                       /* pause ms */
+    SIM_OP_PROBE,                       /* probe */
+    SIM_OP_CONFIGURE,                   /* configure */
+    SIM_OP_SETINTF,                     /* setintf [count [gap_us]] */
+    SIM_OP_HALT,                        /* halt [midframe] */
+    SIM_OP_RESET,                       /* reset [midframe] */
+    SIM_OP_DISCONNECT,                  /* disconnect [midframe] */
+    SIM_OP_MODE,                        /* mode lossless|live */
+    SIM_OP_CYCLES,                      /* cycles [count] */
+    SIM_OP_COUNT
+};
+
+static const char *const glSimOpNames[SIM_OP_COUNT] =
+{
+    "rate", "latency", "run", "pause", "probe", "configure", "setintf", "halt", "reset", "disconnect", "mode", "cycles"
+};
+
+enum SimLatency
+{
+    SIM_LAT_FIXED = 0,
+    SIM_LAT_UNIFORM,
+    SIM_LAT_EXP
+};
+
+/* Checks of the simulated host, on top of those of the stream analyzer. */
+enum SimViolation
+{
+    SIM_VIOL_NO_RESTART = 0,            /* No payload within a second of a restart. */
+    SIM_VIOL_STOPPED,                   /* Payload while the stream was stopped. */
+    SIM_VIOL_PAYLOAD_SIZE,              /* Payload beyond dwMaxPayloadTransferSize. */
+    SIM_VIOL_FRAME_SIZE,                /* Frame beyond dwMaxVideoFrameSize. */
+    SIM_VIOL_PROBE,                     /* Probe / commit request stalled or short. */
+    SIM_VIOL_FIRMWARE_ERROR,            /* GetBuffer / CommitBuffer errors counted by the firmware. */
+    SIM_VIOL_HEAP,                      /* Buffer heap changed by start / stop cycles. */
+    SIM_VIOL_COUNT
+};
+
+static const char *const glSimViolationNames[SIM_VIOL_COUNT] =
+{
+    "no_restart", "stopped", "payload_size", "frame_size", "probe", "firmware_error", "heap"
+};
+
+/* The script run when none is given: every fault once. */
+static const char glSimDefaultScript[] =
+    "configure\n"
+    "run 300\n"
+    "rate 50\n"
+    "run 300\n"
+    "rate 0\n"
+    "pause 50\n"
+    "run 200\n"
+    "latency exp 200\n"
+    "run 200\n"
+    "latency fixed 0\n"
+    "probe\n"
+    "run 100\n"
+    "setintf 20\n"
+    "run 200\n"
+    "setintf 20 100\n"
+    "run 200\n"
+    "reset midframe\n"
+    "run 200\n"
+    "halt midframe\n"
+    "run 200\n"
+    "disconnect midframe\n"
+    "run 100\n"
+    "configure\n"
+    "run 200\n"
+    "cycles 1000\n"
+    "run 200\n";
+
+struct SimStep
+{
+    SimOp op;
+    double arg[2] = {0, 0};
+    SimLatency latency = SIM_LAT_FIXED;
+    CyFxUVCStreamMode_t mode = CY_FX_UVC_MODE_LOSSLESS;
+    bool midFrame = false;
+    unsigned line = 0;
+};
+
+/* A violation of the analyzer, with the session it was found in. */
+struct SimEvent
+{
+    unsigned session;
+    UvcStreamEvent event;
+};
+
+struct SimState
+{
+    std::mt19937_64 rng {1};
+    Clock::time_point epoch;
+    unsigned keepEvents = 16;
+
+    /* Drain model */
+    double rateMBps = 0;
+    SimLatency latency = SIM_LAT_FIXED;
+    double latencyUs[2] = {0, 0};
+    Clock::time_point drainAt;
+
+    /* Committed probe */
+    uint32_t maxFrameBytes = 0;
+    uint32_t maxPayloadBytes = 0;
+
+    /* Session in progress */
+    bool streaming = false;             // The host expects payloads
+    unsigned session = 0;
+    UvcStream stream;
+    SimOp restartOp = SIM_OP_CONFIGURE;
+    Clock::time_point restartAt;
+    bool waitFirst = false;             // No payload of the session read yet
+    Clock::duration emptyWait {};       // Reading an empty endpoint since the restart
+    bool inFrame = false;               // The last payload did not end a frame
+    uint64_t frameCommitNs = 0;
+
+    /* Totals over the sessions */
+    UvcStreamStats total;
+    std::vector<SimEvent> events;
+    uint64_t violations[SIM_VIOL_COUNT] = {};
+    std::vector<double> bufferUs;
+    std::vector<double> frameUs;
+    std::vector<double> restartUs[SIM_OP_COUNT];
+};
+
+static SimState glSim;
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-e script] [-S seed] [-n events] [-H] [-v] [script_file]\n"
+            "  -e  script text, commands separated by ';' or new lines\n"
+            "  -S  seed of the latency distributions (default 1)\n"
+            "  -n  violations listed with their position (default 16)\n"
+            "  -H  report high speed instead of super speed to the firmware\n"
+            "  -v  echo firmware debug output\n"
+            "script commands, one per line ('#' starts a comment); without a script every fault runs once:\n"
+            "  rate MB/s                      drain bandwidth, 0 = unthrottled\n"
+            "  latency fixed|uniform|exp us [us]  time each transfer is held before the next read\n"
+            "  run ms                         read for that long\n"
+            "  pause ms                       stop reading for that long\n"
+            "  probe                          probe / commit sequence\n"
+            "  configure                      SET_CONFIGURATION 1, then probe / commit\n"
+            "  setintf [count [gap_us]]       SET_INTERFACE on the streaming interface, count times\n"
+            "  halt [midframe]                CLEAR_FEATURE(ENDPOINT_HALT) on the video endpoint\n"
+            "  reset [midframe]               bus reset, then SET_CONFIGURATION and probe / commit\n"
+            "  disconnect [midframe]          disconnect; the stream stays down until configure\n"
+            "  mode lossless|live             streaming mode of the firmware (vendor request)\n"
+            "  cycles [count]                 count SET_INTERFACE stop / start cycles between two\n"
+            "                                 disconnects (default 1000), then configure; the buffer\n"
+            "                                 heap must end as it started\n"
+            "  midframe: first read until the host is inside a frame\n",
+            prog);
+}
+
+/* Parse the script into steps. Returns false after printing the first error. */
+static bool
+Parse (
+        const std::string &text,
+        const char *name,
+        std::vector<SimStep> *steps_p)
+{
+    unsigned line = 1;
+    size_t pos = 0;
+
+    while (pos <= text.size ())
+    {
+        size_t end = text.find_first_of (";\n", pos);
+        end = (end == std::string::npos) ? text.size () : end;
+        std::string cmd = text.substr (pos, end - pos);
+        cmd = cmd.substr (0, cmd.find ('#'));
+
+        std::vector<std::string> words;
+        for (char *tok = strtok (cmd.data (), " \t\r"); tok != nullptr; tok = strtok (nullptr, " \t\r"))
+        {
+            words.emplace_back (tok);
+        }
+
+        if (!words.empty ())
+        {
+            SimStep step;
+            step.line = line;
+            unsigned op = 0;
+            while ((op < SIM_OP_COUNT) && (words[0] != glSimOpNames[op]))
+            {
+                op++;
+            }
+            if (op == SIM_OP_COUNT)
+            {
+                fprintf (stderr, "%s:%u: unknown command '%s'\n", name, line, words[0].c_str ());
+                return false;
+            }
+            step.op = static_cast<SimOp>(op);
+
+            size_t first = 1;
+            if (step.op == SIM_OP_LATENCY)
+            {
+                const char *dist = (words.size () > 1) ? words[1].c_str () : "";
+                step.latency = (strcmp (dist, "uniform") == 0) ? SIM_LAT_UNIFORM :
+                        (strcmp (dist, "exp") == 0) ? SIM_LAT_EXP : SIM_LAT_FIXED;
+                if ((step.latency == SIM_LAT_FIXED) && (strcmp (dist, "fixed") != 0))
+                {
+                    fprintf (stderr, "%s:%u: latency fixed, uniform or exp\n", name, line);
+                    return false;
+                }
+                first = 2;
+            }
+            if (step.op == SIM_OP_MODE)
+            {
+                const char *mode = (words.size () > 1) ? words[1].c_str () : "";
+                if ((strcmp (mode, "lossless") != 0) && (strcmp (mode, "live") != 0))
+                {
+                    fprintf (stderr, "%s:%u: mode lossless or live\n", name, line);
+                    return false;
+                }
+                step.mode = (strcmp (mode, "live") == 0) ? CY_FX_UVC_MODE_LIVE : CY_FX_UVC_MODE_LOSSLESS;
+                first = 2;
+            }
+            if ((words.size () > first) && (words.back () == "midframe") &&
+                    ((step.op == SIM_OP_HALT) || (step.op == SIM_OP_RESET) || (step.op == SIM_OP_DISCONNECT)))
+            {
+                step.midFrame = true;
+                words.pop_back ();
+            }
+
+            size_t needed = ((step.op == SIM_OP_RATE) || (step.op == SIM_OP_RUN) || (step.op == SIM_OP_PAUSE)) ? 1 :
+                    (step.op == SIM_OP_LATENCY) ? ((step.latency == SIM_LAT_UNIFORM) ? 2 : 1) : 0;
+            size_t allowed = (step.op == SIM_OP_SETINTF) ? 2 : (step.op == SIM_OP_CYCLES) ? 1 : needed;
+            if ((words.size () - first < needed) || (words.size () - first > allowed))
+            {
+                fprintf (stderr, "%s:%u: %s takes %zu argument(s)\n", name, line, glSimOpNames[op], needed);
+                return false;
+            }
+            step.arg[0] = (step.op == SIM_OP_SETINTF) ? 1 : (step.op == SIM_OP_CYCLES) ? 1000 : 0;
+            for (size_t i = first; i < words.size (); i++)
+            {
+                char *rest;
+                step.arg[i - first] = strtod (words[i].c_str (), &rest);
+                if ((*rest != 0) || (step.arg[i - first] < 0))
+                {
+                    fprintf (stderr, "%s:%u: bad number '%s'\n", name, line, words[i].c_str ());
+                    return false;
+                }
+            }
+            steps_p->push_back (step);
+        }
+
+        line += (end < text.size ()) && (text[end] == '\n');
+        pos = end + 1;
+    }
+    return true;
+}
+
+static uint64_t
+SteadyNs (
+        Clock::time_point t)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds> (t.time_since_epoch ()).count ());
+}
+
+static void
+Violation (
+        SimViolation kind)
+{
+    glSim.violations[kind]++;
+}
+
+static void
+FrameDone (
+        const UvcStreamFrame &frame,
+        void *)
+{
+    if (frame.eof && (glSim.maxFrameBytes != 0) && (frame.bytes > glSim.maxFrameBytes))
+    {
+        Violation (SIM_VIOL_FRAME_SIZE);
+    }
+}
+
+/* End the session in progress: the frame being assembled is cut, not checked. */
+static void
+SessionEnd (
+        void)
+{
+    if (!glSim.streaming)
+    {
+        return;
+    }
+    glSim.streaming = false;
+    UvcStreamFinish (&glSim.stream);
+
+    const UvcStreamStats &stats = glSim.stream.stats;
+    glSim.total.payloads     += stats.payloads;
+    glSim.total.payloadBytes += stats.payloadBytes;
+    glSim.total.frames       += stats.frames;
+    glSim.total.eofFrames    += stats.eofFrames;
+    glSim.total.jpegFrames   += stats.jpegFrames;
+    glSim.total.metaFrames   += stats.metaFrames;
+    for (unsigned i = 0; i < UVC_VIOL_COUNT; i++)
+    {
+        glSim.total.violations[i] += stats.violations[i];
+    }
+    for (const UvcStreamEvent &event : stats.events)
+    {
+        if (glSim.events.size () < glSim.keepEvents)
+        {
+            glSim.events.push_back ({glSim.session, event});
+        }
+    }
+}
+
+/* End the session in progress; the caller sends the event that starts the next one. */
+static void
+SessionRestart (
+        SimOp op)
+{
+    SessionEnd ();
+
+    UvcStreamConfig cfg;
+    cfg.clockHz = CY_FX_UVC_CLOCK_HZ;
+    cfg.keepEvents = glSim.keepEvents;
+    cfg.frameCb = FrameDone;
+    UvcStreamInit (&glSim.stream, cfg);
+
+    glSim.streaming = true;
+    glSim.session++;
+    glSim.restartOp = op;
+    glSim.restartAt = Clock::now ();
+    glSim.waitFirst = true;
+    glSim.emptyWait = {};
+    glSim.inFrame = false;
+}
+
+static void
+Payload (
+        const FxHostBuffer &buf,
+        Clock::time_point readAt)
+{
+    uint64_t readNs = SteadyNs (readAt);
+
+    if (!glSim.streaming)
+    {
+        Violation (SIM_VIOL_STOPPED);
+        return;
+    }
+    if (glSim.waitFirst)
+    {
+        glSim.waitFirst = false;
+        glSim.restartUs[glSim.restartOp].push_back ((static_cast<double>(buf.commitNs) -
+                    static_cast<double>(SteadyNs (glSim.restartAt))) / 1e3);
+    }
+    glSim.bufferUs.push_back ((static_cast<double>(readNs) - static_cast<double>(buf.commitNs)) / 1e3);
+    if ((glSim.maxPayloadBytes != 0) && (buf.count > glSim.maxPayloadBytes))
+    {
+        Violation (SIM_VIOL_PAYLOAD_SIZE);
+    }
+
+    if (buf.count >= 2)
+    {
+        if (!glSim.inFrame)
+        {
+            glSim.frameCommitNs = buf.commitNs;
+        }
+        glSim.inFrame = ((buf.data[1] & CY_FX_UVC_HEADER_EOF) == 0);
+        if (!glSim.inFrame)
+        {
+            glSim.frameUs.push_back ((static_cast<double>(readNs) - static_cast<double>(glSim.frameCommitNs)) / 1e3);
+        }
+    }
+
+    UvcPayload payload;
+    payload.data = buf.data;
+    payload.length = payload.captured = buf.count;
+    payload.ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds> (readAt - glSim.epoch).count ());
+    UvcStreamPayload (&glSim.stream, payload);
+}
+
+/* Time the host keeps a transfer before it reads the next one. */
+static double
+HoldUs (
+        void)
+{
+    switch (glSim.latency)
+    {
+        case SIM_LAT_UNIFORM:
+            return std::uniform_real_distribution<double> (glSim.latencyUs[0], glSim.latencyUs[1]) (glSim.rng);
+        case SIM_LAT_EXP:
+            return (glSim.latencyUs[0] > 0) ?
+                    std::exponential_distribution<double> (1.0 / glSim.latencyUs[0]) (glSim.rng) : 0.0;
+        default:
+            return glSim.latencyUs[0];
+    }
+}
+
+/* Read the video endpoint until the deadline; with midFrame, stop early once the host is
+   inside a frame. Returns false if midFrame was asked for and not reached. */
+static bool
+Drain (
+        Clock::time_point deadline,
+        bool midFrame)
+{
+    FxHostBuffer buf;
+
+    for (;;)
+    {
+        Clock::time_point now = Clock::now ();
+        if (midFrame && glSim.streaming && glSim.inFrame)
+        {
+            return true;
+        }
+        if (now >= deadline)
+        {
+            return !midFrame;
+        }
+
+        if ((glSim.rateMBps > 0) && (glSim.drainAt > now))
+        {
+            std::this_thread::sleep_until (std::min (glSim.drainAt, deadline));
+            continue;
+        }
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds> (deadline - now).count () + 1;
+        if (!FxHostBulkRead (&buf, static_cast<unsigned>(std::min<long long> (left, SIM_POLL_MS))))
+        {
+            /* The stream has to come back while the host reads, however long it paused. */
+            glSim.emptyWait += Clock::now () - now;
+            if (glSim.streaming && glSim.waitFirst &&
+                    (glSim.emptyWait > std::chrono::duration<double> (SIM_RESTART_TIMEOUT_SEC)))
+            {
+                Violation (SIM_VIOL_NO_RESTART);
+                glSim.waitFirst = false;
+            }
+            continue;
+        }
+        Clock::time_point readAt = Clock::now ();
+        Payload (buf, readAt);
+
+        double holdUs = HoldUs ();
+        if (holdUs > 0)
+        {
+            std::this_thread::sleep_for (std::chrono::duration<double, std::micro> (holdUs));
+        }
+        FxHostBulkRelease ();
+
+        if (glSim.rateMBps > 0)
+        {
+            /* No credit for more than a millisecond spent not reading. */
+            glSim.drainAt = std::max (glSim.drainAt, readAt - std::chrono::milliseconds (1)) +
+                    std::chrono::duration_cast<Clock::duration> (
+                            std::chrono::duration<double> (buf.count / (glSim.rateMBps * 1e6)));
+        }
+    }
+}
+
+static uint32_t
+Le32 (
+        const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/* The probe / commit sequence of the UVC driver: read the current probe, propose it,
+   read back what the device made of it and commit that. */
+static void
+ProbeCommit (
+        void)
+{
+    constexpr uint8_t rqtIn = CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_CLASS_RQT | CY_U3P_USB_TARGET_INTF;
+    constexpr uint8_t rqtOut = CY_U3P_USB_CLASS_RQT | CY_U3P_USB_TARGET_INTF;
+    uint8_t probe[CY_FX_UVC_MAX_PROBE_SETTING];
+    bool ok = true;
+
+    ok = ok && (FxHostControl (rqtIn, CY_FX_USB_UVC_GET_CUR_REQ, CY_FX_USB_UVC_VS_PROBE_CONTROL,
+                CY_FX_UVC_INTERFACE_VS, probe, sizeof (probe)) == sizeof (probe));
+    ok = ok && (FxHostControl (rqtOut, CY_FX_USB_UVC_SET_CUR_REQ, CY_FX_USB_UVC_VS_PROBE_CONTROL,
+                CY_FX_UVC_INTERFACE_VS, probe, sizeof (probe)) == sizeof (probe));
+    ok = ok && (FxHostControl (rqtIn, CY_FX_USB_UVC_GET_CUR_REQ, CY_FX_USB_UVC_VS_PROBE_CONTROL,
+                CY_FX_UVC_INTERFACE_VS, probe, sizeof (probe)) == sizeof (probe));
+    ok = ok && (FxHostControl (rqtOut, CY_FX_USB_UVC_SET_CUR_REQ, CY_FX_USB_UVC_VS_COMMIT_CONTROL,
+                CY_FX_UVC_INTERFACE_VS, probe, sizeof (probe)) == sizeof (probe));
+    if (!ok)
+    {
+        Violation (SIM_VIOL_PROBE);
+        return;
+    }
+    glSim.maxFrameBytes   = Le32 (&probe[18]);
+    glSim.maxPayloadBytes = Le32 (&probe[22]);
+}
+
+static void
+Configure (
+        SimOp op)
+{
+    SessionRestart (op);
+    FxHostUsbEvent (CY_U3P_USB_EVENT_SETCONF, 1);
+    ProbeCommit ();
+}
+
+/* Buffer heap figures of CyFxDmaBufferHeapInfoGet compared across start / stop cycles. */
+struct SimHeap
+{
+    uint32_t size, available, fragments, largest, sessions, fallbacks;
+};
+
+static SimHeap
+HeapInfo (
+        void)
+{
+    SimHeap heap;
+    CyFxDmaBufferHeapInfoGet (&heap.size, &heap.available, &heap.fragments, &heap.largest,
+            &heap.sessions, &heap.fallbacks);
+    return heap;
+}
+
+/* Stop / start the stream count times with SET_INTERFACE, each a CyFxUVCApplnStop and
+ * CyFxUVCApplnStart with a session arena, between two disconnects so that no stream
+ * holds the heap while it is read. The free bytes, free runs and longest free run must
+ * come back, and no allocation may have fallen back to the heap. */
+static void
+Cycles (
+        const SimStep &step)
+{
+    unsigned count = static_cast<unsigned>(step.arg[0]);
+
+    SessionEnd ();
+    FxHostUsbEvent (CY_U3P_USB_EVENT_DISCONNECT, 0);
+    SimHeap before = HeapInfo ();
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        SessionRestart (step.op);
+        FxHostUsbEvent (CY_U3P_USB_EVENT_SETINTF, CY_FX_UVC_INTERFACE_VS << 8);
+    }
+
+    SessionEnd ();
+    FxHostUsbEvent (CY_U3P_USB_EVENT_DISCONNECT, 0);
+    SimHeap after = HeapInfo ();
+
+    if ((after.available != before.available) || (after.fragments != before.fragments) ||
+            (after.largest != before.largest) || (after.fallbacks != before.fallbacks) ||
+            (after.sessions - before.sessions != count))
+    {
+        Violation (SIM_VIOL_HEAP);
+        fprintf (stderr, "line %u: buffer heap after %u cycles: %u free bytes in %u runs, longest %u, "
+                "%u sessions, %u fallbacks; before: %u in %u runs, longest %u, %u sessions, %u fallbacks\n",
+                step.line, count, after.available, after.fragments, after.largest, after.sessions,
+                after.fallbacks, before.available, before.fragments, before.largest, before.sessions,
+                before.fallbacks);
+    }
+
+    Configure (step.op);
+}
+
+static void
+Step (
+        const SimStep &step)
+{
+    if (step.midFrame && !Drain (Clock::now () + std::chrono::seconds (1), true))
+    {
+        fprintf (stderr, "line %u: no frame in progress, %s sent between frames\n", step.line, glSimOpNames[step.op]);
+    }
+
+    switch (step.op)
+    {
+        case SIM_OP_RATE:
+            glSim.rateMBps = step.arg[0];
+            glSim.drainAt = Clock::now ();
+            break;
+        case SIM_OP_LATENCY:
+            glSim.latency = step.latency;
+            glSim.latencyUs[0] = step.arg[0];
+            glSim.latencyUs[1] = std::max (step.arg[0], step.arg[1]);
+            break;
+        case SIM_OP_RUN:
+            Drain (Clock::now () + std::chrono::duration_cast<Clock::duration> (
+                        std::chrono::duration<double, std::milli> (step.arg[0])), false);
+            break;
+        case SIM_OP_PAUSE:
+            std::this_thread::sleep_for (std::chrono::duration<double, std::milli> (step.arg[0]));
+            break;
+        case SIM_OP_PROBE:
+            ProbeCommit ();
+            break;
+        case SIM_OP_CONFIGURE:
+            Configure (step.op);
+            break;
+        case SIM_OP_SETINTF:
+            for (unsigned i = 0; i < static_cast<unsigned>(step.arg[0]); i++)
+            {
+                if ((i != 0) && (step.arg[1] > 0))
+                {
+                    std::this_thread::sleep_for (std::chrono::duration<double, std::micro> (step.arg[1]));
+                }
+                SessionRestart (step.op);
+                FxHostUsbEvent (CY_U3P_USB_EVENT_SETINTF, CY_FX_UVC_INTERFACE_VS << 8);
+            }
+            break;
+        case SIM_OP_HALT:
+            SessionRestart (step.op);
+            FxHostControl (CY_U3P_USB_TARGET_ENDPT, CY_U3P_USB_SC_CLEAR_FEATURE, CY_U3P_USBX_FS_EP_HALT,
+                    CY_FX_EP_BULK_VIDEO, nullptr, 0);
+            break;
+        case SIM_OP_RESET:
+        {
+            /* The restart latency counts from the reset, not from the re-enumeration. */
+            SessionEnd ();
+            Clock::time_point resetAt = Clock::now ();
+            FxHostUsbEvent (CY_U3P_USB_EVENT_RESET, 0);
+            Configure (step.op);
+            glSim.restartAt = resetAt;
+            break;
+        }
+        case SIM_OP_DISCONNECT:
+            SessionEnd ();
+            FxHostUsbEvent (CY_U3P_USB_EVENT_DISCONNECT, 0);
+            break;
+        case SIM_OP_CYCLES:
+            Cycles (step);
+            break;
+        case SIM_OP_MODE:
+        {
+            static CyFxUVCLive_t live;
+            if (FxHostControl (CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_VENDOR_RQT, CY_FX_UVC_VENDOR_RQT_LIVE_MODE,
+                        CY_FX_UVC_LIVE_SELECT | (step.mode << 8), 0, &live, sizeof (live)) != static_cast<int>(sizeof (live)))
+            {
+                fprintf (stderr, "line %u: LIVE_MODE failed\n", step.line);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/* Percentiles of a sample, in the unit of the sample. */
+static void
+Percentiles (
+        const char *name,
+        std::vector<double> &sample)
+{
+    if (sample.empty ())
+    {
+        return;
+    }
+    std::sort (sample.begin (), sample.end ());
+    auto at = [&] (double fraction) {
+        return sample[std::min (sample.size () - 1, static_cast<size_t>(std::ceil (fraction * sample.size ())) - 1)];
+    };
+    printf ("  %-12s %8zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, sample.size (), at (0.50), at (0.90),
+            at (0.99), at (0.999), sample.back ());
+}
+
+static void
+Report (
+        const CyFxUVCStats_t &stats,
+        const CyFxUVCStatsLog_t &log,
+        double seconds)
+{
+    const UvcStreamStats &total = glSim.total;
+
+    printf ("sessions         %u in %.2f s\n", glSim.session, seconds);
+    printf ("payloads         %llu, %.1f MB\n", static_cast<unsigned long long>(total.payloads), total.payloadBytes / 1e6);
+    printf ("frames           %llu: %llu with EOF, %llu MJPEG checked good, %llu with metadata\n",
+            static_cast<unsigned long long>(total.frames), static_cast<unsigned long long>(total.eofFrames),
+            static_cast<unsigned long long>(total.jpegFrames), static_cast<unsigned long long>(total.metaFrames));
+    printf ("firmware         %u starts, %u stops, %u restarts, %u resets, %u disconnects, %u frames dropped\n",
+            stats.eventCount[CY_FX_UVC_STATS_EVT_STREAM_START], stats.eventCount[CY_FX_UVC_STATS_EVT_STREAM_STOP],
+            stats.eventCount[CY_FX_UVC_STATS_EVT_STREAM_RESTART], stats.eventCount[CY_FX_UVC_STATS_EVT_USB_RESET],
+            stats.eventCount[CY_FX_UVC_STATS_EVT_USB_DISCONNECT], stats.framesDropped);
+    printf ("event log        %u records, %u reused, pool low %u\n", log.count, log.overwritten, log.minFree);
+
+    printf ("latency us       %8s %10s %10s %10s %10s %10s\n", "count", "p50", "p90", "p99", "p99.9", "max");
+    Percentiles ("buffer", glSim.bufferUs);
+    Percentiles ("frame", glSim.frameUs);
+    for (unsigned op = 0; op < SIM_OP_COUNT; op++)
+    {
+        Percentiles (glSimOpNames[op], glSim.restartUs[op]);
+    }
+
+    uint64_t count = 0;
+    for (unsigned i = 0; i < UVC_VIOL_COUNT; i++)
+    {
+        count += total.violations[i];
+    }
+    for (unsigned i = 0; i < SIM_VIOL_COUNT; i++)
+    {
+        count += glSim.violations[i];
+    }
+    printf ("violations       %llu\n", static_cast<unsigned long long>(count));
+    for (unsigned i = 0; i < UVC_VIOL_COUNT; i++)
+    {
+        if (total.violations[i] != 0)
+        {
+            printf ("  %-14s %llu\n", glUvcStreamViolationNames[i], static_cast<unsigned long long>(total.violations[i]));
+        }
+    }
+    for (unsigned i = 0; i < SIM_VIOL_COUNT; i++)
+    {
+        if (glSim.violations[i] != 0)
+        {
+            printf ("  %-14s %llu\n", glSimViolationNames[i], static_cast<unsigned long long>(glSim.violations[i]));
+        }
+    }
+    for (const SimEvent &ev : glSim.events)
+    {
+        printf ("  session %u, payload %llu, frame %llu: %s\n", ev.session,
+                static_cast<unsigned long long>(ev.event.payload), static_cast<unsigned long long>(ev.event.frame),
+                glUvcStreamViolationNames[ev.event.kind]);
+    }
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    FxHostConfig cfg;
+    std::string script, name = "script";
+    int opt;
+
+    cfg.sleepScale = 0;
+    while ((opt = getopt (argc, argv, "e:S:n:Hvh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'e': script += optarg; script += '\n'; break;
+            case 'S': glSim.rng.seed (strtoull (optarg, nullptr, 0)); break;
+            case 'n': glSim.keepEvents = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'H': cfg.speed = CY_U3P_HIGH_SPEED; break;
+            case 'v': cfg.verbose = true; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+    if (optind + 1 == argc)
+    {
+        FILE *file_p = fopen (argv[optind], "r");
+        if (file_p == nullptr)
+        {
+            perror (argv[optind]);
+            return 1;
+        }
+        char chunk[4096];
+        size_t n;
+        while ((n = fread (chunk, 1, sizeof (chunk), file_p)) != 0)
+        {
+            script.append (chunk, n);
+        }
+        fclose (file_p);
+        name = argv[optind];
+    }
+    else if (optind != argc)
+    {
+        Usage (argv[0]);
+        return 1;
+    }
+
+    std::vector<SimStep> steps;
+    if (!Parse (script.empty () ? glSimDefaultScript : script, name.c_str (), &steps))
+    {
+        return 1;
+    }
+
+    if (!FxHostStart (cfg, 1000))
+    {
+        fprintf (stderr, "firmware did not connect\n");
+        return 1;
+    }
+    glSim.epoch = Clock::now ();
+    for (const SimStep &step : steps)
+    {
+        Step (step);
+    }
+    SessionEnd ();
+    double seconds = std::chrono::duration<double> (Clock::now () - glSim.epoch).count ();
+
+    static CyFxUVCStats_t stats;
+    if (FxHostControl (CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_VENDOR_RQT, CY_FX_UVC_VENDOR_RQT_GET_STATS, 0, 0,
+                &stats, sizeof (stats)) != static_cast<int>(sizeof (stats)))
+    {
+        fprintf (stderr, "GET_STATS failed\n");
+        return 1;
+    }
+    if ((stats.eventCount[CY_FX_UVC_STATS_EVT_GETBUF_ERROR] != 0) || (stats.eventCount[CY_FX_UVC_STATS_EVT_COMMIT_ERROR] != 0))
+    {
+        glSim.violations[SIM_VIOL_FIRMWARE_ERROR] += stats.eventCount[CY_FX_UVC_STATS_EVT_GETBUF_ERROR] +
+                stats.eventCount[CY_FX_UVC_STATS_EVT_COMMIT_ERROR];
+    }
+    static CyFxUVCStatsLog_t log;
+    if (FxHostControl (CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_VENDOR_RQT, CY_FX_UVC_VENDOR_RQT_GET_EVENTS, 0, 0,
+                &log, sizeof (log)) != static_cast<int>(sizeof (log)))
+    {
+        fprintf (stderr, "GET_EVENTS failed\n");
+        return 1;
+    }
+    static CyFxUVCRing_t ring;
+    bool hasRing = FxHostControl (CY_FX_USB_RQT_DIR_IN | CY_U3P_USB_VENDOR_RQT, CY_FX_UVC_VENDOR_RQT_GET_RING, 0, 0,
+            &ring, sizeof (ring)) == static_cast<int>(sizeof (ring));
+    FxHostUsbEvent (CY_U3P_USB_EVENT_DISCONNECT, 0);
+
+    Report (stats, log, seconds);
+    if (hasRing)
+    {
+        /* A RING=1 build: where the adaptive ring ended up. */
+        printf ("ring: depth %u (%u to %u), %u windows, %u grows, %u shrinks, %u deferred, %u failed\n",
+                ring.count, ring.minCount, ring.maxCount, ring.windows, ring.grows, ring.shrinks, ring.deferred,
+                ring.failed);
+    }
+
+    int status = 0;
+    for (unsigned i = 0; i < UVC_VIOL_COUNT; i++)
+    {
+        status = (glSim.total.violations[i] != 0) ? 2 : status;
+    }
+    for (unsigned i = 0; i < SIM_VIOL_COUNT; i++)
+    {
+        status = (glSim.violations[i] != 0) ? 2 : status;
+    }
+
+    /* Streaming threads are still parked; do not wait for them. */
+    fflush (stdout);
+    _exit (status);
+}
+
+/*[]*/
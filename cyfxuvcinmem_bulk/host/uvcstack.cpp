@@ -0,0 +1,179 @@
+/*
+ ## Thread stack usage reader for the UVC bulk streamer (uvcstack.cpp)
+ ## ===========================
+*/
+
+/* Reads the CY_FX_UVC_VENDOR_RQT_GET_STACKS vendor request and prints the stack
+ * size and high-water mark of every thread, with the driver heap usage. High-water
+ * marks only grow, so read them after the device has been through the scenarios of
+ * interest (enumeration, streaming, stop / restart). The last line gives the build
+ * option that sizes the UVC application stack from the measurement.
+ *
+ * With -c the streaming interface is selected again the given number of times, each
+ * selection stopping and restarting the streaming session on the device, and the
+ * buffer heap is compared before and after: with the session arena it must come back
+ * identical. The interface must not be held by the uvcvideo driver. */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "cyfxuvcstack.h"
+#include "uvchost.h"
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d vid:pid] [-c cycles]\n"
+            "  -d  device to read (default %04x:%04x)\n"
+            "  -c  stop / start the streaming session this many times and compare the buffer heap\n",
+            prog, CY_FX_HOST_DEFAULT_VID, CY_FX_HOST_DEFAULT_PID);
+}
+
+/* Read the stack block; false after printing the reason. */
+static bool
+ReadStacks (
+        int fd,
+        CyFxUVCStacks_t *stacks_p)
+{
+    int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_STACKS, 0, stacks_p, sizeof (*stacks_p));
+    if (len < 0)
+    {
+        fprintf (stderr, "GET_STACKS failed: %s\n", strerror (errno));
+        return false;
+    }
+    if ((len != static_cast<int>(sizeof (*stacks_p))) || (stacks_p->version != CY_FX_UVC_STACK_VERSION))
+    {
+        fprintf (stderr, "unexpected stack block (%d bytes, version %u)\n", len, stacks_p->version);
+        return false;
+    }
+    return true;
+}
+
+static void
+PrintBufferHeap (
+        const char *label,
+        const CyFxUVCStacks_t &stacks)
+{
+    printf ("%sbuffer heap: %u bytes, %u free in %u runs, largest %u; %u sessions, %u arena fallbacks\n", label,
+            stacks.bufHeapSize, stacks.bufHeapAvailable, stacks.bufHeapFragments, stacks.bufHeapLargest,
+            stacks.arenaSessions, stacks.arenaFallbacks);
+}
+
+/* Restart the streaming session cycles times; true if the buffer heap came back as it was. */
+static bool
+CycleSessions (
+        int fd,
+        unsigned cycles)
+{
+    static CyFxUVCStacks_t before, after;
+
+    if (!ReadStacks (fd, &before))
+    {
+        return false;
+    }
+    for (unsigned i = 0; i < cycles; i++)
+    {
+        if (UvcHostSetInterface (fd, CY_FX_UVC_INTERFACE_VS, 0) < 0)
+        {
+            fprintf (stderr, "SET_INTERFACE failed after %u cycles: %s\n", i, strerror (errno));
+            return false;
+        }
+    }
+    if (!ReadStacks (fd, &after))
+    {
+        return false;
+    }
+
+    PrintBufferHeap ("before: ", before);
+    PrintBufferHeap ("after:  ", after);
+    bool same = (before.bufHeapAvailable == after.bufHeapAvailable) &&
+        (before.bufHeapFragments == after.bufHeapFragments) && (before.bufHeapLargest == after.bufHeapLargest);
+    printf ("%u cycles, %u sessions released: buffer heap %s\n", cycles, after.arenaSessions - before.arenaSessions,
+            same ? "unchanged" : "CHANGED");
+    return same;
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    unsigned cycles = 0;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:c:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'c': cycles = static_cast<unsigned>(atoi (optarg)); break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    if (cycles != 0)
+    {
+        bool same = CycleSessions (fd, cycles);
+        close (fd);
+        return same ? 0 : 1;
+    }
+
+    static CyFxUVCStacks_t stacks;
+    bool ok = ReadStacks (fd, &stacks);
+    close (fd);
+    if (!ok)
+    {
+        return 1;
+    }
+
+    uint32_t totalSize = 0, totalUsed = 0;
+    printf ("%-16s %8s %8s %8s %5s\n", "thread", "size", "used", "spare", "used%");
+    for (uint32_t i = 0; i < stacks.threadCount; i++)
+    {
+        const CyFxUVCStackThread_t &t = stacks.thread[i];
+        printf ("%-16.*s %8u %8u %8u %4.0f%%%s\n", static_cast<int>(CY_FX_UVC_STACK_NAME_LEN), t.name,
+                t.stackSize, t.stackUsed, t.stackSize - t.stackUsed,
+                (t.stackSize != 0) ? (100.0 * t.stackUsed / t.stackSize) : 0.0,
+                (i == stacks.appThread) ? "  <- UVC application" : "");
+        totalSize += t.stackSize;
+        totalUsed += t.stackUsed;
+    }
+    printf ("%-16s %8u %8u %8u\n", "total", totalSize, totalUsed, totalSize - totalUsed);
+    if (stacks.threadTotal > stacks.threadCount)
+    {
+        printf ("(%u more threads not listed)\n", stacks.threadTotal - stacks.threadCount);
+    }
+    printf ("driver heap: %u bytes, %u free in %u fragments\n", stacks.heapSize, stacks.heapAvailable,
+            stacks.heapFragments);
+    PrintBufferHeap ("", stacks);
+
+    if (stacks.threadCount > stacks.appThread)
+    {
+        uint32_t used = stacks.thread[stacks.appThread].stackUsed;
+        printf ("\nbuild with CY_FX_UVC_APP_STACK_USED=%u for a %u byte UVC stack (now %u)\n", used,
+                UVC_APP_THREAD_STACK_FOR (used), stacks.thread[stacks.appThread].stackSize);
+    }
+    return 0;
+}
+
+/*[]*/
@@ -0,0 +1,211 @@
+/*
+ ## Streaming statistics poller for the UVC bulk streamer (uvcstat.cpp)
+ ## ===========================
+*/
+
+/* Polls the CY_FX_UVC_VENDOR_RQT_GET_STATS vendor request of a connected streamer
+ * through usbdevfs and prints one CSV line per poll: the raw counters, the rates
+ * over the poll interval and the GetBuffer wait times in microseconds. The output
+ * can be plotted with uvcstat.plt (gnuplot). Control transfers to the device
+ * recipient do not need the interface to be claimed, so this runs alongside the
+ * uvcvideo driver while a capture application streams. With -e it reads the event log
+ * (CY_FX_UVC_VENDOR_RQT_GET_EVENTS) once instead and prints one line per event. */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+#include "uvchost.h"
+
+static const char *const glEventNames[CY_FX_UVC_STATS_EVT_COUNT] =
+{
+    "getbuf_err", "commit_err", "lpm_u0", "starts", "stops", "restarts", "resets", "disconnects",
+    "heap_corrupt"
+};
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-d vid:pid] [-i interval_ms] [-n count] [-c] [-e]\n"
+            "  -d  device to poll (default %04x:%04x)\n"
+            "  -i  poll interval in milliseconds (default 1000)\n"
+            "  -n  number of samples, 0 = until interrupted (default 0)\n"
+            "  -c  clear the counters on the device after every read\n"
+            "  -e  print the log of the latest events, oldest first (-c clears it)\n",
+            prog, CY_FX_HOST_DEFAULT_VID, CY_FX_HOST_DEFAULT_PID);
+}
+
+static double
+WaitUs (
+        uint32_t ticks,
+        uint32_t clockHz)
+{
+    return (clockHz != 0) ? (ticks * 1e6 / clockHz) : 0.0;
+}
+
+/* Print the event log: the age of each event in milliseconds and its name. */
+static int
+PrintLog (
+        int fd,
+        bool clear)
+{
+    CyFxUVCStatsLog_t log = {};
+    int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_EVENTS, clear ? CY_FX_UVC_STATS_CLEAR : 0,
+            &log, sizeof (log));
+    if (len < 0)
+    {
+        fprintf (stderr, "GET_EVENTS failed: %s\n", strerror (errno));
+        return 1;
+    }
+    if ((len != static_cast<int>(sizeof (log))) || (log.version != CY_FX_UVC_STATS_LOG_VERSION) ||
+            (log.count > CY_FX_UVC_STATS_LOG_DEPTH))
+    {
+        fprintf (stderr, "unexpected event log (%d bytes, version %u)\n", len, log.version);
+        return 1;
+    }
+
+    printf ("age_ms,uptime_ms,event\n");
+    for (uint32_t i = 0; i < log.count; i++)
+    {
+        const CyFxUVCStatsLogRecord_t &record = log.record[i];
+        printf ("%u,%u,%s\n", log.uptimeMs - record.timeMs, record.timeMs,
+                (record.event < CY_FX_UVC_STATS_EVT_COUNT) ? glEventNames[record.event] : "?");
+    }
+    printf ("# %u overwritten, pool low %u of %u\n", log.overwritten, log.minFree, CY_FX_UVC_STATS_LOG_DEPTH);
+    return 0;
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    uint16_t vid = CY_FX_HOST_DEFAULT_VID, pid = CY_FX_HOST_DEFAULT_PID;
+    unsigned intervalMs = 1000, count = 0;
+    bool clear = false, eventLog = false;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:i:n:ceh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd':
+                if (!UvcHostParseVidPid (optarg, &vid, &pid))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'i': intervalMs = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'n': count = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'c': clear = true; break;
+            case 'e': eventLog = true; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+
+    int fd = UvcHostOpen (vid, pid);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    if (eventLog)
+    {
+        int status = PrintLog (fd, clear);
+        close (fd);
+        return status;
+    }
+
+    printf ("time_s,uptime_ms,frames,buffers,bytes,fps,mbps,wait_min_us,wait_avg_us,wait_max_us");
+    for (const char *name : glEventNames)
+    {
+        printf (",%s", name);
+    }
+    printf (",dropped\n");
+
+    CyFxUVCStats_t prev = {}, cur = {};
+    uint64_t prevBytes = 0;
+    bool havePrev = false;
+    timespec start;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    for (unsigned sample = 0; (count == 0) || (sample < count); sample++)
+    {
+        int len = UvcHostVendorIn (fd, CY_FX_UVC_VENDOR_RQT_GET_STATS, clear ? CY_FX_UVC_STATS_CLEAR : 0,
+                &cur, sizeof (cur));
+        if (len < 0)
+        {
+            fprintf (stderr, "GET_STATS failed: %s\n", strerror (errno));
+            break;
+        }
+        if ((len < static_cast<int>(offsetof (CyFxUVCStats_t, eventCount))) || (cur.version != CY_FX_UVC_STATS_VERSION))
+        {
+            fprintf (stderr, "unexpected statistics block (%d bytes, version %u)\n", len, cur.version);
+            break;
+        }
+
+        /* A device with fewer events sends a shorter block: the missing ones are left empty. */
+        uint32_t covered = (cur.length < static_cast<uint32_t>(len)) ? cur.length : static_cast<uint32_t>(len);
+        uint32_t events  = (covered > offsetof (CyFxUVCStats_t, eventCount)) ?
+                static_cast<uint32_t>((covered - offsetof (CyFxUVCStats_t, eventCount)) / sizeof (uint32_t)) : 0;
+
+        timespec now;
+        clock_gettime (CLOCK_MONOTONIC, &now);
+        double t = static_cast<double>(now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+        uint64_t bytes = (static_cast<uint64_t>(cur.bytesSentHi) << 32) | cur.bytesSentLo;
+
+        /* Rates use the device clock; with -c every sample is already a delta. */
+        double fps = 0, mbps = 0;
+        if (clear || havePrev)
+        {
+            uint32_t frames = clear ? cur.framesSent : cur.framesSent - prev.framesSent;
+            uint64_t sent   = clear ? bytes : bytes - prevBytes;
+            uint32_t ms     = cur.uptimeMs - (clear ? cur.clearedMs : prev.uptimeMs);
+            if (ms != 0)
+            {
+                fps  = frames * 1000.0 / ms;
+                mbps = static_cast<double>(sent) / 1000.0 / ms;
+            }
+        }
+
+        printf ("%.3f,%u,%u,%u,%llu,%.2f,%.3f,%.2f,%.2f,%.2f", t, cur.uptimeMs, cur.framesSent,
+                cur.buffersCommitted, static_cast<unsigned long long>(bytes), fps, mbps,
+                WaitUs (cur.waitMinTicks, cur.clockHz), WaitUs (cur.waitAvgTicks, cur.clockHz),
+                WaitUs (cur.waitMaxTicks, cur.clockHz));
+        for (uint32_t ev = 0; ev < CY_FX_UVC_STATS_EVT_COUNT; ev++)
+        {
+            if (ev < events)
+            {
+                printf (",%u", cur.eventCount[ev]);
+            }
+            else
+            {
+                printf (",");
+            }
+        }
+        printf (",%u\n", cur.framesDropped);
+        fflush (stdout);
+
+        prev = cur;
+        prevBytes = bytes;
+        havePrev = true;
+
+        if ((count == 0) || (sample + 1 < count))
+        {
+            usleep (intervalMs * 1000);
+        }
+    }
+
+    close (fd);
+    return 0;
+}
+
+/*[]*/
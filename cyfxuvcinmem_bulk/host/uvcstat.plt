@@ -0,0 +1,24 @@
+# gnuplot script for the CSV written by uvcstat.
+#   build/uvcstat -i 500 > stats.csv
+#   gnuplot -e "csv='stats.csv'" uvcstat.plt
+
+if (!exists("csv")) csv = 'stats.csv'
+
+set datafile separator ','
+set key autotitle columnhead
+set xlabel 'time [s]'
+set multiplot layout 3,1
+
+set ylabel 'frames/s'
+plot csv using 'time_s':'fps' with lines
+
+set ylabel 'MB/s'
+plot csv using 'time_s':'mbps' with lines
+
+set ylabel 'GetBuffer wait [us]'
+plot csv using 'time_s':'wait_min_us' with lines, \
+     csv using 'time_s':'wait_avg_us' with lines, \
+     csv using 'time_s':'wait_max_us' with lines
+
+unset multiplot
+pause mouse close
@@ -0,0 +1,526 @@
+/*
+ ## UVC bulk payload stream analyzer (uvcstream.cpp)
+ ## ===========================
+*/
+
+/* The per-payload work is a header decode and a copy of the payload data into the frame
+ * buffer; the frame is checked once, at its EOF. The MJPEG check walks the marker
+ * segments and scans the entropy coded data for 0xFF bytes with UvcStreamScanFF, which
+ * compares 64 bytes per round (SSE2 or AVX2 on x86-64, NEON on AArch64): in MJPEG data
+ * a 0xFF byte comes every few hundred bytes, so most rounds are a load, a compare and a
+ * branch not taken. */
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "cyfxuvcpayload.h"
+#include "cyfxuvcmeta.h"
+#include "uvcstream.h"
+
+constexpr uint8_t UVC_BFH_ERR = 1 << 6;                 // Error bit of the bit field header
+
+constexpr uint8_t JPEG_MARKER = 0xFF;
+constexpr uint8_t JPEG_SOI = 0xD8;
+constexpr uint8_t JPEG_EOI = 0xD9;
+constexpr uint8_t JPEG_SOS = 0xDA;
+constexpr uint8_t JPEG_RST0 = 0xD0;
+constexpr uint8_t JPEG_RST7 = 0xD7;
+constexpr uint8_t JPEG_TEM = 0x01;
+
+const char *const glUvcStreamViolationNames[UVC_VIOL_COUNT] =
+{
+    "header_length", "header_eoh", "header_fields", "header_err", "fid_no_eof", "fid_after_eof",
+    "pts_changed", "pts_backwards", "scr_backwards", "jpeg_no_soi", "jpeg_no_eoi", "jpeg_marker",
+    "jpeg_trailing", "meta_sequence", "meta_size", "urb_error"
+};
+
+void
+UvcStreamSeries::Add (
+        double value)
+{
+    min = ((count == 0) || (value < min)) ? value : min;
+    max = ((count == 0) || (value > max)) ? value : max;
+    sum += value;
+    sumSq += value * value;
+    count++;
+}
+
+double
+UvcStreamSeries::Mean (
+        void) const
+{
+    return (count != 0) ? (sum / count) : 0.0;
+}
+
+double
+UvcStreamSeries::StdDev (
+        void) const
+{
+    if (count < 2)
+    {
+        return 0.0;
+    }
+    double mean = Mean ();
+    double var = (sumSq / count) - (mean * mean);
+    return (var > 0) ? std::sqrt (var) : 0.0;
+}
+
+static uint32_t
+Le32 (
+        const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/* First 0xFF of a short run: the tail of the vector loops, or the block they found one in. */
+static size_t
+ScanFFScalar (
+        const uint8_t *p,
+        size_t n)
+{
+    const void *hit = memchr (p, JPEG_MARKER, n);
+    return (hit != nullptr) ? static_cast<size_t>(static_cast<const uint8_t *>(hit) - p) : n;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__ ((target ("avx2"))) static size_t
+ScanFFAvx2 (
+        const uint8_t *p,
+        size_t n)
+{
+    const __m256i ff = _mm256_set1_epi8 (static_cast<char>(JPEG_MARKER));
+    size_t i = 0;
+
+    for (; i + 64 <= n; i += 64)
+    {
+        __m256i a = _mm256_cmpeq_epi8 (_mm256_loadu_si256 (reinterpret_cast<const __m256i *>(p + i)), ff);
+        __m256i b = _mm256_cmpeq_epi8 (_mm256_loadu_si256 (reinterpret_cast<const __m256i *>(p + i + 32)), ff);
+        if (!_mm256_testz_si256 (_mm256_or_si256 (a, b), _mm256_or_si256 (a, b)))
+        {
+            uint64_t mask = static_cast<uint32_t>(_mm256_movemask_epi8 (a)) |
+                    (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8 (b))) << 32);
+            return i + static_cast<size_t>(__builtin_ctzll (mask));
+        }
+    }
+    return i + ScanFFScalar (p + i, n - i);
+}
+
+static size_t
+ScanFFSse2 (
+        const uint8_t *p,
+        size_t n)
+{
+    const __m128i ff = _mm_set1_epi8 (static_cast<char>(JPEG_MARKER));
+    size_t i = 0;
+
+    for (; i + 64 <= n; i += 64)
+    {
+        __m128i a = _mm_cmpeq_epi8 (_mm_loadu_si128 (reinterpret_cast<const __m128i *>(p + i)), ff);
+        __m128i b = _mm_cmpeq_epi8 (_mm_loadu_si128 (reinterpret_cast<const __m128i *>(p + i + 16)), ff);
+        __m128i c = _mm_cmpeq_epi8 (_mm_loadu_si128 (reinterpret_cast<const __m128i *>(p + i + 32)), ff);
+        __m128i d = _mm_cmpeq_epi8 (_mm_loadu_si128 (reinterpret_cast<const __m128i *>(p + i + 48)), ff);
+        if (_mm_movemask_epi8 (_mm_or_si128 (_mm_or_si128 (a, b), _mm_or_si128 (c, d))) != 0)
+        {
+            uint64_t mask = static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8 (a))) |
+                    (static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8 (b))) << 16) |
+                    (static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8 (c))) << 32) |
+                    (static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8 (d))) << 48);
+            return i + static_cast<size_t>(__builtin_ctzll (mask));
+        }
+    }
+    return i + ScanFFScalar (p + i, n - i);
+}
+
+/* Picked once, on the CPU the analyzer runs on. */
+static size_t (*const glScanFF) (const uint8_t *, size_t) =
+        __builtin_cpu_supports ("avx2") ? ScanFFAvx2 : ScanFFSse2;
+
+size_t
+UvcStreamScanFF (
+        const uint8_t *p,
+        size_t n)
+{
+    return glScanFF (p, n);
+}
+
+#elif defined(__ARM_NEON)
+
+size_t
+UvcStreamScanFF (
+        const uint8_t *p,
+        size_t n)
+{
+    const uint8x16_t ff = vdupq_n_u8 (JPEG_MARKER);
+    size_t i = 0;
+
+    for (; i + 64 <= n; i += 64)
+    {
+        uint8x16x4_t v = vld1q_u8_x4 (p + i);
+        uint8x16_t any = vorrq_u8 (vorrq_u8 (vceqq_u8 (v.val[0], ff), vceqq_u8 (v.val[1], ff)),
+                vorrq_u8 (vceqq_u8 (v.val[2], ff), vceqq_u8 (v.val[3], ff)));
+        if (vmaxvq_u8 (any) != 0)
+        {
+            return i + ScanFFScalar (p + i, 64);
+        }
+    }
+    return i + ScanFFScalar (p + i, n - i);
+}
+
+#else
+
+size_t
+UvcStreamScanFF (
+        const uint8_t *p,
+        size_t n)
+{
+    return ScanFFScalar (p, n);
+}
+
+#endif
+
+UvcStreamViolation
+UvcStreamCheckJpeg (
+        const uint8_t *p,
+        size_t n)
+{
+    if ((n < 2) || (p[0] != JPEG_MARKER) || (p[1] != JPEG_SOI))
+    {
+        return UVC_VIOL_JPEG_NO_SOI;
+    }
+
+    size_t pos = 2;
+    for (;;)
+    {
+        /* A marker, possibly after fill bytes. */
+        if (pos + 2 > n)
+        {
+            return UVC_VIOL_JPEG_NO_EOI;
+        }
+        if (p[pos] != JPEG_MARKER)
+        {
+            return UVC_VIOL_JPEG_MARKER;
+        }
+        while ((pos + 2 <= n) && (p[pos + 1] == JPEG_MARKER))
+        {
+            pos++;
+        }
+        if (pos + 2 > n)
+        {
+            return UVC_VIOL_JPEG_NO_EOI;
+        }
+
+        uint8_t marker = p[pos + 1];
+        pos += 2;
+        if (marker == JPEG_EOI)
+        {
+            return (pos == n) ? UVC_VIOL_COUNT : UVC_VIOL_JPEG_TRAILING;
+        }
+        if ((marker == JPEG_SOI) || (marker == 0))
+        {
+            return UVC_VIOL_JPEG_MARKER;
+        }
+        if ((marker == JPEG_TEM) || ((marker >= JPEG_RST0) && (marker <= JPEG_RST7)))
+        {
+            continue;
+        }
+
+        /* A marker segment; after SOS, the entropy coded data up to the next marker. */
+        if (pos + 2 > n)
+        {
+            return UVC_VIOL_JPEG_NO_EOI;
+        }
+        size_t length = (static_cast<size_t>(p[pos]) << 8) | p[pos + 1];
+        if ((length < 2) || (pos + length > n))
+        {
+            return UVC_VIOL_JPEG_MARKER;
+        }
+        pos += length;
+        if (marker != JPEG_SOS)
+        {
+            continue;
+        }
+
+        for (;;)
+        {
+            pos += UvcStreamScanFF (p + pos, n - pos);
+            if (pos + 2 > n)
+            {
+                return UVC_VIOL_JPEG_NO_EOI;
+            }
+            uint8_t next = p[pos + 1];
+            if ((next == 0) || ((next >= JPEG_RST0) && (next <= JPEG_RST7)))
+            {
+                pos += 2;
+            }
+            else if (next == JPEG_MARKER)
+            {
+                pos++;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+}
+
+static void
+Violation (
+        UvcStream *stream_p,
+        UvcStreamViolation kind,
+        uint64_t ns)
+{
+    UvcStreamStats &stats = stream_p->stats;
+
+    stats.violations[kind]++;
+    if (stream_p->frameOpen)
+    {
+        stream_p->frame.violations++;
+    }
+    if (stats.events.size () < stream_p->cfg.keepEvents)
+    {
+        stats.events.push_back ({kind, (stats.payloads != 0) ? stats.payloads - 1 : 0, stats.frames, ns});
+    }
+}
+
+/* Close the frame in progress: checked if it ended with an EOF and was fully captured. */
+static void
+EndFrame (
+        UvcStream *stream_p,
+        bool eof)
+{
+    UvcStreamStats &stats = stream_p->stats;
+    UvcStreamFrame &frame = stream_p->frame;
+
+    frame.eof = eof;
+    frame.jpegOk = false;
+    if (eof)
+    {
+        stats.eofFrames++;
+        if (!frame.truncated)
+        {
+            UvcStreamViolation kind = UvcStreamCheckJpeg (stream_p->data.data (), stream_p->data.size ());
+            if (kind == UVC_VIOL_COUNT)
+            {
+                frame.jpegOk = true;
+                stats.jpegFrames++;
+            }
+            else
+            {
+                Violation (stream_p, kind, frame.lastNs);
+            }
+            stats.frameBytes.Add (frame.bytes);
+        }
+
+        if (stream_p->metaPending)
+        {
+            stats.metaFrames++;
+            if (stream_p->haveMeta && (stream_p->metaSeq != stream_p->lastMetaSeq + 1))
+            {
+                Violation (stream_p, UVC_VIOL_META_SEQUENCE, frame.lastNs);
+            }
+            if (!frame.truncated && (stream_p->metaBytes != frame.bytes))
+            {
+                Violation (stream_p, UVC_VIOL_META_SIZE, frame.lastNs);
+            }
+            stream_p->haveMeta = true;
+            stream_p->lastMetaSeq = stream_p->metaSeq;
+        }
+
+        if (stream_p->lastEofNs != 0)
+        {
+            stats.intervalUs.Add ((frame.lastNs - stream_p->lastEofNs) / 1e3);
+        }
+        stream_p->lastEofNs = frame.lastNs;
+    }
+
+    if (frame.hasPts)
+    {
+        if (stream_p->havePts)
+        {
+            int32_t delta = static_cast<int32_t>(frame.pts - stream_p->lastPts);
+            if (delta < 0)
+            {
+                Violation (stream_p, UVC_VIOL_PTS_BACKWARDS, frame.lastNs);
+            }
+            else
+            {
+                stats.ptsIntervalUs.Add ((stream_p->cfg.clockHz > 0) ? (1e6 * delta / stream_p->cfg.clockHz) : delta);
+            }
+        }
+        stream_p->havePts = true;
+        stream_p->lastPts = frame.pts;
+    }
+
+    stats.frames++;
+    if (stream_p->cfg.frameCb != nullptr)
+    {
+        stream_p->cfg.frameCb (frame, stream_p->cfg.frameContext_p);
+    }
+    stream_p->frameOpen = false;
+    stream_p->metaPending = false;
+}
+
+void
+UvcStreamInit (
+        UvcStream *stream_p,
+        const UvcStreamConfig &cfg)
+{
+    *stream_p = UvcStream {};
+    stream_p->cfg = cfg;
+    stream_p->data.reserve (1u << 20);
+}
+
+void
+UvcStreamPayload (
+        UvcStream *stream_p,
+        const UvcPayload &payload)
+{
+    UvcStreamStats &stats = stream_p->stats;
+    const uint8_t *p = payload.data;
+
+    stats.firstNs = (stats.payloads == 0) ? payload.ns : stats.firstNs;
+    stats.lastNs = payload.ns;
+    stats.payloads++;
+    stats.payloadBytes += payload.length;
+    if (payload.captured < payload.length)
+    {
+        stats.truncatedPayloads++;
+    }
+
+    if ((payload.captured < 2) || (p[0] < 2) || (p[0] > payload.length))
+    {
+        Violation (stream_p, UVC_VIOL_HEADER_LENGTH, payload.ns);
+        return;
+    }
+
+    uint8_t length = p[0];
+    uint8_t bfh = p[1];
+    bool hasPts = (bfh & CY_FX_UVC_HEADER_BFH_PTS) != 0;
+    bool hasScr = (bfh & CY_FX_UVC_HEADER_BFH_SCR) != 0;
+    uint32_t fields = 2 + (hasPts ? 4 : 0) + (hasScr ? 6 : 0);
+    uint8_t fid = bfh & CY_FX_UVC_HEADER_FRAME_ID;
+    bool eof = (bfh & CY_FX_UVC_HEADER_EOF) != 0;
+
+    stats.headerBytes += length;
+    if ((bfh & CY_FX_UVC_HEADER_BFH_EOH) == 0)
+    {
+        Violation (stream_p, UVC_VIOL_HEADER_EOH, payload.ns);
+    }
+    if ((bfh & UVC_BFH_ERR) != 0)
+    {
+        Violation (stream_p, UVC_VIOL_HEADER_ERR, payload.ns);
+    }
+    if (length < fields)
+    {
+        Violation (stream_p, UVC_VIOL_HEADER_FIELDS, payload.ns);
+        hasPts = hasScr = false;
+    }
+    if (payload.captured < fields)
+    {
+        hasPts = hasScr = false;
+    }
+
+    /* Frame boundaries: the FID toggles after the EOF, and only then. */
+    if (stream_p->frameOpen && (fid != stream_p->lastFid))
+    {
+        Violation (stream_p, UVC_VIOL_FID_NO_EOF, payload.ns);
+        EndFrame (stream_p, false);
+    }
+    if (!stream_p->frameOpen)
+    {
+        if (stream_p->haveEof && (fid == stream_p->lastFid))
+        {
+            Violation (stream_p, UVC_VIOL_FID_AFTER_EOF, payload.ns);
+        }
+
+        UvcStreamFrame &frame = stream_p->frame;
+        frame = UvcStreamFrame {};
+        frame.index = stats.frames;
+        frame.firstPayload = stats.payloads - 1;
+        frame.firstNs = payload.ns;
+        frame.hasPts = hasPts;
+        frame.pts = hasPts ? Le32 (p + 2) : 0;
+        stream_p->data.clear ();
+        stream_p->frameOpen = true;
+        stream_p->haveEof = false;
+        stream_p->lastFid = fid;
+    }
+    else if (hasPts && stream_p->frame.hasPts && (Le32 (p + 2) != stream_p->frame.pts))
+    {
+        Violation (stream_p, UVC_VIOL_PTS_CHANGED, payload.ns);
+    }
+
+    if (hasScr)
+    {
+        uint32_t stc = Le32 (p + (hasPts ? 6 : 2));
+        if (stream_p->haveScr && (static_cast<int32_t>(stc - stream_p->lastScr) < 0))
+        {
+            Violation (stream_p, UVC_VIOL_SCR_BACKWARDS, payload.ns);
+        }
+        stream_p->haveScr = true;
+        stream_p->lastScr = stc;
+    }
+
+    /* The firmware metadata follows the PTS and SCR of its EOF headers. */
+    if (eof && hasPts && hasScr && (length == fields + sizeof (CyFxUVCFrameMeta_t)) && (payload.captured >= length))
+    {
+        CyFxUVCFrameMeta_t meta;
+        memcpy (&meta, p + fields, sizeof (meta));
+        if (meta.version == CY_FX_UVC_META_VERSION)
+        {
+            stream_p->metaPending = true;
+            stream_p->metaSeq = meta.sequence;
+            stream_p->metaBytes = meta.frameBytes;
+        }
+    }
+
+    /* Payload data into the frame. */
+    UvcStreamFrame &frame = stream_p->frame;
+    uint32_t bytes = payload.length - length;
+    frame.payloads++;
+    frame.bytes += bytes;
+    frame.lastNs = payload.ns;
+    if ((payload.captured < payload.length) || (frame.bytes > stream_p->cfg.maxFrameBytes))
+    {
+        frame.truncated = true;
+    }
+    if (!frame.truncated)
+    {
+        stream_p->data.insert (stream_p->data.end (), p + length, p + payload.length);
+    }
+
+    if (eof)
+    {
+        EndFrame (stream_p, true);
+        stream_p->haveEof = true;
+    }
+}
+
+void
+UvcStreamUrbError (
+        UvcStream *stream_p,
+        uint64_t ns)
+{
+    Violation (stream_p, UVC_VIOL_URB_ERROR, ns);
+}
+
+void
+UvcStreamFinish (
+        UvcStream *stream_p)
+{
+    if (stream_p->frameOpen)
+    {
+        stream_p->frame.truncated = true;
+        EndFrame (stream_p, false);
+    }
+}
+
+/*[]*/
@@ -0,0 +1,195 @@
+/*
+ ## UVC bulk payload stream analyzer (uvcstream.h)
+ ## ===========================
+*/
+
+#ifndef _INCLUDED_UVCSTREAM_H_
+#define _INCLUDED_UVCSTREAM_H_
+
+/* Checks a stream of UVC bulk payloads as the host receives them: one payload per bulk
+ * transfer, each starting with the payload header the firmware writes (cyfxuvcpayload.h).
+ * Payloads are reassembled into frames on the FID / EOF bits and every frame is checked
+ * as an MJPEG picture. The analyzer keeps no per-payload state beyond the frame being
+ * assembled, so captures of any length run in constant memory.
+ *
+ * Checked, per payload: the header length against the payload and against the PTS / SCR
+ * fields it announces, the end-of-header and error bits, the PTS staying constant within
+ * a frame and the SCR clock going forward. Per frame: the FID toggling after each EOF and
+ * only then, the picture starting with SOI, ending with EOI and made of well-formed
+ * marker segments, and the frame metadata of CY_FX_UVC_METADATA builds (cyfxuvcmeta.h)
+ * agreeing with what was received. Frame sizes, frame intervals on the capture clock and
+ * on the PTS, and the payload throughput are accumulated for the report. */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Protocol violations, counted by kind. */
+enum UvcStreamViolation
+{
+    UVC_VIOL_HEADER_LENGTH = 0,         /* bHeaderLength below 2 or beyond the payload. */
+    UVC_VIOL_HEADER_EOH,                /* End-of-header bit clear. */
+    UVC_VIOL_HEADER_FIELDS,             /* Header too short for the PTS / SCR fields it announces. */
+    UVC_VIOL_HEADER_ERR,                /* Error bit set by the device. */
+    UVC_VIOL_FID_NO_EOF,                /* FID toggled before the frame had an EOF. */
+    UVC_VIOL_FID_AFTER_EOF,             /* FID did not toggle after an EOF. */
+    UVC_VIOL_PTS_CHANGED,               /* PTS differs between payloads of a frame. */
+    UVC_VIOL_PTS_BACKWARDS,             /* PTS of a frame before that of the previous frame. */
+    UVC_VIOL_SCR_BACKWARDS,             /* SCR clock went back. */
+    UVC_VIOL_JPEG_NO_SOI,               /* Frame does not start with SOI. */
+    UVC_VIOL_JPEG_NO_EOI,               /* No EOI: the frame is cut short. */
+    UVC_VIOL_JPEG_MARKER,               /* Malformed or truncated marker segment. */
+    UVC_VIOL_JPEG_TRAILING,             /* Bytes after EOI. */
+    UVC_VIOL_META_SEQUENCE,             /* Metadata sequence number skipped or repeated. */
+    UVC_VIOL_META_SIZE,                 /* Metadata frame size differs from the bytes received. */
+    UVC_VIOL_URB_ERROR,                 /* Transfer completed with an error (usbmon captures). */
+    UVC_VIOL_COUNT
+};
+
+extern const char *const glUvcStreamViolationNames[UVC_VIOL_COUNT];
+
+/* One bulk payload of a capture. captured is less than length when the capture kept
+   only the start of the transfer (usbmon text); such frames skip the content checks. */
+struct UvcPayload
+{
+    const uint8_t *data;
+    uint32_t length;                    // Transfer length
+    uint32_t captured;                  // Bytes of it at data
+    uint64_t ns;                        // Capture time
+};
+
+/* A frame, as handed to the frame callback. */
+struct UvcStreamFrame
+{
+    uint64_t index;                     // Frame number in the capture
+    uint64_t firstPayload;              // Payload number of its first payload
+    uint32_t payloads;
+    uint32_t bytes;                     // Payload data, headers excluded
+    uint64_t firstNs;                   // Capture time of the first and the last payload
+    uint64_t lastNs;
+    uint32_t pts;                       // PTS of the frame, if hasPts
+    bool hasPts;
+    bool eof;                           // Ended by an EOF header (not by FID or the capture end)
+    bool truncated;                     // Content not fully captured: not checked
+    bool jpegOk;                        // Passed the MJPEG checks
+    uint32_t violations;                // Violations counted while it was assembled
+};
+
+/* A violation, kept for the first few of a capture. */
+struct UvcStreamEvent
+{
+    UvcStreamViolation kind;
+    uint64_t payload;                   // Payload number
+    uint64_t frame;                     // Frame number
+    uint64_t ns;                        // Capture time
+};
+
+/* Running minimum, maximum, mean and standard deviation. */
+struct UvcStreamSeries
+{
+    uint64_t count = 0;
+    double sum = 0;
+    double sumSq = 0;
+    double min = 0;
+    double max = 0;
+
+    void Add (double value);
+    double Mean (void) const;
+    double StdDev (void) const;
+};
+
+typedef void (*UvcStreamFrameCb_t) (const UvcStreamFrame &frame, void *context_p);
+
+struct UvcStreamConfig
+{
+    double clockHz = 0;                 // Timestamp clock of the PTS, 0 for ticks
+    uint32_t maxFrameBytes = 64u << 20; // Frames beyond this are not assembled further
+    unsigned keepEvents = 16;           // Violations kept with their position
+    UvcStreamFrameCb_t frameCb = nullptr;
+    void *frameContext_p = nullptr;
+};
+
+struct UvcStreamStats
+{
+    uint64_t payloads = 0;
+    uint64_t payloadBytes = 0;          // Transfer bytes, headers included
+    uint64_t headerBytes = 0;
+    uint64_t truncatedPayloads = 0;
+    uint64_t frames = 0;                // Frames seen, complete or not
+    uint64_t eofFrames = 0;             // Frames ended by EOF
+    uint64_t jpegFrames = 0;            // EOF frames that passed the MJPEG checks
+    uint64_t metaFrames = 0;            // EOF frames with the firmware metadata
+    uint64_t firstNs = 0;
+    uint64_t lastNs = 0;
+    UvcStreamSeries frameBytes;         // Sizes of the EOF frames
+    UvcStreamSeries intervalUs;         // Between the EOFs of consecutive frames, capture clock
+    UvcStreamSeries ptsIntervalUs;      // Between the PTS of consecutive frames (ticks if no clock)
+    uint64_t violations[UVC_VIOL_COUNT] = {};
+    std::vector<UvcStreamEvent> events;
+};
+
+struct UvcStream
+{
+    UvcStreamConfig cfg;
+    UvcStreamStats stats;
+
+    /* Frame being assembled. */
+    UvcStreamFrame frame {};
+    bool frameOpen = false;
+    std::vector<uint8_t> data;
+
+    /* Across frames. */
+    bool haveEof = false;               // An EOF was seen: lastFid is the FID it closed
+    uint8_t lastFid = 0;
+    bool havePts = false;
+    uint32_t lastPts = 0;
+    bool haveScr = false;
+    uint32_t lastScr = 0;
+    uint64_t lastEofNs = 0;
+    bool haveMeta = false;
+    uint32_t lastMetaSeq = 0;
+    bool metaPending = false;           // The EOF header of the frame carried metadata
+    uint32_t metaSeq = 0;
+    uint32_t metaBytes = 0;
+};
+
+/* Reset the analyzer for a new capture. */
+void
+UvcStreamInit (
+        UvcStream *stream_p,
+        const UvcStreamConfig &cfg);
+
+/* Check one payload. */
+void
+UvcStreamPayload (
+        UvcStream *stream_p,
+        const UvcPayload &payload);
+
+/* Count a transfer that completed with an error; it carries no payload. */
+void
+UvcStreamUrbError (
+        UvcStream *stream_p,
+        uint64_t ns);
+
+/* End of the capture: hand over the frame in progress, unchecked. */
+void
+UvcStreamFinish (
+        UvcStream *stream_p);
+
+/* Offset of the first 0xFF byte of the n bytes at p, or n. Vectorized. */
+size_t
+UvcStreamScanFF (
+        const uint8_t *p,
+        size_t n);
+
+/* Check the marker structure of an MJPEG picture: SOI, marker segments, entropy coded
+   data with its stuffing and restart markers, EOI at the end. Returns UVC_VIOL_COUNT
+   when the picture is well formed, otherwise the violation found. */
+UvcStreamViolation
+UvcStreamCheckJpeg (
+        const uint8_t *p,
+        size_t n);
+
+#endif /* _INCLUDED_UVCSTREAM_H_ */
+
+/*[]*/
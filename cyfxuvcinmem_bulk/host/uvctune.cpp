@@ -0,0 +1,557 @@
+/*
+ ## DMA ring and burst tuner of the UVC bulk streamer (uvctune.cpp)
+ ## ===========================
+*/
+
+/* Predicts the throughput and latency of the streaming loop for every DMA ring (buffer
+ * size and count) and SuperSpeed burst that fits the buffer heap, and recommends one per
+ * USB speed. The model:
+ *   - payloads: the segment tables of the streaming code (CyFxUVCSegmentsGet) for the frame
+ *     store, or the same cut of the frame sizes given with -f. One payload per buffer with
+ *     the header of the build in front (CY_FX_UVC_MIN_HEADER, metadata on EOF), so
+ *     dwMaxPayloadTransferSize is the buffer size;
+ *   - SuperSpeed: 500 MB/s after 8b/10b coding, 32 bytes of packet header, CRC and framing
+ *     per 1024-byte packet, an idle turnaround per burst (-t) and a gap per DMA buffer (-d).
+ *     A short packet ends the burst; so does the ZLP that a payload of whole packets shorter
+ *     than the buffer needs to end the host transfer;
+ *   - high speed: 13 packets of 512 bytes per 125 us microframe (-u); short packets and
+ *     ZLPs take a slot each;
+ *   - CPU: the payload copy at a bandwidth (-c, or the wordcopy / copy+clean case of a
+ *     result saved with uvcbench -o) plus a cost per buffer for GetBuffer, header and
+ *     commit. The CPU fills a buffer while the link sends the others: the slower of the
+ *     two sets the rate, unless the ring has a single buffer;
+ *   - host: the host stops reading for a while at a fixed period (-j). The ring takes what
+ *     the CPU makes in the meantime; when it is too shallow the link idles once the host
+ *     reads again.
+ * Latency is the time from the start of the copy of a frame to its EOF payload on the bus,
+ * in steady state and worst case (a frame behind a host gap). The pacing sleep at the top
+ * of the example's streaming loop is left out; -p adds a sleep per buffer.
+ *
+ * The recommendation for a speed is the configuration with the least RAM within -e percent
+ * of the best predicted throughput (with -r: that reaches the frame rate), then the lowest
+ * latency. -o writes it as a header for "make CY_FX_UVC_TUNE=<header>" of the firmware. The
+ * RAM budget is the buffer heap of cyfxmemmap.h less the SDK reserve, and the ring is one
+ * session arena allocation of at most 64 KB (cyfxuvcarena.h). */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "cyfxmemmap.h"
+#include "cyfxuvcbench.h"
+#include "cyfxuvcinmem.h"
+#include "cyfxuvcmeta.h"
+
+constexpr double CY_FX_TUNE_SS_BYTES_PER_US = 500.0;  // 5 Gb/s after 8b/10b coding
+constexpr uint32_t CY_FX_TUNE_SS_PKT = 1024;           // SS bulk packet
+constexpr uint32_t CY_FX_TUNE_SS_PKT_OVERHEAD = 32;    // DPH, DPP CRC-32 and framing per packet
+constexpr uint32_t CY_FX_TUNE_SS_MAX_BURST = 16;       // bMaxBurst + 1 of the companion descriptor
+constexpr uint32_t CY_FX_TUNE_HS_PKT = 512;            // HS bulk packet
+constexpr double CY_FX_TUNE_HS_UFRAME_US = 125.0;      // HS microframe
+constexpr uint32_t CY_FX_TUNE_MAX_ARENA = 0xFFFF;      // The session arena is a single buffer heap allocation
+constexpr uint32_t CY_FX_TUNE_MIN_COUNT = 2;           // One buffer filled while one is sent
+
+/* Payload of one DMA buffer. */
+struct TuneSegment
+{
+    uint32_t length;                                   // Payload bytes copied by the CPU
+    uint32_t commit;                                   // Header and payload bytes sent
+};
+
+/* Model inputs. */
+struct TuneModel
+{
+    std::vector<uint32_t> frameLen;                    // Frame sizes, -f; empty for the frame store
+    double copyMBps;                                   // Payload copy bandwidth
+    double bufferUs;                                   // CPU time per buffer besides the copy
+    double sleepUs;                                    // Pacing sleep per buffer
+    double turnUs;                                     // SS: idle bus time between bursts
+    double dmaUs;                                      // Idle bus time between DMA buffers
+    uint32_t hsPkts;                                   // HS: packets per microframe
+    double gapUs;                                      // Host gap: no reads for gapUs...
+    double periodUs;                                   // ...every periodUs
+    uint32_t budget;                                   // Buffer heap bytes for the ring
+    double fps;                                        // Frame rate to reach, 0 for the best throughput
+    double tolerance;                                  // Percent of the best throughput given up for RAM
+};
+
+/* One configuration and its predicted figures. */
+struct TuneResult
+{
+    uint32_t bufSize;
+    uint32_t count;
+    uint32_t burst;
+    uint32_t ram;                                      // Session arena bytes
+    double mbps;                                       // Video payload MB/s
+    double fps;                                        // Frames per second at that rate
+    double latencyMs;                                  // Copy start to EOF on the bus, steady state
+    double worstMs;                                    // The same behind a host gap
+    double shortPkts;                                  // Short packets per frame
+    double zlps;                                       // ZLPs per frame
+    const char *bound;                                 // "cpu", "link" or "ring"
+};
+
+static void
+Usage (
+        const char *prog)
+{
+    fprintf (stderr,
+            "usage: %s [-S ss|hs] [-f bytes[,bytes...]] [-b bench | -c MB/s,us] [-p us] [-t us] [-d us]\n"
+            "          [-u packets] [-j gap_us,period_us] [-m bytes] [-r fps] [-e percent] [-n rows] [-o prefix]\n"
+            "  -S  model one speed only (default both)\n"
+            "  -f  frame sizes to stream (default the frame store of the firmware)\n"
+            "  -b  take the copy bandwidth from a result saved with uvcbench -o\n"
+            "  -c  copy bandwidth and CPU time per buffer besides the copy (default 100,8)\n"
+            "  -p  pacing sleep per buffer (default 0)\n"
+            "  -t  SS idle time between bursts, host ACK turnaround (default 2)\n"
+            "  -d  idle bus time between DMA buffers (default 0.5)\n"
+            "  -u  HS bulk packets per microframe (default 13)\n"
+            "  -j  host read gaps: gap length and period (default 250,2000)\n"
+            "  -m  RAM for the ring (default %u: buffer heap less the SDK reserve)\n"
+            "  -r  frame rate to reach instead of the best throughput\n"
+            "  -e  throughput given up for less RAM, in percent (default 2)\n"
+            "  -n  configurations listed per speed (default 10)\n"
+            "  -o  write the recommendations to <prefix>_ss.h and <prefix>_hs.h\n",
+            prog, static_cast<unsigned>(CY_FX_MEM_BUF_HEAP_SIZE - CY_FX_MEM_SDK_BUF_RESERVE));
+}
+
+/* Two numbers separated by a comma. */
+static bool
+ParsePair (
+        const char *arg,
+        double *first_p,
+        double *second_p)
+{
+    char *end;
+
+    *first_p = strtod (arg, &end);
+    if (*end != ',')
+    {
+        return false;
+    }
+    *second_p = strtod (end + 1, &end);
+    return (*end == '\0');
+}
+
+/* Copy bandwidth of a result saved with uvcbench -o: the streaming loop copy, with the
+ * cache clean when the D-cache was on. */
+static bool
+ReadBench (
+        const char *path,
+        double *mbps_p)
+{
+    static CyFxUVCBench_t bench;
+    FILE *f = fopen (path, "rb");
+    size_t len = (f != nullptr) ? fread (&bench, 1, sizeof (bench), f) : 0;
+
+    if (f != nullptr)
+    {
+        fclose (f);
+    }
+    if ((len != sizeof (bench)) || (bench.version != CY_FX_UVC_BENCH_VERSION) ||
+            (bench.caseCount != CY_FX_UVC_BENCH_COUNT) || (bench.status != 0))
+    {
+        fprintf (stderr, "%s: not a saved benchmark result\n", path);
+        return false;
+    }
+
+    const CyFxUVCBenchResult_t &r = bench.result[bench.dcache ? CY_FX_UVC_BENCH_COMMIT : CY_FX_UVC_BENCH_WORDCOPY];
+    double seconds = static_cast<double>(r.totalTicks) / bench.clockHz;
+    if (seconds <= 0)
+    {
+        fprintf (stderr, "%s: empty copy case\n", path);
+        return false;
+    }
+    *mbps_p = static_cast<double>(r.bytes) * bench.rounds / seconds / 1e6;
+    return true;
+}
+
+/* Payloads of all the frames for a buffer size, and the number of frames. The frame store
+ * comes from the segment tables of the streaming code; other frame sizes are cut the same
+ * way: full buffers, the frame ending in the first payload that fits next to the EOF header. */
+static uint32_t
+Segments (
+        const TuneModel &model,
+        uint32_t bufSize,
+        std::vector<TuneSegment> *segs_p)
+{
+    segs_p->clear ();
+    if (model.frameLen.empty ())
+    {
+        uint32_t count = 0, frames = 0;
+        const CyFxUVCSegment_t *seg_p = CyFxUVCSegmentsGet (bufSize, &count);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            segs_p->push_back ({ seg_p[i].length, seg_p[i].commit });
+            frames += seg_p[i].start;
+        }
+        return frames;
+    }
+
+    for (uint32_t len : model.frameLen)
+    {
+        uint32_t remaining = len;
+
+        while (remaining > bufSize - CY_FX_UVC_HEADER_EOF_LEN)
+        {
+            uint32_t bytes = std::min (remaining, bufSize - CY_FX_UVC_HEADER_LEN);
+            segs_p->push_back ({ bytes, bytes + CY_FX_UVC_HEADER_LEN });
+            remaining -= bytes;
+        }
+        segs_p->push_back ({ remaining, remaining + CY_FX_UVC_HEADER_EOF_LEN });
+    }
+    return static_cast<uint32_t>(model.frameLen.size ());
+}
+
+/* Predicted figures of one configuration over a pass of all the frames. */
+static TuneResult
+Predict (
+        const TuneModel &model,
+        bool superSpeed,
+        const std::vector<TuneSegment> &segs,
+        uint32_t frames,
+        uint32_t bufSize,
+        uint32_t count,
+        uint32_t burst)
+{
+    TuneResult r {};
+    uint32_t pkt = superSpeed ? CY_FX_TUNE_SS_PKT : CY_FX_TUNE_HS_PKT;
+    double payload = 0, cpuUs = 0, wire = 0, bursts = 0, slots = 0;
+    uint32_t run = 0;
+
+    r.bufSize = bufSize;
+    r.count = count;
+    r.burst = burst;
+    r.ram = count * ((bufSize + 31u) & ~31u);
+
+    for (const TuneSegment &seg : segs)
+    {
+        uint32_t pkts = (seg.commit + pkt - 1) / pkt;
+        bool isShort = (seg.commit % pkt) != 0;
+        bool zlp = !isShort && (seg.commit < bufSize);
+
+        payload += seg.length;
+        cpuUs += seg.length / model.copyMBps + model.bufferUs + model.sleepUs;
+        r.shortPkts += isShort ? 1 : 0;
+        r.zlps += zlp ? 1 : 0;
+
+        /* Full buffers carry on the burst of the one before; a short packet or ZLP ends it. */
+        wire += seg.commit + (pkts + (zlp ? 1 : 0)) * CY_FX_TUNE_SS_PKT_OVERHEAD;
+        run += pkts + (zlp ? 1 : 0);
+        if (isShort || zlp)
+        {
+            bursts += (run + burst - 1) / burst;
+            run = 0;
+        }
+        slots += pkts + (zlp ? 1 : 0);
+    }
+    bursts += static_cast<double>(run) / burst;
+
+    double n = static_cast<double>(segs.size ());
+    double linkUs = n * model.dmaUs + (superSpeed ?
+            (wire / CY_FX_TUNE_SS_BYTES_PER_US + bursts * model.turnUs) :
+            (slots / model.hsPkts * CY_FX_TUNE_HS_UFRAME_US));
+
+    /* Rates in payload bytes per us. The ring holds count buffers of the average payload. */
+    double cpu = payload / cpuUs, link = payload / linkUs, ring = count * payload / n;
+    double period = model.periodUs, active = model.periodUs - model.gapUs, gap = model.gapUs;
+    double rate;
+
+    if (count < CY_FX_TUNE_MIN_COUNT)
+    {
+        rate = payload / (cpuUs + linkUs) * active / period;
+        r.bound = "ring";
+    }
+    else
+    {
+        /* The link sends during the active part of the period only; the CPU fills the ring
+           during the gap as far as it goes and the link drains the backlog afterwards. */
+        double cpuBytes = cpu * active + std::min (cpu * gap, ring);
+        rate = std::min (link * active, cpuBytes) / period;
+        r.bound = (link * active <= cpuBytes) ? "link" : ((cpu * gap > ring) ? "ring" : "cpu");
+    }
+
+    /* A frame waits behind a full ring when the link is the bottleneck. */
+    double frameCpu = cpuUs / frames, frameLink = linkUs / frames, bufCpu = cpuUs / n, bufLink = linkUs / n;
+    double queue = (cpu >= link) ? (count - 1) * bufLink : 0;
+    double latency = std::max (frameCpu + bufLink, bufCpu + queue + frameLink);
+    double backlog = (cpu < link) ? std::min (ring, cpu * gap) / link : 0;
+
+    r.mbps = rate;
+    r.fps = rate * 1e6 / (payload / frames);
+    r.latencyMs = latency / 1e3;
+    r.worstMs = (latency + gap + backlog) / 1e3;
+    r.shortPkts /= frames;
+    r.zlps /= frames;
+    return r;
+}
+
+/* All the configurations of a speed that fit, best predicted throughput first. */
+static std::vector<TuneResult>
+Sweep (
+        const TuneModel &model,
+        bool superSpeed)
+{
+    std::vector<TuneResult> results;
+    std::vector<TuneSegment> segs;
+    uint32_t limit = std::min (model.budget, CY_FX_TUNE_MAX_ARENA);
+    uint32_t maxBurst = superSpeed ? CY_FX_TUNE_SS_MAX_BURST : 1;
+
+    for (uint32_t bufSize : CY_FX_UVC_SEG_BUF_SIZES)
+    {
+        uint32_t frames = Segments (model, bufSize, &segs);
+        uint32_t stride = (bufSize + 31u) & ~31u;
+
+        for (uint32_t count = CY_FX_TUNE_MIN_COUNT; (count <= UINT8_MAX) && (count * stride <= limit); count++)
+        {
+            for (uint32_t burst = 1; burst <= maxBurst; burst++)
+            {
+                results.push_back (Predict (model, superSpeed, segs, frames, bufSize, count, burst));
+            }
+        }
+    }
+    std::stable_sort (results.begin (), results.end (),
+            [] (const TuneResult &a, const TuneResult &b) { return a.mbps > b.mbps; });
+    return results;
+}
+
+/* Least RAM within the tolerance of the best throughput or at the frame rate, then the
+ * lowest latency; nullptr if no configuration reaches the frame rate. */
+static const TuneResult *
+Recommend (
+        const TuneModel &model,
+        const std::vector<TuneResult> &results)
+{
+    const TuneResult *best_p = nullptr;
+    double floor = (model.fps > 0) ? 0 : results.front ().mbps * (1 - model.tolerance / 100);
+
+    for (const TuneResult &r : results)
+    {
+        if ((r.mbps < floor) || (r.fps < model.fps))
+        {
+            continue;
+        }
+        if ((best_p == nullptr) || (r.ram < best_p->ram) ||
+                ((r.ram == best_p->ram) && (r.latencyMs < best_p->latencyMs)))
+        {
+            best_p = &r;
+        }
+    }
+    return best_p;
+}
+
+static void
+PrintRow (
+        const char *mark,
+        const TuneResult &r)
+{
+    printf ("%-2s %6u %5u %5u %7.1f %8.1f %8.0f %8.3f %8.3f %6.2f %5.2f  %s\n", mark, r.bufSize, r.count, r.burst,
+            r.ram / 1024.0, r.mbps, r.fps, r.latencyMs, r.worstMs, r.shortPkts, r.zlps, r.bound);
+}
+
+/* Model inputs as one line, for the report and the header comment. */
+static std::string
+Describe (
+        const TuneModel &model)
+{
+    std::string frames = "frame store";
+    char line[512];
+
+    if (!model.frameLen.empty ())
+    {
+        frames = "frames";
+        for (uint32_t len : model.frameLen)
+        {
+            frames += " " + std::to_string (len);
+        }
+    }
+    snprintf (line, sizeof (line),
+            "header %u bytes, EOF %u; %s; copy %.1f MB/s + %.1f us per buffer%s; host gaps %.0f us every %.0f us; "
+            "RAM %u bytes",
+            static_cast<unsigned>(CY_FX_UVC_HEADER_LEN), static_cast<unsigned>(CY_FX_UVC_HEADER_EOF_LEN),
+            frames.c_str (), model.copyMBps, model.bufferUs,
+            (model.sleepUs > 0) ? (" + " + std::to_string (static_cast<unsigned>(model.sleepUs)) + " us sleep").c_str () : "",
+            model.gapUs, model.periodUs, model.budget);
+    return line;
+}
+
+/* Recommended constants of a speed as a header for CY_FX_UVC_TUNE. */
+static bool
+WriteHeader (
+        const std::string &path,
+        const char *speedName,
+        const TuneModel &model,
+        const TuneResult &r,
+        uint32_t burst)
+{
+    std::string base = path.substr (path.find_last_of ('/') + 1), guard = "_INCLUDED_";
+    for (char c : base)
+    {
+        guard += isalnum (static_cast<unsigned char>(c)) ? static_cast<char>(toupper (static_cast<unsigned char>(c))) : '_';
+    }
+    guard += "_";
+
+    FILE *f = fopen (path.c_str (), "w");
+    if (f == nullptr)
+    {
+        perror (path.c_str ());
+        return false;
+    }
+    fprintf (f, "/*\n ## DMA ring geometry of the UVC bulk streamer for %s (%s)\n ## ===========================\n*/\n\n",
+            speedName, base.c_str ());
+    fprintf (f, "/* Written by host/uvctune; build the firmware with \"make CY_FX_UVC_TUNE=%s\".\n", path.c_str ());
+    std::string inputs = Describe (model);
+    for (size_t pos = inputs.find ("; "); pos != std::string::npos; pos = inputs.find ("; ", pos))
+    {
+        inputs.replace (pos, 2, ";\n *   ");
+    }
+    fprintf (f, " * Model: %s.\n", inputs.c_str ());
+    fprintf (f, " * Predicted: %.1f MB/s, %.0f frames/s, latency %.3f ms, %.3f ms behind a host gap (%s bound).\n",
+            r.mbps, r.fps, r.latencyMs, r.worstMs, r.bound);
+    fprintf (f, " * dwMaxPayloadTransferSize of the probe control follows the buffer size. */\n\n");
+    fprintf (f, "#ifndef %s\n#define %s\n\n", guard.c_str (), guard.c_str ());
+    fprintf (f, "constexpr uint32_t CY_FX_UVC_TUNE_STREAM_BUF_SIZE = %u; // DMA buffer, one payload\n", r.bufSize);
+    fprintf (f, "constexpr uint8_t CY_FX_UVC_TUNE_STREAM_BUF_COUNT = %u; // DMA ring depth, %u bytes\n", r.count, r.ram);
+    fprintf (f, "constexpr uint8_t CY_FX_UVC_TUNE_BULK_BURST = %u; // SS bulk burst%s\n", burst,
+            (r.burst == burst) ? "" : ", the SuperSpeed recommendation");
+    fprintf (f, "\n#endif /* %s */\n", guard.c_str ());
+    if (fclose (f) != 0)
+    {
+        perror (path.c_str ());
+        return false;
+    }
+    printf ("wrote %s\n", path.c_str ());
+    return true;
+}
+
+int
+main (
+        int argc,
+        char **argv)
+{
+    TuneModel model { {}, 100, 8, 0, 2, 0.5, 13, 250, 2000,
+        static_cast<uint32_t>(CY_FX_MEM_BUF_HEAP_SIZE - CY_FX_MEM_SDK_BUF_RESERVE), 0, 2 };
+    const char *speed = nullptr, *prefix = nullptr, *benchPath = nullptr;
+    unsigned rows = 10;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "S:f:b:c:p:t:d:u:j:m:r:e:n:o:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'S': speed = optarg; break;
+            case 'f':
+                for (char *tok = strtok (optarg, ","); tok != nullptr; tok = strtok (nullptr, ","))
+                {
+                    model.frameLen.push_back (static_cast<uint32_t>(strtoul (tok, nullptr, 0)));
+                }
+                break;
+            case 'b': benchPath = optarg; break;
+            case 'c':
+                if (!ParsePair (optarg, &model.copyMBps, &model.bufferUs))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'p': model.sleepUs = strtod (optarg, nullptr); break;
+            case 't': model.turnUs = strtod (optarg, nullptr); break;
+            case 'd': model.dmaUs = strtod (optarg, nullptr); break;
+            case 'u': model.hsPkts = static_cast<uint32_t>(strtoul (optarg, nullptr, 0)); break;
+            case 'j':
+                if (!ParsePair (optarg, &model.gapUs, &model.periodUs))
+                {
+                    Usage (argv[0]);
+                    return 1;
+                }
+                break;
+            case 'm': model.budget = static_cast<uint32_t>(strtoul (optarg, nullptr, 0)); break;
+            case 'r': model.fps = strtod (optarg, nullptr); break;
+            case 'e': model.tolerance = strtod (optarg, nullptr); break;
+            case 'n': rows = static_cast<unsigned>(strtoul (optarg, nullptr, 0)); break;
+            case 'o': prefix = optarg; break;
+            default:
+                Usage (argv[0]);
+                return 1;
+        }
+    }
+    if ((optind != argc) || ((speed != nullptr) && (strcmp (speed, "ss") != 0) && (strcmp (speed, "hs") != 0)) ||
+            (model.copyMBps <= 0) || (model.hsPkts == 0) || (model.periodUs <= 0) || (model.gapUs < 0) ||
+            (model.gapUs >= model.periodUs) ||
+            std::any_of (model.frameLen.begin (), model.frameLen.end (), [] (uint32_t len) { return len == 0; }))
+    {
+        Usage (argv[0]);
+        return 1;
+    }
+    if ((benchPath != nullptr) && !ReadBench (benchPath, &model.copyMBps))
+    {
+        return 1;
+    }
+
+    printf ("model: %s\n", Describe (model).c_str ());
+    printf ("probe: %.1f frames/s\n",
+            1e7 / (glProbeCtrl[4] | (glProbeCtrl[5] << 8) | (glProbeCtrl[6] << 16) | (glProbeCtrl[7] << 24)));
+
+    uint32_t ssBurst = CY_FX_BULK_BURST;
+    for (bool superSpeed : { true, false })
+    {
+        const char *tag = superSpeed ? "ss" : "hs";
+        const char *speedName = superSpeed ? "SuperSpeed" : "high speed";
+
+        if ((speed != nullptr) && (strcmp (speed, tag) != 0))
+        {
+            continue;
+        }
+
+        std::vector<TuneResult> results = Sweep (model, superSpeed);
+        if (results.empty ())
+        {
+            fprintf (stderr, "no ring fits in %u bytes\n", model.budget);
+            return 1;
+        }
+        const TuneResult *rec_p = Recommend (model, results);
+
+        /* The ring of this build, for comparison. */
+        std::vector<TuneSegment> segs;
+        uint32_t frames = Segments (model, CY_FX_UVC_STREAM_BUF_SIZE, &segs);
+        TuneResult current = Predict (model, superSpeed, segs, frames, CY_FX_UVC_STREAM_BUF_SIZE,
+                CY_FX_UVC_STREAM_BUF_COUNT, superSpeed ? CY_FX_BULK_BURST : 1);
+
+        printf ("\n%s: %zu configurations\n", speedName, results.size ());
+        printf ("%-2s %6s %5s %5s %7s %8s %8s %8s %8s %6s %5s  %s\n", "", "buffer", "count", "burst", "RAM KB",
+                "MB/s", "fps", "lat ms", "worst ms", "short", "zlp", "bound");
+        for (unsigned i = 0; (i < rows) && (i < results.size ()); i++)
+        {
+            PrintRow ((&results[i] == rec_p) ? "*" : "", results[i]);
+        }
+        printf ("current:\n");
+        PrintRow ("", current);
+        if (rec_p == nullptr)
+        {
+            printf ("no configuration reaches %.1f frames/s\n", model.fps);
+            continue;
+        }
+        printf ("recommended:\n");
+        PrintRow ("*", *rec_p);
+
+        if (superSpeed)
+        {
+            ssBurst = rec_p->burst;
+        }
+        if ((prefix != nullptr) &&
+                !WriteHeader (std::string (prefix) + "_" + tag + ".h", speedName, model, *rec_p, ssBurst))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*[]*/
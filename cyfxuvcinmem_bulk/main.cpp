@@ -3,6 +3,8 @@
 #include "cyu3dma.h"
 #include "cyu3error.h"
 #include "cyfxuvcinmem.h"
+#include "cyfxuvcclock.h"
+#include "cyfxuvcheap.h"
 #include "cyu3usb.h"
 #include "cyu3uart.h"
 #include "cyu3utils.h"
@@ -16,6 +18,11 @@ main (void)
     CyU3PIoMatrixConfig_t io_cfg;
     CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 
+#ifdef CY_FX_MEM_CHECK_EN
+    /* The heap checks must be on before the heaps are created */
+    CyFxUVCHeapCheckEnable ();
+#endif
+
     /* Initialize the device */
     status = CyU3PDeviceInit (NULL);
     if (status != CY_U3P_SUCCESS)
@@ -23,8 +30,9 @@ main (void)
         goto handle_fatal_error;
     }
 
-    /* Initialize the caches. Enable only the instruction cache. */
-    status = CyU3PDeviceCacheControl (CyTrue, CyFalse, CyFalse);
+    /* Initialize the caches. The data cache is a build option; when it is on, the DMA APIs
+     * keep the buffers coherent except on the video channel (see CyFxUVCApplnStart). */
+    status = CyU3PDeviceCacheControl (CyTrue, CY_FX_UVC_DCACHE, CY_FX_UVC_DCACHE);
     if (status != CY_U3P_SUCCESS)
     {
         goto handle_fatal_error;
@@ -42,11 +50,11 @@ main (void)
     io_cfg.useI2S    = CyFalse;
     io_cfg.useSpi    = CyFalse;
     io_cfg.lppMode   = CY_U3P_IO_MATRIX_LPP_UART_ONLY;
-    /* No GPIOs are enabled. */
+    /* The only GPIO enabled is the complex GPIO whose timer is the timestamp clock. */
     io_cfg.gpioSimpleEn[0]  = 0;
     io_cfg.gpioSimpleEn[1]  = 0;
     io_cfg.gpioComplexEn[0] = 0;
-    io_cfg.gpioComplexEn[1] = 0;
+    io_cfg.gpioComplexEn[1] = 1u << (CY_FX_UVC_CLOCK_GPIO - 32);
     status = CyU3PDeviceConfigureIOMatrix (&io_cfg);
     if (status != CY_U3P_SUCCESS)
     {